@@ -28,6 +28,7 @@ Basically whole important application logic is implemented in this file.
 #include <GL/freeglut.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
 #include <external\AntTweakBar\AntTweakBar.h>
 
 //standard C++ libraries
@@ -35,25 +36,49 @@ Basically whole important application logic is implemented in this file.
 #include <fstream>
 #include <stdexcept>
 #include <cmath>
+#include <cstring>
+#include <cctype>
 #include <string>
 #include <locale>
 #include <vector>
+#include <algorithm>
 #include <direct.h>
 #include <sstream>
 
 #include "shaders\ShaderProgram.h"
 #include "scene\camera\Camera.h"		
+#include "scene\camera\CameraTrack.h"
 #include "scene\objloader\Mesh.h"
+#include "scene\graph\SceneGraph.h"
+#include "scene\scenario\ScenarioGenerator.h"
 #include "lighting\lights\PointLight.h"
+#include "lighting\lights\LightAnimator.h"
 #include "buffers\g-buffer\Gbuffer.h"
 
 //modules
 #include "utils\Utils.h"
 #include "lighting\tiled\Grid.h"
+#include "lighting\tiled\GridInput.h"
+#include "lighting\tiled\GridSnapshot.h"
+#include "lighting\tiled\GridStatistics.h"
+#include "lighting\tiled\ReferenceShading.h"
 #include "buffers\ubo\buffer.h"
 #include "configuration\Types.h"
 #include "configuration\Enums.h"
 #include "utils\timers\PerformanceTimer.h"
+#include "utils\timers\GpuProfiler.h"
+#include "utils\timers\SampleAggregator.h"
+#include "utils\timers\ZoneProfiler.h"
+#include "utils\benchmark\BenchmarkSpec.h"
+#include "utils\benchmark\BenchmarkRecorder.h"
+#include "collision\FrustumCuller.h"
+#include "collision\OcclusionCuller.h"
+#include "utils\threading\ThreadPool.h"
+#include "utils\threading\FramePipeline.h"
+#include "utils\OffscreenContext.h"
+#include "textures\TextureLoader.h"
+#include "textures\TextureRegistry.h"
+#include "textures\TextureStreamer.h"
 
 
 //	GLOBAL VARIABLES
@@ -80,13 +105,22 @@ bool showBoundingQuads = false;
 bool showAffectedTiles = false;
 bool showLightHeatMap = false;
 bool minMaxPass = true;
+bool frustumCulling = true;
+bool occlusionCulling = true;
+int pinnedLod = -1;			//-1 = LOD selection by screen space error
+float lodPixelError = MESH_LOD_PIXEL_ERROR;
 #pragma endregion Feature_Settings
 
 #pragma region Performance_Outputs
-std::vector<double> fpsVector;
-std::vector<double> lightingTime;
-std::vector<double> minmaxTime;
-std::vector<double> gridTime;
+GpuProfiler gpuProfiler;		//GPU times of passes, shown in frame statistics
+SampleAggregator cpuPhases[CP_Max];	//CPU time histograms of frame phases
+const char *cpuPhaseNames[CP_Max] = { "Frame", "Update", "Textures", "Culling", "Grid build", "Render", "Packet wait", "Latency", "Job" };
+double gridBuildMs = 0.0;		//CPU time of last light grid build
+GridStatistics gridStats;		//lights per tile of last light grid
+bool benchmarkMode = false;		//hidden window without tweakbar, camera follows benchmark path
+bool gridInputRequested = false;	//save input of next light grid build
+GridSnapshotWriter gridSnapshots;	//inputs of every light grid build while capturing
+bool referenceShadingRequested = false;	//compare next tiled deferred light pass with CPU reference
 #pragma endregion Performance_Outputs
 
 #pragma region Shader_Programs
@@ -113,13 +147,39 @@ float moveSpeed = 400.0; //units per second
 //camera object
 Camera      gCamera;
 
-//application window
+//camera track, recorded by C key, played by P key (and followed by benchmark if loaded)
+CameraTrack cameraTrack;
+std::string cameraTrackFile = CAMERA_TRACK_FILE;
+bool cameraRecording = false;
+double cameraRecordTime = 0.0;			//seconds since start of recording
+bool cameraPlayback = false;
+unsigned int cameraPlaybackFrame = 0;	//frames since start of playback
+
+//application window, NULL in offscreen mode
 GLFWwindow  * win = NULL;
 
+//offscreen mode (--offscreen), fixed number of frames is rendered to FBO of offscreen context
+bool offscreenMode = false;
+unsigned int offscreenFrames = OFFSCREEN_FRAMES;
+OffscreenContext offscreenContext;
+GLuint outputFramebuffer = 0;		//framebuffer of window (0) or of offscreen context
+bool closeRequested = false;		//main loop ends after current frame
+
+//ticks at application start, getTime is measured from here (GLFW timer needs glfwInit)
+unsigned long long startTicks = PerformanceTimer::getTickCount();
+
 //meshes
 Mesh        * m_pMesh = NULL;		//scene
 Mesh        * m_sphere = NULL;		//pointlight sphere
 
+//scene nodes, copies of scene mesh are drawn instanced
+SceneGraph	sceneGraph;
+
+//benchmark scenario, lights and instances are generated from its parameters
+ScenarioDesc scenarioDesc = { SCENARIO_SEED, SCENARIO_DISTRIBUTION, MAX_LIGHTS, LIGHT_RADIUS_MIN, LIGHT_RADIUS_MAX, SCENARIO_LAYOUT, SCENARIO_LAYOUT_SIZE };
+ScenarioGenerator *scenarioGenerator = NULL;
+std::vector<glm::mat4> sceneInstances;
+
 //gBuffer object
 GBuffer     *gBuf = new GBuffer();
 //gbuffer textures
@@ -129,24 +189,65 @@ GLuint gBufTexIndex = 4;
 //VBOs
 GLuint	quadVBO;
 
-//models of point lights for deferred shading
-glm::mat4 lightSpheres[MAX_LIGHTS];
+//animated lights (L key, --animate-lights)
+LightAnimator lightAnimator;
+bool lightAnimation = false;
+double lightAnimationTime = 0.0;		//seconds of animation since lights were set
+
+//culling of scene submeshes
+FrustumCuller frustumCuller;
+OcclusionCuller *occlusionCuller;
+std::vector<AABB> meshBounds;				//object space bounds of scene submeshes
+std::vector<unsigned int> visibleMeshes;	//draw list of rendered frame
+
+/// <summary>
+/// State of single frame. Input is captured by render (main) thread, draw list
+/// and light grid are produced by simulation thread and only read afterwards.
+/// </summary>
+struct FramePacket
+{
+	//input
+	unsigned int technique;
+	Matrices matrices;
+	glm::vec3 cameraPosition;
+	float nearPlane;
+	float projectionScale;			//viewport height / (2 * tan(fovy / 2))
+	Lights lights;
+	bool minMaxPass;
+	bool frustumCulling;
+	bool occlusionCulling;
+	int pinnedLod;
+	float lodPixelError;
+	GridSnapshotWriter *snapshotWriter;	//grid input is written by render thread once grid is complete
+	unsigned long long inputTicks;	//PerformanceTimer ticks when input was captured
+
+	//produced by simulation
+	std::vector<unsigned int> visibleMeshes;
+	std::vector<unsigned int> lods;	//levels of detail of visible meshes
+	unsigned int drawsFrustumCulled;
+	unsigned int drawsOcclusionCulled;
+	unsigned int trianglesSubmitted;
+	LightGrid grid;
+	std::vector<MinMax> tileDepthRanges;
+	bool gridBuilt;					//FALSE = grid needs min/max depth of frame and is built by render thread
+	double gridBuildMs;
+};
+
+FramePacket immediatePacket;				//frame of single threaded Render()
+FramePipeline<FramePacket> *framePipeline = NULL;	//simulation thread, NULL = frames are rendered by Render()
 
-LightGrid lightgrid;
+FrameStatistics frameStats;
+
+//asynchronous texture loading
+TextureLoader *textureLoader = NULL;
+TextureStreamer *textureStreamer = NULL;	//mipmap streaming, NULL = textures loaded whole
+bool texturesResident = false;
 
 #pragma region Framebuffers
 GLuint minMaxDepthFbo;	//minMax downsample framebuffer
 GLuint forwardFbo;		//forward framebuffer
 #pragma endregion Framebuffers
 
-#pragma region Queries
-GLuint minMaxDepthQuery;
-GLuint minMaxDepthQueryTime = 0;
-
-GLuint lightingQuery;
-GLuint lightingQueryTime;
-#pragma endregion Queries
-
 #pragma region Textures
 GLuint gTexDiffuse, gTexNormal, gTexPos, gTexDepth, gTexSpec, gTexAmbient, depthTex; // G-Buffer Textures
 GLuint forwardTex;
@@ -179,6 +280,27 @@ std::string NVIDIAtechniqueNames[NVIDIA_Max] =
 #pragma endregion GLOBAL_VARIABLES
 
 
+/// <summary>
+/// Seconds since application start, GLFW timer is not available without
+/// window in offscreen mode.
+/// </summary>
+/// <returns>seconds</returns>
+static double getTime()
+{
+	return PerformanceTimer::ticksToSeconds(PerformanceTimer::getTickCount() - startTicks);
+}
+
+
+/// <summary>
+/// Determines whether main loop should end.
+/// </summary>
+/// <returns>true if window was closed or frames of offscreen mode were rendered</returns>
+static bool shouldClose()
+{
+	return closeRequested || (win != NULL && glfwWindowShouldClose(win));
+}
+
+
 /// <summary>
 /// Updates transformation matrices.
 /// </summary>
@@ -193,42 +315,573 @@ static void updateMatrices()
 
 
 /// <summary>
-/// Point lights matrices initialization, creates model matrix for sphere mesh,
-/// translate to light's world position, scale to light's radius size
+/// Uploads decoded textures within per-frame budget and reports when scene
+/// textures become fully resident.
+/// </summary>
+static void updateTextureStreaming()
+{
+	PROFILE_FUNCTION();
+
+	if (!textureLoader)
+	{
+		return;
+	}
+
+	//levels requested by previous frame
+	if (textureStreamer)
+	{
+		textureStreamer->update(TEXTURE_STREAMING_REQUESTS);
+		frameStats.streamedTextureMB = textureStreamer->getResidentBytes() / (1024.0f * 1024.0f);
+	}
+
+	if (textureLoader->getPendingCount() > 0)
+	{
+		textureLoader->update(TEXTURE_UPLOAD_BUDGET_MS);
+	}
+
+	if (!texturesResident)
+	{
+		m_pMesh->updateTextures();
+
+		if (textureLoader->getPendingCount() == 0)
+		{
+			texturesResident = true;
+			printf("Textures resident after %.2f s\n", getTime());
+		}
+	}
+}
+
+
+/// <summary>
+/// Captures camera, lights and settings of next frame.
 /// </summary>
-static void initLightSpheres(unsigned count)
+/// <param name="packet">frame packet to fill.</param>
+static void captureFrameInput(FramePacket &packet)
 {
-	for (unsigned i = 0; i < count; i++)
+	//update transformation matrices
+	updateMatrices();
+
+	packet.technique = technique;
+	packet.matrices = transformationMatrices;
+	packet.cameraPosition = gCamera.position();
+	packet.nearPlane = gCamera.nearPlane();
+	packet.projectionScale = resolution.y / (2.0f * tanf(glm::radians(gCamera.fov()) * 0.5f));
+	packet.lights = pointLights;
+	packet.minMaxPass = minMaxPass;
+	packet.frustumCulling = frustumCulling;
+	packet.occlusionCulling = occlusionCulling;
+	packet.pinnedLod = pinnedLod;
+	packet.lodPixelError = lodPixelError;
+	packet.snapshotWriter = gridSnapshots.isOpen() ? &gridSnapshots : NULL;
+	packet.inputTicks = PerformanceTimer::getTickCount();
+}
+
+
+/// <summary>
+/// Builds list of visible scene submeshes of frame. The list is shared by
+/// depth prepass, G-buffer pass and tiled forward pass.
+/// </summary>
+/// <param name="packet">frame packet.</param>
+static void cullScene(FramePacket &packet)
+{
+	PROFILE_FUNCTION();
+
+	std::vector<unsigned int> &visible = packet.visibleMeshes;
+	unsigned int drawsTotal = m_pMesh->getMeshEntriesCount();
+
+	if (packet.frustumCulling)
+	{
+		frustumCuller.cull(packet.matrices.viewProjection, visible);
+	}
+	else
+	{
+		visible.resize(drawsTotal);
+
+		for (unsigned int i = 0; i < drawsTotal; i++)
+		{
+			visible[i] = i;
+		}
+	}
+
+	packet.drawsFrustumCulled = drawsTotal - (unsigned int)visible.size();
+	packet.drawsOcclusionCulled = 0;
+
+	//occluders are rasterized on CPU, frustum survivors are tested against them
+	if (packet.occlusionCulling && occlusionCuller->getOccluderTriangleCount() > 0)
+	{
+		occlusionCuller->renderOccluders(packet.matrices.viewProjection);
+		occlusionCuller->cull(meshBounds, visible);
+
+		packet.drawsOcclusionCulled = occlusionCuller->getCulledCount();
+	}
+
+	//draws sharing texture bindings are submitted together
+	m_pMesh->sortDrawList(visible);
+
+	//levels of detail of visible submeshes, shared by all passes to keep depth consistent
+	packet.trianglesSubmitted = m_pMesh->computeLods(packet.cameraPosition, packet.projectionScale, packet.lodPixelError, packet.pinnedLod, &visible, packet.lods);
+}
+
+
+/// <summary>
+/// Builds light grid of frame from its lights and tile depth ranges.
+/// </summary>
+/// <param name="packet">frame packet.</param>
+static void buildFrameGrid(FramePacket &packet)
+{
+	packet.grid.setThreadPool(&ThreadPool::shared());
+
+	if (packet.lights.size() > 0)
+	{
+		packet.grid.buildLightGrid(packet.tileDepthRanges, packet.lights, packet.nearPlane, packet.matrices.view, packet.matrices.projection);
+	}
+	else
 	{
-		lightSpheres[i] = glm::scale(glm::translate(glm::mat4(), pointLights[i].position), glm::vec3(pointLights[i].radius));
+		//packets are reused, lists of older frame are dropped
+		packet.grid.resize(packet.grid.getResolution(), packet.grid.getTileSize());
+	}
+
+	packet.gridBuilt = true;
+}
+
+
+/// <summary>
+/// Simulation part of frame: culling, levels of detail and light grid unless
+/// it depends on min/max depth of the frame. Runs on simulation thread, it
+/// reads only packet and scene state changed after FramePipeline::wait().
+/// </summary>
+/// <param name="packet">frame packet with captured input.</param>
+static void produceFrame(FramePacket &packet)
+{
+	PerformanceTimer cullTimer;
+	cullTimer.start();
+	cullScene(packet);
+	cullTimer.stop();
+	cpuPhases[CP_Culling].record(cullTimer.getElapsedNanoseconds());
+
+	packet.gridBuilt = false;
+	packet.gridBuildMs = 0.0;
+	packet.tileDepthRanges.clear();
+
+	if ((packet.technique == AMD_TiledDeferred || packet.technique == AMD_TiledForward) && !packet.minMaxPass)
+	{
+		PerformanceTimer gridTimer;
+		gridTimer.start();
+		buildFrameGrid(packet);
+		gridTimer.stop();
+
+		packet.gridBuildMs = gridTimer.getElapsedTime() * 1000.0;
+		cpuPhases[CP_GridBuild].record(gridTimer.getElapsedNanoseconds());
 	}
 }
 
 
 /// <summary>
-/// Generates lights and their model matrices for deferred shading.
+/// Thread pool hook, jobs are shown in zone trace and their durations are
+/// collected with CPU phases.
+/// </summary>
+/// <param name="name">job name.</param>
+/// <param name="beginTicks">PerformanceTimer ticks at job start.</param>
+/// <param name="endTicks">PerformanceTimer ticks at job end.</param>
+static void profileJob(const char *name, unsigned long long beginTicks, unsigned long long endTicks)
+{
+	ZoneProfiler::record(name, beginTicks, endTicks);
+	cpuPhases[CP_Job].record(PerformanceTimer::ticksToNanoseconds(endTicks - beginTicks));
+}
+
+
+/// <summary>
+/// Waits until simulation thread finishes submitted frames, so scene state
+/// it reads (instances, culling bounds) can be changed.
+/// </summary>
+static void waitForSimulation()
+{
+	if (framePipeline)
+	{
+		framePipeline->wait();
+	}
+}
+
+
+/// <summary>
+/// Sets camera to state of camera track at given frame. Track time advances by
+/// 1 / CAMERA_PLAYBACK_FPS per frame regardless of frame duration, so every
+/// run renders the same views. Track is looped.
+/// </summary>
+/// <param name="frame">frame since start of playback.</param>
+static void playCameraTrack(unsigned int frame)
+{
+	double duration = cameraTrack.getDuration();
+	double time = frame / CAMERA_PLAYBACK_FPS;
+
+	CameraKeyframe keyframe = cameraTrack.sample(duration > 0.0 ? (float)fmod(time, duration) : 0.0f);
+
+	gCamera.setPosition(keyframe.position);
+	gCamera.setAngles(keyframe.hAngle, keyframe.vAngle);
+}
+
+
+/// <summary>
+/// Appends current camera state to recorded track.
+/// </summary>
+static void recordCameraKeyframe()
+{
+	CameraKeyframe keyframe;
+	keyframe.time = (float)cameraRecordTime;
+	keyframe.position = gCamera.position();
+	keyframe.hAngle = gCamera.horizontalAngle();
+	keyframe.vAngle = gCamera.verticalAngle();
+
+	cameraTrack.addKeyframe(keyframe);
+}
+
+
+/// <summary>
+/// Places instances of scene mesh to scene graph. Submesh bounds used for
+/// culling enclose all instances, so they are refreshed as well.
+/// </summary>
+/// <param name="instances">model matrices of scene mesh copies.</param>
+static void applySceneInstances(const std::vector<glm::mat4> &instances)
+{
+	sceneGraph.clear();
+
+	int root = sceneGraph.addNode(NULL, glm::mat4());
+
+	for (unsigned int i = 0; i < instances.size(); i++)
+	{
+		sceneGraph.addNode(m_pMesh, instances[i], root);
+	}
+
+	sceneGraph.update();
+
+	frameStats.instances = sceneGraph.getInstanceCount();
+
+	m_pMesh->getBounds(meshBounds);
+	frustumCuller.setBounds(meshBounds);
+}
+
+
+/// <summary>
+/// Restarts animation from current state of scene lights.
+/// </summary>
+static void resetLightAnimation()
+{
+	lightAnimator.setLights(pointLights, scenarioGenerator->getSceneBounds(sceneInstances), scenarioDesc.seed);
+	lightAnimationTime = 0.0;
+}
+
+
+/// <summary>
+/// Moves animated lights to given time. Only animated range of lights is
+/// rewritten, render passes get lights by frame packet.
+/// </summary>
+/// <param name="time">seconds of animation.</param>
+static void animateLights(double time)
+{
+	lightAnimator.update((float)time, pointLights, &ThreadPool::shared());
+}
+
+
+/// <summary>
+/// Sets scene lights.
+/// </summary>
+/// <param name="lights">generated or loaded lights, only MAX_LIGHTS are used.</param>
+static void applyLights(const Lights &lights)
+{
+	unsigned count = std::min((unsigned)lights.size(), (unsigned)MAX_LIGHTS);
+
+	pointLights.assign(lights.begin(), lights.begin() + count);
+
+	//update light count
+	LIGHT_COUNT = count;
+
+	resetLightAnimation();
+}
+
+
+/// <summary>
+/// Generates lights of current scenario.
 /// </summary>
 /// <param name="count">lights' count.</param>
 /// <param name="min">minimal radius.</param>
 /// <param name="max">maximal radius.</param>
 static void generateLights(unsigned short count, float min, float max)
 {
-	pointLights.resize(count);
+	scenarioDesc.lightCount = count;
+	scenarioDesc.radiusMin = min;
+	scenarioDesc.radiusMax = max;
+
+	Lights lights;
+	scenarioGenerator->generateLights(scenarioDesc, sceneInstances, lights);
 
-	for (unsigned i = 0; i < count; i++)
+	applyLights(lights);
+}
+
+
+/// <summary>
+/// Regenerates layout and lights after change of scenario parameters.
+/// </summary>
+static void regenerateScenario()
+{
+	//instance bounds are read by culling
+	waitForSimulation();
+
+	scenarioGenerator->generateLayout(scenarioDesc, sceneInstances);
+	applySceneInstances(sceneInstances);
+
+	generateLights(scenarioDesc.lightCount, scenarioDesc.radiusMin, scenarioDesc.radiusMax);
+}
+
+
+/// <summary>
+/// Tweakbar setter of scenario parameter, whole scenario is regenerated.
+/// </summary>
+/// <param name="value">new value.</param>
+/// <param name="clientData">pointer to 32-bit parameter in scenarioDesc.</param>
+static void TW_CALL setScenarioParamCB(const void *value, void *clientData)
+{
+	memcpy(clientData, value, sizeof(unsigned int));
+
+	regenerateScenario();
+}
+
+
+/// <summary>
+/// Tweakbar getter of scenario parameter.
+/// </summary>
+/// <param name="value">current value.</param>
+/// <param name="clientData">pointer to 32-bit parameter in scenarioDesc.</param>
+static void TW_CALL getScenarioParamCB(void *value, void *clientData)
+{
+	memcpy(value, clientData, sizeof(unsigned int));
+}
+
+
+/// <summary>
+/// Copies CPU percentiles of frame phases to frame statistics.
+/// </summary>
+static void updateCpuStatistics()
+{
+	for (unsigned int p = 0; p < CP_Max; p++)
 	{
-		pointLights[i].color = glm::vec3(randf(0.0, 1.0), randf(0.0, 1.0), randf(0.0, 1.0));
-		pointLights[i].radius = randf(min, max);
+		SampleSummary summary = cpuPhases[p].summarize();
 
-		//replace values in randf for another scene boundaries
-		pointLights[i].position = glm::vec3(randf(-1750.0, 1750.0), randf(0.0, 1550.0), randf(-1000.0, 1000.0));
+		frameStats.cpuP50Ms[p] = (float)summary.p50Ms;
+		frameStats.cpuP99Ms[p] = (float)summary.p99Ms;
 	}
+}
 
-	//initialize sphere models to light pos for deferred shading
-	initLightSpheres(count);
 
-	//update light count
-	LIGHT_COUNT = count;
+/// <summary>
+/// Tweakbar button removing collected CPU samples.
+/// </summary>
+/// <param name="clientData">unused.</param>
+static void TW_CALL resetCpuStatisticsCB(void *clientData)
+{
+	for (unsigned int p = 0; p < CP_Max; p++)
+	{
+		cpuPhases[p].reset();
+	}
+
+	updateCpuStatistics();
+}
+
+
+/// <summary>
+/// Writes zones recorded by CPU zone profiler to ZONE_TRACE_FILE.
+/// </summary>
+static void saveTrace()
+{
+	if (ZoneProfiler::writeTrace(ZONE_TRACE_FILE))
+		printf("Trace saved to %s\n", ZONE_TRACE_FILE);
+	else
+		printf("Trace: could not save %s\n", ZONE_TRACE_FILE);
+}
+
+
+/// <summary>
+/// Tweakbar button saving trace of CPU zones.
+/// </summary>
+/// <param name="clientData">unused.</param>
+static void TW_CALL saveTraceCB(void *clientData)
+{
+	saveTrace();
+}
+
+
+/// <summary>
+/// Gets input of light grid build of frame.
+/// </summary>
+/// <param name="packet">frame with built light grid.</param>
+/// <param name="input">output grid input.</param>
+static void getGridInput(const FramePacket &packet, GridInput &input)
+{
+	input.resolution = packet.grid.getResolution();
+	input.tileSize = packet.grid.getTileSize();
+	input.nearPlane = packet.nearPlane;
+	input.view = packet.matrices.view;
+	input.projection = packet.matrices.projection;
+	input.lights = packet.lights;
+	input.tileDepthRanges = packet.tileDepthRanges;
+}
+
+
+/// <summary>
+/// Saves input of light grid build to GRID_INPUT_FILE.
+/// </summary>
+/// <param name="packet">frame with built light grid.</param>
+static void captureGridInput(const FramePacket &packet)
+{
+	GridInput input;
+	getGridInput(packet, input);
+
+	if (saveGridInput(GRID_INPUT_FILE, input))
+		printf("Grid input: %u lights saved to %s\n", (unsigned int)packet.lights.size(), GRID_INPUT_FILE);
+	else
+		printf("Grid input: could not save %s\n", GRID_INPUT_FILE);
+
+	gridInputRequested = false;
+}
+
+
+/// <summary>
+/// Reads G-buffer and result of tiled deferred light pass back, shades the
+/// same G-buffer by CPU reference and saves both images to PFM files.
+/// </summary>
+/// <param name="grid">light grid used by light pass.</param>
+static void compareReferenceShading(const LightGrid &grid)
+{
+	PROFILE_FUNCTION();
+
+	referenceShadingRequested = false;
+
+	glm::uvec2 size = glm::uvec2(resolution);
+	std::vector<glm::vec4> texels(size.x * size.y);
+
+	ShadingGBuffer gBuffer;
+	ShadingImage gpuImage;
+	ShadingImage cpuImage;
+
+	resizeGBuffer(gBuffer, size);
+	resizeImage(gpuImage, size);
+
+	//G-buffer textures in order of GBUFFER_TEXTURE_TYPE, light pass writes to ambient texture
+	std::vector<float> *planes[GBuffer::GBUFFER_NUM_TEXTURES] = { gBuffer.diffuse, gBuffer.normal, gBuffer.position, gBuffer.specular, gpuImage.color };
+
+	for (unsigned int t = 0; t < GBuffer::GBUFFER_NUM_TEXTURES; t++)
+	{
+		glBindTexture(GL_TEXTURE_2D, gBuf->getTex(t));
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, &texels[0]);
+
+		for (unsigned int i = 0; i < texels.size(); i++)
+		{
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				planes[t][c][i] = texels[i][c];
+			}
+		}
+
+		//shininess is stored in alpha of specular texture
+		if (t == GBuffer::GBUFFER_TEX_SPEC)
+		{
+			for (unsigned int i = 0; i < texels.size(); i++)
+			{
+				gBuffer.shininess[i] = texels[i].w;
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	PerformanceTimer timer;
+	timer.start();
+	shadeTiledDeferred(gBuffer, grid, cpuImage, &ThreadPool::shared());
+	timer.stop();
+
+	ImageDifference difference;
+	compareImages(cpuImage, gpuImage, difference);
+
+	printf("Reference shading: %.2f ms on CPU (%s), max difference %g, mean %g, %u pixels not finite\n", timer.getElapsedTime() * 1000.0,
+		isSimdShadingAvailable() ? "AVX2" : "scalar", difference.maxError, difference.meanError, difference.nonFinite);
+
+	std::string prefix = REFERENCE_SHADING_PREFIX;
+
+	if (!saveImagePfm(prefix + "_cpu.pfm", cpuImage) || !saveImagePfm(prefix + "_gpu.pfm", gpuImage))
+	{
+		printf("Reference shading: could not save %s_cpu.pfm / %s_gpu.pfm\n", prefix.c_str(), prefix.c_str());
+	}
+}
+
+
+/// <summary>
+/// Starts capture of light grid inputs of every frame.
+/// </summary>
+/// <param name="filename">snapshot stream file.</param>
+static void startGridSnapshots(const std::string &filename)
+{
+	//writer is used only by render thread, frames captured from next input
+	if (gridSnapshots.open(filename))
+	{
+		printf("Grid snapshots: capturing to %s\n", filename.c_str());
+	}
+	else
+	{
+		printf("Grid snapshots: could not create %s\n", filename.c_str());
+	}
+}
+
+
+/// <summary>
+/// Stops capture of light grid inputs.
+/// </summary>
+static void stopGridSnapshots()
+{
+	if (!gridSnapshots.isOpen())
+	{
+		return;
+	}
+
+	//frames in flight skip closed writer
+	gridSnapshots.close();
+
+	printf("Grid snapshots: %u frames, %.2f MB\n", gridSnapshots.getFrameCount(), gridSnapshots.getBytesWritten() / (1024.0 * 1024.0));
+}
+
+
+/// <summary>
+/// Renders lights' bounding quads.
+/// - for debugging purposes
+/// - uses deprecated functions, wont work with core profile
+/// </summary>
+/// <param name="grid">light grid with bounding quads of last build.</param>
+static void showLightQuads(const LightGrid &grid)
+{
+	const std::vector<BoundingBox> &quads = grid.getBoundingQuads();
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0.0, float(resolution.x), 0.0, float(resolution.y), -1.0, 1.0);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+
+	for (unsigned int i = 0; i < quads.size(); i++)
+	{
+		glBegin(GL_LINE_STRIP);
+
+			glColor4f(1.0, 1.0, 1.0, 1.0f);
+
+			glVertex2f(float(quads[i].min.x), float(quads[i].min.y));
+			glVertex2f(float(quads[i].max.x), float(quads[i].min.y));
+			glVertex2f(float(quads[i].max.x), float(quads[i].max.y));
+			glVertex2f(float(quads[i].min.x), float(quads[i].max.y));
+			glVertex2f(float(quads[i].min.x), float(quads[i].min.y));
+
+		glEnd();
+	}
+
+	glPopAttrib();
 }
 
 
@@ -270,6 +923,32 @@ static void keyCallback(GLFWwindow* window, int key, int scancode, int action, i
 	{
 		switch (key)
 		{
+			//save Chrome trace of CPU zones
+			case GLFW_KEY_F12:
+				saveTrace();
+				break;
+
+			//save input of next light grid build for tools/gridbench
+			case GLFW_KEY_F11:
+				gridInputRequested = true;
+				break;
+
+			//compare next tiled deferred light pass with CPU reference
+			case GLFW_KEY_F9:
+				if (technique == AMD_TiledDeferred)
+					referenceShadingRequested = true;
+				else
+					printf("Reference shading: switch to tiled deferred shading first\n");
+				break;
+
+			//start/stop capture of light grid inputs of every frame
+			case GLFW_KEY_F10:
+				if (gridSnapshots.isOpen())
+					stopGridSnapshots();
+				else
+					startGridSnapshots(GRID_SNAPSHOT_FILE);
+				break;
+
 			//increase camera movement speed
 			case GLFW_KEY_KP_ADD:
 				moveSpeed += 100.0;
@@ -359,12 +1038,60 @@ static void keyCallback(GLFWwindow* window, int key, int scancode, int action, i
 				for (unsigned int i = 0; i < pointLights.size(); i++){
 					pointLights[i].color = glm::vec3(randf(0.0, 1.0), randf(0.0, 1.0), randf(0.0, 1.0));
 				}
+				//animated lights keep their base positions and time, only colors change
+				lightAnimator.setColors(pointLights);
+				break;
+
+			//start/stop light animation
+			case GLFW_KEY_L:
+				lightAnimation = !lightAnimation;
 				break;
 
 			//generate new colors for existing lights
 			case GLFW_KEY_J:
 				showLightHeatMap = !showLightHeatMap;
 				break;
+
+			//start/stop camera track recording, track is saved when recording stops
+			case GLFW_KEY_C:
+			{
+				if (cameraPlayback)
+				{
+					break;
+				}
+
+				cameraRecording = !cameraRecording;
+
+				if (cameraRecording)
+				{
+					cameraTrack.clear();
+					cameraRecordTime = 0.0;
+					recordCameraKeyframe();
+				}
+				else
+				{
+					//keyframe at the end unless recorded in the same frame
+					cameraRecordTime += 1.0 / CAMERA_PLAYBACK_FPS;
+					recordCameraKeyframe();
+
+					if (cameraTrack.save(cameraTrackFile))
+						printf("Camera track: %u keyframes (%.2f s) saved to %s\n", cameraTrack.getKeyframeCount(), cameraTrack.getDuration(), cameraTrackFile.c_str());
+					else
+						printf("Camera track: could not save %s\n", cameraTrackFile.c_str());
+				}
+			}
+			break;
+
+			//start/stop camera track playback
+			case GLFW_KEY_P:
+			{
+				if (!cameraRecording && !cameraTrack.empty())
+				{
+					cameraPlayback = !cameraPlayback;
+					cameraPlaybackFrame = 0;
+				}
+			}
+			break;
 			}
 	}
 }
@@ -413,6 +1140,8 @@ static void KeyFunCB(GLFWwindow* window, int key, int scancode, int action, int
 /// <param name="grid">The grid.</param>
 static void bindGridBuffers(LightGrid &grid)
 {
+	PROFILE_FUNCTION();
+
 	glm::ivec4 countsAndOffsets[TILES_COUNT];
 	glm::vec4 posAndRadiuses[MAX_LIGHTS];
 	glm::vec4 colors[MAX_LIGHTS];
@@ -591,8 +1320,8 @@ static void depthPrePass()
 		//set the model view projection uniform
 		simpleShader->setUniform("MVP", transformationMatrices.viewProjection);
 
-		//render meshes
-		m_pMesh->RenderSimple();
+		//render visible meshes
+		m_pMesh->RenderSimple(&visibleMeshes);
 
 	//unbind shader program
 	simpleShader->stopUsing();
@@ -608,6 +1337,8 @@ static void depthPrePass()
 /// <param name="tileDepthRanges">vector to store downsampled values.</param>
 static void calcMinMaxDepth(std::vector<MinMax> &tileDepthRanges)
 {
+	PROFILE_FUNCTION();
+
 	glBindFramebuffer(GL_FRAMEBUFFER, minMaxDepthFbo);
 
 	//clear color buffer
@@ -633,8 +1364,8 @@ static void calcMinMaxDepth(std::vector<MinMax> &tileDepthRanges)
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 	glReadPixels(0, 0, grid_size.x, grid_size.y, GL_RG, GL_FLOAT, &tileDepthRanges[0]);
 
-	//bind default fbo and restore viewport
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	//bind output fbo (window or offscreen) and restore viewport
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
 	glViewport(0, 0, resolution.x, resolution.y);
 }
 
@@ -658,7 +1389,7 @@ void DSgeometryPass()
 		mrt->setUniform("view", transformationMatrices.view);
 		mrt->setUniform("model", glm::mat4());
 
-		m_pMesh->Render(mrt->object());
+		m_pMesh->Render(mrt->object(), &visibleMeshes);
 
 	mrt->stopUsing();
 
@@ -670,8 +1401,10 @@ void DSgeometryPass()
 /// <summary>
 /// Lighting pass of deferred shading.
 /// -	applies lights to textures from Gbuffer
+/// -	sphere mesh is translated to light's position and scaled to its radius
 /// </summary>
-void DSlightPass()
+/// <param name="lights">lights of rendered frame.</param>
+void DSlightPass(const Lights &lights)
 {
 	//shading pass
 	gBuf->bindForLightPass();
@@ -684,16 +1417,16 @@ void DSlightPass()
 	deferredShader->use();
 
 		//set transformation positions
-		for (unsigned int i = 0; i < pointLights.size(); i++)
+		for (unsigned int i = 0; i < lights.size(); i++)
 		{
-
-			glm::vec4 posRad = transformationMatrices.view * (glm::vec4(pointLights[i].position, 1.0));
-			posRad.w = pointLights[i].radius;
-			glm::mat4 MVP = transformationMatrices.viewProjection * lightSpheres[i];
+			glm::vec4 posRad = transformationMatrices.view * (glm::vec4(lights[i].position, 1.0));
+			posRad.w = lights[i].radius;
+			glm::mat4 model = glm::scale(glm::translate(glm::mat4(), lights[i].position), glm::vec3(lights[i].radius));
+			glm::mat4 MVP = transformationMatrices.viewProjection * model;
 
 			deferredShader->setUniform("MVP", MVP);
 			deferredShader->setUniform("light.positionRadius", posRad);
-			deferredShader->setUniform("light.color", glm::vec3(pointLights[i].color));
+			deferredShader->setUniform("light.color", glm::vec3(lights[i].color));
 
 			m_sphere->Render(deferredShader->object());
 		}
@@ -740,17 +1473,72 @@ static void TDSlightPass()
 
 
 /// <summary>
-/// Rendering function. Uses specific method of shading based on chosen parameters.
+/// Builds light grid of frame after min/max depth readback (if simulation
+/// could not build it) and saves grid input if requested. Snapshots are
+/// written here for both threads' builds, so frames are written in order by
+/// single thread regardless of min/max depth setting.
 /// </summary>
-static void Render()
+/// <param name="packet">frame packet.</param>
+static void completeFrameGrid(FramePacket &packet)
 {
-	//update transformation matrices
-	updateMatrices();
+	if (!packet.gridBuilt)
+	{
+		PerformanceTimer gridTimer;
+		gridTimer.start();
 
-	//timer for light grid build
-	PerformanceTimer gridTimer;
+		gpuProfiler.begin(GP_MinMaxDepth);
+		calcMinMaxDepth(packet.tileDepthRanges);
+		gpuProfiler.end(GP_MinMaxDepth);
 
-	switch(technique)
+		buildFrameGrid(packet);
+		gridTimer.stop();
+
+		packet.gridBuildMs = gridTimer.getElapsedTime() * 1000.0;
+		cpuPhases[CP_GridBuild].record(gridTimer.getElapsedNanoseconds());
+	}
+
+	if (packet.snapshotWriter != NULL && packet.lights.size() > 0)
+	{
+		GridInput input;
+		getGridInput(packet, input);
+
+		packet.snapshotWriter->write(input, packet.grid.computeChecksum());
+	}
+
+	if (gridInputRequested)
+	{
+		captureGridInput(packet);
+	}
+}
+
+
+/// <summary>
+/// Rendering function. Uses specific method of shading based on parameters
+/// captured in frame packet.
+/// </summary>
+/// <param name="packet">frame produced by simulation.</param>
+static void renderFrame(FramePacket &packet)
+{
+	PROFILE_FUNCTION();
+
+	//passes draw global draw list with matrices of the frame
+	transformationMatrices = packet.matrices;
+	visibleMeshes = packet.visibleMeshes;
+	m_pMesh->applyLods(packet.lods, &visibleMeshes);
+
+	frameStats.drawsTotal = m_pMesh->getMeshEntriesCount();
+	frameStats.drawsVisible = (unsigned int)visibleMeshes.size();
+	frameStats.drawsFrustumCulled = packet.drawsFrustumCulled;
+	frameStats.drawsOcclusionCulled = packet.drawsOcclusionCulled;
+	frameStats.trianglesSubmitted = packet.trianglesSubmitted;
+
+	//streamer is not thread safe, levels are requested by render thread
+	if (textureStreamer)
+	{
+		m_pMesh->streamTextures(packet.cameraPosition, packet.projectionScale, *textureStreamer, &visibleMeshes);
+	}
+
+	switch(packet.technique)
 	{
 		//simple shading with no lights
 		#pragma region SIMPLE_SHADING
@@ -758,23 +1546,27 @@ static void Render()
 		{
 			glEnable(GL_DEPTH_TEST);
 			
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
 			
 			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 				
+			gpuProfiler.begin(GP_Lighting);
+
 			//bind Multiple Render Targets shader program
 			simpleShader->use();
 
 				//set the model view projection uniform
 				simpleShader->setUniform("MVP", transformationMatrices.viewProjection);
 
-				//render meshes
-				m_pMesh->RenderSimple();
+				//render visible meshes
+				m_pMesh->RenderSimple(&visibleMeshes);
 
 			//unbind shader program
 			simpleShader->stopUsing();
 
+			gpuProfiler.end(GP_Lighting);
+
 			glDisable(GL_DEPTH_TEST);
 		}
 		break;
@@ -788,24 +1580,31 @@ static void Render()
 			gBuf->clearTextures();
 
 			//1st pass
+			gpuProfiler.begin(GP_GBuffer);
 			DSgeometryPass();
+			gpuProfiler.end(GP_GBuffer);
 
 			//2nd pass
-			DSlightPass();
+			gpuProfiler.begin(GP_Lighting);
+			DSlightPass(packet.lights);
+			gpuProfiler.end(GP_Lighting);
+
+			gpuProfiler.begin(GP_Blit);
 
 			//set texture for final output
-			gBuf->bindForFinalPass(gBufTexIndex);
+			gBuf->bindForFinalPass(gBufTexIndex, outputFramebuffer);
 			glBlitFramebuffer(0, 0, resolution.x, resolution.y, 0, 0, resolution.x, resolution.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
 			//render G-buffer textures to main FBO
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
 
 			//if enabled render G-buffer textures to quads
 			if (showMRTQuads)
 			{
 				showMRT();
 			}
-			
+
+			gpuProfiler.end(GP_Blit);
 		}
 		break;
 		#pragma endregion DEFERRED_SHADING
@@ -818,32 +1617,20 @@ static void Render()
 			gBuf->clearTextures();
 
 			//1st pass
+			gpuProfiler.begin(GP_GBuffer);
 			DSgeometryPass();
+			gpuProfiler.end(GP_GBuffer);
 
-			//start grid build timer 
-			//gridTimer.start();
-				std::vector<MinMax> tileDepthRanges;
-
-				if (minMaxPass)
-				{
-					//glBeginQuery(GL_TIME_ELAPSED, minMaxDepthQuery);
-					calcMinMaxDepth(tileDepthRanges);
-					//glEndQuery(GL_TIME_ELAPSED);
-					//glGetQueryObjectuiv(minMaxDepthQuery, GL_QUERY_RESULT_NO_WAIT, &minMaxDepthQueryTime);
-				}
-
-				//build light grid
-				if (pointLights.size() > 0)
-				{
-					lightgrid.buildLightGrid(tileDepthRanges, pointLights, gCamera.nearPlane(), transformationMatrices.view, transformationMatrices.projection);
-				}
-			//gridTimer.stop();
+			//light grid needing min/max depth of G-buffer
+			completeFrameGrid(packet);
 			
 			//bind G-Buffer
 			glBindFramebuffer(GL_FRAMEBUFFER, gBuf->getFramebufferID());
 
 			//bind Uniform buffers
-			bindGridBuffers(lightgrid);
+			bindGridBuffers(packet.grid);
+
+			gpuProfiler.begin(GP_Lighting);
 
 			//render light heat map/affected tiles/lighting
 			if (showLightHeatMap)
@@ -856,25 +1643,31 @@ static void Render()
 			}
 			else
 			{
-				//glBeginQuery(GL_TIME_ELAPSED, lightingQuery);
-
 				//2nd pass
 				TDSlightPass();
+			}
+
+			gpuProfiler.end(GP_Lighting);
 
-				//glEndQuery(GL_TIME_ELAPSED);
-				//glGetQueryObjectuiv(lightingQuery, GL_QUERY_RESULT_NO_WAIT, &lightingQueryTime);
+			if (referenceShadingRequested && !showLightHeatMap && !showAffectedTiles)
+			{
+				compareReferenceShading(packet.grid);
 			}
 
 			//unbind light's ID tex
 			glActiveTexture(GL_TEXTURE0 + TDTB_LightIndex);
 			glBindTexture(GL_TEXTURE_BUFFER, 0);
 
+			gpuProfiler.begin(GP_Blit);
+
 			//set texture for final output
-			gBuf->bindForFinalPass(gBufTexIndex);
+			gBuf->bindForFinalPass(gBufTexIndex, outputFramebuffer);
 			glBlitFramebuffer(0, 0, resolution.x, resolution.y, 0, 0, resolution.x, resolution.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
 			//final pass
 			showMRT();
+
+			gpuProfiler.end(GP_Blit);
 		}
 		break;
 		#pragma endregion TILED_DEFERRED_SHADING
@@ -885,29 +1678,13 @@ static void Render()
 		{
 			glEnable(GL_DEPTH_TEST);
 
-			//do depth pre pass
-			depthPrePass();
-
-			//gridTimer.start();
-				std::vector<MinMax> tileDepthRanges;
-
-				//depth optimization
-				if (minMaxPass)
-				{
-					//glBeginQuery(GL_TIME_ELAPSED, minMaxDepthQuery);
-					
-					calcMinMaxDepth(tileDepthRanges);
-					
-					//glEndQuery(GL_TIME_ELAPSED);
-					//glGetQueryObjectuiv(minMaxDepthQuery, GL_QUERY_RESULT_NO_WAIT, &minMaxDepthQueryTime);
-				}
+			//do depth pre pass
+			gpuProfiler.begin(GP_DepthPrepass);
+			depthPrePass();
+			gpuProfiler.end(GP_DepthPrepass);
 
-				//build lightgrid
-				if (pointLights.size() > 0)
-				{
-					lightgrid.buildLightGrid(tileDepthRanges, pointLights, gCamera.nearPlane(), transformationMatrices.view, transformationMatrices.projection);
-				}
-			//gridTimer.stop();
+			//depth optimization, light grid needing min/max depth of prepass
+			completeFrameGrid(packet);
 
 			//Bind forward FBO
 			glBindFramebuffer(GL_FRAMEBUFFER, forwardFbo);
@@ -918,7 +1695,9 @@ static void Render()
 			glViewport(0, 0, resolution.x, resolution.y);
 			
 			//Bind uniform buffers
-			bindGridBuffers(lightgrid);
+			bindGridBuffers(packet.grid);
+
+			gpuProfiler.begin(GP_Lighting);
 
 			if (showLightHeatMap)
 			{
@@ -930,35 +1709,36 @@ static void Render()
 			}
 			else
 			{
-				//glBeginQuery(GL_TIME_ELAPSED, lightingQuery);
-				
 				//render scene
 				tiledForwardShader->use();
 					tiledForwardShader->setUniform("viewProjection", transformationMatrices.viewProjection);
 					tiledForwardShader->setUniform("view", transformationMatrices.view);
 					tiledForwardShader->setUniform("normalMatrix", transformationMatrices.normal);
 
-					m_pMesh->Render(tiledForwardShader->object());
+					m_pMesh->Render(tiledForwardShader->object(), &visibleMeshes);
 				tiledForwardShader->stopUsing();
-
-				//glEndQuery(GL_TIME_ELAPSED);
-				//glGetQueryObjectuiv(lightingQuery, GL_QUERY_RESULT_NO_WAIT, &lightingQueryTime);
 			}
 
+			gpuProfiler.end(GP_Lighting);
+
 			//unbind light's ID tex
 			glActiveTexture(GL_TEXTURE0 + TDTB_LightIndex);
 			glBindTexture(GL_TEXTURE_BUFFER, 0);
 
+			gpuProfiler.begin(GP_Blit);
+
 			//set read/write FBOs
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
 			glBindFramebuffer(GL_READ_FRAMEBUFFER, forwardFbo);
 
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
 			glBlitFramebuffer(0, 0, resolution.x, resolution.y, 0, 0, resolution.x, resolution.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 			
 			//final pass
 			showMRT();
 
+			gpuProfiler.end(GP_Blit);
+
 			glDisable(GL_DEPTH_TEST);
 		}
 		break;
@@ -971,40 +1751,73 @@ static void Render()
 	//Draw bounding quad
 	if (showBoundingQuads)
 	{
-		lightgrid.showLightQuads();
+		showLightQuads(packet.grid);
 	}
 
 	//Draw AntTweakBar
-	TwDraw();
+	if (!benchmarkMode && !offscreenMode)
+	{
+		TwDraw();
+	}
+
+	//calculate frames per second and writes it to window title once pers 0.5s
+	if (win != NULL)
+	{
+		calcFPS(win, 0.1, GPUVendor == AMD ? AMDtechniqueNames[packet.technique] : NVIDIAtechniqueNames[packet.technique]);
+	}
 
-	if (GPUVendor == AMD)
-		calcFPS(win, 0.1, AMDtechniqueNames[technique]);
+	gridBuildMs = packet.gridBuildMs;
+
+	if (packet.technique == AMD_TiledDeferred || packet.technique == AMD_TiledForward)
+	{
+		computeGridStatistics(packet.grid.getCounts(), packet.grid.getTileCount(), gridStats);
+	}
 	else
-		calcFPS(win, 0.1, NVIDIAtechniqueNames[technique]);
+	{
+		computeGridStatistics(NULL, 0, gridStats);
+	}
 
-	//calculate frames per second and writes it to window title once pers 0.5s
-	/*lightingTime.push_back(lightingQueryTime/1000000);
-	minmaxTime.push_back(minMaxDepthQueryTime / 1000000);
-	gridTime.push_back(float(gridTimer.getElapsedTime() * 1000.0));*/
+	frameStats.tileLightsMean = gridStats.meanLights;
+	frameStats.tileLightsP95 = gridStats.p95Lights;
+	frameStats.tileLightsMax = gridStats.maxLights;
+	frameStats.lightListLength = gridStats.listLength;
+	frameStats.tilesOverThreshold = gridStats.overThreshold * 100.0f;
+
+	if (win != NULL)
+	{
+		//watch events
+		glfwPollEvents();
 
-	//watch events
-	glfwPollEvents();
+		//swap front and back buffers
+		glfwSwapBuffers(win);
+	}
+	else
+	{
+		//offscreen frame has no swap, commands are submitted here
+		glFlush();
+	}
 
-    //swap front and back buffers
-    glfwSwapBuffers(win);
+	cpuPhases[CP_Latency].record(PerformanceTimer::ticksToNanoseconds(PerformanceTimer::getTickCount() - packet.inputTicks));
 }
 
 
 /// <summary>
-/// Update the scene based on the time elapsed since last update, 
-/// mostly used for movement in the scene, mouse and camera handle.
+/// Renders frame on calling thread, input is culled and rendered immediately.
 /// </summary>
-/// <param name="time">Seconds elapsed since last invocation.</param>
-void update(float time)
+static void Render()
 {
+	captureFrameInput(immediatePacket);
+	produceFrame(immediatePacket);
+	renderFrame(immediatePacket);
+}
 
-	//gCamera.lookAt(glm::vec3(1139.06, 228.744, -41.1216));
 
+/// <summary>
+/// Moves camera by keyboard and mouse input of window.
+/// </summary>
+/// <param name="time">Seconds elapsed since last invocation.</param>
+static void updateInput(float time)
+{
     //move camera forward/backward
     if(glfwGetKey(win,'S'))
 	{
@@ -1053,6 +1866,25 @@ void update(float time)
 		//handle mouse moves, set camera
 		glfwGetCursorPos(win, &mouseXold, &mouseYold);
 	}
+}
+
+
+/// <summary>
+/// Update the scene based on the time elapsed since last update, 
+/// mostly used for movement in the scene, mouse and camera handle.
+/// </summary>
+/// <param name="time">Seconds elapsed since last invocation.</param>
+void update(float time)
+{
+	PROFILE_FUNCTION();
+
+	//gCamera.lookAt(glm::vec3(1139.06, 228.744, -41.1216));
+
+	//no input in offscreen mode
+	if (win != NULL)
+	{
+		updateInput(time);
+	}
 
 	for (unsigned i = 0; i < GBuffer::GBUFFER_NUM_TEXTURES; i++)
 	{
@@ -1065,6 +1897,28 @@ void update(float time)
 			showGBufferQuad[i] = false;
 		}
 	}
+
+	//lights advance by frames during camera playback, so played frames are reproducible
+	if (lightAnimation)
+	{
+		lightAnimationTime += cameraPlayback ? 1.0 / CAMERA_PLAYBACK_FPS : time;
+		animateLights(lightAnimationTime);
+	}
+
+	//camera track playback overrides user input
+	if (cameraPlayback)
+	{
+		playCameraTrack(cameraPlaybackFrame++);
+	}
+	else if (cameraRecording)
+	{
+		cameraRecordTime += time;
+
+		if (cameraRecordTime - cameraTrack.getDuration() >= CAMERA_RECORD_INTERVAL)
+		{
+			recordCameraKeyframe();
+		}
+	}
 }
 
 
@@ -1088,7 +1942,7 @@ static void antTweakBarInit()
 	//basic options
 	TwBar *bar;
 	bar = TwNewBar("TweakBar");
-	TwDefine(" TweakBar size='200 140' ");
+	TwDefine(" TweakBar size='200 290' ");
 	TwDefine(" TweakBar resizable = true ");
 	TwDefine(" TweakBar movable = true ");
 	TwDefine(" TweakBar position = '20 20' ");
@@ -1097,7 +1951,61 @@ static void antTweakBarInit()
 	TwDefine(" TweakBar alpha = 0 ");
 
 	TwAddVarRW(bar, "moveSpeed", TW_TYPE_FLOAT, &moveSpeed, " label='Speed' group='Camera' min=0.0 step=100.0 keyIncr=+ keyDecr=- help='Movement speed' ");
+	TwAddVarRO(bar, "cameraRecording", TW_TYPE_BOOLCPP, &cameraRecording, " group='Camera' label='Recording' help='Camera track recording, toggled by C key' ");
+	TwAddVarRO(bar, "cameraPlayback", TW_TYPE_BOOLCPP, &cameraPlayback, " group='Camera' label='Playback' help='Camera track playback by frames, toggled by P key' ");
 	TwAddVarRO(bar, "LIGHT_COUNT", TW_TYPE_UINT32, &LIGHT_COUNT, " group='Lights' label='Count' help='Shows light count in scene' ");
+	TwAddVarRW(bar, "lightAnimation", TW_TYPE_BOOLCPP, &lightAnimation, " group='Lights' label='Animation' help='Orbiting, path following, flickering and pulsing lights, toggled by L key' ");
+	TwAddVarRW(bar, "frustumCulling", TW_TYPE_BOOLCPP, &frustumCulling, " group='Culling' label='Frustum Culling' ");
+	TwAddVarRO(bar, "drawsVisible", TW_TYPE_UINT32, &frameStats.drawsVisible, " group='Culling' label='Visible' help='Submeshes passed to geometry passes' ");
+	TwAddVarRO(bar, "drawsFrustumCulled", TW_TYPE_UINT32, &frameStats.drawsFrustumCulled, " group='Culling' label='Culled' help='Submeshes rejected by frustum culling' ");
+	TwAddVarRW(bar, "occlusionCulling", TW_TYPE_BOOLCPP, &occlusionCulling, " group='Culling' label='Occlusion Culling' ");
+	TwAddVarRO(bar, "drawsOcclusionCulled", TW_TYPE_UINT32, &frameStats.drawsOcclusionCulled, " group='Culling' label='Occluded' help='Submeshes hidden behind occluders' ");
+	TwAddVarRW(bar, "pinnedLod", TW_TYPE_INT32, &pinnedLod, " group='LOD' label='Pinned LOD' min=-1 max=3 help='Level used for all submeshes, -1 = selection by screen space error' ");
+	TwAddVarRW(bar, "lodPixelError", TW_TYPE_FLOAT, &lodPixelError, " group='LOD' label='Pixel Error' min=0.0 max=16.0 step=0.25 help='Allowed screen space error of selected level' ");
+	TwAddVarRO(bar, "trianglesSubmitted", TW_TYPE_UINT32, &frameStats.trianglesSubmitted, " group='LOD' label='Triangles' help='Triangles of selected levels of visible submeshes' ");
+	TwAddVarRO(bar, "instances", TW_TYPE_UINT32, &frameStats.instances, " group='Culling' label='Instances' help='Instances of scene mesh, each draw renders all of them' ");
+	TwAddVarCB(bar, "scenarioSeed", TW_TYPE_UINT32, setScenarioParamCB, getScenarioParamCB, &scenarioDesc.seed, " group='Scenario' label='Seed' help='Seed of generated lights and layout' ");
+
+	TwEnumVal distributionEV[LD_Max];
+	for (int i = 0; i < LD_Max; i++)
+	{
+		distributionEV[i].Value = i;
+		distributionEV[i].Label = ScenarioGenerator::getDistributionName((LightDistribution)i);
+	}
+	TwType distributionType = TwDefineEnum("LightDistribution", distributionEV, LD_Max);
+	TwAddVarCB(bar, "scenarioDistribution", distributionType, setScenarioParamCB, getScenarioParamCB, &scenarioDesc.distribution, " group='Scenario' label='Lights' help='Distribution of generated lights' ");
+
+	TwEnumVal layoutEV[SL_Max];
+	for (int i = 0; i < SL_Max; i++)
+	{
+		layoutEV[i].Value = i;
+		layoutEV[i].Label = ScenarioGenerator::getLayoutName((SceneLayout)i);
+	}
+	TwType layoutType = TwDefineEnum("SceneLayout", layoutEV, SL_Max);
+	TwAddVarCB(bar, "scenarioLayout", layoutType, setScenarioParamCB, getScenarioParamCB, &scenarioDesc.layout, " group='Scenario' label='Layout' help='Instanced layout of scene mesh' ");
+	TwAddVarCB(bar, "scenarioLayoutSize", TW_TYPE_UINT32, setScenarioParamCB, getScenarioParamCB, &scenarioDesc.layoutSize, " group='Scenario' label='Layout Size' min=1 max=16 help='Blocks along X and Z axis' ");
+	TwAddVarRO(bar, "gpuFrameMs", TW_TYPE_FLOAT, &frameStats.gpuFrameMs, " group='GPU' label='Frame ms' precision=2 help='GPU time from start of the first to end of the last pass' ");
+	TwAddVarRO(bar, "gpuGBufferMs", TW_TYPE_FLOAT, &frameStats.gpuPassMs[GP_GBuffer], " group='GPU' label='G-buffer ms' precision=2 ");
+	TwAddVarRO(bar, "gpuDepthPrepassMs", TW_TYPE_FLOAT, &frameStats.gpuPassMs[GP_DepthPrepass], " group='GPU' label='Depth prepass ms' precision=2 ");
+	TwAddVarRO(bar, "gpuMinMaxDepthMs", TW_TYPE_FLOAT, &frameStats.gpuPassMs[GP_MinMaxDepth], " group='GPU' label='Min/max ms' precision=2 ");
+	TwAddVarRO(bar, "gpuLightingMs", TW_TYPE_FLOAT, &frameStats.gpuPassMs[GP_Lighting], " group='GPU' label='Lighting ms' precision=2 ");
+	TwAddVarRO(bar, "gpuBlitMs", TW_TYPE_FLOAT, &frameStats.gpuPassMs[GP_Blit], " group='GPU' label='Blit ms' precision=2 ");
+	for (unsigned int p = 0; p < CP_Max; p++)
+	{
+		std::string name = std::string(cpuPhaseNames[p]);
+		std::string id = "cpu" + std::to_string(p);
+
+		TwAddVarRO(bar, (id + "P50").c_str(), TW_TYPE_FLOAT, &frameStats.cpuP50Ms[p], (" group='CPU' precision=2 label='" + name + " p50' ").c_str());
+		TwAddVarRO(bar, (id + "P99").c_str(), TW_TYPE_FLOAT, &frameStats.cpuP99Ms[p], (" group='CPU' precision=2 label='" + name + " p99' ").c_str());
+	}
+	TwAddButton(bar, "cpuReset", resetCpuStatisticsCB, NULL, " group='CPU' label='Reset' help='Remove collected CPU samples' ");
+	TwAddButton(bar, "cpuTrace", saveTraceCB, NULL, " group='CPU' label='Save trace' help='Save Chrome trace of CPU zones (F12)' ");
+	TwAddVarRO(bar, "tileLightsMean", TW_TYPE_FLOAT, &frameStats.tileLightsMean, " group='Tiles' label='Mean lights' precision=2 help='Mean light count per tile of light grid' ");
+	TwAddVarRO(bar, "tileLightsP95", TW_TYPE_UINT32, &frameStats.tileLightsP95, " group='Tiles' label='p95 lights' help='95 percent of tiles have at most this many lights' ");
+	TwAddVarRO(bar, "tileLightsMax", TW_TYPE_UINT32, &frameStats.tileLightsMax, " group='Tiles' label='Max lights' ");
+	TwAddVarRO(bar, "lightListLength", TW_TYPE_UINT32, &frameStats.lightListLength, " group='Tiles' label='List length' help='Entries of all tile light lists' ");
+	TwAddVarRO(bar, "tilesOverThreshold", TW_TYPE_FLOAT, &frameStats.tilesOverThreshold, (" group='Tiles' label='Over " + std::to_string(GRID_STATS_THRESHOLD) + " %' precision=1 help='Percentage of tiles over threshold of light count' ").c_str());
+	TwAddVarRO(bar, "streamedTextureMB", TW_TYPE_FLOAT, &frameStats.streamedTextureMB, " group='Textures' label='Streamed MB' help='GPU memory of streamed texture mipmaps' ");
 	
 	//tiled shading settings
 	TwBar *tiledBar;
@@ -1208,118 +2116,394 @@ static void bindDeferredLightUniforms(shprogram * shader)
 }
 
 
-/// <summary>
-/// Binds g-buffer textures and light texture to uniforms for tiled deferred shading.
-/// </summary>
-/// <param name="shader">tiled deferred shader object.</param>
-static void bindTiledDeferredLightUniforms(shprogram * shader)
-{
-	//bind textures
-	shader->use();
-	shader->bindTexToUniform(TDTB_Diffuse, gTexDiffuse, "texColor");
-	shader->bindTexToUniform(TDTB_Normal, gTexNormal, "texNormal");
-	shader->bindTexToUniform(TDTB_Position, gTexPos, "texPos");
-	shader->bindTexToUniform(TDTB_Specular, gTexSpec, "texSpec");
-	shader->bindTexToUniform(TDTB_LightIndex, lightIDtex, "texLightID");
-	shader->stopUsing();
+/// <summary>
+/// Binds g-buffer textures and light texture to uniforms for tiled deferred shading.
+/// </summary>
+/// <param name="shader">tiled deferred shader object.</param>
+static void bindTiledDeferredLightUniforms(shprogram * shader)
+{
+	//bind textures
+	shader->use();
+	shader->bindTexToUniform(TDTB_Diffuse, gTexDiffuse, "texColor");
+	shader->bindTexToUniform(TDTB_Normal, gTexNormal, "texNormal");
+	shader->bindTexToUniform(TDTB_Position, gTexPos, "texPos");
+	shader->bindTexToUniform(TDTB_Specular, gTexSpec, "texSpec");
+	shader->bindTexToUniform(TDTB_LightIndex, lightIDtex, "texLightID");
+	shader->stopUsing();
+
+	//set uniform buffers
+	shader->bindBufferToUniform(TBB_LightGrid, "lightGrid");
+	shader->bindBufferToUniform(TBB_LightPosAndRadius, "lightPosAndRadius");
+	shader->bindBufferToUniform(TBB_LightColors, "lightColors");
+}
+
+
+/// <summary>
+/// Creates framebuffer for downsampling.
+/// </summary>
+static void createMinMaxFBO()
+{
+	glGenFramebuffers(1, &minMaxDepthFbo);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, minMaxDepthFbo);
+
+	glGenTextures(1, &minMaxDepthTex);
+
+	glBindTexture(GL_TEXTURE_2D, minMaxDepthTex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, grid_size.x, grid_size.y, 0, GL_RGBA, GL_FLOAT, NULL);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, minMaxDepthTex, 0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+/// <summary>
+/// Creates framebuffer for tiled forward shading.
+/// </summary>
+static void createForwardFBO()
+{
+	glGenFramebuffers(1, &forwardFbo);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, forwardFbo);
+
+	glGenTextures(1, &forwardTex);
+
+	glBindTexture(GL_TEXTURE_2D, forwardTex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, resolution.x, resolution.y, 0, GL_RGBA, GL_FLOAT, NULL);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, forwardTex, 0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, gTexDepth, 0);
+
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/// <summary>
+/// Creates all shader programs.
+/// </summary>
+static void initShaders()
+{
+	std::ofstream shaderLog;
+	shaderLog.open("logs/shaders.txt");
+
+	std::cout << "Loading shaders";
+	mrt = new shprogram("shaders/mrt_vert.glsl", "shaders/mrt_frag.glsl", shaderLog);							//geometry pass shader
+	deferredShader = new shprogram("shaders/stencil_vert.glsl", "shaders/deferred_frag.glsl", shaderLog);		//light pass deferred shader
+	quadShader = new shprogram("shaders/quad_vert.glsl", "shaders/quad_frag.glsl", shaderLog);					//g-buffer quad shader
+	quadDShader = new shprogram("shaders/quad_depth_vert.glsl", "shaders/quad_depth_frag.glsl", shaderLog);		//g-buffer depth quad shader
+	minMaxDepthShader = new shprogram("shaders/deferred_vert.glsl", "shaders/minmaxdepth.glsl", shaderLog);		//tiled deferred depth optimalization (depth min-max)
+	simpleShader = new shprogram("shaders/simple_vert.glsl", "shaders/simple_frag.glsl", shaderLog);			//forward shading (no lighting)
+	tiledDeferredShader = new shprogram("shaders/deferred_vert.glsl", "shaders/tiled_deferred_frag.glsl", shaderLog);	//tiled deferred shader
+	tiledForwardShader = new shprogram("shaders/tiled_forward_vert.glsl", "shaders/tiled_forward_frag.glsl", shaderLog);	//tiled forward shader
+	lightHeatMapShader = new shprogram("shaders/deferred_vert.glsl", "shaders/light_heat_map_frag.glsl", shaderLog);	//light heat map shader
+	affectedTilesShader = new shprogram("shaders/deferred_vert.glsl", "shaders/affected_tiles_frag.glsl", shaderLog);	//affected tiles shader
+	std::cout << ". success\n";
+
+	shaderLog.close();
+}
+
+
+/// <summary>
+/// Reads GPU times of finished frames, the latest one is shown in frame statistics.
+/// </summary>
+static void updateGpuStatistics()
+{
+	GpuFrameTimes times;
+	bool updated = false;
+
+	while (gpuProfiler.popResult(times))
+	{
+		updated = true;
+	}
+
+	if (!updated)
+	{
+		return;
+	}
+
+	for (unsigned int p = 0; p < GP_Max; p++)
+	{
+		frameStats.gpuPassMs[p] = (float)times.passMs[p];
+	}
+
+	frameStats.gpuFrameMs = (float)times.frameMs;
+}
+
+
+/// <summary>
+/// Prints CPU time summary of frame phases.
+/// </summary>
+static void printCpuStatistics()
+{
+	printf("\n%-12s %10s %9s %9s %9s %9s %9s %9s\n", "CPU phase", "samples", "min", "mean", "p50", "p95", "p99", "max");
+
+	for (unsigned int p = 0; p < CP_Max; p++)
+	{
+		SampleSummary s = cpuPhases[p].summarize();
+
+		if (s.count > 0)
+		{
+			printf("%-12s %10llu %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", cpuPhaseNames[p], s.count, s.minMs, s.meanMs, s.p50Ms, s.p95Ms, s.p99Ms, s.maxMs);
+		}
+	}
+}
+
+
+/// <summary>
+/// Sets camera on benchmark path, closed ellipse inside scene bounds looking
+/// at scene center. Camera depends only on path parameter, so all runs render
+/// the same views regardless of frame rate.
+/// </summary>
+/// <param name="bounds">scene bounds.</param>
+/// <param name="t">path parameter from range <0, 1).</param>
+static void setBenchmarkCamera(const AABB &bounds, float t)
+{
+	glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+	glm::vec3 halfExtent = (bounds.max - bounds.min) * 0.5f;
+
+	float angle = t * 2.0f * glm::pi<float>();
+	float height = bounds.min.y + halfExtent.y * 0.6f;
+
+	gCamera.setPosition(glm::vec3(center.x + cos(angle) * halfExtent.x * 0.7f, height, center.z + sin(angle) * halfExtent.z * 0.7f));
+	gCamera.lookAt(glm::vec3(center.x, height, center.z));
+}
+
+
+/// <summary>
+/// Creates directory including missing parent directories.
+/// </summary>
+/// <param name="path">directory path, '/' separated.</param>
+static void createDirectories(const std::string &path)
+{
+	for (size_t separator = path.find('/'); ; separator = path.find('/', separator + 1))
+	{
+		_mkdir(path.substr(0, separator).c_str());
+
+		if (separator == std::string::npos)
+		{
+			break;
+		}
+	}
+}
+
+
+/// <summary>
+/// Runs benchmark sweep. Every configuration renders warm-up and measured frames
+/// along loaded camera track (or benchmark camera path), measured frames are written to
+/// "<output>/<renderer>/<run>.csv|json" and summarized in "summary.csv".
+/// Resolution and tile size are compiled into shaders and light grid, so
+/// configurations not matching current build are skipped and have to be run
+/// by build with corresponding Config.h.
+/// </summary>
+/// <param name="spec">benchmark sweep.</param>
+/// <returns>number of recorded runs</returns>
+static unsigned int runBenchmark(const BenchmarkSpec &spec)
+{
+	std::string renderer = (const char *)glGetString(GL_RENDERER);
+	std::string rendererDir;
+
+	for (unsigned int i = 0; i < renderer.size(); i++)
+	{
+		if (isalnum((unsigned char)renderer[i]))
+		{
+			rendererDir += renderer[i];
+		}
+	}
+
+	std::string outputDir = spec.outputDir + "/" + rendererDir;
+	createDirectories(outputDir);
+
+	std::ofstream summary((outputDir + "/summary.csv").c_str());
+
+	if (!summary.is_open())
+	{
+		std::cerr << "Benchmark: could not write to " << outputDir << std::endl;
+		return 0;
+	}
+
+	BenchmarkRecorder::writeSummaryHeader(summary);
+
+	//textures must be resident before measuring
+	while (textureLoader && !texturesResident && !shouldClose())
+	{
+		updateTextureStreaming();
+		Render();
+	}
+
+	std::vector<BenchmarkConfig> configs;
+	spec.getConfigurations(configs);
+
+	AABB sceneBounds = scenarioGenerator->getSceneBounds(sceneInstances);
+	unsigned int recorded = 0;
+
+	for (unsigned int c = 0; c < configs.size() && !shouldClose(); c++)
+	{
+		const BenchmarkConfig &config = configs[c];
+		std::string name = spec.getRunName(config);
+
+		if (config.resolution != glm::uvec2(RES_X, RES_Y) || config.tileSize != TILE_SIZE_XY)
+		{
+			std::cout << "Benchmark: " << name << " skipped, build renders " << RES_X << "x" << RES_Y << " with tile " << TILE_SIZE_XY << std::endl;
+			continue;
+		}
+
+		if (config.lightCount > MAX_LIGHTS)
+		{
+			std::cout << "Benchmark: " << name << " skipped, build supports up to " << MAX_LIGHTS << " lights" << std::endl;
+			continue;
+		}
+
+		if (GPUVendor == NVIDIA && config.technique >= NVIDIA_Max)
+		{
+			std::cout << "Benchmark: " << name << " skipped, technique is disabled on NVIDIA" << std::endl;
+			continue;
+		}
+
+		technique = config.technique;
+		minMaxPass = config.minMax;
+		generateLights(config.lightCount, LIGHT_RADIUS_MIN, LIGHT_RADIUS_MAX);
 
-	//set uniform buffers
-	shader->bindBufferToUniform(TBB_LightGrid, "lightGrid");
-	shader->bindBufferToUniform(TBB_LightPosAndRadius, "lightPosAndRadius");
-	shader->bindBufferToUniform(TBB_LightColors, "lightColors");
-}
+		unsigned int frameCount = spec.warmupFrames + spec.measuredFrames;
+		std::vector<BenchmarkFrame> frames(frameCount);
+		std::vector<unsigned long long> tileHistogram(GRID_HISTOGRAM_BINS, 0);
+		GpuFrameTimes gpuTimes;
 
+		double frameStart = getTime();
 
-/// <summary>
-/// Creates framebuffer for downsampling.
-/// </summary>
-static void createMinMaxFBO()
-{
-	glGenFramebuffers(1, &minMaxDepthFbo);
+		for (unsigned int f = 0; f < frameCount; f++)
+		{
+			if (cameraTrack.empty())
+			{
+				setBenchmarkCamera(sceneBounds, (float)f / frameCount);
+			}
+			else
+			{
+				playCameraTrack(f);
+			}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, minMaxDepthFbo);
+			if (lightAnimation)
+			{
+				animateLights(f / CAMERA_PLAYBACK_FPS);
+			}
 
-	glGenTextures(1, &minMaxDepthTex);
+			gpuProfiler.beginFrame(f);
 
-	glBindTexture(GL_TEXTURE_2D, minMaxDepthTex);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, grid_size.x, grid_size.y, 0, GL_RGBA, GL_FLOAT, NULL);
+			updateTextureStreaming();
+			Render();
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, minMaxDepthTex, 0);
+			double now = getTime();
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+			frames[f].frameMs = (now - frameStart) * 1000.0;
+			frames[f].gridBuildMs = gridBuildMs;
+			frames[f].tileLightsMean = gridStats.meanLights;
+			frames[f].tileLightsP95 = gridStats.p95Lights;
+			frames[f].tileLightsMax = gridStats.maxLights;
+			frames[f].lightListLength = gridStats.listLength;
+			frames[f].tilesOverThreshold = gridStats.overThreshold * 100.0;
+			frameStart = now;
 
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
-	glReadBuffer(GL_COLOR_ATTACHMENT0);
+			if (f >= spec.warmupFrames)
+			{
+				for (unsigned int b = 0; b < GRID_HISTOGRAM_BINS; b++)
+				{
+					tileHistogram[b] += gridStats.histogram[b];
+				}
+			}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-}
+			//GPU times arrive few frames later
+			while (gpuProfiler.popResult(gpuTimes))
+			{
+				std::copy(gpuTimes.passMs, gpuTimes.passMs + GP_Max, frames[gpuTimes.frame].gpuMs);
+				frames[gpuTimes.frame].gpuFrameMs = gpuTimes.frameMs;
+			}
+		}
 
+		gpuProfiler.flush();
 
-/// <summary>
-/// Creates framebuffer for tiled forward shading.
-/// </summary>
-static void createForwardFBO()
-{
-	glGenFramebuffers(1, &forwardFbo);
+		while (gpuProfiler.popResult(gpuTimes))
+		{
+			std::copy(gpuTimes.passMs, gpuTimes.passMs + GP_Max, frames[gpuTimes.frame].gpuMs);
+			frames[gpuTimes.frame].gpuFrameMs = gpuTimes.frameMs;
+		}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, forwardFbo);
+		BenchmarkRecorder recorder(config, name, spec.getTechniqueName(config.technique));
+		std::vector<double> frameTimes;
 
-	glGenTextures(1, &forwardTex);
+		for (unsigned int f = spec.warmupFrames; f < frameCount; f++)
+		{
+			recorder.addFrame(frames[f]);
+			frameTimes.push_back(frames[f].frameMs);
+		}
 
-	glBindTexture(GL_TEXTURE_2D, forwardTex);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, resolution.x, resolution.y, 0, GL_RGBA, GL_FLOAT, NULL);
+		recorder.setTileHistogram(tileHistogram);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, forwardTex, 0);
+		std::string path = outputDir + "/" + name;
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+		if ((spec.writeCsv && (!recorder.writeCsv(path + ".csv") || !recorder.writeTileHistogram(path + ".tiles.csv"))) || (spec.writeJson && !recorder.writeJson(path + ".json", renderer)))
+		{
+			std::cerr << "Benchmark: could not write " << path << std::endl;
+		}
 
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, gTexDepth, 0);
+		recorder.writeSummaryRow(summary);
+		recorded++;
 
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
-	glReadBuffer(GL_COLOR_ATTACHMENT0);
+		BenchmarkSummary frameSummary = BenchmarkRecorder::summarize(frameTimes);
+		printf("Benchmark: %s %.2f ms (p50 %.2f, p99 %.2f)\n", name.c_str(), frameSummary.mean, frameSummary.p50, frameSummary.p99);
+	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return recorded;
 }
 
 /// <summary>
-/// Creates all shader programs.
+/// Saves output framebuffer of offscreen context to PFM file (image regressions).
 /// </summary>
-static void initShaders()
+/// <param name="filename">output file.</param>
+static void saveOffscreenImage(const char *filename)
 {
-	std::ofstream shaderLog;
-	shaderLog.open("logs/shaders.txt");
+	std::vector<float> rgb;
+	offscreenContext.readPixels(rgb);
 
-	std::cout << "Loading shaders";
-	mrt = new shprogram("shaders/mrt_vert.glsl", "shaders/mrt_frag.glsl", shaderLog);							//geometry pass shader
-	deferredShader = new shprogram("shaders/stencil_vert.glsl", "shaders/deferred_frag.glsl", shaderLog);		//light pass deferred shader
-	quadShader = new shprogram("shaders/quad_vert.glsl", "shaders/quad_frag.glsl", shaderLog);					//g-buffer quad shader
-	quadDShader = new shprogram("shaders/quad_depth_vert.glsl", "shaders/quad_depth_frag.glsl", shaderLog);		//g-buffer depth quad shader
-	minMaxDepthShader = new shprogram("shaders/deferred_vert.glsl", "shaders/minmaxdepth.glsl", shaderLog);		//tiled deferred depth optimalization (depth min-max)
-	simpleShader = new shprogram("shaders/simple_vert.glsl", "shaders/simple_frag.glsl", shaderLog);			//forward shading (no lighting)
-	tiledDeferredShader = new shprogram("shaders/deferred_vert.glsl", "shaders/tiled_deferred_frag.glsl", shaderLog);	//tiled deferred shader
-	tiledForwardShader = new shprogram("shaders/tiled_forward_vert.glsl", "shaders/tiled_forward_frag.glsl", shaderLog);	//tiled forward shader
-	lightHeatMapShader = new shprogram("shaders/deferred_vert.glsl", "shaders/light_heat_map_frag.glsl", shaderLog);	//light heat map shader
-	affectedTilesShader = new shprogram("shaders/deferred_vert.glsl", "shaders/affected_tiles_frag.glsl", shaderLog);	//affected tiles shader
-	std::cout << ". success\n";
+	ShadingImage image;
+	resizeImage(image, offscreenContext.getSize());
 
-	shaderLog.close();
+	for (unsigned int i = 0; i < image.resolution.x * image.resolution.y; i++)
+	{
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			image.color[c][i] = rgb[i * 3 + c];
+		}
+	}
+
+	if (saveImagePfm(filename, image))
+		printf("Offscreen: last frame saved to %s\n", filename);
+	else
+		printf("Offscreen: could not save %s\n", filename);
 }
 
+
 /// <summary>
-/// Mains the specified argc.
+/// Creates application window with current OpenGL context and input callbacks.
 /// </summary>
-/// <param name="argc">number of parameters.</param>
-/// <param name="argv">parameters as array of strings.</param>
-/// <returns></returns>
-int main(int argc, char **argv)
+static void createWindow()
 {
 	//initialise GLFW3
 	if (!glfwInit())
@@ -1334,6 +2518,12 @@ int main(int argc, char **argv)
     //glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);  //API version to be compatible with [major]
     //glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);  //API version to be compatible with [minor]
 
+	//benchmark renders to hidden window
+	if (benchmarkMode)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	}
+
     //create window and check state
     win = glfwCreateWindow((int)resolution.x, (int)resolution.y, "ECL", NULL, NULL);
 
@@ -1345,19 +2535,147 @@ int main(int argc, char **argv)
     //make window's cotext current
     glfwMakeContextCurrent(win);
 
+	//frame rate of benchmark is not limited by vertical sync
+	if (benchmarkMode)
+	{
+		glfwSwapInterval(0);
+	}
+
 	//set keyboard callback function
 	glfwSetKeyCallback(win, keyCallback);
 
     //set cursor to default position and disable it
     glfwSetCursorPos(win, resolution.x/2, resolution.y/2);
     glfwSetInputMode(win, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+}
+
+
+/// <summary>
+/// Mains the specified argc.
+/// </summary>
+/// <param name="argc">number of parameters.</param>
+/// <param name="argv">parameters as array of strings.</param>
+/// <returns></returns>
+int main(int argc, char **argv)
+{
+	ZoneProfiler::setThreadName("Main");
+	ThreadPool::setJobHook(profileJob);
+
+	//importers comparison, no window is created
+	if (argc > 1 && strcmp(argv[1], "--compare-importers") == 0)
+	{
+		Mesh::benchmarkImport(argc > 2 ? argv[2] : "data/models/crysponza/sponza.obj", 5);
+		return 0;
+	}
+
+	//benchmark scenario options
+	const char *scenarioFile = NULL;		//load lights and instances instead of generating them
+	const char *scenarioOutput = NULL;		//save used scenario
+	const char *benchmarkFile = NULL;		//benchmark sweep, defaults are used without file
+	const char *snapshotFile = NULL;		//capture light grid inputs from the first frame
+	const char *outputImage = NULL;			//last frame of offscreen mode is saved here
+	int offscreenApi = OFFSCREEN_CONTEXT_API;	//context API of offscreen mode
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc)
+		{
+			scenarioFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--save-scenario") == 0 && i + 1 < argc)
+		{
+			scenarioOutput = argv[++i];
+		}
+		else if (strcmp(argv[i], "--camera-track") == 0 && i + 1 < argc)
+		{
+			cameraTrackFile = argv[++i];
+
+			if (!cameraTrack.load(cameraTrackFile))
+			{
+				std::cerr << "Camera track " << cameraTrackFile << " could not be loaded" << std::endl;
+			}
+		}
+		else if (strcmp(argv[i], "--grid-snapshots") == 0 && i + 1 < argc)
+		{
+			snapshotFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--offscreen") == 0)
+		{
+			offscreenMode = true;
+
+			if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+			{
+				offscreenFrames = std::max(atoi(argv[++i]), 1);
+			}
+		}
+		else if (strcmp(argv[i], "--offscreen-api") == 0 && i + 1 < argc)
+		{
+			if ((offscreenApi = OffscreenContext::parseApi(argv[++i])) < 0)
+			{
+				std::cerr << "Unknown offscreen API " << argv[i] << ", use glfw, egl or osmesa" << std::endl;
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			outputImage = argv[++i];
+		}
+		else if (strcmp(argv[i], "--animate-lights") == 0)
+		{
+			lightAnimation = true;
+		}
+		else if (strcmp(argv[i], "--benchmark") == 0)
+		{
+			benchmarkMode = true;
+
+			if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+			{
+				benchmarkFile = argv[++i];
+			}
+		}
+	}
+
+	std::vector<std::string> techniqueNames(AMDtechniqueNames, AMDtechniqueNames + AMD_Max);
+	BenchmarkSpec benchmarkSpec(techniqueNames);
+
+	if (benchmarkFile != NULL && !benchmarkSpec.load(benchmarkFile))
+	{
+		return 1;
+	}
+
+	//offscreen context replaces window, tweakbar and input
+	if (offscreenMode)
+	{
+		if (!offscreenContext.create(glm::uvec2(resolution), offscreenApi))
+		{
+			throw std::runtime_error("offscreen context could not be created");
+		}
+
+		std::cout << "Offscreen: " << offscreenFrames << " frames, " << offscreenContext.getApiName() << std::endl;
+	}
+	else
+	{
+		createWindow();
+	}
+
+	//functions of offscreen context are loaded by its API (eglGetProcAddress/OSMesaGetProcAddress)
+	if (offscreenMode && !offscreenContext.loadFunctions())
+	{
+		throw std::runtime_error("OpenGL functions of offscreen context could not be loaded");
+	}
 
     //initialise GLEW
-    if(glewInit() != GLEW_OK)
+    if(!offscreenMode && glewInit() != GLEW_OK)
 	{
         throw std::runtime_error("glewInit failed");
     }
 
+	//FBO of offscreen mode stands in for window framebuffer
+	if (offscreenMode && (outputFramebuffer = offscreenContext.createFramebuffer()) == 0)
+	{
+		throw std::runtime_error("offscreen framebuffer could not be created");
+	}
+
 	//set GPU vendor based on actual graphics card vendor
 	//used to eliminate deferred shading on NVIDIA cards because
 	//of application failure for unknow reasons
@@ -1397,17 +2715,73 @@ int main(int argc, char **argv)
 	m_pMesh = new Mesh();
 	m_sphere = new Mesh();
 
-	m_pMesh->LoadMesh("data/models/crysponza/sponza.obj");
+#if TEXTURE_ASYNC_LOADING
+	textureLoader = new TextureLoader(0, TEXTURE_DECODE_QUEUE);
+
+#if TEXTURE_STREAMING && !TEXTURE_ARRAYS
+	textureStreamer = new TextureStreamer(*textureLoader, (size_t)TEXTURE_STREAMING_BUDGET_MB * 1024 * 1024,
+		TEXTURE_STREAMING_TAIL, TEXTURE_STREAMING_IDLE_FRAMES);
+#endif
+#endif
+
+	m_pMesh->LoadMesh("data/models/crysponza/sponza.obj", textureLoader, textureStreamer);
 	m_sphere->LoadMesh("data/models/sphere/sphere.obj");
 
+	TextureRegistry::shared().printStatistics();
+
+	//scenario generator works with bounds of mesh in object space
+	AABB sceneMeshBounds = emptyAABB();
+
+	for (unsigned int i = 0; i < m_pMesh->getMeshEntriesCount(); i++)
+	{
+		expandAABB(sceneMeshBounds, m_pMesh->getBounds(i));
+	}
+
+	scenarioGenerator = new ScenarioGenerator(sceneMeshBounds, m_pMesh->getSurfaceSamples());
+
+	//scenario from file or generated from config
+	Scenario scenario;
+
+	if (scenarioFile != NULL && ScenarioGenerator::load(scenarioFile, scenario))
+	{
+		scenarioDesc = scenario.desc;
+	}
+	else
+	{
+		if (scenarioFile != NULL)
+		{
+			std::cerr << "Scenario " << scenarioFile << " could not be loaded, generating from config" << std::endl;
+		}
+
+		scenarioGenerator->generate(scenarioDesc, scenario);
+	}
+
+	std::cout << "Scenario: seed " << scenarioDesc.seed << ", " << ScenarioGenerator::getDistributionName(scenarioDesc.distribution)
+		<< " lights (" << scenario.lights.size() << "), " << ScenarioGenerator::getLayoutName(scenarioDesc.layout)
+		<< " layout (" << scenario.instances.size() << " instances)" << std::endl;
+
+	if (scenarioOutput != NULL && !ScenarioGenerator::save(scenarioOutput, scenario))
+	{
+		std::cerr << "Scenario could not be saved to " << scenarioOutput << std::endl;
+	}
+
+	//scene mesh instances, submesh bounds for culling enclose all of them
+	sceneInstances = scenario.instances;
+	applySceneInstances(sceneInstances);
+
+	//occluders for culling
+	occlusionCuller = new OcclusionCuller(OCCLUSION_BUFFER_X, OCCLUSION_BUFFER_Y, &ThreadPool::shared());
+	occlusionCuller->setOccluders(m_pMesh->getOccluderVertices(), m_pMesh->getOccluderIndices());
+
 	//camera presets
 	gCamera.setPosition(glm::vec3(116.294, 238.282, -18.8551));
 	gCamera.lookAt(glm::vec3(1139.06, 228.744, -41.1216));
 	gCamera.setNearPlane(1.0f);
 	gCamera.setFarPlane(5000.0f);
 
-	//generate lights
-	generateLights(MAX_LIGHTS, LIGHT_RADIUS_MIN, LIGHT_RADIUS_MAX);
+	//scenario lights
+	applyLights(scenario.lights);
+	lastLightCnt = LIGHT_COUNT;
 
 	//initialize grid buffers
 	countsAndOffsetsBuffer.init(TILES_COUNT, 0);
@@ -1442,73 +2816,161 @@ int main(int argc, char **argv)
 
 	showGBufferQuad[gBufTexIndex] = true;
 
-	//glGenQueries(1, &lightingQuery);
-	//glGenQueries(1, &minMaxDepthQuery);
+	//initialize antTweakBar
+	if (!offscreenMode)
+	{
+		antTweakBarInit();
+	}
 
+	gpuProfiler.init();
 
-	//initialize antTweakBar
-	antTweakBarInit();
+	if (snapshotFile != NULL)
+	{
+		startGridSnapshots(snapshotFile);
+	}
+
+	//benchmark sweep replaces interactive loop, frames are rendered immediately
+	//so that measured frame matches camera of benchmark path
+	if (benchmarkMode)
+	{
+		runBenchmark(benchmarkSpec);
+
+		closeRequested = true;
+	}
+	else if (offscreenMode)
+	{
+		//offscreen frames are reproducible, textures are resident and camera follows track if it was loaded
+		while (textureLoader && !texturesResident)
+		{
+			updateTextureStreaming();
+			Render();
+		}
+
+		cameraPlayback = !cameraTrack.empty();
+	}
+
+#if FRAME_PIPELINE_DEPTH > 0
+	//culling and light grid of next frames run on simulation thread
+	framePipeline = new FramePipeline<FramePacket>(FRAME_PIPELINE_DEPTH, produceFrame);
+#endif
 
     // run while the window is open
-    double lastTime = glfwGetTime();
+    double lastTime = getTime();
 	start_time = lastTime;
 
-	while(!glfwWindowShouldClose(win)){
+	unsigned int frameNumber = 0;
+	double lastCpuStatsTime = lastTime;
+
+	PerformanceTimer frameTimer;
+	PerformanceTimer phaseTimer;
+
+	while(!shouldClose()){
+
+		PROFILE_ZONE("Frame");
+
+		frameTimer.reset();
+		frameTimer.start();
 
         // update the scene based on the time elapsed since last update
-        double thisTime = glfwGetTime();
+        double thisTime = getTime();
         
+		phaseTimer.reset();
+		phaseTimer.start();
 		update(thisTime - lastTime);
         lastTime = thisTime;
+		phaseTimer.stop();
+		cpuPhases[CP_Update].record(phaseTimer.getElapsedNanoseconds());
 
-        // draw one frame
-        Render();
-    }
+		phaseTimer.reset();
+		phaseTimer.start();
+		updateTextureStreaming();
+		phaseTimer.stop();
+		cpuPhases[CP_Textures].record(phaseTimer.getElapsedNanoseconds());
 
-	#pragma region TIMER_OUTPUTS
-	/*std::ofstream myfile;
-	myfile.open("GridBuildTime.txt");
+		if (framePipeline)
+		{
+			//input of this frame is processed while older frame is rendered
+			FramePacket *packet = framePipeline->begin();
+			captureFrameInput(*packet);
+			framePipeline->submit(packet);
 
-	for (unsigned i = 0; i < gridTime.size(); i++)
-	{
-		myfile << gridTime[i] << std::endl;
-	}
-	
-	myfile.close();
-	
-	std::ofstream myfile2;
-	myfile2.open("fps.txt");
+			if (framePipeline->getInFlight() > framePipeline->getDepth())
+			{
+				phaseTimer.reset();
+				phaseTimer.start();
+				packet = framePipeline->acquire();
+				phaseTimer.stop();
+				cpuPhases[CP_PacketWait].record(phaseTimer.getElapsedNanoseconds());
+
+				// draw one frame
+				gpuProfiler.beginFrame(frameNumber++);
+				phaseTimer.reset();
+				phaseTimer.start();
+				renderFrame(*packet);
+				phaseTimer.stop();
+				cpuPhases[CP_Render].record(phaseTimer.getElapsedNanoseconds());
+
+				framePipeline->release(packet);
+			}
+		}
+		else
+		{
+			// draw one frame
+			gpuProfiler.beginFrame(frameNumber++);
+			phaseTimer.reset();
+			phaseTimer.start();
+			Render();
+			phaseTimer.stop();
+			cpuPhases[CP_Render].record(phaseTimer.getElapsedNanoseconds());
+		}
 
-	for (unsigned i = 0; i < fpsVector.size(); i++)
-	{
-		myfile2 << fpsVector[i] << " " << std::endl;
-	}
+		updateGpuStatistics();
+
+		if (thisTime - lastCpuStatsTime >= CPU_STATS_INTERVAL)
+		{
+			updateCpuStatistics();
+			lastCpuStatsTime = thisTime;
+		}
 
-	myfile2.close();
+		frameTimer.stop();
+		cpuPhases[CP_Frame].record(frameTimer.getElapsedNanoseconds());
 
-	std::ofstream myfile3;
-	myfile3.open("minMaxDepthQuery.txt");
+		//offscreen run ends after given number of rendered frames
+		if (offscreenMode && frameNumber >= offscreenFrames)
+		{
+			closeRequested = true;
+		}
+    }
 
-	for (unsigned i = 0; i < minmaxTime.size(); i++)
+	if (offscreenMode && outputImage != NULL)
 	{
-		myfile3 << minmaxTime[i] << " " << std::endl;
+		saveOffscreenImage(outputImage);
 	}
 
-	myfile3.close();
+	//frames in flight are finished, simulation thread exits
+	delete framePipeline;
+	framePipeline = NULL;
 
-	std::ofstream myfile4;
-	myfile4.open("TiledDeferredlightingQuery.txt");
+	printCpuStatistics();
+	stopGridSnapshots();
 
-	for (unsigned i = 0; i < lightingTime.size(); i++)
-	{
-		myfile4 << lightingTime[i] << " " << std::endl;
-	}
+	delete textureStreamer;
+	delete textureLoader;
 
-	myfile4.close();*/
-	#pragma endregion TIMER_OUTPUTS
+	sceneGraph.clear();
+	delete scenarioGenerator;
 
-	glfwTerminate();
-	TwTerminate();
+	gpuProfiler.release();
+
+	if (offscreenMode)
+	{
+		offscreenContext.release();
+	}
+	else
+	{
+		glfwTerminate();
+		TwTerminate();
+	}
 	
 	//unbind tiled uniform buffers
 	colorsBuffer.unbind();
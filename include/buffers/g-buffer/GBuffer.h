@@ -48,7 +48,7 @@ class GBuffer
         void clearTextures();
         void bindForGeomPass();
         void bindForLightPass();
-        void bindForFinalPass(int i);
+        void bindForFinalPass(int i, GLuint drawFramebuffer = 0);
 
 		GLuint getTex(GLuint index);
 		GLuint getDepthTex();
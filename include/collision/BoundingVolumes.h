@@ -0,0 +1,134 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Bounding volumes (axis aligned bounding box, bounding sphere) used for
+visibility culling of scene geometry.
+*/
+
+#ifndef _BoundingVolumes_h_
+#define _BoundingVolumes_h_
+
+#include <cfloat>
+#include <cmath>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Axis aligned bounding box
+/// </summary>
+struct AABB
+{
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+/// <summary>
+/// Bounding sphere
+/// </summary>
+struct BoundingSphere
+{
+	glm::vec3 center;
+	float radius;
+};
+
+/// <summary>
+/// Returns empty (inverted) box, ready to be expanded by points.
+/// </summary>
+/// <returns>empty AABB</returns>
+inline AABB emptyAABB()
+{
+	AABB box;
+	box.min = glm::vec3(FLT_MAX);
+	box.max = glm::vec3(-FLT_MAX);
+
+	return box;
+}
+
+/// <summary>
+/// Expands box so it contains specified point.
+/// </summary>
+/// <param name="box">box to expand.</param>
+/// <param name="p">point.</param>
+inline void expandAABB(AABB &box, const glm::vec3 &p)
+{
+	box.min = glm::min(box.min, p);
+	box.max = glm::max(box.max, p);
+}
+
+/// <summary>
+/// Checks whether box contains at least one point.
+/// </summary>
+/// <param name="box">The box.</param>
+/// <returns>TRUE if box is valid.</returns>
+inline bool isValidAABB(const AABB &box)
+{
+	return box.min.x <= box.max.x && box.min.y <= box.max.y && box.min.z <= box.max.z;
+}
+
+/// <summary>
+/// Computes sphere enclosing the box.
+/// </summary>
+/// <param name="box">The box.</param>
+/// <returns>bounding sphere of box</returns>
+inline BoundingSphere sphereFromAABB(const AABB &box)
+{
+	BoundingSphere sphere;
+	sphere.center = (box.min + box.max) * 0.5f;
+	sphere.radius = glm::length(box.max - sphere.center);
+
+	return sphere;
+}
+
+/// <summary>
+/// Computes box enclosing transformed box.
+/// </summary>
+/// <param name="box">The box.</param>
+/// <param name="transform">affine transformation.</param>
+/// <returns>transformed AABB</returns>
+inline AABB transformAABB(const AABB &box, const glm::mat4 &transform)
+{
+	glm::vec3 center = glm::vec3(transform * glm::vec4((box.min + box.max) * 0.5f, 1.0f));
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+	glm::vec3 halfSize;
+
+	//extent projected to world axes
+	for (unsigned int r = 0; r < 3; r++)
+	{
+		halfSize[r] = fabsf(transform[0][r]) * extent.x + fabsf(transform[1][r]) * extent.y + fabsf(transform[2][r]) * extent.z;
+	}
+
+	AABB result;
+	result.min = center - halfSize;
+	result.max = center + halfSize;
+
+	return result;
+}
+
+/// <summary>
+/// Expands box so it contains another box.
+/// </summary>
+/// <param name="box">box to expand.</param>
+/// <param name="other">contained box.</param>
+inline void expandAABB(AABB &box, const AABB &other)
+{
+	box.min = glm::min(box.min, other.min);
+	box.max = glm::max(box.max, other.max);
+}
+
+#endif // _BoundingVolumes_h_
@@ -0,0 +1,65 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Frustum culler definition. Culler tests bounding boxes of scene submeshes
+against view frustum planes extracted from view-projection matrix.
+*/
+
+#ifndef _FrustumCuller_h_
+#define _FrustumCuller_h_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "collision\BoundingVolumes.h"
+
+/// <summary>
+/// SIMD frustum culler, bounding boxes are stored in SoA layout so four boxes
+/// are tested against frustum plane at once.
+/// </summary>
+class FrustumCuller
+{
+	public:
+		FrustumCuller();
+		~FrustumCuller();
+
+		void setBounds(const std::vector<AABB> &bounds);
+		void extractPlanes(const glm::mat4 &viewProjection);
+
+		unsigned int cull(const glm::mat4 &viewProjection, std::vector<unsigned int> &visible);
+
+		unsigned int getVisibleCount() const { return m_visibleCount; }
+		unsigned int getCulledCount() const { return m_boundsCount - m_visibleCount; }
+
+		const glm::vec4 *getPlanes() const { return m_planes; }
+
+	protected:
+		//frustum planes (left, right, bottom, top, near, far), normals point inside
+		glm::vec4 m_planes[6];
+
+		//box centers and half extents [SoA, padded to multiple of 4]
+		std::vector<float> m_centerX, m_centerY, m_centerZ;
+		std::vector<float> m_extentX, m_extentY, m_extentZ;
+
+		unsigned int m_boundsCount;
+		unsigned int m_visibleCount;
+};
+
+#endif // _FrustumCuller_h_
@@ -0,0 +1,99 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Occlusion culler definition. Culler rasterizes designated occluder triangles
+into low resolution depth buffer on CPU and tests bounding boxes of occludees
+against hierarchical max-depth buffer built from it. No GL calls are used.
+*/
+
+#ifndef _OcclusionCuller_h_
+#define _OcclusionCuller_h_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "collision\BoundingVolumes.h"
+
+class ThreadPool;
+
+/// <summary>
+/// Software occlusion culler. Depth is stored as NDC z [-1, 1], cleared to far plane.
+/// </summary>
+class OcclusionCuller
+{
+	public:
+		OcclusionCuller(unsigned int width, unsigned int height, ThreadPool *pool = NULL);
+		~OcclusionCuller();
+
+		void setOccluders(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &indices);
+
+		void renderOccluders(const glm::mat4 &viewProjection);
+		unsigned int cull(const std::vector<AABB> &bounds, std::vector<unsigned int> &visible);
+
+		bool isVisible(const AABB &box) const;
+
+		unsigned int getWidth() const { return m_width; }
+		unsigned int getHeight() const { return m_height; }
+		const float *getDepthBuffer() const { return &m_depth[0]; }
+		unsigned int getOccluderTriangleCount() const { return (unsigned int)m_indices.size() / 3; }
+		unsigned int getCulledCount() const { return m_culledCount; }
+
+		//size of finest hierarchical depth tile in pixels
+		static const unsigned int HIZ_TILE = 8;
+
+	protected:
+		/// <summary>
+		/// Occluder triangle in screen space, vertices ordered counter-clockwise
+		/// </summary>
+		struct ScreenTriangle
+		{
+			glm::vec3 v[3];
+			int minX, minY, maxX, maxY;
+		};
+
+		void setupTriangles();
+		void rasterizeBand(unsigned int rowBegin, unsigned int rowEnd);
+		void rasterizeTriangle(const ScreenTriangle &tri, int rowBegin, int rowEnd);
+		void buildHierarchy();
+
+		unsigned int m_width;
+		unsigned int m_height;
+
+		ThreadPool *m_pool;
+
+		//occluder geometry (world space)
+		std::vector<glm::vec3> m_vertices;
+		std::vector<unsigned int> m_indices;
+
+		//transformed occluder vertices (x, y in pixels, z in NDC, w = clip w)
+		std::vector<glm::vec4> m_screenVertices;
+		std::vector<ScreenTriangle> m_triangles;
+
+		std::vector<float> m_depth;
+
+		//hierarchical max-depth buffer, level 0 = HIZ_TILE x HIZ_TILE pixels tiles
+		std::vector<std::vector<float> > m_hiz;
+		std::vector<glm::uvec2> m_hizSize;
+
+		glm::mat4 m_viewProjection;
+		unsigned int m_culledCount;
+};
+
+#endif // _OcclusionCuller_h_
@@ -23,6 +23,9 @@ tile size or lights' count change corresponding values. To apply changes applica
 must be compiled to generate new shaders.
 */
 
+#ifndef _Config_h_
+#define _Config_h_
+
 #include <glm/glm.hpp>
 #include <algorithm>
 #include <array>
@@ -62,6 +65,129 @@ must be compiled to generate new shaders.
 #define S_MAX_LIGHTS	S_(MAX_LIGHTS)
 #define S_TILE_DIM		S_(TILE_SIZE_XY)
 
+//occlusion culling
+#define OCCLUSION_BUFFER_X		256
+#define OCCLUSION_BUFFER_Y		144
+#define OCCLUDER_MIN_EXTENT		300.0f	//submesh bounding box must be at least this large...
+#define OCCLUDER_MAX_TRIANGLES	2048	//...and simple enough to be used as occluder
+
+//mesh import, 1 = .obj files are parsed by parallel OBJ loader instead of Assimp (opt-in, submeshes
+//are split on o/g so their count and order may differ from Assimp, compare by --compare-importers)
+#define MESH_OBJ_LOADER 0
+
+//benchmark scenario (light distribution and instanced layout of scene mesh)
+#define SCENARIO_SEED			1
+#define SCENARIO_DISTRIBUTION	LD_Uniform		//LD_Uniform, LD_Clustered, LD_Surface, LD_Corridor
+#define SCENARIO_LAYOUT			SL_Single		//SL_Single, SL_Repeated, SL_CityGrid
+#define SCENARIO_LAYOUT_SIZE	3				//blocks along X and Z of repeated and city layout
+
+//surface points of scene mesh (lights on surfaces)
+#define MESH_SURFACE_SAMPLES	8192
+#define MESH_SURFACE_SEED		12345
+
+//mesh levels of detail
+#define MESH_LOD_COUNT			4		//including full resolution level
+#define MESH_LOD_MIN_TRIANGLES	128		//smaller submeshes are not simplified
+#define MESH_LOD_PIXEL_ERROR	1.0f	//default allowed screen space error of selected LOD
+
+//textures, 1 = material textures are packed to texture arrays (same size and format per array)
+#define TEXTURE_ARRAYS 1
+
+//textures, 1 = textures are cooked to BC1/BC3 (color) and BC5 (normal maps) with offline mipmaps,
+//cooked images are cached in "<image>.eclt" files
+#define TEXTURE_COMPRESSION 1
+
+//asynchronous texture loading, placeholders are used until textures are uploaded
+#define TEXTURE_ASYNC_LOADING		1
+#define TEXTURE_DECODE_QUEUE		8		//decoded images waiting for upload
+#define TEXTURE_UPLOAD_BUDGET_MS	2.0		//upload time per frame
+
+//mipmap streaming of separate textures (TEXTURE_ARRAYS 0), requires asynchronous loading
+#define TEXTURE_STREAMING				1
+#define TEXTURE_STREAMING_BUDGET_MB		256		//GPU memory of streamed mipmaps
+#define TEXTURE_STREAMING_TAIL			64		//levels up to this size are always resident
+#define TEXTURE_STREAMING_REQUESTS		4		//new level loads per frame
+#define TEXTURE_STREAMING_IDLE_FRAMES	120		//textures unused for this long lose detail first
+
+//workers of shared thread pool are pinned to logical cores 1..n (core 0 is left to main thread)
+#define THREAD_POOL_PINNING			0
+
+//frames whose culling and light grid run on simulation thread ahead of rendered frame,
+//latency grows by a frame per level, 0 = whole frame on main thread
+#define FRAME_PIPELINE_DEPTH		1
+
+//offscreen mode (--offscreen [frames]), frames are rendered to FBO without window, tweakbar and input,
+//context is created by hidden GLFW window (needs display), EGL surfaceless platform (Mesa) or OSMesa,
+//selected by --offscreen-api glfw|egl|osmesa, e.g. egl with llvmpipe in containers without display and GPU,
+//libEGL/libOSMesa are loaded at runtime, OSMesa needs binary linked against libOSMesa instead of libGL
+#define OFFSCREEN_API_GLFW		0
+#define OFFSCREEN_API_EGL		1
+#define OFFSCREEN_API_OSMESA	2
+#define OFFSCREEN_CONTEXT_API	OFFSCREEN_API_GLFW	//API used without --offscreen-api
+#define OFFSCREEN_FRAMES		100		//frames rendered when --offscreen has no count
+
+//CPU timer, 1 = TSC read by rdtscp with calibrated frequency (requires invariant TSC),
+//0 = QueryPerformanceCounter / clock_gettime
+#define PERFORMANCE_TIMER_TSC 0
+
+//CPU timing statistics, values are kept in log-linear histogram
+#define SAMPLE_HISTOGRAM_SUB_BITS	7		//2^bits buckets per power of two, relative error < 2^-(bits-1)
+#define SAMPLE_AGGREGATOR_THREADS	32		//per-thread histograms, more threads share them
+#define CPU_STATS_INTERVAL			1.0		//seconds between refreshes of CPU percentiles in tweakbar
+
+//CPU zone profiler (PROFILE_ZONE), trace is saved by F12 key
+#define ZONE_PROFILER_ENABLED		1
+#define ZONE_PROFILER_EVENTS		16384	//ring of zones per thread, older zones are overwritten
+#define ZONE_PROFILER_THREADS		32		//threads over this count are not recorded
+#define ZONE_TRACE_FILE				"trace.json"
+
+//input of light grid build saved by F11 key, replayed by tools/gridbench
+#define GRID_INPUT_FILE				"grid_input.txt"
+
+//stream of light grid inputs of every frame, capture is toggled by F10 key
+#define GRID_SNAPSHOT_FILE				"grid_snapshot.bin"
+#define GRID_SNAPSHOT_KEYFRAME_INTERVAL	60		//frames between frames stored without delta
+
+//parallel light grid build (LightGrid::setThreadPool), tile rows are split into bands
+#define GRID_ROWS_PER_JOB			2		//minimal band of rows per job
+#define GRID_PARALLEL_MIN_LIGHTS	64		//smaller light sets are built on calling thread
+
+//statistics of lights per tile, threshold matches the top band of light heat map
+#define GRID_STATS_THRESHOLD		60
+#define GRID_HISTOGRAM_BINS			(MAX_LIGHTS + 1)	//one bin per light count
+
+//CPU reference of tiled deferred light pass, G-buffer and GPU result are compared by F9 key,
+//GridBench --shade shades synthetic G-buffers. Only ReferenceShadingAvx2.cpp is compiled with /arch:AVX2,
+//it is called when CPUID reports AVX2 support, scalar path is used otherwise
+#define REFERENCE_SHADING_AVX2				1			//8 pixels at once on CPUs with AVX2
+#define REFERENCE_SHADING_TILES_PER_JOB		4			//tiles of single thread pool job
+#define REFERENCE_SHADING_PREFIX			"reference"	//F9 writes <prefix>_cpu.pfm and <prefix>_gpu.pfm
+
+//animated lights (L key, --animate-lights, GridBench --animate), the first part of light set
+//is animated by LightAnimator, path of path lights is ellipse inside scene bounds
+#define LIGHT_ANIMATION_FRACTION		0.75	//animated part of light set, the rest stays static
+#define LIGHT_ANIMATION_PATH_FRACTION	0.25	//part of animated lights following path, the others orbit
+#define LIGHT_ANIMATION_PATH_POINTS		16		//points of default path
+#define LIGHT_ANIMATION_PATH_PERIOD		30.0	//seconds of the slowest lap of path
+#define LIGHT_ANIMATION_ORBIT_RADIUS	150.0	//maximal orbit radius, path lights circle at tenth of it
+#define LIGHT_ANIMATION_ORBIT_SPEED		1.5		//maximal angular speed of orbit (radians per second)
+#define LIGHT_ANIMATION_FLICKER			0.5		//maximal drop of intensity by flicker
+#define LIGHT_ANIMATION_FLICKER_SPEED	9.0		//angular speed of flicker (radians per second)
+#define LIGHT_ANIMATION_PULSE			0.25	//maximal relative change of radius
+#define LIGHT_ANIMATION_PULSE_SPEED		3.0		//maximal angular speed of pulse (radians per second)
+#define LIGHT_ANIMATION_GROUPS_PER_JOB	256		//groups of 4 lights per thread pool job
+#define LIGHT_ANIMATION_PARALLEL_MIN	4096	//smaller light sets are animated on calling thread
+
+//benchmark mode (--benchmark), frames per configuration of sweep
+#define BENCHMARK_WARMUP_FRAMES		100
+#define BENCHMARK_MEASURED_FRAMES	500
+#define GPU_TIMER_FRAMES			4		//frames of GPU profiler ring, results are usually read 2-3 frames later
+
+//camera track recording (C key) and playback (P key)
+#define CAMERA_TRACK_FILE		"camera_track.txt"	//default file, --camera-track <file> loads another one
+#define CAMERA_RECORD_INTERVAL	0.1					//seconds between recorded keyframes
+#define CAMERA_PLAYBACK_FPS		60.0				//track time advances by 1 / fps per played frame
+
 //mouse
 #define MOUSE_SENSITIVITY 0.05
 
@@ -92,4 +218,6 @@ typedef struct
 {
 	float min;
 	float max;
-} MinMax;
\ No newline at end of file
+} MinMax;
+
+#endif // _Config_h_
\ No newline at end of file
@@ -21,6 +21,8 @@ File information
 This file contains types and structures used in application.
 */
 
+#include "utils\timers\GpuProfiler.h"
+
 /// <summary>
 /// Transformation matrices
 /// </summary>
@@ -33,3 +35,42 @@ struct Matrices
 	glm::mat4 normal;
 };
 
+/// <summary>
+/// CPU phases of frame measured by sample aggregators
+/// </summary>
+enum CpuPhase
+{
+	CP_Frame,			//whole iteration of main loop
+	CP_Update,			//input, camera and scene graph update
+	CP_Textures,		//texture uploads and streaming requests
+	CP_Culling,			//frustum and occlusion culling (simulation thread)
+	CP_GridBuild,		//light grid build, with min/max depth readback on render thread
+	CP_Render,			//render submission including buffer swap
+	CP_PacketWait,		//render thread waiting for frame packet of simulation thread
+	CP_Latency,			//input capture to buffer swap of the same frame
+	CP_Job,				//single job of shared thread pool (any thread)
+	CP_Max,
+};
+
+/// <summary>
+/// Per-frame statistics shown in profiling bar
+/// </summary>
+struct FrameStatistics
+{
+	unsigned int drawsTotal;		//submeshes in scene
+	unsigned int drawsVisible;		//submeshes passed to geometry passes
+	unsigned int drawsFrustumCulled;	//submeshes rejected by frustum culling
+	unsigned int drawsOcclusionCulled;	//submeshes hidden behind occluders
+	unsigned int trianglesSubmitted;	//triangles of selected LODs of visible submeshes (all instances)
+	unsigned int instances;			//instances of scene mesh
+	float streamedTextureMB;		//GPU memory of resident (and loading) streamed mipmaps
+	float gpuPassMs[GP_Max];		//GPU time of passes, read few frames later
+	float gpuFrameMs;				//GPU time from start of the first to end of the last pass
+	float cpuP50Ms[CP_Max];			//CPU time percentiles of phases, refreshed every CPU_STATS_INTERVAL
+	float cpuP99Ms[CP_Max];
+	float tileLightsMean;			//lights per tile of light grid, zero without tiled technique
+	unsigned int tileLightsP95;
+	unsigned int tileLightsMax;
+	unsigned int lightListLength;	//entries of all tile light lists
+	float tilesOverThreshold;		//percentage of tiles with more than GRID_STATS_THRESHOLD lights
+};
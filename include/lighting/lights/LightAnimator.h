@@ -0,0 +1,82 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of light animator. Part of light set is animated every frame
+(orbit around base position, path following, flickering intensity and
+pulsing radius), parameters and results are stored in SoA layout.
+*/
+
+#ifndef _LightAnimator_h_
+#define _LightAnimator_h_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "lighting\lights\PointLight.h"
+#include "collision\BoundingVolumes.h"
+
+class ThreadPool;
+
+/// <summary>
+/// SIMD light animator, four lights are updated at once from SoA copy of base
+/// lights. The first part of light set is animated (path lights first, then
+/// orbiting lights), the rest stays static, so animated lights form single
+/// range which is overwritten in place. Animation depends only on time, base
+/// lights and seed.
+/// </summary>
+class LightAnimator
+{
+	public:
+		LightAnimator();
+		~LightAnimator();
+
+		void setLights(const Lights &lights, const AABB &bounds, unsigned int seed);
+		void setPath(const std::vector<glm::vec3> &points);
+		void setColors(const Lights &lights);
+
+		unsigned int update(float time, Lights &lights, ThreadPool *pool = NULL);
+
+		unsigned int getLightCount() const { return m_lightCount; }
+		unsigned int getAnimatedCount() const { return m_animatedCount; }
+		unsigned int getPathCount() const { return m_pathCount; }
+
+	protected:
+		void updateGroups(unsigned int groupBegin, unsigned int groupEnd, float time, Light *lights);
+
+		//base state of lights [SoA, padded to multiple of 4]
+		std::vector<float> m_baseX, m_baseY, m_baseZ;
+		std::vector<float> m_baseR, m_baseG, m_baseB;
+		std::vector<float> m_baseRadius;
+
+		//animation parameters [SoA, padded to multiple of 4]
+		std::vector<float> m_orbitRadius, m_orbitSpeed, m_orbitPhase;
+		std::vector<float> m_pathOffset, m_pathSpeed;		//path lap fraction at time 0, laps per second
+		std::vector<float> m_flickerAmount, m_flickerPhase;
+		std::vector<float> m_pulseAmount, m_pulseSpeed, m_pulsePhase;
+
+		//closed path, the first point is repeated at the end
+		std::vector<float> m_pathX, m_pathY, m_pathZ;
+
+		unsigned int m_lightCount;
+		unsigned int m_animatedCount;
+		unsigned int m_pathCount;
+};
+
+#endif // _LightAnimator_h_
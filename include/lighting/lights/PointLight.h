@@ -21,6 +21,9 @@ File information
 Definition of point light.
 */
 
+#ifndef _PointLight_h_
+#define _PointLight_h_
+
 #include <glm/glm.hpp>
 #include <vector>
 
@@ -31,4 +34,6 @@ typedef struct
 	float radius;
 } Light;
 
-typedef std::vector<Light> Lights;
\ No newline at end of file
+typedef std::vector<Light> Lights;
+
+#endif // _PointLight_h_
\ No newline at end of file
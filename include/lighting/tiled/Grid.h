@@ -18,33 +18,54 @@ using C/C++ with some external helper libraries to handle basic operations.
 
 File information
 -----------------
-Light grid definition.
+Light grid definition. Grid has no OpenGL dependency, so it can be built
+and benchmarked without window (tools/gridbench).
 */
 
-#include <GL\glew.h>
+#ifndef _Grid_h_
+#define _Grid_h_
+
 #include <vector>
 #include <glm\glm.hpp>
 #include <iostream>
 #include <fstream>
 
+#include "configuration\Config.h"
+#include "lighting\lights\PointLight.h"
+
+class ThreadPool;
+
 class LightGrid
 {
 	public:
 		LightGrid();
+		LightGrid(const glm::uvec2 &resolution, unsigned int tileSize);
 		~LightGrid();
 
-		void showLightQuads();
-		void showLightTiles();
+		void resize(const glm::uvec2 &resolution, unsigned int tileSize);
+
+		void setThreadPool(ThreadPool *pool){ threadPool = pool; }
+		unsigned int computeChecksum() const;
 
 		unsigned int *getCounts(){
-			return counts;
+			return &counts[0];
 		}
 		
 		unsigned int *getOffsets(){
-			return offsets;
+			return &offsets[0];
 		}
 
-		unsigned int getLightListLength(){
+		const unsigned int *getCounts() const { return &counts[0]; }
+		const unsigned int *getOffsets() const { return &offsets[0]; }
+
+		glm::uvec2 getResolution() const { return glm::uvec2(gridResolution); }
+		const glm::uvec2 &getGridDim() const { return gridDim; }
+		unsigned int getTileCount() const { return gridDim.x * gridDim.y; }
+		unsigned int getTileSize() const { return gridTileSize; }
+
+		const std::vector<BoundingBox> &getBoundingQuads() const { return quads; }
+
+		unsigned int getLightListLength() const {
 			return (unsigned int)globalLightList.size();
 		}
 
@@ -57,6 +78,16 @@ class LightGrid
 
 		void computeBoundingQuads(const Lights &lights, const glm::mat4 &modelView, const glm::mat4 &projection, float n);
 		void computeLightAffectedTiles(float minx, float maxx, float miny, float maxy);
+		void countTileLights(unsigned int rowBegin, unsigned int rowEnd);
+		void fillTileLights(unsigned int rowBegin, unsigned int rowEnd);
+		void forEachRowBand(void (LightGrid::*pass)(unsigned int, unsigned int));
+
+		bool isLightInTile(const Light &l, unsigned int x, unsigned int y) const
+		{
+			//tests light against the minimum/maximum of depth buffer 
+			return gridMinMax.empty() || gridMinMax[y * gridDim.x + x].max < (l.position.z + l.radius) &&
+				gridMinMax[y * gridDim.x + x].min > (l.position.z - l.radius);
+		}
 
 		unsigned int lightListLength;
 		std::vector<BoundingBox> quads;
@@ -64,9 +95,17 @@ class LightGrid
 		std::vector<TileArea> affectedTiles;
 
 		std::vector<int> globalLightList;
-		unsigned int offsets[TILES_COUNT];
-		unsigned int counts[TILES_COUNT];
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> counts;
 		
 		std::vector<MinMax> gridMinMax;
 
-};
\ No newline at end of file
+		glm::vec2 gridResolution;		//viewport in pixels
+		unsigned int gridTileSize;		//tile size in pixels
+		glm::uvec2 gridDim;				//tiles along x and y
+
+		ThreadPool *threadPool;				//tile rows are processed in parallel if set
+
+};
+
+#endif // _Grid_h_
\ No newline at end of file
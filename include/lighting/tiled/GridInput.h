@@ -0,0 +1,52 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of light grid input. Captures everything LightGrid::buildLightGrid
+reads in one frame, so that the grid can be rebuilt offline (tools/gridbench).
+*/
+
+#ifndef _GridInput_h_
+#define _GridInput_h_
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "configuration\Config.h"
+#include "lighting\lights\PointLight.h"
+
+/// <summary>
+/// Input of light grid build
+/// </summary>
+typedef struct
+{
+	glm::uvec2 resolution;
+	unsigned int tileSize;
+	float nearPlane;
+	glm::mat4 view;
+	glm::mat4 projection;
+	Lights lights;						//world space lights
+	std::vector<MinMax> tileDepthRanges;	//empty if min/max depth pass was disabled
+} GridInput;
+
+bool saveGridInput(const std::string &filename, const GridInput &input);
+bool loadGridInput(const std::string &filename, GridInput &input);
+
+#endif // _GridInput_h_
@@ -0,0 +1,87 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of light grid snapshot stream. Inputs of light grid builds are
+written frame by frame into compact binary stream, so that captured frames
+can be replayed offline (GridBench --replay) and compared by grid checksum.
+*/
+
+#ifndef _GridSnapshot_h_
+#define _GridSnapshot_h_
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "lighting\tiled\GridInput.h"
+
+/// <summary>
+/// Writes light grid inputs to snapshot stream. Every 32-bit value is XORed
+/// with the same value of previous frame, non-zero deltas are stored as
+/// varints and runs of unchanged values by their length. Keyframes (no
+/// previous frame) are written every GRID_SNAPSHOT_KEYFRAME_INTERVAL frames
+/// and when light count changes.
+/// </summary>
+class GridSnapshotWriter
+{
+	public:
+		GridSnapshotWriter();
+		~GridSnapshotWriter();
+
+		bool open(const std::string &filename);
+		void close();
+		bool isOpen() const { return m_file.is_open(); }
+
+		void write(const GridInput &input, unsigned int checksum);
+
+		unsigned int getFrameCount() const { return m_frame; }
+		unsigned long long getBytesWritten() const { return m_bytesWritten; }
+
+	protected:
+		std::ofstream m_file;
+		std::vector<unsigned int> m_previous;	//values of previous frame
+		std::vector<unsigned int> m_values;
+		std::vector<unsigned char> m_buffer;	//encoded frame
+		unsigned int m_frame;
+		unsigned long long m_bytesWritten;
+};
+
+/// <summary>
+/// Reads light grid inputs from snapshot stream written by GridSnapshotWriter.
+/// </summary>
+class GridSnapshotReader
+{
+	public:
+		GridSnapshotReader();
+
+		bool open(const std::string &filename);
+		bool read(GridInput &input, unsigned int &checksum);
+
+		unsigned int getFrame() const { return m_frame; }
+
+	protected:
+		std::ifstream m_file;
+		std::vector<unsigned int> m_previous;
+		std::vector<unsigned int> m_values;
+		std::vector<unsigned char> m_buffer;
+		unsigned int m_frame;					//index of last read frame
+};
+
+#endif // _GridSnapshot_h_
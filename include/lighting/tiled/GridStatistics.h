@@ -0,0 +1,47 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of light grid statistics. Numbers of lights per tile computed
+from tile light counts of built grid, used to tune tile size and light radii
+against shading cost.
+*/
+
+#ifndef _GridStatistics_h_
+#define _GridStatistics_h_
+
+#include "configuration\Config.h"
+
+/// <summary>
+/// Statistics of light lists of single grid
+/// </summary>
+typedef struct
+{
+	unsigned int tiles;
+	unsigned int listLength;		//entries of all tile light lists
+	float meanLights;
+	unsigned int p95Lights;			//clamped to GRID_HISTOGRAM_BINS - 1
+	unsigned int maxLights;
+	float overThreshold;			//fraction of tiles with more than GRID_STATS_THRESHOLD lights
+	unsigned int histogram[GRID_HISTOGRAM_BINS];	//tiles by light count, the last bin counts also longer lists
+} GridStatistics;
+
+void computeGridStatistics(const unsigned int *counts, unsigned int tileCount, GridStatistics &stats);
+
+#endif // _GridStatistics_h_
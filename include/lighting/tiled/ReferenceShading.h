@@ -0,0 +1,81 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of CPU reference of tiled deferred light pass. Shades G-buffer
+kept in CPU memory with light lists of built LightGrid by the same model as
+tiled_deferred_frag.glsl, so GPU output can be checked and lighting cost
+measured without OpenGL (tools/gridbench --shade).
+*/
+
+#ifndef _ReferenceShading_h_
+#define _ReferenceShading_h_
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+class LightGrid;
+class ThreadPool;
+
+/// <summary>
+/// G-buffer in CPU memory. Every channel is separate plane of pixels stored
+/// by rows from the bottom one (as read from OpenGL textures), positions and
+/// normals are in view space. Pixels with zero normal are background.
+/// </summary>
+typedef struct
+{
+	glm::uvec2 resolution;
+	std::vector<float> diffuse[3];
+	std::vector<float> normal[3];
+	std::vector<float> position[3];
+	std::vector<float> specular[3];
+	std::vector<float> shininess;
+} ShadingGBuffer;
+
+/// <summary>
+/// RGB image with channel planes, same layout as G-buffer
+/// </summary>
+typedef struct
+{
+	glm::uvec2 resolution;
+	std::vector<float> color[3];
+} ShadingImage;
+
+/// <summary>
+/// Absolute difference of two images
+/// </summary>
+typedef struct
+{
+	float maxError;
+	float meanError;
+	unsigned int pixels;		//pixels finite in both images
+	unsigned int nonFinite;		//pixels skipped because of NaN/Inf
+} ImageDifference;
+
+void resizeGBuffer(ShadingGBuffer &gBuffer, const glm::uvec2 &resolution);
+void resizeImage(ShadingImage &image, const glm::uvec2 &resolution);
+
+bool isSimdShadingAvailable();
+void shadeTiledDeferred(const ShadingGBuffer &gBuffer, const LightGrid &grid, ShadingImage &image, ThreadPool *pool = NULL, bool simd = true);
+
+void compareImages(const ShadingImage &a, const ShadingImage &b, ImageDifference &difference);
+bool saveImagePfm(const std::string &filename, const ShadingImage &image);
+
+#endif // _ReferenceShading_h_
@@ -0,0 +1,58 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Interface of AVX2 kernel of CPU reference shading. Only plain types are used,
+kernel translation unit is compiled with AVX2 code generation and must not
+instantiate inline code (glm, STL) shared with the rest of application.
+*/
+
+#ifndef _ReferenceShadingKernel_h_
+#define _ReferenceShadingKernel_h_
+
+/// <summary>
+/// Point light as seen by kernel, same layout as Light
+/// </summary>
+typedef struct
+{
+	float position[3];
+	float color[3];
+	float radius;
+} ShadingKernelLight;
+
+/// <summary>
+/// G-buffer planes, output planes and lights of shaded tile
+/// </summary>
+typedef struct
+{
+	const float *diffuse[3];
+	const float *normal[3];
+	const float *position[3];
+	const float *specular[3];
+	const float *shininess;
+	float *color[3];
+	const ShadingKernelLight *lights;
+	const int *lightIDs;
+	unsigned int lightCount;
+} ShadingKernelTile;
+
+bool isAvx2ShadingCompiled();
+unsigned int shadeRowAvx2(const ShadingKernelTile &tile, unsigned int index, unsigned int count);
+
+#endif // _ReferenceShadingKernel_h_
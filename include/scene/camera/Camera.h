@@ -52,6 +52,11 @@ class Camera
 		void angleOrientation(float upAngle, float rightAngle);
 		glm::mat4 orientation();
 
+		//camera orientation angles (degrees) get, set
+		float horizontalAngle();
+		float verticalAngle();
+		void setAngles(float hAngle, float vAngle);
+
 		//camera directions
         glm::vec3 forward();
         glm::vec3 right();
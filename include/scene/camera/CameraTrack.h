@@ -0,0 +1,68 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of camera track. Track is sequence of timestamped camera
+keyframes, camera between keyframes follows Catmull-Rom spline.
+*/
+
+#ifndef _CameraTrack_h_
+#define _CameraTrack_h_
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Camera state at given time of track
+/// </summary>
+typedef struct
+{
+	float time;			//seconds from track start
+	glm::vec3 position;
+	float hAngle;		//horizontal angle in degrees
+	float vAngle;		//vertical angle in degrees
+} CameraKeyframe;
+
+/// <summary>
+/// Camera track, stored as text file with one "time x y z hAngle vAngle"
+/// keyframe per line. Keyframe times must increase.
+/// </summary>
+class CameraTrack
+{
+	public:
+		CameraTrack();
+
+		void clear();
+		bool addKeyframe(const CameraKeyframe &keyframe);
+
+		CameraKeyframe sample(float time) const;
+
+		bool save(const std::string &filename) const;
+		bool load(const std::string &filename);
+
+		bool empty() const { return m_keyframes.empty(); }
+		unsigned int getKeyframeCount() const { return (unsigned int)m_keyframes.size(); }
+		float getDuration() const { return m_keyframes.empty() ? 0.0f : m_keyframes.back().time; }
+
+	protected:
+		std::vector<CameraKeyframe> m_keyframes;
+};
+
+#endif // _CameraTrack_h_
@@ -0,0 +1,92 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of lightweight scene graph. Nodes hold transforms relative to
+parent and reference meshes, nodes sharing mesh are drawn instanced.
+*/
+
+#ifndef _SceneGraph_h_
+#define _SceneGraph_h_
+
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class Mesh;
+
+/// <summary>
+/// Flat scene graph. Nodes are stored in creation order (parent always before
+/// child), so world transforms are resolved in single pass. Meshes referenced
+/// by nodes are grouped to instance batches, one transforms buffer per mesh.
+/// Meshes are not owned by graph.
+/// </summary>
+class SceneGraph
+{
+	public:
+		SceneGraph();
+		~SceneGraph();
+
+		int addNode(Mesh *mesh, const glm::mat4 &transform, int parent = -1);
+		void setTransform(int node, const glm::mat4 &transform);
+		void clear();
+
+		void update();
+
+		const glm::mat4 &getWorldTransform(int node) const { return m_nodes[node].world; }
+		unsigned int getNodeCount() const { return (unsigned int)m_nodes.size(); }
+		unsigned int getBatchCount() const { return (unsigned int)m_batches.size(); }
+		unsigned int getInstanceCount() const;
+
+	protected:
+		/// <summary>
+		/// Scene node
+		/// </summary>
+		struct SceneNode
+		{
+			int parent;				//-1 = root
+			Mesh *mesh;				//NULL = transform only node
+			glm::mat4 local;		//transform relative to parent
+			glm::mat4 world;
+		};
+
+		/// <summary>
+		/// Instances of single mesh
+		/// </summary>
+		struct InstanceBatch
+		{
+			Mesh *mesh;
+			std::vector<glm::mat4> transforms;
+			GLuint buffer;
+		};
+
+		void releaseBatches();
+
+		std::vector<SceneNode> m_nodes;
+		std::vector<InstanceBatch> m_batches;
+
+		bool m_dirty;	//transforms or structure changed since last update()
+
+	private:
+		//copying disabled
+		SceneGraph(const SceneGraph&);
+		const SceneGraph& operator=(const SceneGraph&);
+};
+
+#endif // _SceneGraph_h_
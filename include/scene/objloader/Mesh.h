@@ -21,6 +21,9 @@ File information
 Mesh class header file.
 */
 
+#ifndef _Mesh_h_
+#define _Mesh_h_
+
 #include <vector>
 #include <GL/glew.h>
 
@@ -30,6 +33,13 @@ Mesh class header file.
 #include <glm/glm.hpp>
 
 #include "textures\texture.h"
+#include "textures\TextureArray.h"
+#include "textures\TextureLoader.h"
+#include "textures\TextureRegistry.h"
+#include "textures\TextureStreamer.h"
+#include "scene\objloader\MeshData.h"
+#include "collision\BoundingVolumes.h"
+#include "configuration\Config.h"
 
 #define POS_VBO 0
 #define TEXCOORD_VBO 1
@@ -37,6 +47,20 @@ Mesh class header file.
 #define TANGENT_VBO 3
 #define BITANGENT_VBO 4
 #define INDICES_VBO 5
+#define INSTANCE_VBO 6
+#define VBO_COUNT 7
+
+//per-instance model matrix occupies attribute locations 5 .. 8
+#define INSTANCE_ATTRIBUTE 5
+
+/// <summary>
+/// Point on mesh surface
+/// </summary>
+typedef struct
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+} SurfaceSample;
 
 /// <summary>
 /// Class that represents loaded Mesh and its renderer
@@ -47,43 +71,131 @@ class Mesh
         Mesh();
         ~Mesh();
 
-        bool LoadMesh(const std::string& Filename);
-		void Render(GLuint shader);
-		void RenderSimple();
+        bool LoadMesh(const std::string& Filename, TextureLoader *loader = NULL, TextureStreamer *streamer = NULL);
+		void updateTextures();
+		void streamTextures(const glm::vec3 &viewPosition, float projectionScale, TextureStreamer &streamer, const std::vector<unsigned int> *drawList = NULL);
+		void Render(GLuint shader, const std::vector<unsigned int> *drawList = NULL);
+		void RenderSimple(const std::vector<unsigned int> *drawList = NULL);
 		glm::vec3 getKd(){ return Kds; }
 		float getSpecExponent() { return specularExponents[0]; }
 
+		//submesh bounding volumes
+		unsigned int getMeshEntriesCount() const { return (unsigned int)meshes.size(); }
+		const AABB &getBounds(unsigned int i) const { return meshes[i].bounds; }
+		const BoundingSphere &getBoundingSphere(unsigned int i) const { return meshes[i].sphere; }
+		void getBounds(std::vector<AABB> &bounds) const;
+
+		//hardware instancing, every draw renders all instances
+		void setInstances(GLuint buffer, const std::vector<glm::mat4> &transforms);
+		unsigned int getInstanceCount() const { return instanceCount; }
+
+		//occluder geometry (submeshes designated as occluders at load time)
+		bool isOccluder(unsigned int i) const { return meshes[i].occluder; }
+		const std::vector<glm::vec3> &getOccluderVertices() const { return occluderVertices; }
+		const std::vector<unsigned int> &getOccluderIndices() const { return occluderIndices; }
+
+		//area uniform points on surface (object space, MESH_SURFACE_SAMPLES at load time)
+		const std::vector<SurfaceSample> &getSurfaceSamples() const { return surfaceSamples; }
+
+		//levels of detail
+		unsigned int computeLods(const glm::vec3 &viewPosition, float projectionScale, float pixelError, int pinnedLod, const std::vector<unsigned int> *drawList, std::vector<unsigned int> &levels) const;
+		void applyLods(const std::vector<unsigned int> &levels, const std::vector<unsigned int> *drawList = NULL);
+		unsigned int getLodCount(unsigned int i) const { return meshes[i].lodCount; }
+		unsigned int getCurrentLod(unsigned int i) const { return meshes[i].currentLod; }
+
+		//groups draws sharing texture bindings
+		void sortDrawList(std::vector<unsigned int> &drawList) const;
+
+		//compares Assimp and OBJ loader import
+		static void benchmarkImport(const std::string& Filename, unsigned int runs);
+
     private:
         void Clear();
+		static bool isObjFile(const std::string& Filename);
+		bool importAssimp(const std::string& Filename, std::vector<MaterialData> &materials);
+		bool importObj(const std::string& Filename, std::vector<MaterialData> &materials);
+		static void readMaterials(const aiScene *oScene, std::vector<MaterialData> &materials);
+		void extractAttributes(unsigned int i, const aiMesh *mesh);
+		void computeBounds(unsigned int i);
+		void sampleSurface(unsigned int count);
+		void generateLods(unsigned int i, unsigned int vertexCount, std::vector<unsigned int> *lodIndices);
+		bool loadMaterialTextures(const std::vector<MaterialData> &materials, const std::string &Dir, TextureLoader *loader, TextureStreamer *streamer);
+		bool loadMaterialArrays(const std::vector<MaterialData> &materials, const std::string &Dir, TextureLoader *loader);
+		void bindMaterialLayers(unsigned int material, const GLint *layerLocations, GLuint *boundArrays, unsigned int count);
+		void bindInstanceAttributes(GLuint buffer);
 
         struct MeshEntry {
 
 			MeshEntry()
 			{
 				numIndices = 0;
+				numVertices = 0;
 				baseVertex = 0;
 				baseIndex = 0;
 				materialIndex = 0;
+				occluder = false;
+				lodCount = 1;
+				currentLod = 0;
+				bounds = emptyAABB();
+				sphere.center = glm::vec3(0.0f);
+				sphere.radius = 0.0f;
+				instanceBounds = bounds;
+				instanceSphere = sphere;
 			}
 
 			unsigned int baseVertex;
 			unsigned int baseIndex;
 			unsigned int numIndices;
+			unsigned int numVertices;
 			unsigned int materialIndex;
+
+			AABB bounds;			//object space bounding box
+			BoundingSphere sphere;	//object space bounding sphere
+			AABB instanceBounds;	//box enclosing all instances (culling, LOD and streaming)
+			BoundingSphere instanceSphere;
+			bool occluder;			//large and simple submesh used for occlusion culling
+
+			//index ranges of levels of detail, level 0 = full resolution (baseIndex, numIndices)
+			struct LodLevel
+			{
+				unsigned int baseIndex;
+				unsigned int numIndices;
+				float error;		//object space geometric error
+			};
+
+			LodLevel lods[MESH_LOD_COUNT];
+			unsigned int lodCount;
+			unsigned int currentLod;	//level used by Render() and RenderSimple()
         };
 
         std::vector<MeshEntry> meshes;
 
 		//TEXTURES
-        std::vector<Texture*> diff_textures;
-		std::vector<Texture*> bump_textures;
-		std::vector<Texture*> spec_textures;
+        std::vector<TextureHandle> diff_textures;
+		std::vector<TextureHandle> bump_textures;
+		std::vector<TextureHandle> spec_textures;
 		glm::vec3 Kds;
 		std::vector<float> specularExponents;
 
 		GLuint defaultTextureOne; /**< all 1, single pixel texture to use when no texture is loaded. */
 		GLuint defaultNormalTexture;  /**< { 0.5, 0.5, 1, 1 }, single pixel float texture to use when no normal texture is loaded. */
 
+		/// <summary>
+		/// Material table entry for texture arrays (TEXTURE_ARRAYS)
+		/// </summary>
+		struct MaterialLayers
+		{
+			TextureSlot diffuse;
+			TextureSlot normal;
+			TextureSlot specular;
+			bool textured;		//material has diffuse texture
+			int images[3];		//packer image ids (diffuse, normal, specular)
+		};
+
+		TextureArrayPacker textureArrays;
+		std::vector<MaterialLayers> materialLayers;
+		TextureSlot defaultLayers[3];
+
 		//CPU DATA
 		//vectors for positions, texcoords, normals, tangents and bitangents, indices
 		std::vector<float> vp;
@@ -93,10 +205,21 @@ class Mesh
 		std::vector<float> vbtn;
 		std::vector<unsigned int> vindices;
 
+		//occluders triangle list, kept after upload for CPU occlusion culling
+		std::vector<glm::vec3> occluderVertices;
+		std::vector<unsigned int> occluderIndices;
+
+		//surface samples, kept for scenario generation
+		std::vector<SurfaceSample> surfaceSamples;
+
 		//GPU DATA
 		//Vertex Buffer Objects
-		GLuint buffers[6];
+		GLuint buffers[VBO_COUNT];
 
 		//Vertex Array Object
-		GLuint vao;		
+		GLuint vao;
+
+		unsigned int instanceCount;	//instances drawn by every draw call
 };
+
+#endif // _Mesh_h_
@@ -0,0 +1,71 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of importer independent mesh description. Importers fill whole
+attribute arrays, Mesh takes them over without conversion.
+*/
+
+#ifndef _MeshData_h_
+#define _MeshData_h_
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Material description
+/// </summary>
+typedef struct
+{
+	std::string diffuseMap;		//texture paths relative to model directory, empty = none
+	std::string normalMap;
+	std::string specularMap;
+	glm::vec3 diffuseColor;
+} MaterialData;
+
+/// <summary>
+/// Range of submesh in attribute and index arrays
+/// </summary>
+typedef struct
+{
+	unsigned int materialIndex;
+	unsigned int baseVertex;
+	unsigned int numVertices;
+	unsigned int baseIndex;
+	unsigned int numIndices;
+} SubmeshData;
+
+/// <summary>
+/// Imported mesh, attributes of all submeshes are stored one after another
+/// </summary>
+struct MeshData
+{
+	std::vector<float> positions;		//3 floats per vertex
+	std::vector<float> texcoords;		//2 floats per vertex
+	std::vector<float> normals;			//3 floats per vertex
+	std::vector<float> tangents;		//3 floats per vertex
+	std::vector<float> bitangents;		//3 floats per vertex
+	std::vector<unsigned int> indices;	//triangle list, relative to baseVertex of submesh
+
+	std::vector<SubmeshData> submeshes;
+	std::vector<MaterialData> materials;
+};
+
+#endif // _MeshData_h_
@@ -0,0 +1,89 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Mesh simplifier definition. Simplifier reduces triangle list of single submesh
+using quadric error metric edge collapses. Vertices are never moved or created,
+so simplified index lists can share vertex buffers with full resolution mesh.
+*/
+
+#ifndef _MeshSimplifier_h_
+#define _MeshSimplifier_h_
+
+#include <vector>
+
+/// <summary>
+/// Progressive quadric error metric simplifier. Every simplify() call continues
+/// from result of previous one, so consecutive calls produce coarser LODs.
+/// </summary>
+class MeshSimplifier
+{
+	public:
+		MeshSimplifier(const float *positions, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount);
+		~MeshSimplifier();
+
+		bool simplify(unsigned int targetIndexCount, std::vector<unsigned int> &indices, float &error);
+
+		unsigned int getIndexCount() const { return (unsigned int)m_indices.size(); }
+
+	protected:
+		/// <summary>
+		/// Symmetric 4x4 error quadric, stores upper triangle
+		/// [a2 ab ac ad b2 bc bd c2 cd d2]
+		/// </summary>
+		struct Quadric
+		{
+			double m[10];
+		};
+
+		/// <summary>
+		/// Candidate collapse of vertex u into vertex v
+		/// </summary>
+		struct Collapse
+		{
+			unsigned int u;
+			unsigned int v;
+			double cost;
+
+			bool operator<(const Collapse &other) const { return cost < other.cost; }
+		};
+
+		void computeQuadrics();
+		void lockBorderVertices();
+		unsigned int collapsePass(unsigned int trianglesToRemove);
+		void removeDegenerates();
+
+		bool flipsTriangle(unsigned int u, unsigned int v) const;
+		double collapseCost(unsigned int u, unsigned int v) const;
+
+		const float *m_positions;
+		unsigned int m_vertexCount;
+
+		std::vector<unsigned int> m_indices;
+		std::vector<Quadric> m_quadrics;
+		std::vector<unsigned char> m_locked;		//border and UV seam vertices
+
+		//vertex -> triangles adjacency, rebuilt every pass
+		std::vector<unsigned int> m_adjacencyOffsets;
+		std::vector<unsigned int> m_adjacency;
+
+		double m_error;		//largest collapse cost so far
+};
+
+#endif // _MeshSimplifier_h_
@@ -0,0 +1,131 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of Wavefront OBJ/MTL loader. Loader is dedicated alternative to
+Assimp import of OBJ scenes, it parses mapped file in parallel chunks.
+*/
+
+#ifndef _ObjLoader_h_
+#define _ObjLoader_h_
+
+#include <string>
+#include <vector>
+#include <map>
+#include "scene\objloader\MeshData.h"
+
+class ThreadPool;
+
+/// <summary>
+/// OBJ/MTL loader. Faces are triangulated, vertices deduplicated per submesh
+/// (one submesh per object/group and material), missing normals and tangent
+/// frames are generated. Output matches Assimp import with Triangulate,
+/// GenSmoothNormals, CalcTangentSpace and FlipUVs flags.
+/// </summary>
+class ObjLoader
+{
+	public:
+		ObjLoader(ThreadPool &pool);
+
+		bool load(const std::string &filename, MeshData &data);
+
+		static float parseFloat(const char *&p, const char *end);
+		static int parseInt(const char *&p, const char *end);
+
+	protected:
+		/// <summary>
+		/// Face corner, 0 based attribute indices, -1 = missing
+		/// </summary>
+		struct Corner
+		{
+			int v;
+			int t;
+			int n;
+		};
+
+		/// <summary>
+		/// usemtl, o and g statements, apply from given face on
+		/// </summary>
+		struct Switch
+		{
+			unsigned int face;
+			bool material;			//FALSE = object / group
+			std::string name;
+		};
+
+		/// <summary>
+		/// Line aligned part of file parsed by single thread
+		/// </summary>
+		struct Chunk
+		{
+			const char *begin;
+			const char *end;
+
+			std::vector<float> positions;
+			std::vector<float> texcoords;
+			std::vector<float> normals;
+
+			std::vector<Corner> corners;
+			std::vector<unsigned char> relative;	//per corner, negative (relative) indices (bits v, t, n)
+			std::vector<unsigned int> faces;		//first corner of every face
+			std::vector<Switch> switches;
+			std::vector<std::string> libraries;
+
+			unsigned int basePosition;				//counts of attributes in previous chunks
+			unsigned int baseTexcoord;
+			unsigned int baseNormal;
+		};
+
+		/// <summary>
+		/// Submesh being built
+		/// </summary>
+		struct Submesh
+		{
+			unsigned int materialIndex;
+			std::vector<unsigned long long> faces;	//chunk << 32 | face
+
+			std::vector<float> positions;
+			std::vector<float> texcoords;
+			std::vector<float> normals;
+			std::vector<float> tangents;
+			std::vector<float> bitangents;
+			std::vector<unsigned int> indices;
+			std::vector<int> positionIds;			//source position of vertex
+		};
+
+		void parseChunk(Chunk &chunk) const;
+		bool loadMaterials(const std::string &filename, MeshData &data, std::map<std::string, unsigned int> &materialIds) const;
+		void buildSubmesh(Submesh &submesh) const;
+		void generateNormals(Submesh &submesh) const;
+		void generateTangents(Submesh &submesh) const;
+
+		ThreadPool &m_pool;
+
+		std::vector<Chunk> m_chunks;
+		std::vector<float> m_positions;
+		std::vector<float> m_texcoords;
+		std::vector<float> m_normals;
+
+	private:
+		//copying disabled
+		ObjLoader(const ObjLoader&);
+		const ObjLoader& operator=(const ObjLoader&);
+};
+
+#endif // _ObjLoader_h_
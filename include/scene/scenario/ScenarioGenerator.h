@@ -0,0 +1,117 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of benchmark scenario generator. Scenario is seeded light set
+of chosen distribution together with instanced layout of scene mesh, it
+can be stored to compact binary file.
+*/
+
+#ifndef _ScenarioGenerator_h_
+#define _ScenarioGenerator_h_
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "lighting\lights\PointLight.h"
+#include "collision\BoundingVolumes.h"
+#include "scene\objloader\Mesh.h"
+
+/// <summary>
+/// Distributions of generated lights
+/// </summary>
+enum LightDistribution
+{
+	LD_Uniform,		//uniform in scene bounds
+	LD_Clustered,	//gaussian clusters around random hotspots
+	LD_Surface,		//slightly above points sampled from mesh surface
+	LD_Corridor,	//narrow tube along the longest horizontal axis
+	LD_Max,
+};
+
+/// <summary>
+/// Instanced layouts of scene mesh
+/// </summary>
+enum SceneLayout
+{
+	SL_Single,		//single identity instance
+	SL_Repeated,	//N x N copies touching by bounding boxes
+	SL_CityGrid,	//N x N blocks separated by streets, randomly rotated, some left empty
+	SL_Max,
+};
+
+/// <summary>
+/// Scenario parameters, generated content depends only on them
+/// </summary>
+typedef struct
+{
+	unsigned int seed;
+	LightDistribution distribution;
+	unsigned int lightCount;
+	float radiusMin;
+	float radiusMax;
+	SceneLayout layout;
+	unsigned int layoutSize;	//blocks along X and Z
+} ScenarioDesc;
+
+/// <summary>
+/// Generated (or loaded) scenario
+/// </summary>
+struct Scenario
+{
+	ScenarioDesc desc;
+	Lights lights;
+	std::vector<glm::mat4> instances;	//model matrices of scene mesh
+};
+
+/// <summary>
+/// Deterministic scenario generator. The same parameters give the same
+/// scenario on every platform (own conversion of mt19937 output is used
+/// instead of implementation defined std distributions). Lights and layout
+/// use separate random streams.
+/// </summary>
+class ScenarioGenerator
+{
+	public:
+		ScenarioGenerator(const AABB &meshBounds, const std::vector<SurfaceSample> &surface);
+
+		void generate(const ScenarioDesc &desc, Scenario &scenario) const;
+		void generateLayout(const ScenarioDesc &desc, std::vector<glm::mat4> &instances) const;
+		void generateLights(const ScenarioDesc &desc, const std::vector<glm::mat4> &instances, Lights &lights) const;
+
+		AABB getSceneBounds(const std::vector<glm::mat4> &instances) const;
+
+		static bool save(const std::string &filename, const Scenario &scenario);
+		static bool load(const std::string &filename, Scenario &scenario);
+
+		static const char *getDistributionName(LightDistribution distribution);
+		static const char *getLayoutName(SceneLayout layout);
+
+	protected:
+		AABB m_meshBounds;
+		const std::vector<SurfaceSample> &m_surface;
+
+	private:
+		//copying disabled
+		ScenarioGenerator(const ScenarioGenerator&);
+		const ScenarioGenerator& operator=(const ScenarioGenerator&);
+};
+
+#endif // _ScenarioGenerator_h_
@@ -21,21 +21,43 @@ File information
 Header file of Texture loader class.
 */
 
+#include "textures\TextureCooker.h"
+
+class TextureLoader;
+class TextureStreamer;
+
 /// <summary>
 /// Texture class
 /// </summary>
 class Texture
 {
 	public:
-		Texture(GLenum TextureTarget, const std::string& filename);
+		Texture(GLenum TextureTarget, const std::string& filename, TextureKind kind = TEXTURE_KIND_COLOR);
+		~Texture();
 
 		bool Load(bool srgb);
+		bool LoadAsync(bool srgb, TextureLoader &loader);
+		bool LoadStreamed(bool srgb, TextureStreamer &streamer);
+		bool isResident() const;
+		size_t getMemorySize() const { return m_memorySize; }
 
 		void Bind(GLenum textureUnit);
 		void Bind(GLenum textureUnit, GLuint defaultTex);
 
 	protected:
+		GLenum chooseFormat(bool srgb, int components) const;
+		void uploadCooked(const CookedImage &image);
+
 		std::string m_filename;
 		GLuint m_textureObj;
 		GLenum m_textureTarget;
+		TextureKind m_kind;
+		size_t m_memorySize;	//GPU memory including mipmaps
+
+		//asynchronous loading, NULL loader = loaded synchronously
+		TextureLoader *m_loader;
+		unsigned int m_loadId;
+
+		//mipmap streaming, NULL = all levels resident
+		TextureStreamer *m_streamer;
 };
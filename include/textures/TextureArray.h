@@ -0,0 +1,107 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of texture array packer. Packer groups textures of the same size
+and format (block compressed formats chosen by texture cooker) into
+GL_TEXTURE_2D_ARRAY objects, so materials are described by
+array and layer index instead of separate texture objects.
+*/
+
+#ifndef _TextureArray_h_
+#define _TextureArray_h_
+
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "textures\TextureCooker.h"
+
+class TextureLoader;
+
+/// <summary>
+/// Location of packed texture
+/// </summary>
+typedef struct
+{
+	int array;		//index of array in packer, -1 = not packed
+	int layer;		//layer in array
+} TextureSlot;
+
+/// <summary>
+/// Texture array packer. Images are registered first (only headers are read),
+/// build() then allocates one array per size/format group and uploads layers
+/// one image at a time, or hands them over to asynchronous loader.
+/// </summary>
+class TextureArrayPacker
+{
+	public:
+		TextureArrayPacker();
+		~TextureArrayPacker();
+
+		int addImage(const std::string &filename, TextureKind kind);
+		int addColor(const glm::vec4 &color);
+
+		bool build(TextureLoader *loader = NULL);
+		void update();
+		void clear();
+
+		TextureSlot getSlot(int id) const;
+		bool isResident(int id) const;
+		GLuint getArrayObject(int array) const { return m_arrays[array].object; }
+		unsigned int getArrayCount() const { return (unsigned int)m_arrays.size(); }
+
+	protected:
+		/// <summary>
+		/// Registered image
+		/// </summary>
+		struct Entry
+		{
+			std::string filename;	//empty for solid color
+			glm::vec4 color;
+			int width;
+			int height;
+			GLenum format;			//internal format
+			TextureSlot slot;
+			int loadId;				//asynchronous load request, -1 = uploaded by build()
+		};
+
+		/// <summary>
+		/// Array of same sized and formatted layers
+		/// </summary>
+		struct Group
+		{
+			int width;
+			int height;
+			GLenum format;			//internal format, compressed layers carry own mipmaps
+			unsigned int layers;
+			GLuint object;
+			int levels;
+			bool complete;			//all layers uploaded and mipmaps generated
+		};
+
+		int findGroup(int width, int height, GLenum format);
+
+		std::vector<Entry> m_entries;
+		std::vector<Group> m_arrays;
+
+		TextureLoader *m_loader;
+};
+
+#endif // _TextureArray_h_
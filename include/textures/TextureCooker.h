@@ -0,0 +1,82 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of texture cooker. Cooker converts source images to block
+compressed formats (BC1/BC3 for color, BC5 for normal maps) with full mipmap
+chains and keeps results in cache files next to source images.
+*/
+
+#ifndef _TextureCooker_h_
+#define _TextureCooker_h_
+
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+/// <summary>
+/// Usage of texture, decides its compressed format
+/// </summary>
+enum TextureKind
+{
+	TEXTURE_KIND_COLOR = 0,		//albedo, specular (SRGB)
+	TEXTURE_KIND_NORMAL			//tangent space normal map
+};
+
+/// <summary>
+/// Mipmap chain of texture in its GPU format
+/// </summary>
+typedef struct
+{
+	GLenum format;		//internal format
+	int width;
+	int height;
+	std::vector<std::vector<unsigned char> > levels;	//levels below requested first level are empty
+} CookedImage;
+
+/// <summary>
+/// Texture cooker, all methods are thread safe.
+/// </summary>
+class TextureCooker
+{
+	public:
+		static GLenum chooseFormat(TextureKind kind, int components);
+		static bool isCompressed(GLenum format);
+		static unsigned int levelSize(GLenum format, int width, int height);
+		static int levelCount(int width, int height);
+		static size_t chainSize(GLenum format, int width, int height);
+
+		static bool load(const std::string &filename, GLenum format, CookedImage &image, int firstLevel = 0);
+
+		static void generateMipmaps(const unsigned char *rgba, int width, int height, bool normalMap, std::vector<std::vector<unsigned char> > &levels);
+		static void compress(const unsigned char *rgba, int width, int height, GLenum format, std::vector<unsigned char> &blocks);
+
+		static void compressBlockBC1(const unsigned char *block, unsigned char *out);
+		static void compressBlockBC3(const unsigned char *block, unsigned char *out);
+		static void compressBlockBC5(const unsigned char *block, unsigned char *out);
+
+	protected:
+		static void compressBlockBC4(const unsigned char *block, unsigned int channel, unsigned char *out);
+
+		static std::string cachePath(const std::string &filename);
+		static bool readCache(const std::string &filename, GLenum format, CookedImage &image, int firstLevel);
+		static bool writeCache(const std::string &filename, const CookedImage &image);
+};
+
+#endif // _TextureCooker_h_
@@ -0,0 +1,114 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of asynchronous texture loader. Images are decoded (or loaded
+from cooked texture cache) by worker threads into bounded queue, GL thread uploads them through pixel buffer
+objects within per-frame time budget.
+*/
+
+#ifndef _TextureLoader_h_
+#define _TextureLoader_h_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <GL/glew.h>
+#include "textures\TextureCooker.h"
+
+/// <summary>
+/// Asynchronous texture loader. request() may be called only from GL thread,
+/// as well as update() which performs uploads.
+/// </summary>
+class TextureLoader
+{
+	public:
+		/// <summary>
+		/// Residency state of requested image
+		/// </summary>
+		enum State
+		{
+			PENDING = 0,
+			RESIDENT,
+			FAILED
+		};
+
+		TextureLoader(unsigned int decodeThreads = 0, unsigned int queueCapacity = 8);
+		~TextureLoader();
+
+		unsigned int request(const std::string &filename, GLenum target, GLuint texture, GLenum format, int layer = -1, int firstLevel = -1, int lastLevel = -1);
+		unsigned int update(double budgetMs);
+		void finish();
+
+		State getState(unsigned int id) const { return (State)m_states[id]; }
+		bool isResident(unsigned int id) const { return m_states[id] == RESIDENT; }
+		unsigned int getPendingCount() const { return m_pendingCount; }
+
+	protected:
+		/// <summary>
+		/// Upload job, data is filled by decode thread
+		/// </summary>
+		struct Job
+		{
+			unsigned int id;
+			std::string filename;
+			GLenum target;		//GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+			GLuint texture;
+			GLenum format;		//internal format, compressed formats are loaded by cooker
+			int layer;			//array layer, -1 for 2D textures
+			int firstLevel;		//uploaded levels of streamed texture, -1 = whole image
+			int lastLevel;
+
+			unsigned char *data;	//RGBA8 image of uncompressed format
+			CookedImage *cooked;	//mipmap chain of compressed format
+			int width;
+			int height;
+		};
+
+		void decodeLoop();
+		void upload(Job &job);
+		void release(Job &job);
+
+		std::vector<std::thread> m_workers;
+
+		//requests waiting for decoding
+		std::deque<Job> m_requests;
+		std::mutex m_requestMutex;
+		std::condition_variable m_requestCondition;
+
+		//decoded images waiting for upload (bounded)
+		std::deque<Job> m_decoded;
+		std::mutex m_decodedMutex;
+		std::condition_variable m_notFull;
+		unsigned int m_capacity;
+
+		bool m_stop;
+
+		//GL thread only
+		std::vector<unsigned char> m_states;
+		unsigned int m_pendingCount;
+
+		GLuint m_pbos[2];
+		unsigned int m_nextPbo;
+};
+
+#endif // _TextureLoader_h_
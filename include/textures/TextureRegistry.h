@@ -0,0 +1,83 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of texture registry. Registry shares textures loaded from the
+same image with the same options across materials and meshes.
+*/
+
+#ifndef _TextureRegistry_h_
+#define _TextureRegistry_h_
+
+#include <string>
+#include <map>
+#include <memory>
+#include "textures\TextureCooker.h"
+
+class Texture;
+class TextureLoader;
+class TextureStreamer;
+
+/// <summary>
+/// Reference counted texture, texture is released with its last handle
+/// </summary>
+typedef std::shared_ptr<Texture> TextureHandle;
+
+/// <summary>
+/// Deduplication statistics
+/// </summary>
+typedef struct
+{
+	unsigned int loads;			//distinct images loaded
+	unsigned int duplicates;	//requests served by already loaded image
+	size_t bytesLoaded;			//GPU memory of loaded images (including mipmaps)
+	size_t bytesSaved;			//GPU memory duplicates would have taken
+} TextureRegistryStatistics;
+
+/// <summary>
+/// Process wide texture registry keyed by canonical path and load options.
+/// Registry holds only weak references, so it never keeps texture alive.
+/// Methods may be called only from GL thread.
+/// </summary>
+class TextureRegistry
+{
+	public:
+		TextureHandle acquire(const std::string &filename, TextureKind kind, bool srgb, TextureLoader *loader = NULL, TextureStreamer *streamer = NULL);
+		void recordLoad(size_t bytes);
+		void recordDuplicate(size_t bytes);
+
+		const TextureRegistryStatistics &getStatistics() const { return m_statistics; }
+		void printStatistics() const;
+
+		static std::string canonicalPath(const std::string &filename);
+		static TextureRegistry &shared();
+
+	protected:
+		TextureRegistry();
+
+		std::map<std::string, std::weak_ptr<Texture> > m_textures;
+		TextureRegistryStatistics m_statistics;
+
+	private:
+		//copying disabled
+		TextureRegistry(const TextureRegistry&);
+		const TextureRegistry& operator=(const TextureRegistry&);
+};
+
+#endif // _TextureRegistry_h_
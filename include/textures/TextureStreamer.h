@@ -0,0 +1,104 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of mipmap streamer. Streamed textures start with only their
+coarsest mipmaps resident, finer mipmaps are loaded by screen space driven
+priority and released again when GPU memory budget is exceeded.
+*/
+
+#ifndef _TextureStreamer_h_
+#define _TextureStreamer_h_
+
+#include <string>
+#include <map>
+#include <GL/glew.h>
+
+class Texture;
+class TextureLoader;
+
+/// <summary>
+/// Mipmap streamer. Resident range of texture [residentLevel, levels) is exposed
+/// to sampling by GL_TEXTURE_BASE_LEVEL, GL_TEXTURE_MIN_LOD fades newly loaded
+/// levels in over few frames. Methods may be called only from GL thread.
+/// </summary>
+class TextureStreamer
+{
+	public:
+		TextureStreamer(TextureLoader &loader, size_t budget, int tailSize, unsigned int idleFrames);
+		~TextureStreamer();
+
+		void add(Texture *texture, GLuint object, const std::string &filename, GLenum format, int width, int height);
+		void remove(const Texture *texture);
+
+		void request(const Texture *texture, float pixels);
+		void update(unsigned int maxRequests);
+
+		bool isResident(const Texture *texture) const;
+
+		size_t getResidentBytes() const { return m_residentBytes; }
+		size_t getBudget() const { return m_budget; }
+		void setBudget(size_t budget) { m_budget = budget; }
+
+	protected:
+		/// <summary>
+		/// Streamed texture
+		/// </summary>
+		struct Record
+		{
+			GLuint object;
+			std::string filename;
+			GLenum format;
+			int width;
+			int height;
+			int levels;
+
+			int tailLevel;			//finest level which is always resident
+			int residentLevel;		//finest resident level, levels = nothing resident
+			int pendingLevel;		//finest level being loaded, -1 = no request in flight
+			unsigned int loadId;
+
+			float minLod;			//fade of newly loaded levels, relative to residentLevel
+
+			int desiredLevel;		//finest level requested by last frame it was used in
+			float priority;			//screen size in pixels
+			unsigned int lastUsed;	//frame of last request
+		};
+
+		size_t rangeSize(const Record &record, int first, int last) const;
+		void setBaseLevel(Record &record, int level);
+		void evictLevel(Record &record);
+		bool evictOne(bool idleOnly);
+
+		TextureLoader &m_loader;
+		std::map<const Texture*, Record> m_records;
+
+		size_t m_budget;
+		size_t m_residentBytes;		//including pending loads
+		int m_tailSize;
+		unsigned int m_idleFrames;
+		unsigned int m_frame;
+
+	private:
+		//copying disabled
+		TextureStreamer(const TextureStreamer&);
+		const TextureStreamer& operator=(const TextureStreamer&);
+};
+
+#endif // _TextureStreamer_h_
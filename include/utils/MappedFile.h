@@ -0,0 +1,62 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of read only memory mapped file.
+*/
+
+#ifndef _MappedFile_h_
+#define _MappedFile_h_
+
+#include <string>
+
+/// <summary>
+/// Read only view of whole file mapped to memory. Pages are loaded by OS on
+/// first access, so file can be processed by several threads at once.
+/// </summary>
+class MappedFile
+{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool open(const std::string &filename);
+		void close();
+
+		const char *getData() const { return m_data; }
+		size_t getSize() const { return m_size; }
+
+	protected:
+		const char *m_data;
+		size_t m_size;
+
+#ifdef _WIN32
+		void *m_file;		//HANDLE of file
+		void *m_mapping;	//HANDLE of file mapping
+#else
+		int m_file;
+#endif
+
+	private:
+		//copying disabled
+		MappedFile(const MappedFile&);
+		const MappedFile& operator=(const MappedFile&);
+};
+
+#endif // _MappedFile_h_
@@ -0,0 +1,40 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of process memory usage queries.
+*/
+
+#ifndef _MemoryUsage_h_
+#define _MemoryUsage_h_
+
+#include <stddef.h>
+
+/// <summary>
+/// Resident memory (working set) of process.
+/// </summary>
+class MemoryUsage
+{
+	public:
+		static size_t getCurrent();
+		static size_t getPeak();
+		static bool resetPeak();
+};
+
+#endif // _MemoryUsage_h_
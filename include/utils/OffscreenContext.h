@@ -0,0 +1,84 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of offscreen OpenGL context. Context is created without visible
+window (hidden GLFW window, EGL surfaceless or OSMesa, selected at runtime)
+and frames are rendered to its framebuffer object instead of window.
+*/
+
+#ifndef _OffscreenContext_h_
+#define _OffscreenContext_h_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "configuration\Config.h"
+
+struct GLFWwindow;
+
+/// <summary>
+/// OpenGL context without window. Context is made current by create, OpenGL
+/// functions are loaded by loadFunctions through API of the context, output
+/// framebuffer (RGBA8 color and depth) replaces default framebuffer.
+/// </summary>
+class OffscreenContext
+{
+	public:
+		OffscreenContext();
+		~OffscreenContext();
+
+		bool create(const glm::uvec2 &size, int api = OFFSCREEN_CONTEXT_API);
+		bool loadFunctions();
+		GLuint createFramebuffer();
+		void release();
+
+		void readPixels(std::vector<float> &rgb) const;
+
+		GLuint getFramebuffer() const { return m_framebuffer; }
+		const glm::uvec2 &getSize() const { return m_size; }
+		const char *getApiName() const;
+
+		static int parseApi(const char *name);
+
+	protected:
+		bool createGlfw();
+		bool createEgl();
+		bool createOsMesa();
+		void *getProcAddress(const char *name) const;
+
+		int m_api;
+		glm::uvec2 m_size;
+		GLuint m_framebuffer;
+		GLuint m_renderbuffers[2];		//color, depth
+
+		void *m_library;		//libEGL or libOSMesa, loaded at runtime
+		void *m_display;		//EGL display
+		void *m_context;		//EGL or OSMesa context
+		std::vector<unsigned char> m_colorBuffer;	//OSMesa requires its own color buffer
+		GLFWwindow *m_window;
+
+	private:
+		//copying disabled
+		OffscreenContext(const OffscreenContext&);
+		const OffscreenContext& operator=(const OffscreenContext&);
+};
+
+#endif // _OffscreenContext_h_
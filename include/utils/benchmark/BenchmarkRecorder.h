@@ -0,0 +1,99 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of benchmark recorder. Recorder collects per-frame times and light
+grid statistics of one benchmark run and writes them with summary percentiles
+to CSV/JSON files.
+*/
+
+#ifndef _BenchmarkRecorder_h_
+#define _BenchmarkRecorder_h_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "utils\benchmark\BenchmarkSpec.h"
+#include "utils\timers\GpuProfiler.h"
+#include "lighting\tiled\GridStatistics.h"
+
+/// <summary>
+/// Measured values of single frame
+/// </summary>
+typedef struct
+{
+	double frameMs;				//CPU time between frame starts
+	double gridBuildMs;			//CPU light grid build
+	double gpuMs[GP_Max];		//GPU time of passes
+	double gpuFrameMs;			//GPU time of whole frame
+	double tileLightsMean;		//lights per tile, zero for techniques without light grid
+	double tileLightsP95;
+	double tileLightsMax;
+	double lightListLength;		//entries of all tile light lists
+	double tilesOverThreshold;	//percentage of tiles with more than GRID_STATS_THRESHOLD lights
+} BenchmarkFrame;
+
+/// <summary>
+/// Summary of single measured value
+/// </summary>
+typedef struct
+{
+	double mean;
+	double min;
+	double p50;
+	double p90;
+	double p95;
+	double p99;
+	double max;
+} BenchmarkSummary;
+
+/// <summary>
+/// Collects frames of single benchmark run
+/// </summary>
+class BenchmarkRecorder
+{
+	public:
+		BenchmarkRecorder(const BenchmarkConfig &config, const std::string &name, const std::string &techniqueName);
+
+		void addFrame(const BenchmarkFrame &frame){ m_frames.push_back(frame); }
+		void setTileHistogram(const std::vector<unsigned long long> &histogram){ m_tileHistogram = histogram; }
+
+		std::vector<BenchmarkFrame> &getFrames(){ return m_frames; }
+		const std::string &getName() const { return m_name; }
+
+		bool writeCsv(const std::string &filename) const;
+		bool writeJson(const std::string &filename, const std::string &renderer) const;
+		bool writeTileHistogram(const std::string &filename) const;
+		void writeSummaryRow(std::ostream &stream) const;
+
+		static void writeSummaryHeader(std::ostream &stream);
+		static BenchmarkSummary summarize(std::vector<double> values);
+
+	protected:
+		void getValues(unsigned int column, std::vector<double> &values) const;
+
+		BenchmarkConfig m_config;
+		std::string m_name;
+		std::string m_techniqueName;
+		std::vector<BenchmarkFrame> m_frames;
+		std::vector<unsigned long long> m_tileHistogram;	//tiles by light count summed over frames
+};
+
+#endif // _BenchmarkRecorder_h_
@@ -0,0 +1,80 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of benchmark sweep specification. Sweep is a cartesian product
+of resolutions, tile sizes, techniques, light counts and min/max depth pass
+settings, every configuration is rendered along the same camera path.
+*/
+
+#ifndef _BenchmarkSpec_h_
+#define _BenchmarkSpec_h_
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// <summary>
+/// Single configuration of benchmark sweep
+/// </summary>
+typedef struct
+{
+	glm::uvec2 resolution;
+	unsigned int tileSize;
+	unsigned int technique;		//index to technique names
+	unsigned int lightCount;
+	bool minMax;				//min/max depth pass of tiled techniques
+} BenchmarkConfig;
+
+/// <summary>
+/// Benchmark sweep loaded from text file with "key = values" lines, e.g.
+/// "lights = 256 512 1024" or "technique = TiledDeferred TiledForward".
+/// Lines starting with '#' are comments.
+/// </summary>
+class BenchmarkSpec
+{
+	public:
+		BenchmarkSpec(const std::vector<std::string> &techniqueNames);
+
+		bool load(const std::string &filename);
+		void getConfigurations(std::vector<BenchmarkConfig> &configs) const;
+
+		std::string getRunName(const BenchmarkConfig &config) const;
+		const std::string &getTechniqueName(unsigned int technique) const { return m_techniqueNames[technique]; }
+
+		std::vector<glm::uvec2> resolutions;
+		std::vector<unsigned int> tileSizes;
+		std::vector<unsigned int> techniques;
+		std::vector<unsigned int> lightCounts;
+		std::vector<bool> minMax;
+
+		unsigned int warmupFrames;		//rendered but not recorded
+		unsigned int measuredFrames;	//recorded, camera path is stretched over warmup + measured frames
+		std::string outputDir;
+		bool writeCsv;
+		bool writeJson;
+
+	protected:
+		bool parseLine(const std::string &key, std::istringstream &values);
+
+		std::vector<std::string> m_techniqueNames;
+};
+
+#endif // _BenchmarkSpec_h_
@@ -0,0 +1,264 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Frame pipeline definition. Simulation thread turns frame inputs into frame
+packets while the render thread draws older packets. Packets are recycled,
+so number of frames in flight (and latency) is bounded by pipeline depth.
+*/
+
+#ifndef _FramePipeline_h_
+#define _FramePipeline_h_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "utils\timers\ZoneProfiler.h"
+
+/// <summary>
+/// Two stage pipeline of frame packets. Render thread takes free packet by
+/// begin(), fills input of frame and submits it. Simulation thread completes
+/// packets by producer in order of submission, render thread takes them by
+/// acquire() and returns them by release() after drawing.
+/// </summary>
+template <class Packet>
+class FramePipeline
+{
+	public:
+		typedef std::function<void(Packet &)> Producer;
+
+		FramePipeline(unsigned int depth, const Producer &producer);
+		~FramePipeline();
+
+		Packet *begin();
+		void submit(Packet *packet);
+		Packet *acquire();
+		void release(Packet *packet);
+		void wait();
+
+		unsigned int getDepth() const { return m_depth; }
+		unsigned int getInFlight() const { return m_inFlight; }
+
+	protected:
+		void simulationLoop();
+
+		unsigned int m_depth;
+		unsigned int m_inFlight;		//submitted and not acquired (render thread only)
+		Producer m_producer;
+
+		std::vector<Packet *> m_packets;
+		std::deque<Packet *> m_free;
+		std::deque<Packet *> m_submitted;
+		std::deque<Packet *> m_produced;
+		bool m_producing;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::thread m_thread;
+		bool m_stop;
+
+	private:
+		//copying disabled
+		FramePipeline(const FramePipeline&);
+		const FramePipeline& operator=(const FramePipeline&);
+};
+
+/// <summary>
+/// Initializes a new instance of the <see cref="FramePipeline"/> class and
+/// starts simulation thread.
+/// </summary>
+/// <param name="depth">frames produced ahead of the rendered one.</param>
+/// <param name="producer">completes packet on simulation thread.</param>
+template <class Packet>
+FramePipeline<Packet>::FramePipeline(unsigned int depth, const Producer &producer)
+	: m_depth(depth > 0 ? depth : 1), m_inFlight(0), m_producer(producer), m_producing(false), m_stop(false)
+{
+	//one more packet is drawn while depth packets are in flight
+	for (unsigned int i = 0; i < m_depth + 1; i++)
+	{
+		m_packets.push_back(new Packet());
+		m_free.push_back(m_packets.back());
+	}
+
+	m_thread = std::thread(&FramePipeline::simulationLoop, this);
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="FramePipeline"/> class. Submitted
+/// packets are finished before simulation thread exits.
+/// </summary>
+template <class Packet>
+FramePipeline<Packet>::~FramePipeline()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_condition.notify_all();
+	m_thread.join();
+
+	for (unsigned int i = 0; i < m_packets.size(); i++)
+	{
+		delete m_packets[i];
+	}
+}
+
+/// <summary>
+/// Takes free packet for input of next frame.
+/// </summary>
+/// <returns>packet</returns>
+template <class Packet>
+Packet *FramePipeline<Packet>::begin()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (m_free.empty())
+	{
+		m_condition.wait(lock);
+	}
+
+	Packet *packet = m_free.front();
+	m_free.pop_front();
+
+	return packet;
+}
+
+/// <summary>
+/// Passes packet with filled input to simulation thread.
+/// </summary>
+/// <param name="packet">packet taken by begin().</param>
+template <class Packet>
+void FramePipeline<Packet>::submit(Packet *packet)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_submitted.push_back(packet);
+	}
+
+	m_inFlight++;
+	m_condition.notify_all();
+}
+
+/// <summary>
+/// Waits for the oldest submitted packet to be produced.
+/// </summary>
+/// <returns>packet, NULL if nothing is in flight</returns>
+template <class Packet>
+Packet *FramePipeline<Packet>::acquire()
+{
+	if (m_inFlight == 0)
+	{
+		return NULL;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (m_produced.empty())
+	{
+		m_condition.wait(lock);
+	}
+
+	Packet *packet = m_produced.front();
+	m_produced.pop_front();
+	m_inFlight--;
+
+	return packet;
+}
+
+/// <summary>
+/// Returns drawn packet to pipeline.
+/// </summary>
+/// <param name="packet">packet taken by acquire().</param>
+template <class Packet>
+void FramePipeline<Packet>::release(Packet *packet)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_free.push_back(packet);
+	}
+
+	m_condition.notify_all();
+}
+
+/// <summary>
+/// Waits until all submitted packets are produced, shared state read by
+/// producer may be changed afterwards until next submit().
+/// </summary>
+template <class Packet>
+void FramePipeline<Packet>::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_submitted.empty() || m_producing)
+	{
+		m_condition.wait(lock);
+	}
+}
+
+/// <summary>
+/// Simulation thread main loop.
+/// </summary>
+template <class Packet>
+void FramePipeline<Packet>::simulationLoop()
+{
+	ZoneProfiler::setThreadName("Simulation");
+
+	for (;;)
+	{
+		Packet *packet;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			while (!m_stop && m_submitted.empty())
+			{
+				m_condition.wait(lock);
+			}
+
+			if (m_submitted.empty())
+			{
+				return;
+			}
+
+			packet = m_submitted.front();
+			m_submitted.pop_front();
+			m_producing = true;
+		}
+
+		{
+			PROFILE_ZONE("Frame packet");
+			m_producer(*packet);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_produced.push_back(packet);
+			m_producing = false;
+		}
+
+		m_condition.notify_all();
+	}
+}
+
+#endif // _FramePipeline_h_
@@ -0,0 +1,128 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Thread pool definition. Pool owns fixed set of worker threads with work
+stealing deques, it is shared by CPU heavy parts of application (culling,
+loading, light grid build, ...). Jobs may be grouped by counters which are
+waited for by threads helping with queued jobs.
+*/
+
+#ifndef _ThreadPool_h_
+#define _ThreadPool_h_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+/// <summary>
+/// Number of unfinished jobs submitted with it. Job depending on other jobs
+/// is submitted after waiting for their counter.
+/// </summary>
+class JobCounter
+{
+	public:
+		JobCounter() : m_count(0){ }
+
+		bool isDone() const { return m_count.load() == 0; }
+		unsigned int getCount() const { return m_count.load(); }
+
+	private:
+		friend class ThreadPool;
+
+		//copying disabled
+		JobCounter(const JobCounter&);
+		const JobCounter& operator=(const JobCounter&);
+
+		std::atomic<unsigned int> m_count;
+};
+
+/// <summary>
+/// Called after every job with its name and PerformanceTimer ticks.
+/// </summary>
+typedef void (*JobHook)(const char *name, unsigned long long beginTicks, unsigned long long endTicks);
+
+/// <summary>
+/// Work stealing thread pool with fork-join parallel for. Worker pushes and
+/// pops its jobs at the back of own deque, idle workers steal from the front
+/// of other deques. Jobs of other threads go to shared queue. Waiting thread
+/// executes queued jobs, so pool with no workers still executes everything.
+/// </summary>
+class ThreadPool
+{
+	public:
+		ThreadPool(unsigned int threads = 0, bool pinThreads = false);
+		~ThreadPool();
+
+		void submit(const std::function<void()> &task, JobCounter *counter = NULL, const char *name = "Job");
+		void wait(JobCounter &counter);
+		void parallelFor(unsigned int count, unsigned int grain, const std::function<void(unsigned int, unsigned int)> &body, const char *name = "parallelFor");
+
+		unsigned int getThreadCount() const { return (unsigned int)m_workers.size(); }
+
+		static void setJobHook(JobHook hook){ s_jobHook = hook; }
+		static ThreadPool &shared();
+
+	protected:
+		/// <summary>
+		/// Queued job
+		/// </summary>
+		struct Job
+		{
+			std::function<void()> task;
+			JobCounter *counter;
+			const char *name;		//string literal, only pointer is stored
+		};
+
+		/// <summary>
+		/// Deque of single worker (the last one is shared by other threads)
+		/// </summary>
+		struct JobQueue
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		void workerLoop(unsigned int index, bool pin);
+		bool popJob(int index, Job &job);
+		void runJob(Job &job);
+		int getWorkerIndex() const;
+
+		std::vector<std::thread> m_workers;
+		std::vector<JobQueue *> m_queues;
+		std::atomic<unsigned int> m_pending;	//queued jobs of all queues
+
+		//sleeping workers and waiting threads
+		std::mutex m_sleepMutex;
+		std::condition_variable m_condition;
+		bool m_stop;
+
+		static JobHook s_jobHook;
+
+	private:
+		//copying disabled
+		ThreadPool(const ThreadPool&);
+		const ThreadPool& operator=(const ThreadPool&);
+};
+
+#endif // _ThreadPool_h_
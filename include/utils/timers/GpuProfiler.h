@@ -0,0 +1,115 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of GPU profiler. Render passes are enclosed by GL_TIMESTAMP
+queries kept in ring of frames, results are read when available (usually
+2-3 frames later), so the CPU never waits for the GPU.
+*/
+
+#ifndef _GpuProfiler_h_
+#define _GpuProfiler_h_
+
+#include <deque>
+#include <vector>
+#include <GL/glew.h>
+
+#include "configuration\Config.h"
+
+/// <summary>
+/// Profiled GPU passes
+/// </summary>
+enum GpuPass
+{
+	GP_GBuffer,			//G-buffer fill of deferred techniques
+	GP_DepthPrepass,	//depth pre pass of tiled forward shading
+	GP_MinMaxDepth,		//tile depth bounds
+	GP_Lighting,		//light pass, forward shading or simple shading
+	GP_Blit,			//copy to default framebuffer and debug quads
+	GP_Max,
+};
+
+/// <summary>
+/// GPU times of single frame
+/// </summary>
+typedef struct
+{
+	unsigned int frame;
+	double passMs[GP_Max];		//0 = pass was not executed
+	double frameMs;				//from start of the first to end of the last pass
+} GpuFrameTimes;
+
+/// <summary>
+/// Non-blocking GPU profiler. Every pass writes timestamps at its begin and
+/// end, so passes may be nested. Queries of GPU_TIMER_FRAMES frames are kept
+/// in ring, finished frames are returned by popResult().
+/// </summary>
+class GpuProfiler
+{
+	public:
+		GpuProfiler();
+		~GpuProfiler();
+
+		void init();
+		void release();
+
+		void beginFrame(unsigned int frame);
+		void begin(GpuPass pass);
+		void end(GpuPass pass);
+
+		bool popResult(GpuFrameTimes &times);
+		void flush();
+
+		/// <summary>
+		/// Enables or disables profiling, begin() and end() do nothing when disabled.
+		/// </summary>
+		/// <param name="enabled">new state.</param>
+		void setEnabled(bool enabled){ m_enabled = enabled; }
+		bool isEnabled() const { return m_enabled; }
+
+	protected:
+		/// <summary>
+		/// Timestamp queries of single frame in flight
+		/// </summary>
+		typedef struct
+		{
+			unsigned int frame;
+			bool pending;
+			GLuint queries[GP_Max * 2];		//begin and end timestamp of every pass
+			bool used[GP_Max];
+			GLuint lastQuery;				//timestamps finish in order, the last one marks finished frame
+		} FrameQueries;
+
+		bool isAvailable(const FrameQueries &slot) const;
+		void resolve(FrameQueries &slot);
+
+		FrameQueries m_ring[GPU_TIMER_FRAMES];
+		std::deque<GpuFrameTimes> m_results;
+		unsigned int m_current;
+		bool m_initialized;
+		bool m_frameActive;
+		bool m_enabled;
+
+	private:
+		//copying disabled
+		GpuProfiler(const GpuProfiler&);
+		const GpuProfiler& operator=(const GpuProfiler&);
+};
+
+#endif // _GpuProfiler_h_
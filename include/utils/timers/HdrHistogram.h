@@ -0,0 +1,73 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of high dynamic range histogram. Values are counted in log-linear
+buckets, so relative precision is the same for nanoseconds and seconds and
+percentiles are computed from fixed amount of memory.
+*/
+
+#ifndef _HdrHistogram_h_
+#define _HdrHistogram_h_
+
+#include <vector>
+
+#include "configuration\Config.h"
+
+//buckets per power of two and bucket count covering 64-bit values
+#define HDR_SUB_BUCKETS		(1u << SAMPLE_HISTOGRAM_SUB_BITS)
+#define HDR_HALF_BUCKETS	(HDR_SUB_BUCKETS / 2)
+#define HDR_BUCKET_COUNT	((66u - SAMPLE_HISTOGRAM_SUB_BITS) * HDR_HALF_BUCKETS)
+
+/// <summary>
+/// Log-linear histogram of 64-bit values. Values below HDR_SUB_BUCKETS are
+/// exact, larger values share buckets with relative width below
+/// 2^-(SAMPLE_HISTOGRAM_SUB_BITS - 1). Minimum, maximum and sum are exact.
+/// </summary>
+class HdrHistogram
+{
+	public:
+		HdrHistogram();
+
+		void record(unsigned long long value, unsigned long long count = 1);
+		void addBucket(unsigned int bucket, unsigned long long count);
+		void setRange(unsigned long long min, unsigned long long max, double sum);
+		void merge(const HdrHistogram &histogram);
+		void reset();
+
+		unsigned long long getCount() const { return m_count; }
+		unsigned long long getMin() const { return m_count ? m_min : 0; }
+		unsigned long long getMax() const { return m_max; }
+		double getMean() const { return m_count ? m_sum / m_count : 0.0; }
+
+		unsigned long long getValueAtPercentile(double percentile) const;
+
+		static unsigned int getBucket(unsigned long long value);
+		static unsigned long long getBucketLowest(unsigned int bucket);
+		static unsigned long long getBucketWidth(unsigned int bucket);
+
+	protected:
+		std::vector<unsigned long long> m_counts;
+		unsigned long long m_count;
+		unsigned long long m_min;
+		unsigned long long m_max;
+		double m_sum;
+};
+
+#endif // _HdrHistogram_h_
@@ -26,7 +26,8 @@
 #include <stdio.h>
 
 /// <summary>
-/// Used to time some section of code, is reasonably accurate.
+/// Used to time some section of code, is reasonably accurate. Ticks are 64-bit
+/// and monotonic (QueryPerformanceCounter, clock_gettime or calibrated TSC).
 /// </summary>
 class PerformanceTimer
 {
@@ -47,7 +48,7 @@ class PerformanceTimer
 		/// </summary>
 		void stop()
 		{
-			m_accumulatedTicks += getTickCount() - m_ticksAtStart;
+			m_accumulatedTicks += getElapsedTicks();
 			m_isRunning = false;
 		}
 
@@ -60,6 +61,15 @@ class PerformanceTimer
 			start();
 		}
 
+		/// <summary>
+		/// Clears accumulated time and stops the timer.
+		/// </summary>
+		void reset()
+		{
+			m_accumulatedTicks = 0;
+			m_isRunning = false;
+		}
+
 		/// <summary>
 		/// Get the elapsed time in seconds, if the timer is running it gets the current elapsed time.
 		/// If it has been stopped, it takes the elapsed time when stop() was called.
@@ -67,50 +77,71 @@ class PerformanceTimer
 		/// <returns></returns>
 		double getElapsedTime()
 		{
-			unsigned int ticks = getTickCount();
-			// SUPERHACK, my computer reports decreasing time at times, need mobo driver update perhaps... weird.
-			// - Does not seem to happen after an AMD processor driver install...
-			
-			if (ticks < m_ticksAtStart)
-			{
-				//printf("get: %I64d\n", ticks);
-				ticks = m_ticksAtStart;
-			}
-			return ticksToSeconds((m_isRunning ? ticks - m_ticksAtStart : m_accumulatedTicks));
+			return ticksToSeconds(m_isRunning ? getElapsedTicks() : m_accumulatedTicks);
 		}
 
+		/// <summary>
+		/// Get the elapsed time in nanoseconds, see getElapsedTime().
+		/// </summary>
+		/// <returns></returns>
+		unsigned long long getElapsedNanoseconds()
+		{
+			return ticksToNanoseconds(m_isRunning ? getElapsedTicks() : m_accumulatedTicks);
+		}
 
 		/// <summary>
 		/// Get the current tick count, in whatever unit the machine pleases.
 		/// </summary>
 		/// <returns></returns>
-		static unsigned int getTickCount();
+		static unsigned long long getTickCount();
 		
 		/// <summary>
 		/// Returns the number of ticks per second, use for converting the above tick count to something useful.
 		/// </summary>
 		/// <returns></returns>
-		static unsigned int getTicksPerSecond()
-		{
-			static unsigned int ticksPerSecond = initTicksPerSecond();
-			return ticksPerSecond;
-		}
+		static unsigned long long getTicksPerSecond();
 
 		/// <summary>
 		/// converts a given number of ticks to seconds.
 		/// </summary>
 		/// <param name="ticks">The ticks.</param>
 		/// <returns></returns>
-		static double ticksToSeconds(unsigned int ticks)
+		static double ticksToSeconds(unsigned long long ticks)
 		{
 			return double(ticks) / double(getTicksPerSecond());
 		}
 
+		/// <summary>
+		/// converts a given number of ticks to nanoseconds.
+		/// </summary>
+		/// <param name="ticks">The ticks.</param>
+		/// <returns></returns>
+		static unsigned long long ticksToNanoseconds(unsigned long long ticks)
+		{
+			unsigned long long frequency = getTicksPerSecond();
+
+			//split to avoid overflow of ticks * 10^9
+			return (ticks / frequency) * 1000000000ull + ((ticks % frequency) * 1000000000ull) / frequency;
+		}
+
 	private:
-	  static unsigned int initTicksPerSecond();
-	  unsigned int m_ticksAtStart;
-	  unsigned int m_accumulatedTicks;
-	  bool m_isRunning;
+		/// <summary>
+		/// Ticks since start, clamped to zero if counter goes backwards (TSC of
+		/// unsynchronized cores, buggy drivers).
+		/// </summary>
+		/// <returns></returns>
+		unsigned long long getElapsedTicks()
+		{
+			unsigned long long ticks = getTickCount();
+
+			return ticks > m_ticksAtStart ? ticks - m_ticksAtStart : 0;
+		}
+
+		static unsigned long long initTicksPerSecond();
+
+		unsigned long long m_ticksAtStart;
+		unsigned long long m_accumulatedTicks;
+		bool m_isRunning;
 };
 
 #endif // _PerformanceTimer_h_
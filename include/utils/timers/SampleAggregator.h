@@ -0,0 +1,87 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of sample aggregator. Collects timing samples from any number of
+threads without locks into per-thread histograms and merges them into
+percentile summary on request.
+*/
+
+#ifndef _SampleAggregator_h_
+#define _SampleAggregator_h_
+
+#include <atomic>
+
+#include "utils\timers\HdrHistogram.h"
+#include "utils\threading\ThreadLocal.h"
+
+/// <summary>
+/// Summary of recorded samples in milliseconds
+/// </summary>
+typedef struct
+{
+	unsigned long long count;
+	double minMs;
+	double meanMs;
+	double p50Ms;
+	double p95Ms;
+	double p99Ms;
+	double maxMs;
+} SampleSummary;
+
+/// <summary>
+/// Lock-free aggregator of nanosecond samples. Every thread records into
+/// its own slot of atomic buckets (threads are spread over
+/// SAMPLE_AGGREGATOR_THREADS slots), slots are merged only by summarize().
+/// </summary>
+class SampleAggregator
+{
+	public:
+		SampleAggregator();
+		~SampleAggregator();
+
+		void record(unsigned long long nanoseconds);
+		void reset();
+
+		void getHistogram(HdrHistogram &histogram) const;
+		SampleSummary summarize() const;
+
+	protected:
+		typedef struct
+		{
+			std::atomic<unsigned long long> counts[HDR_BUCKET_COUNT];
+			std::atomic<unsigned long long> count;
+			std::atomic<unsigned long long> sum;
+			std::atomic<unsigned long long> min;
+			std::atomic<unsigned long long> max;
+		} ThreadSlot;
+
+		static unsigned int getThreadIndex();
+		static void clearSlot(ThreadSlot *slot);
+
+		ThreadSlot *getSlot();
+
+		std::atomic<ThreadSlot*> m_slots[SAMPLE_AGGREGATOR_THREADS];
+
+	private:
+		SampleAggregator(const SampleAggregator &);
+		SampleAggregator &operator=(const SampleAggregator &);
+};
+
+#endif // _SampleAggregator_h_
@@ -0,0 +1,80 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Header file of CPU zone profiler. Scopes marked by PROFILE_ZONE are stored
+into preallocated per-thread ring buffers and exported on demand as Chrome
+trace_event JSON (chrome://tracing, Perfetto).
+*/
+
+#ifndef _ZoneProfiler_h_
+#define _ZoneProfiler_h_
+
+#include <string>
+
+#include "configuration\Config.h"
+#include "utils\timers\PerformanceTimer.h"
+
+#if ZONE_PROFILER_ENABLED
+  #define PROFILE_ZONE_CONCAT_(a, b)	a##b
+  #define PROFILE_ZONE_CONCAT(a, b)		PROFILE_ZONE_CONCAT_(a, b)
+
+  //name has to be string literal, only pointer is stored
+  #define PROFILE_ZONE(name)	ScopedZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
+  #define PROFILE_FUNCTION()	PROFILE_ZONE(__FUNCTION__)
+#else
+  #define PROFILE_ZONE(name)
+  #define PROFILE_FUNCTION()
+#endif
+
+/// <summary>
+/// Collects zones of all threads. Every thread writes only into its own ring
+/// of ZONE_PROFILER_EVENTS zones, older zones are overwritten.
+/// </summary>
+class ZoneProfiler
+{
+	public:
+		static void setThreadName(const char *name);
+		static void record(const char *name, unsigned long long beginTicks, unsigned long long endTicks);
+		static void clear();
+		static bool writeTrace(const std::string &filename);
+};
+
+/// <summary>
+/// Records zone from construction to destruction.
+/// </summary>
+class ScopedZone
+{
+	public:
+		ScopedZone(const char *name) : m_name(name), m_beginTicks(PerformanceTimer::getTickCount()){ }
+
+		~ScopedZone()
+		{
+			ZoneProfiler::record(m_name, m_beginTicks, PerformanceTimer::getTickCount());
+		}
+
+	private:
+		ScopedZone(const ScopedZone &);
+		ScopedZone &operator=(const ScopedZone &);
+
+		const char *m_name;
+		unsigned long long m_beginTicks;
+};
+
+#endif // _ZoneProfiler_h_
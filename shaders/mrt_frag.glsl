@@ -1,7 +1,43 @@
+#ifdef TEXTURE_ARRAYS
+uniform sampler2DArray diff_tex;
+uniform sampler2DArray normal_map;
+uniform sampler2DArray spec_map;
+
+uniform float diffLayer;
+uniform float normalLayer;
+uniform float specLayer;
+
+#define DIFFUSE(uv)		texture(diff_tex, vec3(uv, diffLayer))
+#define NORMAL(uv)		texture(normal_map, vec3(uv, normalLayer))
+#define SPECULAR(uv)	texture(spec_map, vec3(uv, specLayer))
+#else
 uniform sampler2D diff_tex;
 uniform sampler2D normal_map;
 uniform sampler2D spec_map;
 
+#define DIFFUSE(uv)		texture(diff_tex, uv)
+#define NORMAL(uv)		texture(normal_map, uv)
+#define SPECULAR(uv)	texture(spec_map, uv)
+#endif
+
+#ifdef TEXTURE_COMPRESSION
+/*
+	Normal maps are stored in two channel format (x, y),
+	z is reconstructed from unit length of normal
+*/
+vec3 reconstructNormal(vec2 rg)
+{
+	vec2 xy = rg * vec2(2.0) - vec2(1.0);
+	vec3 normal = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+
+	return normal * vec3(0.5) + vec3(0.5);
+}
+
+#define NORMAL_MAP(uv)	reconstructNormal(NORMAL(uv).rg)
+#else
+#define NORMAL_MAP(uv)	NORMAL(uv).rgb
+#endif
+
 uniform float specExponent;
 uniform vec3 Kd;
 
@@ -40,9 +76,9 @@ vec3 bumpNormal(vec3 normalMap)
 
 void main(){
 
-  vec3 norm = normalize(bumpNormal(texture(normal_map, ft).rgb));
-  vec3 diff = texture(diff_tex, ft).rgb;
-  vec3 spec = texture(spec_map, ft).rgb;
+  vec3 norm = normalize(bumpNormal(NORMAL_MAP(ft)));
+  vec3 diff = DIFFUSE(ft).rgb;
+  vec3 spec = SPECULAR(ft).rgb;
 
   vec3 ambient = diff * 0.05;
 
@@ -7,6 +7,7 @@ layout (location = 1) in vec2 vt;
 layout (location = 2) in vec3 vn;
 layout (location = 3) in vec3 vtan;
 layout (location = 4) in vec3 vbitan;
+layout (location = 5) in mat4 instanceModel;	//per-instance model matrix
 
 out vec3 fp;
 out vec2 ft;
@@ -16,13 +17,16 @@ out vec3 fbitan;
 
 void main()
 {
+	// instance transforms are rigid with uniform scale, normals are renormalized
+	mat4 modelView = view * model * instanceModel;
+
 	// Pass some variables to the fragment shader
 	ft = vt;
-    fn = normalize((view * vec4 (vn, 0.0)).xyz);
-    fp = (view * vec4 (vp, 1.0)).xyz;
-	ftan = normalize((view * vec4 (vtan, 0.0)).xyz);
-	fbitan = normalize((view * vec4 (vbitan, 0.0)).xyz);
+    fn = normalize((modelView * vec4 (vn, 0.0)).xyz);
+    fp = (modelView * vec4 (vp, 1.0)).xyz;
+	ftan = normalize((modelView * vec4 (vtan, 0.0)).xyz);
+	fbitan = normalize((modelView * vec4 (vbitan, 0.0)).xyz);
 
 	// Apply all matrix transformations to vert
-    gl_Position = projection * view  * model * vec4(vp, 1.0);
+    gl_Position = projection * modelView * vec4(vp, 1.0);
 }
\ No newline at end of file
@@ -1,4 +1,14 @@
+#ifdef TEXTURE_ARRAYS
+uniform sampler2DArray diff_tex;
+uniform float diffLayer;
+
+#define DIFFUSE(uv)		texture(diff_tex, vec3(uv, diffLayer))
+#else
 uniform sampler2D diff_tex;
+
+#define DIFFUSE(uv)		texture(diff_tex, uv)
+#endif
+
 uniform vec3 Kd;
 
 in vec2 ft;
@@ -8,6 +18,6 @@ out vec4 resultColor;
 
 void main()
 {
-	vec3 diff = texture(diff_tex, ft).rgb * Kd;
+	vec3 diff = DIFFUSE(ft).rgb * Kd;
 	resultColor = vec4(diff, 1.0);
 }
@@ -3,6 +3,7 @@ uniform mat4 MVP;
 layout (location = 0) in vec3 vp;
 layout (location = 1) in vec2 vt;
 layout (location = 2) in vec3 vn;
+layout (location = 5) in mat4 instanceModel;	//per-instance model matrix
 
 out vec2 ft;
 out vec3 fn;
@@ -12,5 +13,5 @@ void main() {
 	ft = vt;
     
 	// Apply all matrix transformations to vert
-    gl_Position = MVP  * vec4(vp, 1.0);
+    gl_Position = MVP * instanceModel * vec4(vp, 1.0);
 }
\ No newline at end of file
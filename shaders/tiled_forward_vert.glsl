@@ -7,6 +7,7 @@ layout (location = 1) in vec2 vt;
 layout (location = 2) in vec3 vn;
 layout (location = 3) in vec3 vtan;
 layout (location = 4) in vec3 vbitan;
+layout (location = 5) in mat4 instanceModel;	//per-instance model matrix
 
 out vec3 fp;
 out vec2 ft;
@@ -16,13 +17,17 @@ out vec3 fbitan;
 
 void main()
 {
+	// instance transforms are rigid with uniform scale, normals are renormalized
+	vec4 position = instanceModel * vec4(vp, 1.0);
+	mat3 instanceNormal = mat3(instanceModel);
+
 	// Pass some variables to the fragment shader
 	ft = vt;
-	fp = (view * vec4(vp, 1.0)).xyz;
-    fn = normalize((normalMatrix * vec4(vn, 0.0)).xyz);
-	ftan = normalize((normalMatrix * vec4(vtan, 0.0)).xyz);
-	fbitan = normalize((normalMatrix * vec4(vbitan, 0.0)).xyz);
+	fp = (view * position).xyz;
+    fn = normalize((normalMatrix * vec4(instanceNormal * vn, 0.0)).xyz);
+	ftan = normalize((normalMatrix * vec4(instanceNormal * vtan, 0.0)).xyz);
+	fbitan = normalize((normalMatrix * vec4(instanceNormal * vbitan, 0.0)).xyz);
 
 	// Apply all matrix transformations to vert
-    gl_Position = viewProjection * vec4(vp, 1.0);
+    gl_Position = viewProjection * position;
 }
\ No newline at end of file
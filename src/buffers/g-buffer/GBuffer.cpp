@@ -178,9 +178,10 @@ void GBuffer::bindForLightPass()
 /// Binds for final pass, blits texture to default FBO.
 /// </summary>
 /// <param name="i">index of the g-buffer texture to blit.</param>
-void GBuffer::bindForFinalPass(int i)
+/// <param name="drawFramebuffer">target FBO, 0 = window (default FBO).</param>
+void GBuffer::bindForFinalPass(int i, GLuint drawFramebuffer)
 {
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
     glBindFramebuffer(GL_READ_FRAMEBUFFER, _fbo);
 
 	glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
@@ -0,0 +1,181 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements culling of scene submeshes against view frustum. Boxes
+are processed in groups of four using SSE, result is list of visible submeshes
+which is used by all geometry passes (depth prepass, G-buffer, tiled forward).
+*/
+
+#include <cmath>
+#include <xmmintrin.h>
+#include "collision\FrustumCuller.h"
+
+/// <summary>
+/// Initializes a new instance of the <see cref="FrustumCuller"/> class.
+/// </summary>
+FrustumCuller::FrustumCuller() : m_boundsCount(0), m_visibleCount(0)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="FrustumCuller"/> class.
+/// </summary>
+FrustumCuller::~FrustumCuller()
+{
+}
+
+/// <summary>
+/// Stores bounding boxes in SoA layout. Arrays are padded to multiple of 4, padding
+/// boxes are skipped when visible list is written.
+/// </summary>
+/// <param name="bounds">bounding boxes of submeshes.</param>
+void FrustumCuller::setBounds(const std::vector<AABB> &bounds)
+{
+	m_boundsCount = (unsigned int)bounds.size();
+	m_visibleCount = m_boundsCount;
+
+	unsigned int padded = (m_boundsCount + 3) & ~3u;
+
+	m_centerX.assign(padded, 0.0f);
+	m_centerY.assign(padded, 0.0f);
+	m_centerZ.assign(padded, 0.0f);
+	m_extentX.assign(padded, 0.0f);
+	m_extentY.assign(padded, 0.0f);
+	m_extentZ.assign(padded, 0.0f);
+
+	for (unsigned int i = 0; i < m_boundsCount; i++)
+	{
+		glm::vec3 center = (bounds[i].min + bounds[i].max) * 0.5f;
+		glm::vec3 extent = (bounds[i].max - bounds[i].min) * 0.5f;
+
+		m_centerX[i] = center.x;
+		m_centerY[i] = center.y;
+		m_centerZ[i] = center.z;
+
+		m_extentX[i] = extent.x;
+		m_extentY[i] = extent.y;
+		m_extentZ[i] = extent.z;
+	}
+}
+
+/// <summary>
+/// Extracts frustum planes from view-projection matrix (Gribb/Hartmann method).
+/// </summary>
+/// <param name="viewProjection">projection * view matrix.</param>
+void FrustumCuller::extractPlanes(const glm::mat4 &viewProjection)
+{
+	//glm matrices are column major, m[column][row]
+	glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	m_planes[0] = row3 + row0;	//left
+	m_planes[1] = row3 - row0;	//right
+	m_planes[2] = row3 + row1;	//bottom
+	m_planes[3] = row3 - row1;	//top
+	m_planes[4] = row3 + row2;	//near
+	m_planes[5] = row3 - row2;	//far
+
+	for (unsigned int i = 0; i < 6; i++)
+	{
+		m_planes[i] /= glm::length(glm::vec3(m_planes[i]));
+	}
+}
+
+/// <summary>
+/// Culls stored bounding boxes against view frustum. Box is outside if it lies 
+/// completely behind at least one plane: n.c + d + |n|.e &lt; 0
+/// </summary>
+/// <param name="viewProjection">projection * view matrix.</param>
+/// <param name="visible">output list of visible box indices.</param>
+/// <returns>visible boxes count</returns>
+unsigned int FrustumCuller::cull(const glm::mat4 &viewProjection, std::vector<unsigned int> &visible)
+{
+	extractPlanes(viewProjection);
+
+	visible.clear();
+
+	__m128 planeX[6], planeY[6], planeZ[6], planeD[6];
+	__m128 absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+
+	//broadcast plane components
+	for (unsigned int p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm_set1_ps(m_planes[p].x);
+		planeY[p] = _mm_set1_ps(m_planes[p].y);
+		planeZ[p] = _mm_set1_ps(m_planes[p].z);
+		planeD[p] = _mm_set1_ps(m_planes[p].w);
+
+		absPlaneX[p] = _mm_set1_ps(fabsf(m_planes[p].x));
+		absPlaneY[p] = _mm_set1_ps(fabsf(m_planes[p].y));
+		absPlaneZ[p] = _mm_set1_ps(fabsf(m_planes[p].z));
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	unsigned int padded = (unsigned int)m_centerX.size();
+
+	for (unsigned int i = 0; i < padded; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&m_centerX[i]);
+		__m128 cy = _mm_loadu_ps(&m_centerY[i]);
+		__m128 cz = _mm_loadu_ps(&m_centerZ[i]);
+		__m128 ex = _mm_loadu_ps(&m_extentX[i]);
+		__m128 ey = _mm_loadu_ps(&m_extentY[i]);
+		__m128 ez = _mm_loadu_ps(&m_extentZ[i]);
+
+		__m128 outside = _mm_setzero_ps();
+
+		for (unsigned int p = 0; p < 6; p++)
+		{
+			//signed distance of box center from plane
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, planeX[p]), _mm_mul_ps(cy, planeY[p])),
+									 _mm_add_ps(_mm_mul_ps(cz, planeZ[p]), planeD[p]));
+
+			//projected box radius onto plane normal
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, absPlaneX[p]), _mm_mul_ps(ey, absPlaneY[p])),
+									   _mm_mul_ps(ez, absPlaneZ[p]));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+		}
+
+		int mask = ~_mm_movemask_ps(outside) & 0xF;
+
+		while (mask)
+		{
+			unsigned int lane = 0;
+			while (!(mask & (1 << lane)))
+			{
+				lane++;
+			}
+
+			if (i + lane < m_boundsCount)
+			{
+				visible.push_back(i + lane);
+			}
+
+			mask &= ~(1 << lane);
+		}
+	}
+
+	m_visibleCount = (unsigned int)visible.size();
+
+	return m_visibleCount;
+}
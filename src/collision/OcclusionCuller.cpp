@@ -0,0 +1,477 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements software occlusion culling. Occluder triangles are
+rasterized into low resolution depth buffer (four pixels at once using SSE),
+depth buffer is reduced to hierarchy of maximum depths and bounding boxes of
+submeshes are tested against it. Rasterization is split into horizontal bands
+and box tests into chunks which are processed by worker threads.
+*/
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <emmintrin.h>
+#include <functional>
+
+#include "collision\OcclusionCuller.h"
+#include "utils\threading\ThreadPool.h"
+
+//clip space w under which vertex is considered to be behind camera
+#define OCCLUSION_MIN_W 1e-4f
+
+/// <summary>
+/// Initializes a new instance of the <see cref="OcclusionCuller"/> class.
+/// </summary>
+/// <param name="width">depth buffer width, must be multiple of 4.</param>
+/// <param name="height">depth buffer height.</param>
+/// <param name="pool">thread pool, NULL = process on calling thread.</param>
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height, ThreadPool *pool) :
+	m_width((width + 3) & ~3u), m_height(height), m_pool(pool), m_culledCount(0)
+{
+	m_depth.assign(m_width * m_height, 1.0f);
+
+	//allocate hierarchy levels down to single tile
+	glm::uvec2 size((m_width + HIZ_TILE - 1) / HIZ_TILE, (m_height + HIZ_TILE - 1) / HIZ_TILE);
+
+	for (;;)
+	{
+		m_hizSize.push_back(size);
+		m_hiz.push_back(std::vector<float>(size.x * size.y, 1.0f));
+
+		if (size.x == 1 && size.y == 1)
+		{
+			break;
+		}
+
+		size = glm::uvec2((size.x + 1) / 2, (size.y + 1) / 2);
+	}
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="OcclusionCuller"/> class.
+/// </summary>
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+/// <summary>
+/// Sets occluder geometry, triangles are stored in world space.
+/// </summary>
+/// <param name="vertices">occluder vertices.</param>
+/// <param name="indices">triangle list indices.</param>
+void OcclusionCuller::setOccluders(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &indices)
+{
+	m_vertices = vertices;
+	m_indices = indices;
+
+	m_screenVertices.resize(m_vertices.size());
+	m_triangles.reserve(m_indices.size() / 3);
+}
+
+/// <summary>
+/// Transforms occluders, rasterizes them to depth buffer and builds depth hierarchy.
+/// </summary>
+/// <param name="viewProjection">projection * view matrix.</param>
+void OcclusionCuller::renderOccluders(const glm::mat4 &viewProjection)
+{
+	m_viewProjection = viewProjection;
+
+	//transform occluder vertices to screen space
+	const float w = (float)m_width;
+	const float h = (float)m_height;
+
+	std::function<void(unsigned int, unsigned int)> transform = [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			glm::vec4 clip = viewProjection * glm::vec4(m_vertices[i], 1.0f);
+
+			if (clip.w > OCCLUSION_MIN_W)
+			{
+				float invW = 1.0f / clip.w;
+				m_screenVertices[i] = glm::vec4((clip.x * invW * 0.5f + 0.5f) * w, (clip.y * invW * 0.5f + 0.5f) * h, clip.z * invW, clip.w);
+			}
+			else
+			{
+				m_screenVertices[i] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+			}
+		}
+	};
+
+	if (m_pool)
+	{
+		m_pool->parallelFor((unsigned int)m_vertices.size(), 1024, transform);
+	}
+	else
+	{
+		transform(0, (unsigned int)m_vertices.size());
+	}
+
+	setupTriangles();
+
+	//rasterize in horizontal bands, every band is owned by single thread
+	std::function<void(unsigned int, unsigned int)> raster = [&](unsigned int begin, unsigned int end)
+	{
+		rasterizeBand(begin, end);
+	};
+
+	if (m_pool)
+	{
+		m_pool->parallelFor(m_height, HIZ_TILE, raster);
+	}
+	else
+	{
+		raster(0, m_height);
+	}
+
+	buildHierarchy();
+}
+
+/// <summary>
+/// Prepares screen space triangles. Triangles crossing near plane are skipped, that
+/// is conservative since missing occluder can only make more objects visible.
+/// </summary>
+void OcclusionCuller::setupTriangles()
+{
+	m_triangles.clear();
+
+	for (unsigned int i = 0; i + 2 < m_indices.size(); i += 3)
+	{
+		ScreenTriangle tri;
+		bool valid = true;
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			const glm::vec4 &sv = m_screenVertices[m_indices[i + k]];
+
+			if (sv.w <= OCCLUSION_MIN_W || sv.z < -1.0f)
+			{
+				valid = false;
+				break;
+			}
+
+			tri.v[k] = glm::vec3(sv);
+		}
+
+		if (!valid)
+		{
+			continue;
+		}
+
+		//orient triangles counter-clockwise, occluders are treated as double sided
+		float area = (tri.v[1].x - tri.v[0].x) * (tri.v[2].y - tri.v[0].y) - (tri.v[2].x - tri.v[0].x) * (tri.v[1].y - tri.v[0].y);
+
+		if (fabsf(area) < 1e-6f)
+		{
+			continue;
+		}
+
+		if (area < 0.0f)
+		{
+			std::swap(tri.v[1], tri.v[2]);
+		}
+
+		glm::vec3 minV = glm::min(tri.v[0], glm::min(tri.v[1], tri.v[2]));
+		glm::vec3 maxV = glm::max(tri.v[0], glm::max(tri.v[1], tri.v[2]));
+
+		//whole triangle behind far plane or out of screen
+		if (minV.z > 1.0f || maxV.x < 0.0f || maxV.y < 0.0f || minV.x >= (float)m_width || minV.y >= (float)m_height)
+		{
+			continue;
+		}
+
+		tri.minX = std::max(0, (int)floorf(minV.x));
+		tri.minY = std::max(0, (int)floorf(minV.y));
+		tri.maxX = std::min((int)m_width - 1, (int)ceilf(maxV.x));
+		tri.maxY = std::min((int)m_height - 1, (int)ceilf(maxV.y));
+
+		m_triangles.push_back(tri);
+	}
+}
+
+/// <summary>
+/// Clears and rasterizes all triangles overlapping rows [rowBegin, rowEnd).
+/// </summary>
+/// <param name="rowBegin">first row.</param>
+/// <param name="rowEnd">row after last.</param>
+void OcclusionCuller::rasterizeBand(unsigned int rowBegin, unsigned int rowEnd)
+{
+	std::fill(m_depth.begin() + rowBegin * m_width, m_depth.begin() + rowEnd * m_width, 1.0f);
+
+	for (unsigned int i = 0; i < m_triangles.size(); i++)
+	{
+		const ScreenTriangle &tri = m_triangles[i];
+
+		if (tri.maxY >= (int)rowBegin && tri.minY < (int)rowEnd)
+		{
+			rasterizeTriangle(tri, (int)rowBegin, (int)rowEnd);
+		}
+	}
+}
+
+/// <summary>
+/// Rasterizes triangle into depth buffer using edge functions, four pixels of row
+/// are evaluated at once. Depth buffer keeps nearest depth.
+/// </summary>
+/// <param name="tri">screen space triangle.</param>
+/// <param name="rowBegin">first row of band.</param>
+/// <param name="rowEnd">row after last of band.</param>
+void OcclusionCuller::rasterizeTriangle(const ScreenTriangle &tri, int rowBegin, int rowEnd)
+{
+	//edge functions w_k(x, y) = A_k * x + B_k * y + C_k, edge k is opposite to vertex k,
+	//coefficients of shared edge are exact negations in both triangles (no cracks)
+	float A[3], B[3], C[3];
+
+	for (unsigned int k = 0; k < 3; k++)
+	{
+		const glm::vec3 &a = tri.v[(k + 1) % 3];
+		const glm::vec3 &b = tri.v[(k + 2) % 3];
+
+		A[k] = a.y - b.y;
+		B[k] = b.x - a.x;
+		C[k] = a.x * b.y - a.y * b.x;
+	}
+
+	//depth plane z(x, y) = zA * x + zB * y + zC
+	float area = C[0] + C[1] + C[2];
+	float invArea = 1.0f / area;
+
+	float zA = (A[0] * tri.v[0].z + A[1] * tri.v[1].z + A[2] * tri.v[2].z) * invArea;
+	float zB = (B[0] * tri.v[0].z + B[1] * tri.v[1].z + B[2] * tri.v[2].z) * invArea;
+	float zC = (C[0] * tri.v[0].z + C[1] * tri.v[1].z + C[2] * tri.v[2].z) * invArea;
+
+	int y0 = std::max(tri.minY, rowBegin);
+	int y1 = std::min(tri.maxY, rowEnd - 1);
+	int x0 = tri.minX & ~3;
+	int x1 = tri.maxX;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+	__m128 edgeA[3];
+	for (unsigned int k = 0; k < 3; k++)
+	{
+		edgeA[k] = _mm_set1_ps(A[k]);
+	}
+
+	__m128 depthA = _mm_set1_ps(zA);
+
+	for (int y = y0; y <= y1; y++)
+	{
+		float py = (float)y + 0.5f;
+
+		__m128 rowEdge[3];
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			rowEdge[k] = _mm_set1_ps(B[k] * py + C[k]);
+		}
+
+		__m128 rowDepth = _mm_set1_ps(zB * py + zC);
+
+		float *row = &m_depth[y * m_width];
+
+		for (int x = x0; x <= x1; x += 4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+
+			__m128 w0 = _mm_add_ps(_mm_mul_ps(edgeA[0], px), rowEdge[0]);
+			__m128 w1 = _mm_add_ps(_mm_mul_ps(edgeA[1], px), rowEdge[1]);
+			__m128 w2 = _mm_add_ps(_mm_mul_ps(edgeA[2], px), rowEdge[2]);
+
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+			__m128 old = _mm_loadu_ps(row + x);
+			__m128 nearest = _mm_min_ps(old, z);
+
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+		}
+	}
+}
+
+/// <summary>
+/// Builds hierarchical max-depth buffer. Level 0 stores farthest depth of every
+/// HIZ_TILE x HIZ_TILE tile, next levels store maximum of 2x2 tiles of previous one.
+/// </summary>
+void OcclusionCuller::buildHierarchy()
+{
+	glm::uvec2 size = m_hizSize[0];
+
+	for (unsigned int ty = 0; ty < size.y; ty++)
+	{
+		for (unsigned int tx = 0; tx < size.x; tx++)
+		{
+			unsigned int xEnd = std::min(m_width, (tx + 1) * HIZ_TILE);
+			unsigned int yEnd = std::min(m_height, (ty + 1) * HIZ_TILE);
+
+			__m128 maxDepth = _mm_set1_ps(-1.0f);
+
+			for (unsigned int y = ty * HIZ_TILE; y < yEnd; y++)
+			{
+				for (unsigned int x = tx * HIZ_TILE; x < xEnd; x += 4)
+				{
+					maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(&m_depth[y * m_width + x]));
+				}
+			}
+
+			float lanes[4];
+			_mm_storeu_ps(lanes, maxDepth);
+
+			m_hiz[0][ty * size.x + tx] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		}
+	}
+
+	for (unsigned int l = 1; l < m_hiz.size(); l++)
+	{
+		glm::uvec2 prevSize = m_hizSize[l - 1];
+		glm::uvec2 levelSize = m_hizSize[l];
+
+		for (unsigned int y = 0; y < levelSize.y; y++)
+		{
+			for (unsigned int x = 0; x < levelSize.x; x++)
+			{
+				unsigned int x0 = x * 2, y0 = y * 2;
+				unsigned int x1 = std::min(x0 + 1, prevSize.x - 1), y1 = std::min(y0 + 1, prevSize.y - 1);
+
+				const std::vector<float> &prev = m_hiz[l - 1];
+
+				m_hiz[l][y * levelSize.x + x] = std::max(std::max(prev[y0 * prevSize.x + x0], prev[y0 * prevSize.x + x1]),
+														 std::max(prev[y1 * prevSize.x + x0], prev[y1 * prevSize.x + x1]));
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Tests bounding box against depth hierarchy. Box is visible when its nearest 
+/// depth is in front of farthest occluder depth of at least one covered tile.
+/// </summary>
+/// <param name="box">world space bounding box.</param>
+/// <returns>FALSE if box is completely hidden behind occluders.</returns>
+bool OcclusionCuller::isVisible(const AABB &box) const
+{
+	glm::vec2 minP(FLT_MAX), maxP(-FLT_MAX);
+	float minZ = FLT_MAX;
+
+	for (unsigned int c = 0; c < 8; c++)
+	{
+		glm::vec3 corner((c & 1) ? box.max.x : box.min.x, (c & 2) ? box.max.y : box.min.y, (c & 4) ? box.max.z : box.min.z);
+		glm::vec4 clip = m_viewProjection * glm::vec4(corner, 1.0f);
+
+		//box intersects near plane or lies behind camera
+		if (clip.w <= OCCLUSION_MIN_W)
+		{
+			return true;
+		}
+
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+
+		minP = glm::min(minP, glm::vec2(ndc));
+		maxP = glm::max(maxP, glm::vec2(ndc));
+		minZ = std::min(minZ, ndc.z);
+	}
+
+	//convert to pixels and clamp to screen
+	int x0 = std::max(0, (int)floorf((minP.x * 0.5f + 0.5f) * m_width));
+	int y0 = std::max(0, (int)floorf((minP.y * 0.5f + 0.5f) * m_height));
+	int x1 = std::min((int)m_width - 1, (int)ceilf((maxP.x * 0.5f + 0.5f) * m_width));
+	int y1 = std::min((int)m_height - 1, (int)ceilf((maxP.y * 0.5f + 0.5f) * m_height));
+
+	if (x0 > x1 || y0 > y1)
+	{
+		return false;
+	}
+
+	//choose hierarchy level where box covers at most 4x4 tiles
+	unsigned int level = 0;
+	unsigned int tile = HIZ_TILE;
+
+	while (level + 1 < m_hiz.size() && ((x1 / tile - x0 / tile + 1) * (y1 / tile - y0 / tile + 1)) > 16)
+	{
+		level++;
+		tile *= 2;
+	}
+
+	const std::vector<float> &hiz = m_hiz[level];
+	unsigned int levelWidth = m_hizSize[level].x;
+
+	for (int ty = y0 / (int)tile; ty <= y1 / (int)tile; ty++)
+	{
+		for (int tx = x0 / (int)tile; tx <= x1 / (int)tile; tx++)
+		{
+			if (hiz[ty * levelWidth + tx] >= minZ)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Removes occluded boxes from list of visible ones. Tests run on worker threads.
+/// </summary>
+/// <param name="bounds">bounding boxes indexed by values in visible list.</param>
+/// <param name="visible">in: candidate indices (frustum culled), out: not occluded indices.</param>
+/// <returns>visible boxes count</returns>
+unsigned int OcclusionCuller::cull(const std::vector<AABB> &bounds, std::vector<unsigned int> &visible)
+{
+	std::vector<unsigned char> passed(visible.size(), 1);
+
+	std::function<void(unsigned int, unsigned int)> test = [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			passed[i] = isVisible(bounds[visible[i]]) ? 1 : 0;
+		}
+	};
+
+	if (m_pool)
+	{
+		m_pool->parallelFor((unsigned int)visible.size(), 32, test);
+	}
+	else
+	{
+		test(0, (unsigned int)visible.size());
+	}
+
+	//compact list, order of draws is preserved
+	unsigned int count = 0;
+
+	for (unsigned int i = 0; i < visible.size(); i++)
+	{
+		if (passed[i])
+		{
+			visible[count++] = visible[i];
+		}
+	}
+
+	m_culledCount = (unsigned int)visible.size() - count;
+	visible.resize(count);
+
+	return count;
+}
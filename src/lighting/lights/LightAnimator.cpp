@@ -0,0 +1,386 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements animation of dynamic lights. Lights are processed in
+groups of four using SSE, sine and cosine are evaluated by polynomials after
+reduction to quadrant. Large light sets are split between jobs of thread pool,
+every job writes its own range of lights.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+#include "configuration\Config.h"
+#include "lighting\lights\LightAnimator.h"
+#include "utils\threading\ThreadPool.h"
+#include "utils\timers\ZoneProfiler.h"
+
+#define TWO_PI 6.28318530718f
+
+/// <summary>
+/// Deterministic random number of light parameter.
+/// </summary>
+/// <param name="seed">seed of light set.</param>
+/// <param name="index">light index.</param>
+/// <param name="salt">parameter index.</param>
+/// <returns>number in [0, 1) range</returns>
+static float hashUnit(unsigned int seed, unsigned int index, unsigned int salt)
+{
+	unsigned int h = (seed * 0x9e3779b9u) ^ (index * 0x85ebca6bu) ^ (salt * 0xc2b2ae35u);
+
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+	h *= 0x846ca68bu;
+	h ^= h >> 16;
+
+	return (h >> 8) * (1.0f / 16777216.0f);
+}
+
+/// <summary>
+/// Computes sine and cosine of four angles. Angle is reduced to [-pi/4, pi/4]
+/// by multiple of pi/2 (Cody-Waite), quadrant swaps and negates results.
+/// </summary>
+/// <param name="x">angles in radians.</param>
+/// <param name="s">output sines.</param>
+/// <param name="c">output cosines.</param>
+static inline void sinCos(__m128 x, __m128 &s, __m128 &c)
+{
+	__m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772f)));
+	__m128 qf = _mm_cvtepi32_ps(q);
+
+	//pi/2 split to exactly representable parts
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(1.5703125f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(4.83751297e-4f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(7.54978995e-8f)));
+
+	__m128 r2 = _mm_mul_ps(r, r);
+
+	__m128 ps = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(-1.9515295891e-4f)), _mm_set1_ps(8.3321608736e-3f));
+	ps = _mm_add_ps(_mm_mul_ps(ps, r2), _mm_set1_ps(-1.6666654611e-1f));
+	ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, r2), r), r);
+
+	__m128 pc = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(2.443315711809948e-5f)), _mm_set1_ps(-1.388731625493765e-3f));
+	pc = _mm_add_ps(_mm_mul_ps(pc, r2), _mm_set1_ps(4.166664568298827e-2f));
+	pc = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(pc, r2), r2), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))));
+
+	//odd quadrants swap sine and cosine
+	__m128i one = _mm_set1_epi32(1);
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+
+	s = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+	c = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+
+	//sine is negative in quadrants 2, 3, cosine in quadrants 1, 2 (bit 1 moved to sign bit)
+	__m128i two = _mm_set1_epi32(2);
+	s = _mm_xor_ps(s, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30)));
+	c = _mm_xor_ps(c, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30)));
+}
+
+/// <summary>
+/// Computes sine of four angles.
+/// </summary>
+/// <param name="x">angles in radians.</param>
+/// <returns>sines</returns>
+static inline __m128 sin4(__m128 x)
+{
+	__m128 s, c;
+	sinCos(x, s, c);
+
+	return s;
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="LightAnimator"/> class.
+/// </summary>
+LightAnimator::LightAnimator() : m_lightCount(0), m_animatedCount(0), m_pathCount(0)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="LightAnimator"/> class.
+/// </summary>
+LightAnimator::~LightAnimator()
+{
+}
+
+/// <summary>
+/// Stores base lights and generates animation parameters of animated part.
+/// Default path is ellipse in the lower quarter of bounds, it can be replaced
+/// by setPath afterwards.
+/// </summary>
+/// <param name="lights">base lights, animation moves them around these positions.</param>
+/// <param name="bounds">bounds of scene.</param>
+/// <param name="seed">seed of animation parameters.</param>
+void LightAnimator::setLights(const Lights &lights, const AABB &bounds, unsigned int seed)
+{
+	m_lightCount = (unsigned int)lights.size();
+	m_animatedCount = (unsigned int)(m_lightCount * LIGHT_ANIMATION_FRACTION);
+	m_pathCount = (unsigned int)(m_animatedCount * LIGHT_ANIMATION_PATH_FRACTION);
+
+	unsigned int padded = (m_lightCount + 3) & ~3u;
+
+	std::vector<float> *arrays[] =
+	{
+		&m_baseX, &m_baseY, &m_baseZ, &m_baseR, &m_baseG, &m_baseB, &m_baseRadius,
+		&m_orbitRadius, &m_orbitSpeed, &m_orbitPhase, &m_pathOffset, &m_pathSpeed,
+		&m_flickerAmount, &m_flickerPhase, &m_pulseAmount, &m_pulseSpeed, &m_pulsePhase,
+	};
+
+	for (unsigned int a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++)
+	{
+		arrays[a]->assign(padded, 0.0f);
+	}
+
+	for (unsigned int i = 0; i < m_lightCount; i++)
+	{
+		const Light &l = lights[i];
+
+		m_baseX[i] = l.position.x;
+		m_baseY[i] = l.position.y;
+		m_baseZ[i] = l.position.z;
+		m_baseR[i] = l.color.r;
+		m_baseG[i] = l.color.g;
+		m_baseB[i] = l.color.b;
+		m_baseRadius[i] = l.radius;
+
+		//static lights keep zero parameters
+		if (i >= m_animatedCount)
+		{
+			continue;
+		}
+
+		float orbitRadius = float(LIGHT_ANIMATION_ORBIT_RADIUS) * (0.25f + 0.75f * hashUnit(seed, i, 0));
+		float orbitSpeed = float(LIGHT_ANIMATION_ORBIT_SPEED) * (0.25f + 0.75f * hashUnit(seed, i, 1));
+
+		//path lights circle around their point of path
+		if (i < m_pathCount)
+		{
+			orbitRadius *= 0.1f;
+			m_pathOffset[i] = hashUnit(seed, i, 2);
+			m_pathSpeed[i] = (1.0f + hashUnit(seed, i, 3)) / float(LIGHT_ANIMATION_PATH_PERIOD);
+		}
+
+		m_orbitRadius[i] = orbitRadius;
+		m_orbitSpeed[i] = hashUnit(seed, i, 4) < 0.5f ? -orbitSpeed : orbitSpeed;
+		m_orbitPhase[i] = TWO_PI * hashUnit(seed, i, 5);
+
+		m_flickerAmount[i] = float(LIGHT_ANIMATION_FLICKER) * hashUnit(seed, i, 6);
+		m_flickerPhase[i] = TWO_PI * hashUnit(seed, i, 7);
+
+		m_pulseAmount[i] = float(LIGHT_ANIMATION_PULSE) * hashUnit(seed, i, 8);
+		m_pulseSpeed[i] = float(LIGHT_ANIMATION_PULSE_SPEED) * (0.5f + 0.5f * hashUnit(seed, i, 9));
+		m_pulsePhase[i] = TWO_PI * hashUnit(seed, i, 10);
+	}
+
+	//default path
+	glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+	glm::vec3 extent = (bounds.max - bounds.min) * 0.5f;
+
+	std::vector<glm::vec3> path(LIGHT_ANIMATION_PATH_POINTS);
+
+	for (unsigned int p = 0; p < path.size(); p++)
+	{
+		float angle = TWO_PI * p / path.size();
+
+		path[p].x = center.x + 0.7f * extent.x * cosf(angle);
+		path[p].y = bounds.min.y + 0.5f * extent.y;
+		path[p].z = center.z + 0.7f * extent.z * sinf(angle);
+	}
+
+	setPath(path);
+}
+
+/// <summary>
+/// Replaces base colors, base positions, radii and animation parameters are
+/// kept, so animation continues without jumps.
+/// </summary>
+/// <param name="lights">lights with new colors, same count as set lights.</param>
+void LightAnimator::setColors(const Lights &lights)
+{
+	unsigned int count = std::min(m_lightCount, (unsigned int)lights.size());
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		m_baseR[i] = lights[i].color.r;
+		m_baseG[i] = lights[i].color.g;
+		m_baseB[i] = lights[i].color.b;
+	}
+}
+
+/// <summary>
+/// Sets path followed by path lights, path is closed by segment from the last
+/// point back to the first one.
+/// </summary>
+/// <param name="points">points of path, empty path keeps path lights at base positions.</param>
+void LightAnimator::setPath(const std::vector<glm::vec3> &points)
+{
+	m_pathX.clear();
+	m_pathY.clear();
+	m_pathZ.clear();
+
+	for (unsigned int p = 0; p <= points.size() && !points.empty(); p++)
+	{
+		const glm::vec3 &point = points[p % points.size()];
+
+		m_pathX.push_back(point.x);
+		m_pathY.push_back(point.y);
+		m_pathZ.push_back(point.z);
+	}
+}
+
+/// <summary>
+/// Animates lights to given time and overwrites animated range of lights.
+/// Static lights are not touched.
+/// </summary>
+/// <param name="time">animation time in seconds.</param>
+/// <param name="lights">light set passed to setLights, animated range is overwritten.</param>
+/// <param name="pool">thread pool used for large light sets, NULL = calling thread.</param>
+/// <returns>count of updated lights at the beginning of light set</returns>
+unsigned int LightAnimator::update(float time, Lights &lights, ThreadPool *pool)
+{
+	PROFILE_FUNCTION();
+
+	if (lights.size() != m_lightCount || m_animatedCount == 0)
+	{
+		return 0;
+	}
+
+	unsigned int groups = (m_animatedCount + 3) / 4;
+	Light *data = &lights[0];
+
+	if (pool == NULL || m_animatedCount < LIGHT_ANIMATION_PARALLEL_MIN)
+	{
+		updateGroups(0, groups, time, data);
+	}
+	else
+	{
+		pool->parallelFor(groups, LIGHT_ANIMATION_GROUPS_PER_JOB, [this, time, data](unsigned int groupBegin, unsigned int groupEnd)
+		{
+			updateGroups(groupBegin, groupEnd, time, data);
+		}, "Animate lights");
+	}
+
+	return m_animatedCount;
+}
+
+/// <summary>
+/// Animates groups of four lights. Lanes behind animated range have zero
+/// parameters and are not written.
+/// </summary>
+/// <param name="groupBegin">first group.</param>
+/// <param name="groupEnd">group behind the last one.</param>
+/// <param name="time">animation time in seconds.</param>
+/// <param name="lights">output lights.</param>
+void LightAnimator::updateGroups(unsigned int groupBegin, unsigned int groupEnd, float time, Light *lights)
+{
+	__m128 t = _mm_set1_ps(time);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 quarter = _mm_set1_ps(0.25f);
+	__m128 flickerSpeed = _mm_set1_ps(float(LIGHT_ANIMATION_FLICKER_SPEED));
+	__m128 flickerSpeed2 = _mm_set1_ps(float(LIGHT_ANIMATION_FLICKER_SPEED) * 2.71f);
+	__m128 pathCount = _mm_set1_ps(float(m_pathCount));
+
+	unsigned int segments = m_pathX.empty() ? 0 : (unsigned int)m_pathX.size() - 1;
+
+	for (unsigned int g = groupBegin; g < groupEnd; g++)
+	{
+		unsigned int i = g * 4;
+
+		__m128 centerX = _mm_loadu_ps(&m_baseX[i]);
+		__m128 centerY = _mm_loadu_ps(&m_baseY[i]);
+		__m128 centerZ = _mm_loadu_ps(&m_baseZ[i]);
+
+		//path lights replace base position by point of path
+		if (i < m_pathCount && segments > 0)
+		{
+			__m128 lap = _mm_add_ps(_mm_loadu_ps(&m_pathOffset[i]), _mm_mul_ps(_mm_loadu_ps(&m_pathSpeed[i]), t));
+			__m128 lapFloor = _mm_cvtepi32_ps(_mm_cvttps_epi32(lap));
+			lapFloor = _mm_sub_ps(lapFloor, _mm_and_ps(_mm_cmpgt_ps(lapFloor, lap), one));
+
+			__m128 s = _mm_mul_ps(_mm_sub_ps(lap, lapFloor), _mm_set1_ps(float(segments)));
+
+			int k[4];
+			_mm_storeu_si128((__m128i*)k, _mm_cvttps_epi32(s));
+
+			for (unsigned int j = 0; j < 4; j++)
+			{
+				k[j] = std::min(std::max(k[j], 0), (int)segments - 1);
+			}
+
+			__m128 f = _mm_sub_ps(s, _mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)k)));
+
+			__m128 pathX = _mm_setr_ps(m_pathX[k[0]], m_pathX[k[1]], m_pathX[k[2]], m_pathX[k[3]]);
+			__m128 pathY = _mm_setr_ps(m_pathY[k[0]], m_pathY[k[1]], m_pathY[k[2]], m_pathY[k[3]]);
+			__m128 pathZ = _mm_setr_ps(m_pathZ[k[0]], m_pathZ[k[1]], m_pathZ[k[2]], m_pathZ[k[3]]);
+
+			pathX = _mm_add_ps(pathX, _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(m_pathX[k[0] + 1], m_pathX[k[1] + 1], m_pathX[k[2] + 1], m_pathX[k[3] + 1]), pathX), f));
+			pathY = _mm_add_ps(pathY, _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(m_pathY[k[0] + 1], m_pathY[k[1] + 1], m_pathY[k[2] + 1], m_pathY[k[3] + 1]), pathY), f));
+			pathZ = _mm_add_ps(pathZ, _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(m_pathZ[k[0] + 1], m_pathZ[k[1] + 1], m_pathZ[k[2] + 1], m_pathZ[k[3] + 1]), pathZ), f));
+
+			__m128 isPath = _mm_cmplt_ps(_mm_setr_ps(float(i), float(i + 1), float(i + 2), float(i + 3)), pathCount);
+
+			centerX = _mm_or_ps(_mm_and_ps(isPath, pathX), _mm_andnot_ps(isPath, centerX));
+			centerY = _mm_or_ps(_mm_and_ps(isPath, pathY), _mm_andnot_ps(isPath, centerY));
+			centerZ = _mm_or_ps(_mm_and_ps(isPath, pathZ), _mm_andnot_ps(isPath, centerZ));
+		}
+
+		//orbit in horizontal plane
+		__m128 orbitSin, orbitCos;
+		sinCos(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_orbitSpeed[i]), t), _mm_loadu_ps(&m_orbitPhase[i])), orbitSin, orbitCos);
+
+		__m128 orbitRadius = _mm_loadu_ps(&m_orbitRadius[i]);
+		__m128 x = _mm_add_ps(centerX, _mm_mul_ps(orbitRadius, orbitCos));
+		__m128 z = _mm_add_ps(centerZ, _mm_mul_ps(orbitRadius, orbitSin));
+
+		//flicker of two incommensurate waves, intensity is in [1 - amount, 1]
+		__m128 flickerPhase = _mm_loadu_ps(&m_flickerPhase[i]);
+		__m128 wave = _mm_add_ps(sin4(_mm_add_ps(_mm_mul_ps(flickerSpeed, t), flickerPhase)),
+			sin4(_mm_add_ps(_mm_mul_ps(flickerSpeed2, t), _mm_add_ps(flickerPhase, flickerPhase))));
+		__m128 intensity = _mm_sub_ps(one, _mm_mul_ps(_mm_loadu_ps(&m_flickerAmount[i]), _mm_add_ps(half, _mm_mul_ps(quarter, wave))));
+
+		__m128 r = _mm_mul_ps(_mm_loadu_ps(&m_baseR[i]), intensity);
+		__m128 gr = _mm_mul_ps(_mm_loadu_ps(&m_baseG[i]), intensity);
+		__m128 b = _mm_mul_ps(_mm_loadu_ps(&m_baseB[i]), intensity);
+
+		//pulsing radius
+		__m128 pulse = sin4(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_pulseSpeed[i]), t), _mm_loadu_ps(&m_pulsePhase[i])));
+		__m128 radius = _mm_mul_ps(_mm_loadu_ps(&m_baseRadius[i]), _mm_add_ps(one, _mm_mul_ps(_mm_loadu_ps(&m_pulseAmount[i]), pulse)));
+
+		float out[7][4];
+		_mm_storeu_ps(out[0], x);
+		_mm_storeu_ps(out[1], centerY);
+		_mm_storeu_ps(out[2], z);
+		_mm_storeu_ps(out[3], r);
+		_mm_storeu_ps(out[4], gr);
+		_mm_storeu_ps(out[5], b);
+		_mm_storeu_ps(out[6], radius);
+
+		for (unsigned int j = 0; j < 4 && i + j < m_animatedCount; j++)
+		{
+			Light &l = lights[i + j];
+
+			l.position = glm::vec3(out[0][j], out[1][j], out[2][j]);
+			l.color = glm::vec3(out[3][j], out[4][j], out[5][j]);
+			l.radius = out[6][j];
+		}
+	}
+}
@@ -25,19 +25,54 @@ is also done here.
 
 #include "lighting\lights\PointLight.h"
 #include "configuration\Config.h"
-#include "configuration\Types.h"
 #include "collision\SSBB.h"
 #include "lighting\tiled\Grid.h"
+#include "utils\timers\ZoneProfiler.h"
+#include "utils\threading\ThreadPool.h"
 #include <algorithm>
+#include <cstring>
 
-#define OFFSETS(i,j) (offsets[i + j * LIGHT_GRID_DIM_X])
-#define COUNTS(i,j) (counts[i + j * LIGHT_GRID_DIM_X])
+#define OFFSETS(i,j) (offsets[i + j * gridDim.x])
+#define COUNTS(i,j) (counts[i + j * gridDim.x])
+
+/// <summary>
+/// Initializes a new instance of the <see cref="LightGrid"/> class with
+/// resolution and tile size of current build.
+/// </summary>
+LightGrid::LightGrid() : threadPool(NULL)
+{
+	resize(glm::uvec2(RES_X, RES_Y), TILE_SIZE_XY);
+}
 
 /// <summary>
 /// Initializes a new instance of the <see cref="LightGrid"/> class.
 /// </summary>
-LightGrid::LightGrid()
+/// <param name="resolution">viewport in pixels.</param>
+/// <param name="tileSize">tile size in pixels.</param>
+LightGrid::LightGrid(const glm::uvec2 &resolution, unsigned int tileSize) : threadPool(NULL)
 {
+	resize(resolution, tileSize);
+}
+
+/// <summary>
+/// Changes viewport and tile size, light lists are cleared.
+/// </summary>
+/// <param name="resolution">viewport in pixels.</param>
+/// <param name="tileSize">tile size in pixels.</param>
+void LightGrid::resize(const glm::uvec2 &resolution, unsigned int tileSize)
+{
+	gridResolution = glm::vec2(resolution);
+	gridTileSize = tileSize;
+	gridDim = (resolution + tileSize - 1u) / tileSize;
+
+	offsets.assign(getTileCount(), 0);
+	counts.assign(getTileCount(), 0);
+
+	quads.clear();
+	viewSpaceLights.clear();
+	affectedTiles.clear();
+	globalLightList.clear();
+	lightListLength = 0;
 }
 
 /// <summary>
@@ -64,6 +99,8 @@ LightGrid::~LightGrid()
 /// <param name="projection">projection matrix.</param>
 void LightGrid::buildLightGrid(std::vector<MinMax> &minMax, Lights &lights, float n, const glm::mat4 &view, const glm::mat4 &projection)
 {
+	PROFILE_FUNCTION();
+
 	//store minimum/maximum depth to lightgrid
 	gridMinMax = minMax;
 
@@ -71,37 +108,18 @@ void LightGrid::buildLightGrid(std::vector<MinMax> &minMax, Lights &lights, floa
 	computeBoundingQuads(lights,view,projection,n);
 
 	//initialize light lists
-	memset(offsets, 0, sizeof(offsets));
-	memset(counts, 0, sizeof(counts));
-
-	lightListLength = 0;
+	memset(&offsets[0], 0, offsets.size() * sizeof(unsigned int));
+	memset(&counts[0], 0, counts.size() * sizeof(unsigned int));
 
 	//Find light count for each tile
-	for (int i = 0; i < quads.size(); i++)
-	{
-		Light l = viewSpaceLights[i];
-
-		for (unsigned int x = affectedTiles[i].x.x; x < affectedTiles[i].x.y - 1; x++)
-		{
-			for (unsigned int y = affectedTiles[i].y.x; y < affectedTiles[i].y.y - 1; y++)
-			{
-					//tests light against the minimum/maximum of depth buffer 
-					if (gridMinMax.empty() || gridMinMax[y * grid_size.x + x].max < (l.position.z + l.radius) &&
-						gridMinMax[y * grid_size.x + x].min >(l.position.z - l.radius))
-					{
-						lightListLength++;
-						COUNTS(x, y) += 1;
-					}
-			}
-		}
-	}
+	forEachRowBand(&LightGrid::countTileLights);
 
 	//set offsets
 	unsigned int offset = 0;
 
-	for (unsigned int y = 0; y < LIGHT_GRID_DIM_Y; y++)
+	for (unsigned int y = 0; y < gridDim.y; y++)
 	{
-		for (unsigned int x = 0; x < LIGHT_GRID_DIM_X; x++)
+		for (unsigned int x = 0; x < gridDim.x; x++)
 		{
 			unsigned int count = COUNTS(x, y);
 
@@ -110,31 +128,53 @@ void LightGrid::buildLightGrid(std::vector<MinMax> &minMax, Lights &lights, floa
 		}
 	}
 
+	lightListLength = offset;
 	globalLightList.resize(lightListLength);
 	
 	if(quads.size() && !globalLightList.empty())
 	{
-		int *data = &globalLightList[0];
-			
-		for (unsigned int i = 0; i < quads.size(); ++i)
-		{
-			unsigned int lightId = i;
+		forEachRowBand(&LightGrid::fillTileLights);
+	}
+}
+
+/// <summary>
+/// Runs pass of grid build over all tile rows. With thread pool the rows are
+/// split into bands, every tile is written only by job of its band.
+/// </summary>
+/// <param name="pass">pass called with [rowBegin, rowEnd) range.</param>
+void LightGrid::forEachRowBand(void (LightGrid::*pass)(unsigned int, unsigned int))
+{
+	if (threadPool == NULL || quads.size() < GRID_PARALLEL_MIN_LIGHTS)
+	{
+		(this->*pass)(0, gridDim.y);
+		return;
+	}
+
+	threadPool->parallelFor(gridDim.y, GRID_ROWS_PER_JOB, [this, pass](unsigned int rowBegin, unsigned int rowEnd)
+	{
+		(this->*pass)(rowBegin, rowEnd);
+	}, "Grid rows");
+}
 
-			Light l = viewSpaceLights[i];
+/// <summary>
+/// Counts lights of tiles in range of rows.
+/// </summary>
+/// <param name="rowBegin">first row.</param>
+/// <param name="rowEnd">row behind the last one.</param>
+void LightGrid::countTileLights(unsigned int rowBegin, unsigned int rowEnd)
+{
+	for (unsigned int i = 0; i < quads.size(); i++)
+	{
+		const Light &l = viewSpaceLights[i];
+		const TileArea &area = affectedTiles[i];
 
-			for (unsigned int x = affectedTiles[i].x.x; x < affectedTiles[i].x.y - 1; x++)
+		for (unsigned int y = std::max((unsigned int)area.y.x, rowBegin); y < rowEnd && y < area.y.y - 1; y++)
+		{
+			for (unsigned int x = area.x.x; x < area.x.y - 1; x++)
 			{
-				for (unsigned int y = affectedTiles[i].y.x; y < affectedTiles[i].y.y - 1; y++)
+				if (isLightInTile(l, x, y))
 				{
-					//tests light against the minimum/maximum of depth buffer 
-					if (gridMinMax.empty() || gridMinMax[y * grid_size.x + x].max < (l.position.z + l.radius) &&
-						gridMinMax[y * grid_size.x + x].min >(l.position.z - l.radius)){
-
-						// store reversely into next free slot
-						unsigned int offset = OFFSETS(x, y) - 1;
-						data[offset] = lightId;
-						OFFSETS(x, y) = offset;
-					}
+					COUNTS(x, y) += 1;
 				}
 			}
 		}
@@ -142,38 +182,72 @@ void LightGrid::buildLightGrid(std::vector<MinMax> &minMax, Lights &lights, floa
 }
 
 /// <summary>
-/// Renders lights' bounding quads.
-/// - for debugging purposes
-/// - uses deprecated functions, wont work with core profile
+/// Stores light IDs into lists of tiles in range of rows, lists are filled
+/// from the end (offsets end up at the first light).
 /// </summary>
-void LightGrid::showLightQuads()
+/// <param name="rowBegin">first row.</param>
+/// <param name="rowEnd">row behind the last one.</param>
+void LightGrid::fillTileLights(unsigned int rowBegin, unsigned int rowEnd)
 {
-	unsigned count = viewSpaceLights.size();
+	int *data = &globalLightList[0];
 
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0.0, float(resolution.x), 0.0, float(resolution.y), -1.0, 1.0);
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	for (unsigned int i = 0; i < quads.size(); i++)
+	{
+		const Light &l = viewSpaceLights[i];
+		const TileArea &area = affectedTiles[i];
 
-	glPushAttrib(GL_ALL_ATTRIB_BITS);
+		for (unsigned int y = std::max((unsigned int)area.y.x, rowBegin); y < rowEnd && y < area.y.y - 1; y++)
+		{
+			for (unsigned int x = area.x.x; x < area.x.y - 1; x++)
+			{
+				if (isLightInTile(l, x, y))
+				{
+					// store reversely into next free slot
+					unsigned int offset = OFFSETS(x, y) - 1;
+					data[offset] = i;
+					OFFSETS(x, y) = offset;
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Computes checksum (FNV-1a) of light lists. Lights of every tile are sorted,
+/// so grids built by different culling implementations can be compared.
+/// </summary>
+/// <returns>checksum</returns>
+unsigned int LightGrid::computeChecksum() const
+{
+	unsigned int hash = 2166136261u;
+	std::vector<int> tileLights;
 
-	for (unsigned int i = 0; i < count; i++)
+	for (unsigned int t = 0; t < getTileCount(); t++)
 	{
-		glBegin(GL_LINE_STRIP);
+		unsigned int values[2] = { t, counts[t] };
 
-			glColor4f(1.0, 1.0, 1.0, 1.0f);
+		if (counts[t] > 0)
+		{
+			tileLights.assign(globalLightList.begin() + offsets[t], globalLightList.begin() + offsets[t] + counts[t]);
+			std::sort(tileLights.begin(), tileLights.end());
+		}
+		else
+		{
+			tileLights.clear();
+		}
 
-			glVertex2f(float(quads[i].min.x), float(quads[i].min.y));
-			glVertex2f(float(quads[i].max.x), float(quads[i].min.y));
-			glVertex2f(float(quads[i].max.x), float(quads[i].max.y));
-			glVertex2f(float(quads[i].min.x), float(quads[i].max.y));
-			glVertex2f(float(quads[i].min.x), float(quads[i].min.y));
+		for (unsigned int i = 0; i < 2 + tileLights.size(); i++)
+		{
+			unsigned int value = i < 2 ? values[i] : (unsigned int)tileLights[i - 2];
 
-		glEnd();
+			for (unsigned int b = 0; b < 4; b++)
+			{
+				hash = (hash ^ ((value >> (8 * b)) & 0xff)) * 16777619u;
+			}
+		}
 	}
 
-	glPopAttrib();
+	return hash;
 }
 
 /// <summary>
@@ -185,6 +259,8 @@ void LightGrid::showLightQuads()
 /// <param name="n">near plane of view frustum.</param>
 void LightGrid::computeBoundingQuads(const Lights &lights, const glm::mat4 &view, const glm::mat4 &projection, float n)
 {
+	PROFILE_FUNCTION();
+
 	//clear vectors
 	quads.clear();
 	viewSpaceLights.clear();
@@ -211,10 +287,10 @@ void LightGrid::computeBoundingQuads(const Lights &lights, const glm::mat4 &view
 
 		//convert clip region to viewport
 		BoundingBox quad;
-		quad.min.x = clip.x * resolution.x;
-		quad.min.y = clip.y * resolution.y;
-		quad.max.x = clip.z * resolution.x;
-		quad.max.y = clip.w * resolution.y;
+		quad.min.x = clip.x * gridResolution.x;
+		quad.min.y = clip.y * gridResolution.y;
+		quad.max.x = clip.z * gridResolution.x;
+		quad.max.y = clip.w * gridResolution.y;
 
 		//store viewspace lights and their quads
 		//lights are stored in world space
@@ -243,13 +319,15 @@ void LightGrid::computeBoundingQuads(const Lights &lights, const glm::mat4 &view
 /// <param name="maxy">right bottom y coordinate.</param>
 void LightGrid::computeLightAffectedTiles(float minx, float maxx, float miny, float maxy)
 {
-	glm::vec2 x = glm::vec2(minx / TILE_SIZE_XY, (maxx + TILE_SIZE_XY - 1)/ TILE_SIZE_XY);
-	glm::vec2 y = glm::vec2(miny/ TILE_SIZE_XY, (maxy + TILE_SIZE_XY - 1) / TILE_SIZE_XY);
+	float tile = float(gridTileSize);
+
+	glm::vec2 x = glm::vec2(minx / tile, (maxx + tile - 1)/ tile);
+	glm::vec2 y = glm::vec2(miny/ tile, (maxy + tile - 1) / tile);
 
 	TileArea tmp;
 
-	tmp.x = glm::clamp(x, glm::vec2(0.0), glm::vec2(grid_size.x + 1,grid_size.x + 1));
-	tmp.y = glm::clamp(y, glm::vec2(0.0), glm::vec2(grid_size.y + 1, grid_size.y + 1));
+	tmp.x = glm::clamp(x, glm::vec2(0.0), glm::vec2(gridDim.x + 1, gridDim.x + 1));
+	tmp.y = glm::clamp(y, glm::vec2(0.0), glm::vec2(gridDim.y + 1, gridDim.y + 1));
 
 	affectedTiles.push_back(tmp);
 }
\ No newline at end of file
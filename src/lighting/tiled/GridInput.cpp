@@ -0,0 +1,177 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements saving and loading of light grid input. File is plain
+text, matrices are stored column by column.
+*/
+
+#include <fstream>
+#include <iomanip>
+
+#include "lighting\tiled\GridInput.h"
+
+/// <summary>
+/// Writes matrix line.
+/// </summary>
+/// <param name="file">output stream.</param>
+/// <param name="name">matrix name.</param>
+/// <param name="m">matrix.</param>
+static void writeMatrix(std::ofstream &file, const char *name, const glm::mat4 &m)
+{
+	file << name;
+
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			file << " " << m[c][r];
+		}
+	}
+
+	file << "\n";
+}
+
+/// <summary>
+/// Reads matrix line.
+/// </summary>
+/// <param name="file">input stream.</param>
+/// <param name="name">expected matrix name.</param>
+/// <param name="m">output matrix.</param>
+/// <returns>false if line is missing or invalid</returns>
+static bool readMatrix(std::ifstream &file, const char *name, glm::mat4 &m)
+{
+	std::string key;
+
+	if (!(file >> key) || key != name)
+	{
+		return false;
+	}
+
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			file >> m[c][r];
+		}
+	}
+
+	return !file.fail();
+}
+
+/// <summary>
+/// Saves light grid input.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <param name="input">grid input.</param>
+/// <returns>false if file could not be written</returns>
+bool saveGridInput(const std::string &filename, const GridInput &input)
+{
+	std::ofstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file << std::setprecision(9);
+	file << "resolution " << input.resolution.x << " " << input.resolution.y << "\n";
+	file << "tile " << input.tileSize << "\n";
+	file << "near " << input.nearPlane << "\n";
+	writeMatrix(file, "view", input.view);
+	writeMatrix(file, "projection", input.projection);
+
+	file << "lights " << input.lights.size() << "\n";
+
+	for (unsigned int i = 0; i < input.lights.size(); i++)
+	{
+		const Light &l = input.lights[i];
+
+		file << l.position.x << " " << l.position.y << " " << l.position.z << " "
+			<< l.color.x << " " << l.color.y << " " << l.color.z << " " << l.radius << "\n";
+	}
+
+	file << "depth_ranges " << input.tileDepthRanges.size() << "\n";
+
+	for (unsigned int i = 0; i < input.tileDepthRanges.size(); i++)
+	{
+		file << input.tileDepthRanges[i].min << " " << input.tileDepthRanges[i].max << "\n";
+	}
+
+	return file.good();
+}
+
+/// <summary>
+/// Loads light grid input saved by saveGridInput().
+/// </summary>
+/// <param name="filename">input file.</param>
+/// <param name="input">output grid input.</param>
+/// <returns>false if file could not be read or is invalid</returns>
+bool loadGridInput(const std::string &filename, GridInput &input)
+{
+	std::ifstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::string key;
+	unsigned int count;
+
+	if (!(file >> key >> input.resolution.x >> input.resolution.y) || key != "resolution" ||
+		!(file >> key >> input.tileSize) || key != "tile" || input.tileSize == 0 ||
+		!(file >> key >> input.nearPlane) || key != "near" ||
+		!readMatrix(file, "view", input.view) || !readMatrix(file, "projection", input.projection))
+	{
+		return false;
+	}
+
+	if (!(file >> key >> count) || key != "lights")
+	{
+		return false;
+	}
+
+	input.lights.resize(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		Light &l = input.lights[i];
+
+		file >> l.position.x >> l.position.y >> l.position.z >> l.color.x >> l.color.y >> l.color.z >> l.radius;
+	}
+
+	//depth ranges are either missing or given for every tile
+	unsigned long long tileCount = ((input.resolution.x + (unsigned long long)input.tileSize - 1) / input.tileSize) *
+		((input.resolution.y + (unsigned long long)input.tileSize - 1) / input.tileSize);
+
+	if (!(file >> key >> count) || key != "depth_ranges" || (count != 0 && count != tileCount))
+	{
+		return false;
+	}
+
+	input.tileDepthRanges.resize(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		file >> input.tileDepthRanges[i].min >> input.tileDepthRanges[i].max;
+	}
+
+	return !file.fail();
+}
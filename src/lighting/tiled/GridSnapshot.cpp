@@ -0,0 +1,459 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements light grid snapshot stream. Stream starts with magic
+and version, every frame is stored as size prefixed record of varints:
+frame, keyframe flag, resolution, tile size, light and depth range counts,
+XOR delta of all float values (near plane, view, projection, lights, depth
+ranges) and checksum of built grid. Deltas are stored as pairs of zero run
+length and non-zero delta, followed by length of trailing zero run.
+*/
+
+#include <cstring>
+
+#include "lighting\tiled\GridSnapshot.h"
+
+#define SNAPSHOT_MAGIC		0x474C4345u		//"ECLG"
+#define SNAPSHOT_VERSION	1u
+
+//floats of single light (position, color, radius) and depth range
+#define LIGHT_VALUES		7
+#define RANGE_VALUES		2
+
+//values before lights: near plane, view and projection matrix
+#define CAMERA_VALUES		33
+
+/// <summary>
+/// Returns bit pattern of float.
+/// </summary>
+/// <param name="value">float value.</param>
+/// <returns>bits</returns>
+static inline unsigned int floatBits(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	return bits;
+}
+
+/// <summary>
+/// Returns float of bit pattern.
+/// </summary>
+/// <param name="bits">bits.</param>
+/// <returns>float value</returns>
+static inline float bitsFloat(unsigned int bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+/// <summary>
+/// Appends varint (7 bits per byte, high bit = more bytes follow).
+/// </summary>
+/// <param name="buffer">output buffer.</param>
+/// <param name="value">value.</param>
+static void putVarint(std::vector<unsigned char> &buffer, unsigned int value)
+{
+	while (value >= 0x80)
+	{
+		buffer.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+
+	buffer.push_back((unsigned char)value);
+}
+
+/// <summary>
+/// Reads varint.
+/// </summary>
+/// <param name="buffer">input buffer.</param>
+/// <param name="position">read position, moved behind value.</param>
+/// <param name="value">output value.</param>
+/// <returns>false if buffer ends inside value</returns>
+static bool getVarint(const std::vector<unsigned char> &buffer, size_t &position, unsigned int &value)
+{
+	value = 0;
+
+	for (unsigned int shift = 0; shift < 35; shift += 7)
+	{
+		if (position >= buffer.size())
+		{
+			return false;
+		}
+
+		unsigned char byte = buffer[position++];
+		value |= (unsigned int)(byte & 0x7f) << shift;
+
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Writes 32-bit value in little endian.
+/// </summary>
+/// <param name="file">output stream.</param>
+/// <param name="value">value.</param>
+static void writeUint(std::ofstream &file, unsigned int value)
+{
+	unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+	file.write((const char *)bytes, 4);
+}
+
+/// <summary>
+/// Reads 32-bit little endian value.
+/// </summary>
+/// <param name="file">input stream.</param>
+/// <param name="value">output value.</param>
+/// <returns>false at end of stream</returns>
+static bool readUint(std::ifstream &file, unsigned int &value)
+{
+	unsigned char bytes[4];
+
+	if (!file.read((char *)bytes, 4))
+	{
+		return false;
+	}
+
+	value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+
+	return true;
+}
+
+
+/// <summary>
+/// Initializes a new instance of the <see cref="GridSnapshotWriter"/> class.
+/// </summary>
+GridSnapshotWriter::GridSnapshotWriter() : m_frame(0), m_bytesWritten(0)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="GridSnapshotWriter"/> class.
+/// </summary>
+GridSnapshotWriter::~GridSnapshotWriter()
+{
+	close();
+}
+
+/// <summary>
+/// Creates snapshot stream.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <returns>false if file could not be created</returns>
+bool GridSnapshotWriter::open(const std::string &filename)
+{
+	close();
+
+	m_file.open(filename.c_str(), std::ios::binary);
+
+	if (!m_file.is_open())
+	{
+		return false;
+	}
+
+	writeUint(m_file, SNAPSHOT_MAGIC);
+	writeUint(m_file, SNAPSHOT_VERSION);
+
+	m_previous.clear();
+	m_frame = 0;
+	m_bytesWritten = 8;
+
+	return m_file.good();
+}
+
+/// <summary>
+/// Closes snapshot stream.
+/// </summary>
+void GridSnapshotWriter::close()
+{
+	if (m_file.is_open())
+	{
+		m_file.close();
+	}
+}
+
+/// <summary>
+/// Appends frame to snapshot stream.
+/// </summary>
+/// <param name="input">inputs of light grid build.</param>
+/// <param name="checksum">checksum of built grid (LightGrid::computeChecksum).</param>
+void GridSnapshotWriter::write(const GridInput &input, unsigned int checksum)
+{
+	if (!m_file.is_open())
+	{
+		return;
+	}
+
+	//flatten floats of frame
+	m_values.clear();
+	m_values.push_back(floatBits(input.nearPlane));
+
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			m_values.push_back(floatBits(input.view[c][r]));
+		}
+	}
+
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			m_values.push_back(floatBits(input.projection[c][r]));
+		}
+	}
+
+	for (unsigned int i = 0; i < input.lights.size(); i++)
+	{
+		const Light &l = input.lights[i];
+
+		m_values.push_back(floatBits(l.position.x));
+		m_values.push_back(floatBits(l.position.y));
+		m_values.push_back(floatBits(l.position.z));
+		m_values.push_back(floatBits(l.color.x));
+		m_values.push_back(floatBits(l.color.y));
+		m_values.push_back(floatBits(l.color.z));
+		m_values.push_back(floatBits(l.radius));
+	}
+
+	for (unsigned int i = 0; i < input.tileDepthRanges.size(); i++)
+	{
+		m_values.push_back(floatBits(input.tileDepthRanges[i].min));
+		m_values.push_back(floatBits(input.tileDepthRanges[i].max));
+	}
+
+	//delta against previous frame only if layout of values is the same
+	bool keyframe = m_previous.size() != m_values.size() || m_frame % GRID_SNAPSHOT_KEYFRAME_INTERVAL == 0;
+
+	m_buffer.clear();
+	putVarint(m_buffer, m_frame);
+	putVarint(m_buffer, keyframe ? 1 : 0);
+	putVarint(m_buffer, input.resolution.x);
+	putVarint(m_buffer, input.resolution.y);
+	putVarint(m_buffer, input.tileSize);
+	putVarint(m_buffer, (unsigned int)input.lights.size());
+	putVarint(m_buffer, (unsigned int)input.tileDepthRanges.size());
+
+	unsigned int zeroRun = 0;
+
+	for (unsigned int i = 0; i < m_values.size(); i++)
+	{
+		unsigned int delta = keyframe ? m_values[i] : m_values[i] ^ m_previous[i];
+
+		if (delta == 0)
+		{
+			zeroRun++;
+			continue;
+		}
+
+		putVarint(m_buffer, zeroRun);
+		putVarint(m_buffer, delta);
+		zeroRun = 0;
+	}
+
+	putVarint(m_buffer, zeroRun);
+	putVarint(m_buffer, checksum);
+
+	writeUint(m_file, (unsigned int)m_buffer.size());
+	m_file.write((const char *)&m_buffer[0], m_buffer.size());
+
+	m_previous.swap(m_values);
+	m_bytesWritten += 4 + m_buffer.size();
+	m_frame++;
+}
+
+
+/// <summary>
+/// Initializes a new instance of the <see cref="GridSnapshotReader"/> class.
+/// </summary>
+GridSnapshotReader::GridSnapshotReader() : m_frame(0)
+{
+}
+
+/// <summary>
+/// Opens snapshot stream and checks its header.
+/// </summary>
+/// <param name="filename">input file.</param>
+/// <returns>false if file could not be read or is not snapshot stream</returns>
+bool GridSnapshotReader::open(const std::string &filename)
+{
+	m_file.open(filename.c_str(), std::ios::binary);
+
+	unsigned int magic, version;
+
+	if (!m_file.is_open() || !readUint(m_file, magic) || !readUint(m_file, version))
+	{
+		return false;
+	}
+
+	m_previous.clear();
+	m_frame = 0;
+
+	return magic == SNAPSHOT_MAGIC && version == SNAPSHOT_VERSION;
+}
+
+/// <summary>
+/// Reads next frame.
+/// </summary>
+/// <param name="input">output inputs of light grid build.</param>
+/// <param name="checksum">output checksum of grid built during capture.</param>
+/// <returns>false at end of stream or if frame is corrupted</returns>
+bool GridSnapshotReader::read(GridInput &input, unsigned int &checksum)
+{
+	unsigned int size;
+
+	if (!readUint(m_file, size))
+	{
+		return false;
+	}
+
+	m_buffer.resize(size);
+
+	if (size == 0 || !m_file.read((char *)&m_buffer[0], size))
+	{
+		return false;
+	}
+
+	size_t position = 0;
+	unsigned int keyframe, lightCount, rangeCount;
+
+	if (!getVarint(m_buffer, position, m_frame) || !getVarint(m_buffer, position, keyframe) ||
+		!getVarint(m_buffer, position, input.resolution.x) || !getVarint(m_buffer, position, input.resolution.y) ||
+		!getVarint(m_buffer, position, input.tileSize) ||
+		!getVarint(m_buffer, position, lightCount) || !getVarint(m_buffer, position, rangeCount))
+	{
+		return false;
+	}
+
+	//depth ranges are either missing or given for every tile
+	if (input.tileSize == 0)
+	{
+		return false;
+	}
+
+	unsigned long long tileCount = ((input.resolution.x + (unsigned long long)input.tileSize - 1) / input.tileSize) *
+		((input.resolution.y + (unsigned long long)input.tileSize - 1) / input.tileSize);
+
+	if (rangeCount != 0 && rangeCount != tileCount)
+	{
+		return false;
+	}
+
+	size_t valueCount = CAMERA_VALUES + (size_t)lightCount * LIGHT_VALUES + (size_t)rangeCount * RANGE_VALUES;
+
+	//delta frame must follow frame with the same layout
+	if (!keyframe && m_previous.size() != valueCount)
+	{
+		return false;
+	}
+
+	m_values.assign(valueCount, 0);
+
+	for (size_t i = 0;;)
+	{
+		unsigned int zeroRun;
+
+		if (!getVarint(m_buffer, position, zeroRun) || zeroRun > valueCount - i)
+		{
+			return false;
+		}
+
+		i += zeroRun;
+
+		if (i == valueCount)
+		{
+			break;
+		}
+
+		if (!getVarint(m_buffer, position, m_values[i++]))
+		{
+			return false;
+		}
+	}
+
+	if (!keyframe)
+	{
+		for (size_t i = 0; i < valueCount; i++)
+		{
+			m_values[i] ^= m_previous[i];
+		}
+	}
+
+	if (!getVarint(m_buffer, position, checksum))
+	{
+		return false;
+	}
+
+	//unflatten values
+	const unsigned int *v = &m_values[0];
+
+	input.nearPlane = bitsFloat(*v++);
+
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			input.view[c][r] = bitsFloat(*v++);
+		}
+	}
+
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			input.projection[c][r] = bitsFloat(*v++);
+		}
+	}
+
+	input.lights.resize(lightCount);
+
+	for (unsigned int i = 0; i < lightCount; i++)
+	{
+		Light &l = input.lights[i];
+
+		l.position.x = bitsFloat(*v++);
+		l.position.y = bitsFloat(*v++);
+		l.position.z = bitsFloat(*v++);
+		l.color.x = bitsFloat(*v++);
+		l.color.y = bitsFloat(*v++);
+		l.color.z = bitsFloat(*v++);
+		l.radius = bitsFloat(*v++);
+	}
+
+	input.tileDepthRanges.resize(rangeCount);
+
+	for (unsigned int i = 0; i < rangeCount; i++)
+	{
+		input.tileDepthRanges[i].min = bitsFloat(*v++);
+		input.tileDepthRanges[i].max = bitsFloat(*v++);
+	}
+
+	m_previous.swap(m_values);
+
+	return true;
+}
@@ -0,0 +1,80 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements light grid statistics. Single pass over tile light
+counts fills histogram, percentile is then read from histogram.
+*/
+
+#include <cmath>
+#include <cstring>
+
+#include "lighting\tiled\GridStatistics.h"
+
+/// <summary>
+/// Computes statistics of tile light counts.
+/// </summary>
+/// <param name="counts">light count of every tile (LightGrid::getCounts).</param>
+/// <param name="tileCount">number of tiles.</param>
+/// <param name="stats">output statistics.</param>
+void computeGridStatistics(const unsigned int *counts, unsigned int tileCount, GridStatistics &stats)
+{
+	memset(&stats, 0, sizeof(GridStatistics));
+
+	stats.tiles = tileCount;
+
+	if (tileCount == 0)
+	{
+		return;
+	}
+
+	unsigned int overThreshold = 0;
+
+	for (unsigned int t = 0; t < tileCount; t++)
+	{
+		unsigned int count = counts[t];
+
+		stats.listLength += count;
+		stats.maxLights = count > stats.maxLights ? count : stats.maxLights;
+		stats.histogram[count < GRID_HISTOGRAM_BINS ? count : GRID_HISTOGRAM_BINS - 1]++;
+
+		if (count > GRID_STATS_THRESHOLD)
+		{
+			overThreshold++;
+		}
+	}
+
+	stats.meanLights = float(stats.listLength) / tileCount;
+	stats.overThreshold = float(overThreshold) / tileCount;
+
+	//the lowest count with at least 95% of tiles at or below it
+	unsigned int rank = (unsigned int)ceil(0.95 * tileCount);
+	unsigned int cumulative = 0;
+
+	for (unsigned int b = 0; b < GRID_HISTOGRAM_BINS; b++)
+	{
+		cumulative += stats.histogram[b];
+
+		if (cumulative >= rank)
+		{
+			stats.p95Lights = b;
+			break;
+		}
+	}
+}
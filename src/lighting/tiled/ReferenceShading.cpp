@@ -0,0 +1,438 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements CPU reference of tiled deferred light pass. Tiles are
+shaded in parallel by jobs of thread pool. Scalar path follows calcLighting
+of tiled_deferred_frag.glsl line by line and it is used by default. AVX2 kernel
+(ReferenceShadingAvx2.cpp) is called only if CPU and OS support AVX2, which
+is detected by CPUID at startup. Lights out of range of the pixel are
+skipped, their contribution is zero because of attenuation.
+*/
+
+#include "lighting\tiled\ReferenceShading.h"
+#include "lighting\tiled\ReferenceShadingKernel.h"
+#include "lighting\tiled\Grid.h"
+#include "configuration\Config.h"
+#include "utils\threading\ThreadPool.h"
+#include "utils\timers\ZoneProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #include <cpuid.h>
+#endif
+
+//AVX2 kernel reads view space lights of grid directly
+static_assert(sizeof(Light) == sizeof(ShadingKernelLight), "Light layout differs from ShadingKernelLight");
+
+/// <summary>
+/// Inputs and output shared by tile jobs
+/// </summary>
+typedef struct
+{
+	const ShadingGBuffer *gBuffer;
+	ShadingImage *image;
+	const unsigned int *counts;
+	const unsigned int *offsets;
+	const int *lightList;
+	const Light *lights;			//view space lights of grid
+	glm::uvec2 gridDim;
+	unsigned int tileSize;
+	bool simd;
+} ShadingContext;
+
+
+/// <summary>
+/// Detects AVX2 support of CPU and OS (YMM registers saved on context switch).
+/// </summary>
+/// <returns>true if AVX2 instructions can be executed</returns>
+static bool detectAvx2()
+{
+	#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	  int regs[4];
+
+	  __cpuid(regs, 0);
+	  if (regs[0] < 7)
+	  {
+		  return false;
+	  }
+
+	  //OSXSAVE and AVX
+	  __cpuid(regs, 1);
+	  if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+	  {
+		  return false;
+	  }
+
+	  //XMM and YMM state enabled by OS
+	  if ((_xgetbv(0) & 6) != 6)
+	  {
+		  return false;
+	  }
+
+	  __cpuidex(regs, 7, 0);
+	  return (regs[1] & (1 << 5)) != 0;
+	#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	  unsigned int eax, ebx, ecx, edx;
+
+	  if (__get_cpuid_max(0, NULL) < 7)
+	  {
+		  return false;
+	  }
+
+	  //OSXSAVE and AVX
+	  __cpuid(1, eax, ebx, ecx, edx);
+	  if ((ecx & (1 << 27)) == 0 || (ecx & (1 << 28)) == 0)
+	  {
+		  return false;
+	  }
+
+	  //XMM and YMM state enabled by OS
+	  unsigned int xcr0, xcr0High;
+	  __asm__ ("xgetbv" : "=a" (xcr0), "=d" (xcr0High) : "c" (0));
+	  if ((xcr0 & 6) != 6)
+	  {
+		  return false;
+	  }
+
+	  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+	  return (ebx & (1 << 5)) != 0;
+	#else
+	  return false;
+	#endif
+}
+
+//CPUID is queried once at startup
+static const bool avx2Supported = detectAvx2();
+
+
+/// <summary>
+/// Resizes all planes of G-buffer.
+/// </summary>
+/// <param name="gBuffer">G-buffer.</param>
+/// <param name="resolution">resolution in pixels.</param>
+void resizeGBuffer(ShadingGBuffer &gBuffer, const glm::uvec2 &resolution)
+{
+	unsigned int pixels = resolution.x * resolution.y;
+
+	gBuffer.resolution = resolution;
+
+	for (unsigned int c = 0; c < 3; c++)
+	{
+		gBuffer.diffuse[c].assign(pixels, 0.0f);
+		gBuffer.normal[c].assign(pixels, 0.0f);
+		gBuffer.position[c].assign(pixels, 0.0f);
+		gBuffer.specular[c].assign(pixels, 0.0f);
+	}
+
+	gBuffer.shininess.assign(pixels, 0.0f);
+}
+
+
+/// <summary>
+/// Resizes all planes of image, image is cleared to black.
+/// </summary>
+/// <param name="image">image.</param>
+/// <param name="resolution">resolution in pixels.</param>
+void resizeImage(ShadingImage &image, const glm::uvec2 &resolution)
+{
+	image.resolution = resolution;
+
+	for (unsigned int c = 0; c < 3; c++)
+	{
+		image.color[c].assign(resolution.x * resolution.y, 0.0f);
+	}
+}
+
+
+/// <summary>
+/// Determines whether AVX2 kernel can be used, it has to be enabled
+/// in configuration, compiled in and supported by CPU.
+/// </summary>
+/// <returns>true if AVX2 kernel is used when requested</returns>
+bool isSimdShadingAvailable()
+{
+	return REFERENCE_SHADING_AVX2 && avx2Supported && isAvx2ShadingCompiled();
+}
+
+
+/// <summary>
+/// Fresnel-Schlick reflection.
+/// </summary>
+/// <param name="specular">specular color.</param>
+/// <param name="E">direction to light.</param>
+/// <param name="H">halfway direction.</param>
+/// <returns>reflected fraction</returns>
+static glm::vec3 fresnelSchlick(const glm::vec3 &specular, const glm::vec3 &E, const glm::vec3 &H)
+{
+	return specular + (1.0f - specular) * powf(1.0f - glm::clamp(glm::dot(E, H), 0.0f, 1.0f), 5.0f);
+}
+
+
+/// <summary>
+/// Shades single pixel by all lights of its tile.
+/// </summary>
+/// <param name="context">shading context.</param>
+/// <param name="tile">tile index.</param>
+/// <param name="index">pixel index.</param>
+static void shadePixel(const ShadingContext &context, unsigned int tile, unsigned int index)
+{
+	const ShadingGBuffer &g = *context.gBuffer;
+
+	glm::vec3 N(g.normal[0][index], g.normal[1][index], g.normal[2][index]);
+	glm::vec3 color(0.0f);
+
+	if (N != glm::vec3(0.0f))
+	{
+		glm::vec3 position(g.position[0][index], g.position[1][index], g.position[2][index]);
+		glm::vec3 diffuse(g.diffuse[0][index], g.diffuse[1][index], g.diffuse[2][index]);
+		glm::vec3 specular(g.specular[0][index], g.specular[1][index], g.specular[2][index]);
+		float shininess = g.shininess[index];
+
+		glm::vec3 V = glm::normalize(-position);
+
+		const int *lightIDs = context.lightList + context.offsets[tile];
+
+		for (unsigned int i = 0; i < context.counts[tile]; i++)
+		{
+			const Light &light = context.lights[lightIDs[i]];
+
+			//light direction
+			glm::vec3 L = light.position - position;
+
+			float dist = glm::length(L);
+
+			if (dist >= light.radius)
+			{
+				continue;
+			}
+
+			L = glm::normalize(L);
+
+			//halfway direction
+			glm::vec3 H = glm::normalize(L + V);
+
+			float NdotL = glm::clamp(glm::dot(N, L), 0.0f, 1.0f);
+			float NdotH = glm::clamp(glm::dot(N, H), 0.0f, 1.0f);
+
+			float attenuation = glm::clamp(1.0f - dist * dist / (light.radius * light.radius), 0.0f, 1.0f);
+			attenuation *= attenuation;
+
+			//fresnel specular reflection, pow(0, shininess) is taken as 0
+			float highlight = NdotH > 0.0f ? powf(NdotH, shininess) : 0.0f;
+			glm::vec3 spec = fresnelSchlick(specular, L, H) * ((shininess + 2.0f) / 8.0f) * highlight * NdotL;
+
+			color += NdotL * light.color * (diffuse + spec) * attenuation;
+		}
+	}
+
+	for (unsigned int c = 0; c < 3; c++)
+	{
+		context.image->color[c][index] = color[c];
+	}
+}
+
+
+/// <summary>
+/// Shades pixels of tiles in range.
+/// </summary>
+/// <param name="context">shading context.</param>
+/// <param name="tileBegin">first tile.</param>
+/// <param name="tileEnd">tile behind the last one.</param>
+static void shadeTiles(const ShadingContext &context, unsigned int tileBegin, unsigned int tileEnd)
+{
+	const ShadingGBuffer &g = *context.gBuffer;
+	glm::uvec2 resolution = g.resolution;
+
+	ShadingKernelTile kernelTile;
+
+	if (context.simd)
+	{
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			kernelTile.diffuse[c] = &g.diffuse[c][0];
+			kernelTile.normal[c] = &g.normal[c][0];
+			kernelTile.position[c] = &g.position[c][0];
+			kernelTile.specular[c] = &g.specular[c][0];
+			kernelTile.color[c] = &context.image->color[c][0];
+		}
+
+		kernelTile.shininess = &g.shininess[0];
+		kernelTile.lights = reinterpret_cast<const ShadingKernelLight*>(context.lights);
+	}
+
+	for (unsigned int tile = tileBegin; tile < tileEnd; tile++)
+	{
+		kernelTile.lightIDs = context.lightList + context.offsets[tile];
+		kernelTile.lightCount = context.counts[tile];
+
+		unsigned int x0 = (tile % context.gridDim.x) * context.tileSize;
+		unsigned int y0 = (tile / context.gridDim.x) * context.tileSize;
+		unsigned int x1 = std::min(x0 + context.tileSize, resolution.x);
+		unsigned int y1 = std::min(y0 + context.tileSize, resolution.y);
+
+		for (unsigned int y = y0; y < y1; y++)
+		{
+			unsigned int x = x0;
+
+			if (context.simd)
+			{
+				x += shadeRowAvx2(kernelTile, y * resolution.x + x, x1 - x);
+			}
+
+			for (; x < x1; x++)
+			{
+				shadePixel(context, tile, y * resolution.x + x);
+			}
+		}
+	}
+}
+
+
+/// <summary>
+/// Shades G-buffer by lights of tiles of built grid. Grid has to be built
+/// for resolution of G-buffer.
+/// </summary>
+/// <param name="gBuffer">G-buffer.</param>
+/// <param name="grid">built light grid.</param>
+/// <param name="image">output image, resized to G-buffer.</param>
+/// <param name="pool">thread pool shading tiles in parallel, NULL = calling thread.</param>
+/// <param name="simd">use AVX2 kernel if it is available on this CPU.</param>
+void shadeTiledDeferred(const ShadingGBuffer &gBuffer, const LightGrid &grid, ShadingImage &image, ThreadPool *pool, bool simd)
+{
+	PROFILE_FUNCTION();
+
+	resizeImage(image, gBuffer.resolution);
+
+	if (grid.getLightListLength() == 0)
+	{
+		return;
+	}
+
+	ShadingContext context;
+	context.gBuffer = &gBuffer;
+	context.image = &image;
+	context.counts = grid.getCounts();
+	context.offsets = grid.getOffsets();
+	context.lightList = grid.getLightList();
+	context.lights = &grid.getViewSpaceLights()[0];
+	context.gridDim = grid.getGridDim();
+	context.tileSize = grid.getTileSize();
+	context.simd = simd && isSimdShadingAvailable();
+
+	if (pool == NULL)
+	{
+		shadeTiles(context, 0, grid.getTileCount());
+		return;
+	}
+
+	pool->parallelFor(grid.getTileCount(), REFERENCE_SHADING_TILES_PER_JOB, [&context](unsigned int tileBegin, unsigned int tileEnd)
+	{
+		shadeTiles(context, tileBegin, tileEnd);
+	}, "Shade tiles");
+}
+
+
+/// <summary>
+/// Compares two images of the same resolution.
+/// </summary>
+/// <param name="a">first image.</param>
+/// <param name="b">second image.</param>
+/// <param name="difference">output absolute difference over channels.</param>
+void compareImages(const ShadingImage &a, const ShadingImage &b, ImageDifference &difference)
+{
+	double sum = 0.0;
+
+	difference.maxError = 0.0f;
+	difference.meanError = 0.0f;
+	difference.pixels = 0;
+	difference.nonFinite = 0;
+
+	if (a.resolution != b.resolution)
+	{
+		return;
+	}
+
+	for (unsigned int i = 0; i < a.resolution.x * a.resolution.y; i++)
+	{
+		float error = 0.0f;
+		bool finite = true;
+
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			finite = finite && std::isfinite(a.color[c][i]) && std::isfinite(b.color[c][i]);
+			error = std::max(error, std::fabs(a.color[c][i] - b.color[c][i]));
+		}
+
+		if (!finite)
+		{
+			difference.nonFinite++;
+			continue;
+		}
+
+		difference.maxError = std::max(difference.maxError, error);
+		difference.pixels++;
+		sum += error;
+	}
+
+	difference.meanError = difference.pixels ? float(sum / difference.pixels) : 0.0f;
+}
+
+
+/// <summary>
+/// Saves image to PFM (portable float map), rows are stored from the bottom
+/// one as in image.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <param name="image">image.</param>
+/// <returns>false if file could not be written</returns>
+bool saveImagePfm(const std::string &filename, const ShadingImage &image)
+{
+	std::ofstream file(filename.c_str(), std::ios::binary);
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	//negative scale = little endian
+	file << "PF\n" << image.resolution.x << " " << image.resolution.y << "\n-1.0\n";
+
+	std::vector<float> row(image.resolution.x * 3);
+
+	for (unsigned int y = 0; y < image.resolution.y; y++)
+	{
+		for (unsigned int x = 0; x < image.resolution.x; x++)
+		{
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				row[x * 3 + c] = image.color[c][y * image.resolution.x + x];
+			}
+		}
+
+		file.write((const char*)&row[0], row.size() * sizeof(float));
+	}
+
+	return file.good();
+}
@@ -0,0 +1,279 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements AVX2 kernel of CPU reference shading, it shades 8 pixels
+of tile row at once with approximated pow (log2/exp2 polynomials, relative
+error below 1e-6). Lights out of range of all 8 pixels are skipped, their
+contribution is zero because of attenuation. File is compiled with /arch:AVX2
+(MSVC) or uses target attributes (GCC, Clang), kernel is called only when
+CPU supports AVX2 (see isSimdShadingAvailable).
+*/
+
+#include "lighting\tiled\ReferenceShadingKernel.h"
+
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define AVX2_KERNEL 1
+  #define AVX2_TARGET
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define AVX2_KERNEL 1
+  #define AVX2_TARGET __attribute__((target("avx2")))
+#else
+  #define AVX2_KERNEL 0
+#endif
+
+//pixels shaded at once
+#define AVX2_WIDTH 8
+
+
+#if AVX2_KERNEL
+
+/// <summary>
+/// Base 2 logarithm of positive normal numbers.
+/// </summary>
+/// <param name="x">values.</param>
+/// <returns>log2(x)</returns>
+static inline AVX2_TARGET __m256 log2Simd(__m256 x)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	//x = m * 2^e with m in [sqrt(0.5), sqrt(2))
+	__m256i bits = _mm256_castps_si256(x);
+	__m256i exponent = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_castps_si256(one)));
+
+	__m256 large = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+	m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), large);
+	exponent = _mm256_sub_epi32(exponent, _mm256_castps_si256(large));
+
+	//log2(m) = 2 / ln(2) * atanh(t), t = (m - 1) / (m + 1) in [-0.172, 0.172]
+	__m256 t = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+	__m256 t2 = _mm256_mul_ps(t, t);
+
+	__m256 p = _mm256_set1_ps(1.0f / 9.0f);
+	p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(1.0f / 7.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(1.0f / 5.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(1.0f / 3.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, t2), one);
+
+	return _mm256_add_ps(_mm256_cvtepi32_ps(exponent), _mm256_mul_ps(_mm256_mul_ps(t, p), _mm256_set1_ps(2.88539008f)));
+}
+
+
+/// <summary>
+/// Base 2 exponential, results under 2^-126 are clamped to it.
+/// </summary>
+/// <param name="y">values.</param>
+/// <returns>2^y</returns>
+static inline AVX2_TARGET __m256 exp2Simd(__m256 y)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	y = _mm256_min_ps(_mm256_max_ps(y, _mm256_set1_ps(-126.0f)), _mm256_set1_ps(127.0f));
+
+	//2^y = 2^n * e^(f * ln(2)), f in [-0.5, 0.5]
+	__m256 n = _mm256_round_ps(y, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	__m256 f = _mm256_mul_ps(_mm256_sub_ps(y, n), _mm256_set1_ps(0.693147181f));
+
+	__m256 p = _mm256_set1_ps(1.0f / 720.0f);
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.0f / 120.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.0f / 24.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.0f / 6.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(0.5f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), one);
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), one);
+
+	__m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+
+	return _mm256_mul_ps(p, _mm256_castsi256_ps(scale));
+}
+
+
+/// <summary>
+/// Clamps values to [0, 1].
+/// </summary>
+/// <param name="x">values.</param>
+/// <returns>clamped values</returns>
+static inline AVX2_TARGET __m256 saturateSimd(__m256 x)
+{
+	return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+}
+
+
+/// <summary>
+/// Dot product of 8 vector pairs.
+/// </summary>
+static inline AVX2_TARGET __m256 dotSimd(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
+{
+	return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+}
+
+
+/// <summary>
+/// Shades 8 consecutive pixels of tile row by all lights of the tile.
+/// </summary>
+/// <param name="tile">planes and lights of the tile.</param>
+/// <param name="index">index of the first pixel.</param>
+static AVX2_TARGET void shadePixelsAvx2(const ShadingKernelTile &tile, unsigned int index)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	__m256 px = _mm256_loadu_ps(tile.position[0] + index);
+	__m256 py = _mm256_loadu_ps(tile.position[1] + index);
+	__m256 pz = _mm256_loadu_ps(tile.position[2] + index);
+	__m256 nx = _mm256_loadu_ps(tile.normal[0] + index);
+	__m256 ny = _mm256_loadu_ps(tile.normal[1] + index);
+	__m256 nz = _mm256_loadu_ps(tile.normal[2] + index);
+	__m256 shininess = _mm256_loadu_ps(tile.shininess + index);
+
+	__m256 diffuse[3], specular[3], color[3];
+
+	for (unsigned int c = 0; c < 3; c++)
+	{
+		diffuse[c] = _mm256_loadu_ps(tile.diffuse[c] + index);
+		specular[c] = _mm256_loadu_ps(tile.specular[c] + index);
+		color[c] = zero;
+	}
+
+	//background pixels stay black
+	__m256 background = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(nx, zero, _CMP_EQ_OQ), _mm256_cmp_ps(ny, zero, _CMP_EQ_OQ)), _mm256_cmp_ps(nz, zero, _CMP_EQ_OQ));
+
+	if (_mm256_movemask_ps(background) != 0xff)
+	{
+		//V = normalize(-position)
+		__m256 invLength = _mm256_div_ps(one, _mm256_sqrt_ps(dotSimd(px, py, pz, px, py, pz)));
+		__m256 vx = _mm256_mul_ps(_mm256_sub_ps(zero, px), invLength);
+		__m256 vy = _mm256_mul_ps(_mm256_sub_ps(zero, py), invLength);
+		__m256 vz = _mm256_mul_ps(_mm256_sub_ps(zero, pz), invLength);
+
+		__m256 specularNorm = _mm256_mul_ps(_mm256_add_ps(shininess, _mm256_set1_ps(2.0f)), _mm256_set1_ps(1.0f / 8.0f));
+
+		for (unsigned int i = 0; i < tile.lightCount; i++)
+		{
+			const ShadingKernelLight &light = tile.lights[tile.lightIDs[i]];
+
+			//light direction
+			__m256 lx = _mm256_sub_ps(_mm256_set1_ps(light.position[0]), px);
+			__m256 ly = _mm256_sub_ps(_mm256_set1_ps(light.position[1]), py);
+			__m256 lz = _mm256_sub_ps(_mm256_set1_ps(light.position[2]), pz);
+
+			__m256 dist2 = dotSimd(lx, ly, lz, lx, ly, lz);
+			__m256 radius2 = _mm256_set1_ps(light.radius * light.radius);
+
+			if (_mm256_movemask_ps(_mm256_cmp_ps(dist2, radius2, _CMP_LT_OQ)) == 0)
+			{
+				continue;
+			}
+
+			__m256 invDist = _mm256_div_ps(one, _mm256_sqrt_ps(dist2));
+			lx = _mm256_mul_ps(lx, invDist);
+			ly = _mm256_mul_ps(ly, invDist);
+			lz = _mm256_mul_ps(lz, invDist);
+
+			//halfway direction
+			__m256 hx = _mm256_add_ps(lx, vx);
+			__m256 hy = _mm256_add_ps(ly, vy);
+			__m256 hz = _mm256_add_ps(lz, vz);
+			__m256 invH = _mm256_div_ps(one, _mm256_sqrt_ps(dotSimd(hx, hy, hz, hx, hy, hz)));
+			hx = _mm256_mul_ps(hx, invH);
+			hy = _mm256_mul_ps(hy, invH);
+			hz = _mm256_mul_ps(hz, invH);
+
+			__m256 NdotL = saturateSimd(dotSimd(nx, ny, nz, lx, ly, lz));
+			__m256 NdotH = saturateSimd(dotSimd(nx, ny, nz, hx, hy, hz));
+			__m256 LdotH = saturateSimd(dotSimd(lx, ly, lz, hx, hy, hz));
+
+			__m256 attenuation = saturateSimd(_mm256_sub_ps(one, _mm256_div_ps(dist2, radius2)));
+			attenuation = _mm256_mul_ps(attenuation, attenuation);
+
+			//pow(1 - L.H, 5) of fresnel term
+			__m256 f = _mm256_sub_ps(one, LdotH);
+			__m256 f2 = _mm256_mul_ps(f, f);
+			__m256 f5 = _mm256_mul_ps(_mm256_mul_ps(f2, f2), f);
+
+			//pow(N.H, shininess), 0 for N.H = 0
+			__m256 highlight = exp2Simd(_mm256_mul_ps(shininess, log2Simd(NdotH)));
+			highlight = _mm256_and_ps(highlight, _mm256_cmp_ps(NdotH, zero, _CMP_GT_OQ));
+
+			__m256 specularTerm = _mm256_mul_ps(_mm256_mul_ps(specularNorm, highlight), NdotL);
+			__m256 lightTerm = _mm256_mul_ps(NdotL, attenuation);
+
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				__m256 fresnel = _mm256_add_ps(specular[c], _mm256_mul_ps(_mm256_sub_ps(one, specular[c]), f5));
+				__m256 reflected = _mm256_add_ps(diffuse[c], _mm256_mul_ps(fresnel, specularTerm));
+
+				color[c] = _mm256_add_ps(color[c], _mm256_mul_ps(_mm256_mul_ps(lightTerm, _mm256_set1_ps(light.color[c])), reflected));
+			}
+		}
+	}
+
+	for (unsigned int c = 0; c < 3; c++)
+	{
+		_mm256_storeu_ps(tile.color[c] + index, _mm256_andnot_ps(background, color[c]));
+	}
+}
+
+
+
+/// <summary>
+/// Shades pixels of tile row by groups of 8 pixels.
+/// </summary>
+/// <param name="tile">planes and lights of the tile.</param>
+/// <param name="index">index of the first pixel.</param>
+/// <param name="count">pixels of row.</param>
+/// <returns>number of shaded pixels, the rest has to be shaded by scalar path</returns>
+AVX2_TARGET unsigned int shadeRowAvx2(const ShadingKernelTile &tile, unsigned int index, unsigned int count)
+{
+	unsigned int shaded = 0;
+
+	for (; shaded + AVX2_WIDTH <= count; shaded += AVX2_WIDTH)
+	{
+		shadePixelsAvx2(tile, index + shaded);
+	}
+
+	return shaded;
+}
+
+
+/// <summary>
+/// Determines whether kernel was compiled in.
+/// </summary>
+/// <returns>true if shadeRowAvx2 shades pixels</returns>
+bool isAvx2ShadingCompiled()
+{
+	return true;
+}
+
+#else
+
+unsigned int shadeRowAvx2(const ShadingKernelTile &tile, unsigned int index, unsigned int count)
+{
+	return 0;
+}
+
+bool isAvx2ShadingCompiled()
+{
+	return false;
+}
+
+#endif // AVX2_KERNEL
@@ -158,6 +158,37 @@ void Camera::angleOrientation(float upAngle, float rightAngle)
 	normalizeAngles();
 }
 
+/// <summary>
+/// Returns horizontal angle of camera in degrees.
+/// </summary>
+/// <returns></returns>
+float Camera::horizontalAngle()
+{
+	return m_hAngle;
+}
+
+/// <summary>
+/// Returns vertical angle of camera in degrees.
+/// </summary>
+/// <returns></returns>
+float Camera::verticalAngle()
+{
+	return m_vAngle;
+}
+
+/// <summary>
+/// Sets camera orientation angles.
+/// </summary>
+/// <param name="hAngle">horizontal angle in degrees.</param>
+/// <param name="vAngle">vertical angle in degrees.</param>
+void Camera::setAngles(float hAngle, float vAngle)
+{
+	m_hAngle = hAngle;
+	m_vAngle = vAngle;
+
+	normalizeAngles();
+}
+
 /// <summary>
 /// Set camera direction to specific point.
 /// </summary>
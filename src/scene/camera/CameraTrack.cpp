@@ -0,0 +1,228 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements camera track. Keyframes are interpolated by Catmull-Rom
+spline with tangents scaled to neighbouring time intervals, so keyframes do
+not have to be recorded in regular intervals.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include "scene\camera\CameraTrack.h"
+
+//first line of track file
+#define CAMERA_TRACK_HEADER "# ECL camera track 1: time x y z hAngle vAngle"
+
+/// <summary>
+/// Evaluates cubic Hermite curve.
+/// </summary>
+/// <param name="p1">start value.</param>
+/// <param name="p2">end value.</param>
+/// <param name="m1">start tangent.</param>
+/// <param name="m2">end tangent.</param>
+/// <param name="s">parameter from range <0, 1>.</param>
+/// <returns>interpolated value</returns>
+template <typename T>
+static T hermite(const T &p1, const T &p2, const T &m1, const T &m2, float s)
+{
+	float s2 = s * s;
+	float s3 = s2 * s;
+
+	return p1 * (2.0f * s3 - 3.0f * s2 + 1.0f) + m1 * (s3 - 2.0f * s2 + s) + p2 * (-2.0f * s3 + 3.0f * s2) + m2 * (s3 - s2);
+}
+
+/// <summary>
+/// Returns angle shifted by full turns to be closest to reference angle.
+/// </summary>
+/// <param name="angle">angle in degrees.</param>
+/// <param name="reference">reference angle in degrees.</param>
+/// <returns>unwrapped angle</returns>
+static float unwrapAngle(float angle, float reference)
+{
+	return angle - 360.0f * floorf((angle - reference) / 360.0f + 0.5f);
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="CameraTrack"/> class.
+/// </summary>
+CameraTrack::CameraTrack()
+{
+}
+
+/// <summary>
+/// Removes all keyframes.
+/// </summary>
+void CameraTrack::clear()
+{
+	m_keyframes.clear();
+}
+
+/// <summary>
+/// Appends keyframe to track.
+/// </summary>
+/// <param name="keyframe">keyframe, its time must be greater than time of last keyframe.</param>
+/// <returns>false if keyframe time does not increase</returns>
+bool CameraTrack::addKeyframe(const CameraKeyframe &keyframe)
+{
+	if (!m_keyframes.empty() && keyframe.time <= m_keyframes.back().time)
+	{
+		return false;
+	}
+
+	m_keyframes.push_back(keyframe);
+
+	return true;
+}
+
+/// <summary>
+/// Returns camera state at given time, track is clamped to its first and last keyframe.
+/// </summary>
+/// <param name="time">seconds from track start.</param>
+/// <returns>interpolated keyframe</returns>
+CameraKeyframe CameraTrack::sample(float time) const
+{
+	if (m_keyframes.empty())
+	{
+		CameraKeyframe keyframe = { time, glm::vec3(0.0f), 0.0f, 0.0f };
+		return keyframe;
+	}
+
+	if (time <= m_keyframes.front().time)
+	{
+		return m_keyframes.front();
+	}
+
+	if (time >= m_keyframes.back().time)
+	{
+		return m_keyframes.back();
+	}
+
+	//segment k1-k2 containing time, end keyframes are duplicated
+	size_t i2 = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time,
+		[](float t, const CameraKeyframe &keyframe) { return t < keyframe.time; }) - m_keyframes.begin();
+	size_t i1 = i2 - 1;
+	size_t i0 = i1 > 0 ? i1 - 1 : i1;
+	size_t i3 = i2 + 1 < m_keyframes.size() ? i2 + 1 : i2;
+
+	const CameraKeyframe &k0 = m_keyframes[i0];
+	const CameraKeyframe &k1 = m_keyframes[i1];
+	const CameraKeyframe &k2 = m_keyframes[i2];
+	const CameraKeyframe &k3 = m_keyframes[i3];
+
+	float dt = k2.time - k1.time;
+	float s = (time - k1.time) / dt;
+
+	//tangents in units per segment
+	float scale1 = dt / (k2.time - k0.time);
+	float scale2 = dt / (k3.time - k1.time);
+
+	//horizontal angle takes shorter way around
+	float h1 = k1.hAngle;
+	float h0 = unwrapAngle(k0.hAngle, h1);
+	float h2 = unwrapAngle(k2.hAngle, h1);
+	float h3 = unwrapAngle(k3.hAngle, h2);
+
+	CameraKeyframe keyframe;
+	keyframe.time = time;
+	keyframe.position = hermite(k1.position, k2.position, (k2.position - k0.position) * scale1, (k3.position - k1.position) * scale2, s);
+	keyframe.hAngle = hermite(h1, h2, (h2 - h0) * scale1, (h3 - h1) * scale2, s);
+	keyframe.vAngle = hermite(k1.vAngle, k2.vAngle, (k2.vAngle - k0.vAngle) * scale1, (k3.vAngle - k1.vAngle) * scale2, s);
+
+	return keyframe;
+}
+
+/// <summary>
+/// Saves track to text file.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <returns>false if file could not be written</returns>
+bool CameraTrack::save(const std::string &filename) const
+{
+	std::ofstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file << CAMERA_TRACK_HEADER << "\n";
+	file.precision(9);
+
+	for (unsigned int i = 0; i < m_keyframes.size(); i++)
+	{
+		const CameraKeyframe &k = m_keyframes[i];
+
+		file << k.time << " " << k.position.x << " " << k.position.y << " " << k.position.z << " " << k.hAngle << " " << k.vAngle << "\n";
+	}
+
+	return file.good();
+}
+
+/// <summary>
+/// Loads track from text file, lines starting with '#' are skipped.
+/// </summary>
+/// <param name="filename">track file.</param>
+/// <returns>false if file could not be read or keyframes are invalid</returns>
+bool CameraTrack::load(const std::string &filename)
+{
+	std::ifstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::vector<CameraKeyframe> keyframes;
+	std::string line;
+
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#' || line[0] == '\r')
+		{
+			continue;
+		}
+
+		std::istringstream values(line);
+		CameraKeyframe k;
+
+		if (!(values >> k.time >> k.position.x >> k.position.y >> k.position.z >> k.hAngle >> k.vAngle))
+		{
+			return false;
+		}
+
+		if (!keyframes.empty() && k.time <= keyframes.back().time)
+		{
+			return false;
+		}
+
+		keyframes.push_back(k);
+	}
+
+	if (keyframes.empty())
+	{
+		return false;
+	}
+
+	m_keyframes.swap(keyframes);
+
+	return true;
+}
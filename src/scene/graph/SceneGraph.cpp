@@ -0,0 +1,189 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements lightweight scene graph. After transforms change,
+world matrices are resolved and per-instance model matrices are uploaded
+to instance buffers of referenced meshes.
+*/
+
+#include <map>
+#include "scene\graph\SceneGraph.h"
+#include "scene\objloader\Mesh.h"
+
+/// <summary>
+/// Initializes a new instance of the <see cref="SceneGraph"/> class.
+/// </summary>
+SceneGraph::SceneGraph() : m_dirty(false)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="SceneGraph"/> class.
+/// </summary>
+SceneGraph::~SceneGraph()
+{
+	clear();
+}
+
+/// <summary>
+/// Adds node to graph.
+/// </summary>
+/// <param name="mesh">referenced mesh, NULL = node only groups children.</param>
+/// <param name="transform">transform relative to parent.</param>
+/// <param name="parent">parent node, -1 = root.</param>
+/// <returns>node id, -1 if parent does not exist</returns>
+int SceneGraph::addNode(Mesh *mesh, const glm::mat4 &transform, int parent)
+{
+	if (parent >= (int)m_nodes.size())
+	{
+		return -1;
+	}
+
+	SceneNode node;
+	node.parent = parent;
+	node.mesh = mesh;
+	node.local = transform;
+	node.world = transform;
+
+	m_nodes.push_back(node);
+	m_dirty = true;
+
+	return (int)m_nodes.size() - 1;
+}
+
+/// <summary>
+/// Sets node transform relative to its parent.
+/// </summary>
+/// <param name="node">node id.</param>
+/// <param name="transform">transform.</param>
+void SceneGraph::setTransform(int node, const glm::mat4 &transform)
+{
+	m_nodes[node].local = transform;
+	m_dirty = true;
+}
+
+/// <summary>
+/// Removes all nodes, meshes are switched back to single identity instance.
+/// </summary>
+void SceneGraph::clear()
+{
+	releaseBatches();
+
+	m_nodes.clear();
+	m_dirty = false;
+}
+
+/// <summary>
+/// Returns total count of mesh instances.
+/// </summary>
+/// <returns>instances count</returns>
+unsigned int SceneGraph::getInstanceCount() const
+{
+	unsigned int count = 0;
+
+	for (unsigned int b = 0; b < m_batches.size(); b++)
+	{
+		count += (unsigned int)m_batches[b].transforms.size();
+	}
+
+	return count;
+}
+
+/// <summary>
+/// Resolves world transforms and regroups mesh instances. Nothing is done
+/// when graph has not changed since previous call. Must be called on GL thread.
+/// </summary>
+void SceneGraph::update()
+{
+	if (!m_dirty)
+	{
+		return;
+	}
+
+	std::map<Mesh*, unsigned int> batchIds;
+
+	for (unsigned int b = 0; b < m_batches.size(); b++)
+	{
+		m_batches[b].transforms.clear();
+		batchIds[m_batches[b].mesh] = b;
+	}
+
+	//parents precede children
+	for (unsigned int i = 0; i < m_nodes.size(); i++)
+	{
+		SceneNode &node = m_nodes[i];
+		node.world = node.parent >= 0 ? m_nodes[node.parent].world * node.local : node.local;
+
+		if (!node.mesh)
+		{
+			continue;
+		}
+
+		std::map<Mesh*, unsigned int>::iterator it = batchIds.find(node.mesh);
+
+		if (it == batchIds.end())
+		{
+			InstanceBatch batch;
+			batch.mesh = node.mesh;
+			glGenBuffers(1, &batch.buffer);
+
+			it = batchIds.insert(std::make_pair(node.mesh, (unsigned int)m_batches.size())).first;
+			m_batches.push_back(batch);
+		}
+
+		m_batches[it->second].transforms.push_back(node.world);
+	}
+
+	for (unsigned int b = 0; b < m_batches.size(); b++)
+	{
+		InstanceBatch &batch = m_batches[b];
+
+		//mesh no longer referenced gets back its own identity instance
+		if (batch.transforms.empty())
+		{
+			batch.mesh->setInstances(0, batch.transforms);
+			continue;
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+		glBufferData(GL_ARRAY_BUFFER, batch.transforms.size() * sizeof(glm::mat4), &batch.transforms[0], GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		batch.mesh->setInstances(batch.buffer, batch.transforms);
+	}
+
+	m_dirty = false;
+}
+
+/// <summary>
+/// Deletes instance buffers, referenced meshes get back own identity instance.
+/// </summary>
+void SceneGraph::releaseBatches()
+{
+	std::vector<glm::mat4> none;
+
+	for (unsigned int b = 0; b < m_batches.size(); b++)
+	{
+		m_batches[b].mesh->setInstances(0, none);
+		glDeleteBuffers(1, &m_batches[b].buffer);
+	}
+
+	m_batches.clear();
+}
@@ -20,23 +20,38 @@ File information
 -----------------
 This file implements Mesh class, which is used to load external scene models
 and their textures especially in .obj format. To achieve this Assimp library 
-has been used. This class also represents object renderer.
+has been used, .obj files can be parsed by faster parallel OBJ loader. This
+class also represents object renderer.
 */
 
 #include <assert.h>
+#include <algorithm>
+#include <ctype.h>
 #include "scene\objloader\Mesh.h"
+#include "scene\objloader\MeshSimplifier.h"
+#include "scene\objloader\ObjLoader.h"
+#include "utils\threading\ThreadPool.h"
+#include "utils\timers\PerformanceTimer.h"
+#include "utils\timers\ZoneProfiler.h"
+#include "utils\MemoryUsage.h"
 #include <stdio.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <random>
 
 #define SAFE_DELETE(p) if (p) { delete p; p = NULL; }
 
+//Assimp post-processing, OBJ loader produces the same output
+#define MESH_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_FlipUVs)
+
 
 /// <summary>
 /// Initializes a new instance of the <see cref="Mesh"/> class.
 /// </summary>
 Mesh::Mesh()
 {
+	instanceCount = 1;
 }
 
 /// <summary>
@@ -52,16 +67,14 @@ Mesh::~Mesh()
 /// </summary>
 void Mesh::Clear()
 {
-    for (unsigned int i = 0 ; i < diff_textures.size() ; i++)
-	{
-        SAFE_DELETE(diff_textures[i]);
-		SAFE_DELETE(bump_textures[i]);
-		SAFE_DELETE(spec_textures[i]);
-    }
+	//textures shared with other meshes stay alive
+	diff_textures.clear();
+	bump_textures.clear();
+	spec_textures.clear();
 
 	if (buffers[0] != 0)
 	{
-		glDeleteBuffers(6, buffers);
+		glDeleteBuffers(VBO_COUNT, buffers);
 	}
 
 	if (vao != 0)
@@ -69,16 +82,26 @@ void Mesh::Clear()
 		glDeleteVertexArrays(1, &vao);
 		vao = 0;
 	}
+
+	occluderVertices.clear();
+	occluderIndices.clear();
+	surfaceSamples.clear();
+
+	textureArrays.clear();
+	materialLayers.clear();
 }
 
 /// <summary>
 /// Loads the mesh from file.
 /// </summary>
 /// <param name="Filename">Model file.</param>
+/// <param name="loader">asynchronous texture loader, NULL = textures are loaded before return.</param>
+/// <param name="streamer">mipmap streamer of separate textures (not used with texture arrays).</param>
 /// <returns></returns>
-bool Mesh::LoadMesh(const std::string& Filename)
+bool Mesh::LoadMesh(const std::string& Filename, TextureLoader *loader, TextureStreamer *streamer)
 {
-    Assimp::Importer Importer;
+	PROFILE_FUNCTION();
+
     bool rc = false;
 
     //clear previous loaded mesh
@@ -89,130 +112,87 @@ bool Mesh::LoadMesh(const std::string& Filename)
 	glBindVertexArray(vao);
 
 	// Create the buffers for the vertices atttributes
-	glGenBuffers(6, buffers);
+	glGenBuffers(VBO_COUNT, buffers);
 
-    //read file content, set post-processing flags
-    const aiScene* oScene = Importer.ReadFile(Filename.c_str(),
-                                              aiProcess_Triangulate |
-                                              aiProcess_GenSmoothNormals |
-											  aiProcess_CalcTangentSpace |
-                                              aiProcess_FlipUVs);
-
-    if(oScene)
-	{
-		//prints control info
-       /* printf ("  %i animations\n", oScene->mNumAnimations);
-        printf ("  %i cameras\n", oScene->mNumCameras);
-        printf ("  %i lights\n", oScene->mNumLights);
-        printf ("  %i materials\n", oScene->mNumMaterials);
-        printf ("  %i meshes\n", oScene->mNumMeshes);
-        printf ("  %i textures\n", oScene->mNumTextures);
-		*/
-
-		//set array size based on mesh/texture counts
-        meshes.resize(oScene->mNumMeshes);
-        diff_textures.resize(oScene->mNumMaterials);
-		bump_textures.resize(oScene->mNumMaterials);
-		spec_textures.resize(oScene->mNumMaterials);
-		specularExponents.resize(oScene->mNumMaterials);
-
-		unsigned int numIndices = 0;
-		unsigned int numVertices = 0;
-
-		/*
-			All corresponding attributes are being stored in single VBO for all meshes:
-			VBO for indices
-			VBO for positions
-			VBO for texcoords
-			VBO for normals
-
-			so I need to save indices to VBO where are data for specific mesh:
-			baseVertex	- offset to position VBO
-			baseIndex	- offset to indices VBO
-			materialIndex	-	material corresponding to actual mesh
-			numIndices	- indices count
-		*/
-		for (unsigned int i = 0; i < meshes.size(); i++)
-		{
-			meshes[i].materialIndex = oScene->mMeshes[i]->mMaterialIndex;
-			meshes[i].numIndices = oScene->mMeshes[i]->mNumFaces * 3;
-			meshes[i].baseVertex = numVertices;
-			meshes[i].baseIndex = numIndices;
+	printf("Loading '%s'\n", Filename.c_str());
 
-			numVertices += oScene->mMeshes[i]->mNumVertices;
-			numIndices += meshes[i].numIndices;
-		}
+	//OBJ files are parsed by dedicated loader, other formats by Assimp
+	std::vector<MaterialData> materials;
+	bool imported;
 
-		printf("numindices: %d\n",numIndices);
+#if MESH_OBJ_LOADER
+	if (isObjFile(Filename))
+	{
+		imported = importObj(Filename, materials);
+	}
+	else
+#endif
+	{
+		imported = importAssimp(Filename, materials);
+	}
 
-		vp.reserve(numVertices);
-		vn.reserve(numVertices);
-		vt.reserve(numVertices);
-		vtn.reserve(numVertices);
-		vbtn.reserve(numVertices);
+    if(imported)
+	{
+		//import phases are timed and logged
+		PerformanceTimer timer;
+		timer.start();
 
-		vindices.reserve(numIndices);
+		ThreadPool &pool = ThreadPool::shared();
 
-		const aiVector3D Zero3D(0.0f, 0.0f, 0.0f);
+		//occluders depend on bounds
+		JobCounter boundsJobs;
 
 		for (unsigned int i = 0; i < meshes.size(); i++)
 		{
-            const aiMesh* mesh = oScene->mMeshes[i];
-
-			for (unsigned int j = 0; j < mesh->mNumVertices; j++)
+			pool.submit([this, i]()
 			{
-				if (mesh->HasPositions())
-				{
-					const aiVector3D* vpos = &(mesh->mVertices[j]);
+				computeBounds(i);
+			}, &boundsJobs, "Compute bounds");
+		}
 
-					vp.push_back(vpos->x);
-					vp.push_back(vpos->y);
-					vp.push_back(vpos->z);
-				}
+		pool.wait(boundsJobs);
 
-				if (mesh->HasNormals())
-				{
-					const aiVector3D* vnormal = &(mesh->mNormals[j]);
+		//simplified levels of detail are appended behind full resolution indices,
+		//they are generated by jobs while occluders are extracted and vertices uploaded,
+		//jobs are queued after bounds so waiting for bounds does not run them on main thread
+		std::vector<std::vector<unsigned int> > lodIndices(meshes.size() * (MESH_LOD_COUNT - 1));
+		JobCounter lodJobs;
 
-					vn.push_back(vnormal->x);
-					vn.push_back(vnormal->y);
-					vn.push_back(vnormal->z);
-				}
+		for (unsigned int i = 0; i < meshes.size(); i++)
+		{
+			pool.submit([this, i, &lodIndices]()
+			{
+				generateLods(i, meshes[i].numVertices, &lodIndices[i * (MESH_LOD_COUNT - 1)]);
+			}, &lodJobs, "Generate LODs");
+		}
 
-				if (mesh->HasTextureCoords(0))
-				{
-					const aiVector3D* vtexture = &(mesh->mTextureCoords[0][j]);
+		//large submeshes with few triangles (walls, floors, pillars) become occluders
+		for (unsigned int i = 0; i < meshes.size(); i++)
+		{
+			glm::vec3 extent = meshes[i].bounds.max - meshes[i].bounds.min;
+			float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
 
-					vt.push_back(vtexture->x);
-					vt.push_back(vtexture->y);
-				}
+			if (meshes[i].numVertices > 0 && maxExtent >= OCCLUDER_MIN_EXTENT && meshes[i].numIndices / 3 <= OCCLUDER_MAX_TRIANGLES)
+			{
+				unsigned int baseOccluderVertex = (unsigned int)occluderVertices.size();
 
-				if (mesh->HasTangentsAndBitangents())
+				for (unsigned int j = 0; j < meshes[i].numVertices; j++)
 				{
-					const aiVector3D* vtan = &(mesh->mTangents[j]);
-					const aiVector3D* vbitan = &(mesh->mBitangents[j]);
-
-					vtn.push_back(vtan->x);
-					vtn.push_back(vtan->y);
-					vtn.push_back(vtan->z);
-
-					vbtn.push_back(vbitan->x);
-					vbtn.push_back(vbitan->y);
-					vbtn.push_back(vbitan->z);
+					const float *position = &vp[(meshes[i].baseVertex + j) * 3];
+					occluderVertices.push_back(glm::vec3(position[0], position[1], position[2]));
 				}
-			}
-
-			for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-			{
-				const aiFace& Face = mesh->mFaces[i];
 
-				assert(Face.mNumIndices == 3);
+				for (unsigned int j = 0; j < meshes[i].numIndices; j++)
+				{
+					occluderIndices.push_back(baseOccluderVertex + vindices[meshes[i].baseIndex + j]);
+				}
 
-				vindices.push_back(Face.mIndices[0]);
-				vindices.push_back(Face.mIndices[1]);
-				vindices.push_back(Face.mIndices[2]);
+				meshes[i].occluder = true;
 			}
-        }
+		}
+
+		printf("  bounds + occluders: %.2f ms\n", timer.getElapsedTime() * 1000.0);
+		timer.restart();
 
 		//create vbo for positions
 		glBindBuffer(GL_ARRAY_BUFFER, buffers[POS_VBO]);
@@ -244,10 +224,41 @@ bool Mesh::LoadMesh(const std::string& Filename)
 		glEnableVertexAttribArray(4);
 		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, (GLubyte*)NULL);
 
+		printf("  vertex upload: %.2f ms\n", timer.getElapsedTime() * 1000.0);
+		timer.restart();
+
+		//main thread helps with remaining LOD jobs
+		pool.wait(lodJobs);
+
+		for (unsigned int i = 0; i < meshes.size(); i++)
+		{
+			for (unsigned int l = 1; l < meshes[i].lodCount; l++)
+			{
+				const std::vector<unsigned int> &lod = lodIndices[i * (MESH_LOD_COUNT - 1) + l - 1];
+
+				meshes[i].lods[l].baseIndex = (unsigned int)vindices.size();
+				vindices.insert(vindices.end(), lod.begin(), lod.end());
+			}
+		}
+
 		//create vbo for indices
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[INDICES_VBO]);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, vindices.size() * sizeof (unsigned int), &vindices[0], GL_STATIC_DRAW);
 
+		//single identity instance until scene graph provides instances
+		glm::mat4 identity;
+
+		glBindBuffer(GL_ARRAY_BUFFER, buffers[INSTANCE_VBO]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4), &identity, GL_STATIC_DRAW);
+		bindInstanceAttributes(buffers[INSTANCE_VBO]);
+
+		instanceCount = 1;
+
+		printf("  LODs + index upload: %.2f ms, %u indices\n", timer.getElapsedTime() * 1000.0, (unsigned int)vindices.size());
+		timer.restart();
+
+		sampleSurface(MESH_SURFACE_SAMPLES);
+
 		//clear memory
 		vp.clear();
 		vp.shrink_to_fit();
@@ -291,102 +302,638 @@ bool Mesh::LoadMesh(const std::string& Filename)
 		glBindTexture(GL_TEXTURE_2D, 0);
 
         /*.............Initialize the materials.............................*/
-        for(unsigned int i = 0 ; i < oScene->mNumMaterials ; i++)
+		diff_textures.resize(materials.size());
+		bump_textures.resize(materials.size());
+		spec_textures.resize(materials.size());
+		specularExponents.resize(materials.size());
+
+#if TEXTURE_ARRAYS
+		if (!loadMaterialArrays(materials, Dir, loader))
+		{
+			rc = false;
+		}
+#else
+		if (!loadMaterialTextures(materials, Dir, loader, streamer))
+		{
+			rc = false;
+		}
+#endif
+        /*.................Initialization of materials end....................*/
+
+		printf("  textures: %.2f ms\n", timer.getElapsedTime() * 1000.0);
+    }
+
+	glBindVertexArray(0);
+
+    return rc;
+}
+
+/// <summary>
+/// Determines whether file is Wavefront OBJ (by extension).
+/// </summary>
+/// <param name="Filename">model file.</param>
+/// <returns>TRUE for .obj files.</returns>
+bool Mesh::isObjFile(const std::string& Filename)
+{
+	std::string::size_type dot = Filename.find_last_of('.');
+
+	if (dot == std::string::npos)
+	{
+		return false;
+	}
+
+	std::string extension = Filename.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	return extension == "obj";
+}
+
+/// <summary>
+/// Imports submeshes and materials by Assimp.
+/// </summary>
+/// <param name="Filename">model file.</param>
+/// <param name="materials">output materials.</param>
+/// <returns>FALSE if file can not be imported.</returns>
+bool Mesh::importAssimp(const std::string& Filename, std::vector<MaterialData> &materials)
+{
+	PROFILE_FUNCTION();
+
+	Assimp::Importer Importer;
+
+	PerformanceTimer timer;
+	timer.start();
+
+    //read file content, set post-processing flags
+    const aiScene* oScene = Importer.ReadFile(Filename.c_str(), MESH_IMPORT_FLAGS);
+
+	if (!oScene)
+	{
+		printf("Error parsing '%s': '%s'\n", Filename.c_str(), Importer.GetErrorString());
+		return false;
+	}
+
+	printf("  import: %.2f ms\n", timer.getElapsedTime() * 1000.0);
+	timer.restart();
+
+	//set array size based on mesh count
+	meshes.resize(oScene->mNumMeshes);
+
+	unsigned int numIndices = 0;
+	unsigned int numVertices = 0;
+
+	/*
+		All corresponding attributes are being stored in single VBO for all meshes:
+		VBO for indices
+		VBO for positions
+		VBO for texcoords
+		VBO for normals
+
+		so I need to save indices to VBO where are data for specific mesh:
+		baseVertex	- offset to position VBO
+		baseIndex	- offset to indices VBO
+		materialIndex	-	material corresponding to actual mesh
+		numIndices	- indices count
+	*/
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		meshes[i].materialIndex = oScene->mMeshes[i]->mMaterialIndex;
+		meshes[i].numIndices = oScene->mMeshes[i]->mNumFaces * 3;
+		meshes[i].numVertices = oScene->mMeshes[i]->mNumVertices;
+		meshes[i].baseVertex = numVertices;
+		meshes[i].baseIndex = numIndices;
+
+		meshes[i].lods[0].baseIndex = meshes[i].baseIndex;
+		meshes[i].lods[0].numIndices = meshes[i].numIndices;
+		meshes[i].lods[0].error = 0.0f;
+
+		numVertices += meshes[i].numVertices;
+		numIndices += meshes[i].numIndices;
+	}
+
+	printf("numindices: %d\n",numIndices);
+
+	//every submesh owns exact range of attribute arrays given by baseVertex / baseIndex,
+	//so submeshes are extracted in parallel, missing attributes stay zero
+	vp.resize(numVertices * 3);
+	vn.resize(numVertices * 3);
+	vt.resize(numVertices * 2);
+	vtn.resize(numVertices * 3);
+	vbtn.resize(numVertices * 3);
+
+	vindices.resize(numIndices);
+
+	ThreadPool::shared().parallelFor((unsigned int)meshes.size(), 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
 		{
-			const aiMaterial* pMaterial = oScene->mMaterials[i];
-            
-			diff_textures[i] = NULL;
-			bump_textures[i] = NULL;
-			spec_textures[i] = NULL;
+			extractAttributes(i, oScene->mMeshes[i]);
+		}
+	});
+
+	readMaterials(oScene, materials);
+
+	printf("  attributes: %.2f ms\n", timer.getElapsedTime() * 1000.0);
+
+	return true;
+}
+
+/// <summary>
+/// Imports submeshes and materials of OBJ file by parallel OBJ loader. Loader
+/// output has the same layout as CPU arrays, so it is taken over without copy.
+/// </summary>
+/// <param name="Filename">model file.</param>
+/// <param name="materials">output materials.</param>
+/// <returns>FALSE if file can not be read.</returns>
+bool Mesh::importObj(const std::string& Filename, std::vector<MaterialData> &materials)
+{
+	PROFILE_FUNCTION();
+
+	PerformanceTimer timer;
+	timer.start();
+
+	ObjLoader objLoader(ThreadPool::shared());
+	MeshData data;
+
+	if (!objLoader.load(Filename, data))
+	{
+		return false;
+	}
 
+	vp.swap(data.positions);
+	vt.swap(data.texcoords);
+	vn.swap(data.normals);
+	vtn.swap(data.tangents);
+	vbtn.swap(data.bitangents);
+	vindices.swap(data.indices);
+	materials.swap(data.materials);
+
+	meshes.resize(data.submeshes.size());
+
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		const SubmeshData &submesh = data.submeshes[i];
+
+		meshes[i].materialIndex = submesh.materialIndex;
+		meshes[i].numIndices = submesh.numIndices;
+		meshes[i].numVertices = submesh.numVertices;
+		meshes[i].baseVertex = submesh.baseVertex;
+		meshes[i].baseIndex = submesh.baseIndex;
+
+		meshes[i].lods[0].baseIndex = meshes[i].baseIndex;
+		meshes[i].lods[0].numIndices = meshes[i].numIndices;
+		meshes[i].lods[0].error = 0.0f;
+	}
+
+	printf("numindices: %d\n", (unsigned int)vindices.size());
+	printf("  import (obj): %.2f ms\n", timer.getElapsedTime() * 1000.0);
+
+	return true;
+}
+
+/// <summary>
+/// Reads texture paths and diffuse color of imported materials.
+/// </summary>
+/// <param name="oScene">imported scene.</param>
+/// <param name="materials">output materials, indexed as scene materials.</param>
+void Mesh::readMaterials(const aiScene *oScene, std::vector<MaterialData> &materials)
+{
+	materials.resize(oScene->mNumMaterials);
+
+	for (unsigned int i = 0; i < oScene->mNumMaterials; i++)
+	{
+		const aiMaterial* pMaterial = oScene->mMaterials[i];
+
+		const aiTextureType types[3] = { aiTextureType_DIFFUSE, aiTextureType_HEIGHT, aiTextureType_SPECULAR };
+		std::string *paths[3] = { &materials[i].diffuseMap, &materials[i].normalMap, &materials[i].specularMap };
+
+		for (unsigned int t = 0; t < 3; t++)
+		{
 			aiString Path;
 
-            if (pMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
-
-                if (pMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &Path, NULL, NULL, NULL, NULL, NULL) == AI_SUCCESS) {
-                    std::string FullPath = Dir + "/" + Path.data;
-                    diff_textures[i] = new Texture(GL_TEXTURE_2D, FullPath.c_str());
-
-					aiColor3D color(0.f, 0.f, 0.f);
-					pMaterial->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-					
-					Kds = glm::vec3(color.r, color.g, color.b);
-
-					specularExponents[i] = 10;
-
-
-                    if (!diff_textures[i]->Load(true)) {
-                        printf("Error loading diff. texture '%s'\n", FullPath.c_str());
-                        delete diff_textures[i];
-                        diff_textures[i] = NULL;
-                        rc = false;
-                    }
-                    else {
-                        printf("Loaded diff. texture '%s'\n",FullPath.c_str());
-                    }
-                }
-            }
-
-			if (pMaterial->GetTextureCount(aiTextureType_SPECULAR) > 0) {
-
-				if (pMaterial->GetTexture(aiTextureType_SPECULAR, 0, &Path, NULL, NULL, NULL, NULL, NULL) == AI_SUCCESS) {
-					std::string FullPath = Dir + "/" + Path.data;
-					spec_textures[i] = new Texture(GL_TEXTURE_2D, FullPath.c_str());
-
-					if (!spec_textures[i]->Load(true)) {
-						printf("Error loading spec. texture '%s'\n", FullPath.c_str());
-						delete spec_textures[i];
-						spec_textures[i] = NULL;
-						rc = false;
-					}
-					else {
-						printf("Loaded spec. texture '%s'\n",FullPath.c_str());
-					}
-				}
+			if (pMaterial->GetTextureCount(types[t]) > 0 &&
+				pMaterial->GetTexture(types[t], 0, &Path, NULL, NULL, NULL, NULL, NULL) == AI_SUCCESS)
+			{
+				*paths[t] = Path.data;
 			}
+		}
+
+		aiColor3D color(0.f, 0.f, 0.f);
+		pMaterial->Get(AI_MATKEY_COLOR_DIFFUSE, color);
 
-			if (pMaterial->GetTextureCount(aiTextureType_HEIGHT) > 0) {
-
-				if (pMaterial->GetTexture(aiTextureType_HEIGHT, 0, &Path, NULL, NULL, NULL, NULL, NULL) == AI_SUCCESS) {
-					std::string FullPath = Dir + "/" + Path.data;
-					bump_textures[i] = new Texture(GL_TEXTURE_2D, FullPath.c_str());
-
-					if (!bump_textures[i]->Load(false)) {
-						printf("Error loading normal texture '%s'\n", FullPath.c_str());
-						delete bump_textures[i];
-						bump_textures[i] = NULL;
-						rc = false;
-					}
-					else {
-						printf("Loaded normal texture '%s'\n",FullPath.c_str());
-					}
+		materials[i].diffuseColor = glm::vec3(color.r, color.g, color.b);
+	}
+}
+
+/// <summary>
+/// Compares load time and peak memory of Assimp import and OBJ loader. Only
+/// CPU side import is measured, no GL context is needed. Peak memory is reported
+/// only if peak can be reset before every run (not on Windows), otherwise it would
+/// include peak of earlier runs.
+/// </summary>
+/// <param name="Filename">OBJ file.</param>
+/// <param name="runs">timed runs of every importer.</param>
+void Mesh::benchmarkImport(const std::string& Filename, unsigned int runs)
+{
+	printf("Import benchmark '%s', %u runs\n", Filename.c_str(), runs);
+
+	for (unsigned int importer = 0; importer < 2; importer++)
+	{
+		double total = 0.0, best = 0.0;
+		size_t peak = 0;
+		unsigned int triangles = 0;
+		bool ok = true;
+		bool peakValid = true;
+
+		for (unsigned int r = 0; r < runs && ok; r++)
+		{
+			peakValid = MemoryUsage::resetPeak() && peakValid;
+			size_t before = MemoryUsage::getCurrent();
+
+			PerformanceTimer timer;
+			timer.start();
+
+			if (importer == 0)
+			{
+				ObjLoader objLoader(ThreadPool::shared());
+				MeshData data;
+
+				ok = objLoader.load(Filename, data);
+				triangles = (unsigned int)data.indices.size() / 3;
+			}
+			else
+			{
+				Assimp::Importer Importer;
+				const aiScene* oScene = Importer.ReadFile(Filename.c_str(), MESH_IMPORT_FLAGS);
+
+				ok = oScene != NULL;
+				triangles = 0;
+
+				for (unsigned int i = 0; ok && i < oScene->mNumMeshes; i++)
+				{
+					triangles += oScene->mMeshes[i]->mNumFaces;
 				}
 			}
-        }
-        /*.................Initialization of materials end....................*/
-    }
-    else {
-        printf("Error parsing '%s': '%s'\n", Filename.c_str(), Importer.GetErrorString());
-    }
 
+			double elapsed = timer.getElapsedTime() * 1000.0;
+			size_t used = MemoryUsage::getPeak();
+
+			peak = std::max(peak, used > before ? used - before : 0);
+
+			total += elapsed;
+			best = r == 0 ? elapsed : std::min(best, elapsed);
+		}
+
+		if (!ok)
+		{
+			printf("  %s: failed\n", importer == 0 ? "obj loader" : "assimp");
+			continue;
+		}
+
+		printf("  %s: avg %.2f ms, best %.2f ms, ", importer == 0 ? "obj loader" : "assimp", total / runs, best);
+
+		if (peakValid)
+			printf("peak +%.1f MB", peak / (1024.0 * 1024.0));
+		else
+			printf("peak n/a");
+
+		printf(", %u triangles\n", triangles);
+	}
+}
+
+/// <summary>
+/// Computes bounding volumes of submesh from its positions. Submeshes do not
+/// share any output, so this is called concurrently for different submeshes.
+/// </summary>
+/// <param name="i">submesh index.</param>
+void Mesh::computeBounds(unsigned int i)
+{
+	MeshEntry &entry = meshes[i];
+	const float *positions = vp.data() + entry.baseVertex * 3;
+
+	for (unsigned int j = 0; j < entry.numVertices; j++)
+	{
+		expandAABB(entry.bounds, glm::vec3(positions[j * 3], positions[j * 3 + 1], positions[j * 3 + 2]));
+	}
+
+	//bounding sphere is derived from box, empty submeshes get zero volume at origin
+	if (!isValidAABB(entry.bounds))
+	{
+		entry.bounds.min = entry.bounds.max = glm::vec3(0.0f);
+	}
+
+	entry.sphere = sphereFromAABB(entry.bounds);
+
+	entry.instanceBounds = entry.bounds;
+	entry.instanceSphere = entry.sphere;
+}
+
+/// <summary>
+/// Picks points uniformly distributed over area of full resolution triangles.
+/// Fixed seed is used, so the same mesh always gives the same samples.
+/// </summary>
+/// <param name="count">samples count.</param>
+void Mesh::sampleSurface(unsigned int count)
+{
+	surfaceSamples.clear();
+
+	//cumulative area of all triangles
+	std::vector<unsigned int> triangles;
+	std::vector<double> areas;
+	double total = 0.0;
+
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		for (unsigned int j = 0; j + 2 < meshes[i].numIndices; j += 3)
+		{
+			const unsigned int *triangle = &vindices[meshes[i].baseIndex + j];
+			glm::vec3 p[3];
+
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				p[k] = glm::make_vec3(&vp[(meshes[i].baseVertex + triangle[k]) * 3]);
+			}
+
+			total += 0.5 * glm::length(glm::cross(p[1] - p[0], p[2] - p[0]));
+
+			triangles.push_back(meshes[i].baseIndex + j);
+			triangles.push_back(meshes[i].baseVertex);
+			areas.push_back(total);
+		}
+	}
+
+	if (total <= 0.0)
+	{
+		return;
+	}
+
+	std::mt19937 random(MESH_SURFACE_SEED);
+	surfaceSamples.resize(count);
+
+	for (unsigned int s = 0; s < count; s++)
+	{
+		double target = random() / 4294967296.0 * total;
+		unsigned int t = (unsigned int)(std::upper_bound(areas.begin(), areas.end(), target) - areas.begin());
+		t = std::min(t, (unsigned int)areas.size() - 1);
+
+		const unsigned int *triangle = &vindices[triangles[t * 2]];
+		unsigned int baseVertex = triangles[t * 2 + 1];
+
+		//uniform barycentric coordinates
+		float u = random() / 4294967296.0f, v = random() / 4294967296.0f;
+
+		if (u + v > 1.0f)
+		{
+			u = 1.0f - u;
+			v = 1.0f - v;
+		}
+
+		float weights[3] = { 1.0f - u - v, u, v };
+		SurfaceSample &sample = surfaceSamples[s];
+
+		sample.position = glm::vec3(0.0f);
+		sample.normal = glm::vec3(0.0f);
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			sample.position += glm::make_vec3(&vp[(baseVertex + triangle[k]) * 3]) * weights[k];
+			sample.normal += glm::make_vec3(&vn[(baseVertex + triangle[k]) * 3]) * weights[k];
+		}
+
+		float length = glm::length(sample.normal);
+		sample.normal = length > 0.0f ? sample.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+}
+
+/// <summary>
+/// Copies vertex attributes and indices of single submesh to its preallocated
+/// ranges of CPU arrays. Submeshes do not share any output, so this is called concurrently for different submeshes.
+/// </summary>
+/// <param name="i">submesh index.</param>
+/// <param name="mesh">imported mesh.</param>
+void Mesh::extractAttributes(unsigned int i, const aiMesh *mesh)
+{
+	MeshEntry &entry = meshes[i];
+
+	float *positions = vp.data() + entry.baseVertex * 3;
+	float *normals = vn.data() + entry.baseVertex * 3;
+	float *texcoords = vt.data() + entry.baseVertex * 2;
+	float *tangents = vtn.data() + entry.baseVertex * 3;
+	float *bitangents = vbtn.data() + entry.baseVertex * 3;
+
+	for (unsigned int j = 0; j < mesh->mNumVertices; j++)
+	{
+		if (mesh->HasPositions())
+		{
+			const aiVector3D* vpos = &(mesh->mVertices[j]);
+
+			positions[j * 3] = vpos->x;
+			positions[j * 3 + 1] = vpos->y;
+			positions[j * 3 + 2] = vpos->z;
+		}
+
+		if (mesh->HasNormals())
+		{
+			const aiVector3D* vnormal = &(mesh->mNormals[j]);
+
+			normals[j * 3] = vnormal->x;
+			normals[j * 3 + 1] = vnormal->y;
+			normals[j * 3 + 2] = vnormal->z;
+		}
+
+		if (mesh->HasTextureCoords(0))
+		{
+			const aiVector3D* vtexture = &(mesh->mTextureCoords[0][j]);
+
+			texcoords[j * 2] = vtexture->x;
+			texcoords[j * 2 + 1] = vtexture->y;
+		}
+
+		if (mesh->HasTangentsAndBitangents())
+		{
+			const aiVector3D* vtan = &(mesh->mTangents[j]);
+			const aiVector3D* vbitan = &(mesh->mBitangents[j]);
+
+			tangents[j * 3] = vtan->x;
+			tangents[j * 3 + 1] = vtan->y;
+			tangents[j * 3 + 2] = vtan->z;
+
+			bitangents[j * 3] = vbitan->x;
+			bitangents[j * 3 + 1] = vbitan->y;
+			bitangents[j * 3 + 2] = vbitan->z;
+		}
+	}
+
+	unsigned int *indices = vindices.data() + entry.baseIndex;
+
+	for (unsigned int f = 0; f < mesh->mNumFaces; f++)
+	{
+		const aiFace& Face = mesh->mFaces[f];
+
+		assert(Face.mNumIndices == 3);
+
+		indices[f * 3] = Face.mIndices[0];
+		indices[f * 3 + 1] = Face.mIndices[1];
+		indices[f * 3 + 2] = Face.mIndices[2];
+	}
+}
+
+/// <summary>
+/// Finishes asynchronously loaded textures (mipmaps of completed texture arrays).
+/// Call once per frame on GL thread.
+/// </summary>
+void Mesh::updateTextures()
+{
+#if TEXTURE_ARRAYS
+	textureArrays.update();
+#endif
+}
+
+/// <summary>
+/// Requests mipmap levels of material textures of drawn submeshes, detail is
+/// derived from screen size of submesh bounding sphere.
+/// </summary>
+/// <param name="viewPosition">camera position.</param>
+/// <param name="projectionScale">viewport height / (2 * tan(fovy / 2)).</param>
+/// <param name="streamer">mipmap streamer textures were loaded with.</param>
+/// <param name="drawList">drawn submeshes, NULL = all.</param>
+void Mesh::streamTextures(const glm::vec3 &viewPosition, float projectionScale, TextureStreamer &streamer, const std::vector<unsigned int> *drawList)
+{
+#if !TEXTURE_ARRAYS
+	unsigned int drawCount = drawList ? (unsigned int)drawList->size() : (unsigned int)meshes.size();
+
+	for (unsigned int d = 0; d < drawCount; d++)
+	{
+		const MeshEntry &entry = meshes[drawList ? (*drawList)[d] : d];
+		unsigned int material = entry.materialIndex;
+
+		if (material >= diff_textures.size())
+		{
+			continue;
+		}
+
+		//size of single instance at distance of the nearest one
+		float distance = std::max(glm::length(entry.instanceSphere.center - viewPosition) - entry.instanceSphere.radius, 1e-3f);
+		float pixels = 2.0f * entry.sphere.radius * projectionScale / distance;
+
+		const TextureHandle *textures[3] = { &diff_textures[material], &bump_textures[material], &spec_textures[material] };
+
+		for (unsigned int t = 0; t < 3; t++)
+		{
+			if (*textures[t])
+			{
+				streamer.request(textures[t]->get(), pixels);
+			}
+		}
+	}
+#endif
+}
+
+/// <summary>
+/// Returns bounding boxes of all submeshes.
+/// </summary>
+/// <param name="bounds">output vector of boxes, indexed by submesh.</param>
+void Mesh::getBounds(std::vector<AABB> &bounds) const
+{
+	bounds.resize(meshes.size());
+
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		bounds[i] = meshes[i].instanceBounds;
+	}
+}
+
+/// <summary>
+/// Sets per-instance model matrices used by all draws. Submesh bounds used for
+/// culling, LOD selection and texture streaming then enclose all instances.
+/// </summary>
+/// <param name="buffer">buffer with transforms (one mat4 per instance), 0 = own single identity instance.</param>
+/// <param name="transforms">instance transforms (content of buffer).</param>
+void Mesh::setInstances(GLuint buffer, const std::vector<glm::mat4> &transforms)
+{
+	glBindVertexArray(vao);
+	bindInstanceAttributes(buffer ? buffer : buffers[INSTANCE_VBO]);
 	glBindVertexArray(0);
 
-    return rc;
+	instanceCount = buffer ? (unsigned int)transforms.size() : 1;
+
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		MeshEntry &entry = meshes[i];
+
+		if (!buffer)
+		{
+			entry.instanceBounds = entry.bounds;
+		}
+		else
+		{
+			entry.instanceBounds = emptyAABB();
+
+			for (unsigned int t = 0; t < transforms.size(); t++)
+			{
+				expandAABB(entry.instanceBounds, transformAABB(entry.bounds, transforms[t]));
+			}
+
+			if (!isValidAABB(entry.instanceBounds))
+			{
+				entry.instanceBounds = entry.bounds;
+			}
+		}
+
+		entry.instanceSphere = sphereFromAABB(entry.instanceBounds);
+	}
+}
+
+/// <summary>
+/// Sets instance matrix attributes of bound VAO to given buffer.
+/// </summary>
+/// <param name="buffer">instance transforms buffer.</param>
+void Mesh::bindInstanceAttributes(GLuint buffer)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	//matrix is passed as four column attributes advancing once per instance
+	for (unsigned int c = 0; c < 4; c++)
+	{
+		glEnableVertexAttribArray(INSTANCE_ATTRIBUTE + c);
+		glVertexAttribPointer(INSTANCE_ATTRIBUTE + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLubyte*)NULL + sizeof(glm::vec4) * c);
+		glVertexAttribDivisor(INSTANCE_ATTRIBUTE + c, 1);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 /// <summary>
 /// Renders the simple scene with no lighting.
 /// </summary>
-void Mesh::RenderSimple(){
+/// <param name="drawList">indices of submeshes to render, NULL renders all.</param>
+void Mesh::RenderSimple(const std::vector<unsigned int> *drawList){
 
 	//enable VAO
 	glBindVertexArray(vao);
 
-	for (unsigned int i = 0; i < meshes.size(); i++)
+#if TEXTURE_ARRAYS
+	//shader is not passed here, diffuse layer is set in currently used program
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+	GLint layerLocation = program ? glGetUniformLocation(program, "diffLayer") : -1;
+	GLuint boundArray = 0;
+#endif
+
+	unsigned int drawCount = drawList ? (unsigned int)drawList->size() : (unsigned int)meshes.size();
+
+	for (unsigned int d = 0; d < drawCount; d++)
 	{
+		const unsigned int i = drawList ? (*drawList)[d] : d;
 		const unsigned int MaterialIndex = meshes[i].materialIndex;
 
-		if (MaterialIndex < diff_textures.size() && diff_textures[MaterialIndex])
+#if TEXTURE_ARRAYS
+		if (MaterialIndex < materialLayers.size())
+		{
+			bindMaterialLayers(MaterialIndex, &layerLocation, &boundArray, 1);
+		}
+#else
+		if (MaterialIndex < diff_textures.size() && diff_textures[MaterialIndex] && diff_textures[MaterialIndex]->isResident())
 		{
 				diff_textures[MaterialIndex]->Bind(GL_TEXTURE0);
 		}
@@ -395,9 +942,12 @@ void Mesh::RenderSimple(){
 			glActiveTexture(GL_TEXTURE0);
 			glBindTexture(GL_TEXTURE_2D, defaultTextureOne);
 		}
+#endif
+
+		const MeshEntry::LodLevel &lod = meshes[i].lods[meshes[i].currentLod];
 
-		glDrawElementsBaseVertex(GL_TRIANGLES, meshes[i].numIndices, GL_UNSIGNED_INT,
-			(void*)(sizeof(unsigned int)* meshes[i].baseIndex), meshes[i].baseVertex);
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.numIndices, GL_UNSIGNED_INT,
+			(void*)(sizeof(unsigned int)* lod.baseIndex), instanceCount, meshes[i].baseVertex);
 	}
 
 	glBindVertexArray(0);
@@ -407,7 +957,8 @@ void Mesh::RenderSimple(){
 /// Renders the scene.
 /// </summary>
 /// <param name="shader">references shader ID to access shader uniforms.</param>
-void Mesh::Render(GLuint shader)
+/// <param name="drawList">indices of submeshes to render, NULL renders all.</param>
+void Mesh::Render(GLuint shader, const std::vector<unsigned int> *drawList)
 {
 	GLuint specularExponent_loc;
 
@@ -419,15 +970,43 @@ void Mesh::Render(GLuint shader)
 		specularExponent_loc = glGetUniformLocation(shader, "specExponent");
 		
 	}
-		
-    for(unsigned int i = 0 ; i < meshes.size() ; i++)
+
+#if TEXTURE_ARRAYS
+	//arrays stay bound while consecutive draws use them, only layers change per draw
+	GLint layerLocations[3] = { -1, -1, -1 };
+	GLuint boundArrays[3] = { 0, 0, 0 };
+
+	if (shader)
 	{
+		layerLocations[0] = glGetUniformLocation(shader, "diffLayer");
+		layerLocations[1] = glGetUniformLocation(shader, "normalLayer");
+		layerLocations[2] = glGetUniformLocation(shader, "specLayer");
 
+		glUniform3f(glGetUniformLocation(shader, "Kd"), Kds.r, Kds.g, Kds.b);
+	}
+#endif
+		
+	unsigned int drawCount = drawList ? (unsigned int)drawList->size() : (unsigned int)meshes.size();
+
+    for(unsigned int d = 0 ; d < drawCount ; d++)
+	{
+		const unsigned int i = drawList ? (*drawList)[d] : d;
         const unsigned int MaterialIndex = meshes[i].materialIndex;
 
+#if TEXTURE_ARRAYS
+		if (MaterialIndex < materialLayers.size() && materialLayers[MaterialIndex].textured)
+		{
+			bindMaterialLayers(MaterialIndex, layerLocations, boundArrays, 3);
+
+			if (shader)
+			{
+				glUniform1f(specularExponent_loc, specularExponents[MaterialIndex]);
+			}
+		}
+#else
         if (MaterialIndex < diff_textures.size() && diff_textures[MaterialIndex])
 		{
-			if (diff_textures[MaterialIndex] != NULL){
+			if (diff_textures[MaterialIndex]->isResident()){
 				diff_textures[MaterialIndex]->Bind(GL_TEXTURE0);
 
 				if (shader)
@@ -441,7 +1020,7 @@ void Mesh::Render(GLuint shader)
 				glBindTexture(GL_TEXTURE_2D, defaultTextureOne);
 			}
 
-			if (bump_textures[MaterialIndex] != NULL){
+			if (bump_textures[MaterialIndex] != NULL && bump_textures[MaterialIndex]->isResident()){
 				bump_textures[MaterialIndex]->Bind(GL_TEXTURE1);
 			}
 			else {
@@ -449,7 +1028,7 @@ void Mesh::Render(GLuint shader)
 				glBindTexture(GL_TEXTURE_2D, defaultNormalTexture);
 			}
 
-			if (spec_textures[MaterialIndex] != NULL){
+			if (spec_textures[MaterialIndex] != NULL && spec_textures[MaterialIndex]->isResident()){
 				spec_textures[MaterialIndex]->Bind(GL_TEXTURE2);
 				
 			}
@@ -463,10 +1042,331 @@ void Mesh::Render(GLuint shader)
 				glUniform1f(specularExponent_loc, specularExponents[MaterialIndex]);
 			}
         }
+#endif
 
-		glDrawElementsBaseVertex(GL_TRIANGLES, meshes[i].numIndices,GL_UNSIGNED_INT,
-			(void*)(sizeof(unsigned int)* meshes[i].baseIndex), meshes[i].baseVertex);
+		const MeshEntry::LodLevel &lod = meshes[i].lods[meshes[i].currentLod];
+
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.numIndices, GL_UNSIGNED_INT,
+			(void*)(sizeof(unsigned int)* lod.baseIndex), instanceCount, meshes[i].baseVertex);
     }
 
 	glBindVertexArray(0);
 }
+
+/// <summary>
+/// Generates simplified levels of detail of submesh. Every level targets half
+/// of triangles of previous one, generation stops when simplification stalls.
+/// </summary>
+/// <param name="i">submesh index.</param>
+/// <param name="vertexCount">submesh vertex count.</param>
+/// <param name="lodIndices">output index lists for levels 1 .. MESH_LOD_COUNT - 1.</param>
+void Mesh::generateLods(unsigned int i, unsigned int vertexCount, std::vector<unsigned int> *lodIndices)
+{
+	MeshEntry &entry = meshes[i];
+
+	if (entry.numIndices / 3 < MESH_LOD_MIN_TRIANGLES || vertexCount == 0)
+	{
+		return;
+	}
+
+	MeshSimplifier simplifier(&vp[entry.baseVertex * 3], vertexCount, &vindices[entry.baseIndex], entry.numIndices);
+
+	for (unsigned int l = 1; l < MESH_LOD_COUNT; l++)
+	{
+		unsigned int target = (entry.lods[l - 1].numIndices / 6) * 3;
+		float error;
+
+		simplifier.simplify(target, lodIndices[l - 1], error);
+
+		//level which removes less than fifth of triangles is not worth it
+		if (lodIndices[l - 1].empty() || lodIndices[l - 1].size() * 5 > entry.lods[l - 1].numIndices * 4)
+		{
+			lodIndices[l - 1].clear();
+			break;
+		}
+
+		entry.lods[l].numIndices = (unsigned int)lodIndices[l - 1].size();
+		entry.lods[l].error = error;
+		entry.lodCount = l + 1;
+	}
+}
+
+/// <summary>
+/// Selects level of detail of every drawn submesh. The coarsest level whose
+/// geometric error projected to the nearest point of bounding sphere (enclosing
+/// all instances) stays under pixel threshold is chosen. Levels used by
+/// rendering are not changed (applyLods), so it may run on other thread than Render().
+/// </summary>
+/// <param name="viewPosition">camera position.</param>
+/// <param name="projectionScale">pixels per unit at distance 1 (resolution.y / (2 * tan(fovy / 2))).</param>
+/// <param name="pixelError">allowed screen space error in pixels.</param>
+/// <param name="pinnedLod">-1 = select by error, otherwise level used for all submeshes (clamped).</param>
+/// <param name="drawList">submeshes to process, NULL = all.</param>
+/// <param name="levels">output level of every processed submesh (in order of draw list).</param>
+/// <returns>triangles count of selected levels</returns>
+unsigned int Mesh::computeLods(const glm::vec3 &viewPosition, float projectionScale, float pixelError, int pinnedLod, const std::vector<unsigned int> *drawList, std::vector<unsigned int> &levels) const
+{
+	unsigned int triangles = 0;
+	unsigned int drawCount = drawList ? (unsigned int)drawList->size() : (unsigned int)meshes.size();
+
+	levels.resize(drawCount);
+
+	for (unsigned int d = 0; d < drawCount; d++)
+	{
+		const MeshEntry &entry = meshes[drawList ? (*drawList)[d] : d];
+		unsigned int level = 0;
+
+		if (pinnedLod >= 0)
+		{
+			level = std::min((unsigned int)pinnedLod, entry.lodCount - 1);
+		}
+		else
+		{
+			float distance = std::max(glm::length(entry.instanceSphere.center - viewPosition) - entry.instanceSphere.radius, 1e-3f);
+
+			for (unsigned int l = entry.lodCount - 1; l > 0; l--)
+			{
+				if (entry.lods[l].error * projectionScale / distance <= pixelError)
+				{
+					level = l;
+					break;
+				}
+			}
+		}
+
+		levels[d] = level;
+		triangles += entry.lods[level].numIndices / 3 * instanceCount;
+	}
+
+	return triangles;
+}
+
+/// <summary>
+/// Sets levels of detail used by Render() and RenderSimple().
+/// </summary>
+/// <param name="levels">level of every submesh of draw list (computeLods).</param>
+/// <param name="drawList">submeshes to set, NULL = all.</param>
+void Mesh::applyLods(const std::vector<unsigned int> &levels, const std::vector<unsigned int> *drawList)
+{
+	for (unsigned int d = 0; d < levels.size(); d++)
+	{
+		MeshEntry &entry = meshes[drawList ? (*drawList)[d] : d];
+		entry.currentLod = std::min(levels[d], entry.lodCount - 1);
+	}
+}
+
+/// <summary>
+/// Loads separate material textures through shared texture registry.
+/// </summary>
+/// <param name="materials">imported materials.</param>
+/// <param name="Dir">model directory.</param>
+/// <param name="loader">asynchronous texture loader, NULL = synchronous upload.</param>
+/// <param name="streamer">mipmap streamer, NULL = textures are fully resident.</param>
+/// <returns>TRUE if all textures have been loaded.</returns>
+bool Mesh::loadMaterialTextures(const std::vector<MaterialData> &materials, const std::string &Dir, TextureLoader *loader, TextureStreamer *streamer)
+{
+	PROFILE_FUNCTION();
+
+	bool rc = true;
+
+	for (unsigned int i = 0; i < materials.size(); i++)
+	{
+		diff_textures[i].reset();
+		bump_textures[i].reset();
+		spec_textures[i].reset();
+
+		if (!materials[i].diffuseMap.empty())
+		{
+			std::string FullPath = Dir + "/" + materials[i].diffuseMap;
+
+			Kds = materials[i].diffuseColor;
+			specularExponents[i] = 10;
+
+			diff_textures[i] = TextureRegistry::shared().acquire(FullPath, TEXTURE_KIND_COLOR, true, loader, streamer);
+
+			if (!diff_textures[i]) {
+				printf("Error loading diff. texture '%s'\n", FullPath.c_str());
+				rc = false;
+			}
+			else {
+				printf("Loaded diff. texture '%s'\n",FullPath.c_str());
+			}
+		}
+
+		if (!materials[i].specularMap.empty())
+		{
+			std::string FullPath = Dir + "/" + materials[i].specularMap;
+			spec_textures[i] = TextureRegistry::shared().acquire(FullPath, TEXTURE_KIND_COLOR, true, loader, streamer);
+
+			if (!spec_textures[i]) {
+				printf("Error loading spec. texture '%s'\n", FullPath.c_str());
+				rc = false;
+			}
+			else {
+				printf("Loaded spec. texture '%s'\n",FullPath.c_str());
+			}
+		}
+
+		if (!materials[i].normalMap.empty())
+		{
+			std::string FullPath = Dir + "/" + materials[i].normalMap;
+			bump_textures[i] = TextureRegistry::shared().acquire(FullPath, TEXTURE_KIND_NORMAL, false, loader, streamer);
+
+			if (!bump_textures[i]) {
+				printf("Error loading normal texture '%s'\n", FullPath.c_str());
+				rc = false;
+			}
+			else {
+				printf("Loaded normal texture '%s'\n",FullPath.c_str());
+			}
+		}
+	}
+
+	return rc;
+}
+
+/// <summary>
+/// Registers material textures in texture array packer and builds arrays. Every
+/// material gets array layers for diffuse, normal and specular texture, missing
+/// textures are replaced by single pixel default layers.
+/// </summary>
+/// <param name="materials">imported materials.</param>
+/// <param name="Dir">model directory.</param>
+/// <param name="loader">asynchronous texture loader, NULL = synchronous upload.</param>
+/// <returns>TRUE if all textures have been packed.</returns>
+bool Mesh::loadMaterialArrays(const std::vector<MaterialData> &materials, const std::string &Dir, TextureLoader *loader)
+{
+	PROFILE_FUNCTION();
+
+	bool rc = true;
+
+	int whiteId = textureArrays.addColor(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+	int normalId = textureArrays.addColor(glm::vec4(0.5f, 0.5f, 1.0f, 1.0f));
+
+	std::vector<int> ids(materials.size() * 3);
+
+	for (unsigned int i = 0; i < materials.size(); i++)
+	{
+		const std::string *paths[3] = { &materials[i].diffuseMap, &materials[i].normalMap, &materials[i].specularMap };
+		const int defaults[3] = { whiteId, normalId, whiteId };
+
+		for (unsigned int t = 0; t < 3; t++)
+		{
+			ids[i * 3 + t] = -1;
+
+			if (!paths[t]->empty())
+			{
+				std::string FullPath = Dir + "/" + *paths[t];
+
+				//normal maps get two channel format, color textures are stored in SRGB
+				ids[i * 3 + t] = textureArrays.addImage(FullPath, t == 1 ? TEXTURE_KIND_NORMAL : TEXTURE_KIND_COLOR);
+
+				if (ids[i * 3 + t] < 0)
+				{
+					printf("Error loading texture '%s'\n", FullPath.c_str());
+					rc = false;
+				}
+			}
+
+			if (t == 0 && ids[i * 3] >= 0)
+			{
+				Kds = materials[i].diffuseColor;
+				specularExponents[i] = 10;
+			}
+
+			if (ids[i * 3 + t] < 0)
+			{
+				ids[i * 3 + t] = defaults[t];
+			}
+		}
+	}
+
+	if (!textureArrays.build(loader))
+	{
+		rc = false;
+	}
+
+	materialLayers.resize(materials.size());
+
+	for (unsigned int i = 0; i < materials.size(); i++)
+	{
+		materialLayers[i].diffuse = textureArrays.getSlot(ids[i * 3]);
+		materialLayers[i].normal = textureArrays.getSlot(ids[i * 3 + 1]);
+		materialLayers[i].specular = textureArrays.getSlot(ids[i * 3 + 2]);
+		materialLayers[i].textured = ids[i * 3] != whiteId;
+
+		for (unsigned int t = 0; t < 3; t++)
+		{
+			materialLayers[i].images[t] = ids[i * 3 + t];
+		}
+	}
+
+	//layers used until material layers are resident
+	defaultLayers[0] = defaultLayers[2] = textureArrays.getSlot(whiteId);
+	defaultLayers[1] = textureArrays.getSlot(normalId);
+
+	return rc;
+}
+
+/// <summary>
+/// Binds arrays of material textures to units 0 .. count - 1 and sets layer
+/// uniforms. Arrays already bound by previous draw are not rebound. Layers
+/// which are still being loaded are replaced by default ones.
+/// </summary>
+/// <param name="material">material index.</param>
+/// <param name="layerLocations">locations of layer uniforms (diffuse, normal, specular), -1 = unused.</param>
+/// <param name="boundArrays">arrays bound to units by previous draws, updated.</param>
+/// <param name="count">textures count (1 = diffuse only).</param>
+void Mesh::bindMaterialLayers(unsigned int material, const GLint *layerLocations, GLuint *boundArrays, unsigned int count)
+{
+	const TextureSlot slots[3] = { materialLayers[material].diffuse, materialLayers[material].normal, materialLayers[material].specular };
+
+	for (unsigned int t = 0; t < count; t++)
+	{
+		const TextureSlot &slot = textureArrays.isResident(materialLayers[material].images[t]) ? slots[t] : defaultLayers[t];
+		GLuint object = textureArrays.getArrayObject(slot.array);
+
+		if (boundArrays[t] != object)
+		{
+			glActiveTexture(GL_TEXTURE0 + t);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, object);
+			boundArrays[t] = object;
+		}
+
+		if (layerLocations[t] != -1)
+		{
+			glUniform1f(layerLocations[t], (float)slot.layer);
+		}
+	}
+}
+
+/// <summary>
+/// Sorts draw list so that submeshes sharing texture bindings are drawn
+/// consecutively. Relative order of equal submeshes is kept.
+/// </summary>
+/// <param name="drawList">submesh indices.</param>
+void Mesh::sortDrawList(std::vector<unsigned int> &drawList) const
+{
+	std::vector<unsigned long long> keys(meshes.size(), 0);
+
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		unsigned int material = meshes[i].materialIndex;
+
+#if TEXTURE_ARRAYS
+		if (material < materialLayers.size())
+		{
+			//arrays of diffuse, normal and specular textures (16 bits each)
+			const MaterialLayers &layers = materialLayers[material];
+			keys[i] = ((unsigned long long)(layers.diffuse.array & 0xffff) << 32) | ((unsigned long long)(layers.normal.array & 0xffff) << 16) | (unsigned long long)(layers.specular.array & 0xffff);
+		}
+#else
+		keys[i] = material;
+#endif
+	}
+
+	std::stable_sort(drawList.begin(), drawList.end(), [&keys](unsigned int a, unsigned int b)
+	{
+		return keys[a] < keys[b];
+	});
+}
@@ -0,0 +1,374 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements quadric error metric mesh simplification (Garland, Heckbert).
+Every vertex accumulates quadrics of planes of its triangles, cheapest edge
+collapses are performed in passes until requested triangle count is reached.
+Vertices on open borders (including UV and normal seams, where vertices are
+duplicated) are locked, so simplified meshes keep their outline without cracks.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+#include <glm/glm.hpp>
+
+#include "scene\objloader\MeshSimplifier.h"
+
+/// <summary>
+/// Initializes a new instance of the <see cref="MeshSimplifier"/> class.
+/// </summary>
+/// <param name="positions">vertex positions (xyz), data must stay valid during simplification.</param>
+/// <param name="vertexCount">vertex count.</param>
+/// <param name="indices">triangle list indices.</param>
+/// <param name="indexCount">index count.</param>
+MeshSimplifier::MeshSimplifier(const float *positions, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount) :
+	m_positions(positions), m_vertexCount(vertexCount), m_indices(indices, indices + indexCount), m_error(0.0)
+{
+	removeDegenerates();
+	computeQuadrics();
+	lockBorderVertices();
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="MeshSimplifier"/> class.
+/// </summary>
+MeshSimplifier::~MeshSimplifier()
+{
+}
+
+/// <summary>
+/// Simplifies mesh until index count drops to target or no more collapses are possible.
+/// </summary>
+/// <param name="targetIndexCount">desired index count.</param>
+/// <param name="indices">output triangle list.</param>
+/// <param name="error">output approximate geometric error in object space units.</param>
+/// <returns>TRUE if mesh has been simplified at least a bit</returns>
+bool MeshSimplifier::simplify(unsigned int targetIndexCount, std::vector<unsigned int> &indices, float &error)
+{
+	unsigned int startCount = (unsigned int)m_indices.size();
+
+	while (m_indices.size() > targetIndexCount)
+	{
+		unsigned int trianglesToRemove = ((unsigned int)m_indices.size() - targetIndexCount + 2) / 3;
+
+		if (collapsePass(trianglesToRemove) == 0)
+		{
+			break;
+		}
+
+		removeDegenerates();
+	}
+
+	indices = m_indices;
+	error = (float)sqrt(m_error);
+
+	return m_indices.size() < startCount;
+}
+
+/// <summary>
+/// Computes vertex quadrics as sum of plane quadrics of adjacent triangles.
+/// </summary>
+void MeshSimplifier::computeQuadrics()
+{
+	Quadric zero;
+	memset(zero.m, 0, sizeof(zero.m));
+
+	m_quadrics.assign(m_vertexCount, zero);
+
+	for (unsigned int t = 0; t < m_indices.size(); t += 3)
+	{
+		glm::vec3 p0 = glm::vec3(m_positions[m_indices[t] * 3], m_positions[m_indices[t] * 3 + 1], m_positions[m_indices[t] * 3 + 2]);
+		glm::vec3 p1 = glm::vec3(m_positions[m_indices[t + 1] * 3], m_positions[m_indices[t + 1] * 3 + 1], m_positions[m_indices[t + 1] * 3 + 2]);
+		glm::vec3 p2 = glm::vec3(m_positions[m_indices[t + 2] * 3], m_positions[m_indices[t + 2] * 3 + 1], m_positions[m_indices[t + 2] * 3 + 2]);
+
+		glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(n);
+
+		if (length <= 0.0f)
+		{
+			continue;
+		}
+
+		n /= length;
+
+		double a = n.x, b = n.y, c = n.z, d = -glm::dot(n, p0);
+		double plane[10] = { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			Quadric &q = m_quadrics[m_indices[t + k]];
+
+			for (unsigned int j = 0; j < 10; j++)
+			{
+				q.m[j] += plane[j];
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Locks vertices of edges used by single triangle only.
+/// </summary>
+void MeshSimplifier::lockBorderVertices()
+{
+	m_locked.assign(m_vertexCount, 0);
+
+	std::unordered_set<unsigned long long> edges;
+	edges.reserve(m_indices.size());
+
+	for (unsigned int t = 0; t < m_indices.size(); t += 3)
+	{
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			unsigned long long a = m_indices[t + k], b = m_indices[t + (k + 1) % 3];
+			edges.insert((a << 32) | b);
+		}
+	}
+
+	for (unsigned int t = 0; t < m_indices.size(); t += 3)
+	{
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			unsigned long long a = m_indices[t + k], b = m_indices[t + (k + 1) % 3];
+
+			//opposite half edge missing = border
+			if (edges.find((b << 32) | a) == edges.end())
+			{
+				m_locked[(unsigned int)a] = 1;
+				m_locked[(unsigned int)b] = 1;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Evaluates error of moving vertex u into position of vertex v.
+/// </summary>
+/// <param name="u">removed vertex.</param>
+/// <param name="v">kept vertex.</param>
+/// <returns>sum of squared distances to planes of both vertices</returns>
+double MeshSimplifier::collapseCost(unsigned int u, unsigned int v) const
+{
+	const double *qu = m_quadrics[u].m;
+	const double *qv = m_quadrics[v].m;
+
+	double q[10];
+	for (unsigned int j = 0; j < 10; j++)
+	{
+		q[j] = qu[j] + qv[j];
+	}
+
+	double x = m_positions[v * 3], y = m_positions[v * 3 + 1], z = m_positions[v * 3 + 2];
+
+	double cost = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x
+				+ q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+				+ q[7] * z * z + 2.0 * q[8] * z
+				+ q[9];
+
+	return std::max(cost, 0.0);
+}
+
+/// <summary>
+/// Checks whether collapse u -> v flips normal of some remaining triangle.
+/// </summary>
+/// <param name="u">removed vertex.</param>
+/// <param name="v">kept vertex.</param>
+/// <returns>TRUE if collapse would fold mesh</returns>
+bool MeshSimplifier::flipsTriangle(unsigned int u, unsigned int v) const
+{
+	glm::vec3 pv = glm::vec3(m_positions[v * 3], m_positions[v * 3 + 1], m_positions[v * 3 + 2]);
+
+	for (unsigned int a = m_adjacencyOffsets[u]; a < m_adjacencyOffsets[u + 1]; a++)
+	{
+		unsigned int t = m_adjacency[a] * 3;
+		unsigned int i0 = m_indices[t], i1 = m_indices[t + 1], i2 = m_indices[t + 2];
+
+		//triangles sharing collapsed edge disappear
+		if (i0 == v || i1 == v || i2 == v || i0 == i1 || i1 == i2 || i0 == i2)
+		{
+			continue;
+		}
+
+		glm::vec3 p[3];
+		unsigned int ids[3] = { i0, i1, i2 };
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			p[k] = glm::vec3(m_positions[ids[k] * 3], m_positions[ids[k] * 3 + 1], m_positions[ids[k] * 3 + 2]);
+		}
+
+		glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (ids[k] == u)
+			{
+				p[k] = pv;
+			}
+		}
+
+		glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+		if (glm::dot(before, after) <= 0.0f)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Performs one pass of independent cheapest collapses. Vertices around every
+/// collapse are frozen until next pass, so adjacency stays valid.
+/// </summary>
+/// <param name="trianglesToRemove">maximal count of removed triangles.</param>
+/// <returns>performed collapses count</returns>
+unsigned int MeshSimplifier::collapsePass(unsigned int trianglesToRemove)
+{
+	unsigned int triangleCount = (unsigned int)m_indices.size() / 3;
+
+	//build vertex -> triangles adjacency
+	m_adjacencyOffsets.assign(m_vertexCount + 1, 0);
+
+	for (unsigned int i = 0; i < m_indices.size(); i++)
+	{
+		m_adjacencyOffsets[m_indices[i] + 1]++;
+	}
+
+	for (unsigned int v = 0; v < m_vertexCount; v++)
+	{
+		m_adjacencyOffsets[v + 1] += m_adjacencyOffsets[v];
+	}
+
+	m_adjacency.resize(m_indices.size());
+	std::vector<unsigned int> fill(m_adjacencyOffsets.begin(), m_adjacencyOffsets.end() - 1);
+
+	for (unsigned int i = 0; i < m_indices.size(); i++)
+	{
+		m_adjacency[fill[m_indices[i]]++] = i / 3;
+	}
+
+	//evaluate both directions of every edge
+	std::vector<Collapse> collapses;
+	collapses.reserve(triangleCount * 3);
+
+	for (unsigned int t = 0; t < m_indices.size(); t += 3)
+	{
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			unsigned int a = m_indices[t + k], b = m_indices[t + (k + 1) % 3];
+
+			//inner edges are visited from both triangles, border edges have locked ends
+			if (a > b)
+			{
+				continue;
+			}
+
+			if (!m_locked[a])
+			{
+				Collapse c = { a, b, collapseCost(a, b) };
+				collapses.push_back(c);
+			}
+
+			if (!m_locked[b])
+			{
+				Collapse c = { b, a, collapseCost(b, a) };
+				collapses.push_back(c);
+			}
+		}
+	}
+
+	std::sort(collapses.begin(), collapses.end());
+
+	std::vector<unsigned char> frozen(m_vertexCount, 0);
+	unsigned int removed = 0;
+	unsigned int performed = 0;
+
+	for (unsigned int c = 0; c < collapses.size() && removed < trianglesToRemove; c++)
+	{
+		unsigned int u = collapses[c].u;
+		unsigned int v = collapses[c].v;
+
+		if (frozen[u] || frozen[v] || flipsTriangle(u, v))
+		{
+			continue;
+		}
+
+		for (unsigned int a = m_adjacencyOffsets[u]; a < m_adjacencyOffsets[u + 1]; a++)
+		{
+			unsigned int t = m_adjacency[a] * 3;
+			bool degenerate = false;
+
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				frozen[m_indices[t + k]] = 1;
+				degenerate = degenerate || (m_indices[t + k] == v);
+			}
+
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				if (m_indices[t + k] == u)
+				{
+					m_indices[t + k] = v;
+				}
+			}
+
+			if (degenerate)
+			{
+				removed++;
+			}
+		}
+
+		for (unsigned int j = 0; j < 10; j++)
+		{
+			m_quadrics[v].m[j] += m_quadrics[u].m[j];
+		}
+
+		m_error = std::max(m_error, collapses[c].cost);
+		performed++;
+	}
+
+	return performed;
+}
+
+/// <summary>
+/// Removes triangles with repeated vertices.
+/// </summary>
+void MeshSimplifier::removeDegenerates()
+{
+	unsigned int count = 0;
+
+	for (unsigned int t = 0; t + 2 < m_indices.size(); t += 3)
+	{
+		unsigned int i0 = m_indices[t], i1 = m_indices[t + 1], i2 = m_indices[t + 2];
+
+		if (i0 != i1 && i1 != i2 && i0 != i2)
+		{
+			m_indices[count++] = i0;
+			m_indices[count++] = i1;
+			m_indices[count++] = i2;
+		}
+	}
+
+	m_indices.resize(count);
+}
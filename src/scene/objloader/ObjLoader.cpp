@@ -0,0 +1,920 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements Wavefront OBJ/MTL loader. File is mapped to memory and
+split to line aligned chunks which are parsed in parallel, relative indices
+are resolved once attribute counts of previous chunks are known. Submeshes
+are then triangulated, deduplicated and get their normals and tangents in
+parallel too.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <stdio.h>
+#include <unordered_map>
+#include "scene\objloader\ObjLoader.h"
+#include "utils\MappedFile.h"
+#include "utils\threading\ThreadPool.h"
+
+//minimal chunk size, small files are parsed by less threads
+#define OBJ_CHUNK_SIZE (1 << 20)
+
+//relative index bits of corner
+#define RELATIVE_V 1
+#define RELATIVE_T 2
+#define RELATIVE_N 4
+
+static inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+/// <summary>
+/// Unique combination of corner attributes
+/// </summary>
+struct VertexKey
+{
+	int v;
+	int t;
+	int n;
+
+	bool operator==(const VertexKey &other) const
+	{
+		return v == other.v && t == other.t && n == other.n;
+	}
+};
+
+/// <summary>
+/// Hash of corner attributes
+/// </summary>
+struct VertexKeyHash
+{
+	size_t operator()(const VertexKey &key) const
+	{
+		return ((size_t)key.v * 73856093u) ^ ((size_t)key.t * 19349663u) ^ ((size_t)key.n * 83492791u);
+	}
+};
+
+/// <summary>
+/// Reads statement argument (rest of line without surrounding whitespace).
+/// </summary>
+/// <param name="p">argument start.</param>
+/// <param name="end">line end.</param>
+/// <returns>argument</returns>
+static std::string readName(const char *p, const char *end)
+{
+	while (p < end && isSpace(*p))
+	{
+		p++;
+	}
+
+	while (end > p && isSpace(end[-1]))
+	{
+		end--;
+	}
+
+	return std::string(p, end);
+}
+
+/// <summary>
+/// Determines whether line starts with keyword followed by whitespace.
+/// </summary>
+/// <param name="p">line start.</param>
+/// <param name="end">line end.</param>
+/// <param name="keyword">keyword.</param>
+/// <returns>TRUE if line is keyword statement.</returns>
+static bool isStatement(const char *p, const char *end, const char *keyword)
+{
+	size_t length = strlen(keyword);
+
+	return (size_t)(end - p) > length && strncmp(p, keyword, length) == 0 && isSpace(p[length]);
+}
+
+/// <summary>
+/// Converts OBJ index (1 based, negative = relative to end) to 0 based index.
+/// </summary>
+/// <param name="index">OBJ index.</param>
+/// <param name="count">attributes parsed so far in chunk.</param>
+/// <param name="relative">relative flags of corner.</param>
+/// <param name="bit">flag of attribute.</param>
+/// <returns>index within chunk (relative) or file, -1 = missing</returns>
+static int resolveIndex(int index, unsigned int count, unsigned char &relative, unsigned char bit)
+{
+	if (index > 0)
+	{
+		return index - 1;
+	}
+
+	if (index < 0)
+	{
+		relative |= bit;
+		return (int)count + index;
+	}
+
+	return -1;
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="ObjLoader"/> class.
+/// </summary>
+/// <param name="pool">thread pool used for parsing and processing.</param>
+ObjLoader::ObjLoader(ThreadPool &pool) : m_pool(pool)
+{
+}
+
+/// <summary>
+/// Parses integer.
+/// </summary>
+/// <param name="p">position, moved behind number.</param>
+/// <param name="end">end of input.</param>
+/// <returns>parsed value</returns>
+int ObjLoader::parseInt(const char *&p, const char *end)
+{
+	bool negative = false;
+
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	int value = 0;
+
+	while (p < end && isDigit(*p))
+	{
+		value = value * 10 + (*p - '0');
+		p++;
+	}
+
+	return negative ? -value : value;
+}
+
+/// <summary>
+/// Parses decimal floating point number (with optional exponent), leading
+/// whitespace is skipped. Up to 19 significant digits are accumulated as
+/// integer and scaled once, which is exact enough for float.
+/// </summary>
+/// <param name="p">position, moved behind number.</param>
+/// <param name="end">end of input.</param>
+/// <returns>parsed value, 0 if there is no number</returns>
+float ObjLoader::parseFloat(const char *&p, const char *end)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	while (p < end && isSpace(*p))
+	{
+		p++;
+	}
+
+	bool negative = false;
+
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+
+	for (; p < end && isDigit(*p); p++)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa > 0 ? 1 : 0;
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && isDigit(*p); p++)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa > 0 ? 1 : 0;
+				exponent--;
+			}
+		}
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		exponent += parseInt(p, end);
+	}
+
+	double value = (double)mantissa;
+
+	while (exponent > 22)
+	{
+		value *= powers[22];
+		exponent -= 22;
+	}
+
+	while (exponent < -22)
+	{
+		value /= powers[22];
+		exponent += 22;
+	}
+
+	value = exponent >= 0 ? value * powers[exponent] : value / powers[-exponent];
+
+	return (float)(negative ? -value : value);
+}
+
+/// <summary>
+/// Loads OBJ file and materials of its MTL libraries.
+/// </summary>
+/// <param name="filename">OBJ file.</param>
+/// <param name="data">output mesh.</param>
+/// <returns>FALSE if file can not be read.</returns>
+bool ObjLoader::load(const std::string &filename, MeshData &data)
+{
+	MappedFile file;
+
+	if (!file.open(filename))
+	{
+		printf("Error opening '%s'\n", filename.c_str());
+		return false;
+	}
+
+	const char *begin = file.getData();
+	const char *end = begin + file.getSize();
+
+	//line aligned chunks, few per thread to balance uneven statement mix
+	size_t chunkCount = std::max((size_t)1, std::min(file.getSize() / OBJ_CHUNK_SIZE, (size_t)(m_pool.getThreadCount() + 1) * 4));
+	const char *p = begin;
+
+	m_chunks.clear();
+	m_chunks.reserve(chunkCount);
+
+	for (size_t c = 0; c < chunkCount && p < end; c++)
+	{
+		const char *chunkEnd = c + 1 == chunkCount ? end : begin + file.getSize() / chunkCount * (c + 1);
+
+		while (chunkEnd < end && chunkEnd[-1] != '\n')
+		{
+			chunkEnd++;
+		}
+
+		if (chunkEnd <= p)
+		{
+			continue;
+		}
+
+		m_chunks.push_back(Chunk());
+		m_chunks.back().begin = p;
+		m_chunks.back().end = chunkEnd;
+
+		p = chunkEnd;
+	}
+
+	m_pool.parallelFor((unsigned int)m_chunks.size(), 1, [&](unsigned int first, unsigned int last)
+	{
+		for (unsigned int c = first; c < last; c++)
+		{
+			parseChunk(m_chunks[c]);
+		}
+	});
+
+	//attribute offsets of chunks
+	unsigned int positionCount = 0, texcoordCount = 0, normalCount = 0;
+
+	for (unsigned int c = 0; c < m_chunks.size(); c++)
+	{
+		m_chunks[c].basePosition = positionCount;
+		m_chunks[c].baseTexcoord = texcoordCount;
+		m_chunks[c].baseNormal = normalCount;
+
+		positionCount += (unsigned int)m_chunks[c].positions.size() / 3;
+		texcoordCount += (unsigned int)m_chunks[c].texcoords.size() / 2;
+		normalCount += (unsigned int)m_chunks[c].normals.size() / 3;
+	}
+
+	m_positions.resize(positionCount * 3);
+	m_texcoords.resize(texcoordCount * 2);
+	m_normals.resize(normalCount * 3);
+
+	//merge attributes, resolve relative and validate indices
+	m_pool.parallelFor((unsigned int)m_chunks.size(), 1, [&](unsigned int first, unsigned int last)
+	{
+		for (unsigned int c = first; c < last; c++)
+		{
+			Chunk &chunk = m_chunks[c];
+
+			std::copy(chunk.positions.begin(), chunk.positions.end(), m_positions.begin() + chunk.basePosition * 3);
+			std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), m_texcoords.begin() + chunk.baseTexcoord * 2);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), m_normals.begin() + chunk.baseNormal * 3);
+
+			std::vector<float>().swap(chunk.positions);
+			std::vector<float>().swap(chunk.texcoords);
+			std::vector<float>().swap(chunk.normals);
+
+			for (unsigned int i = 0; i < chunk.corners.size(); i++)
+			{
+				Corner &corner = chunk.corners[i];
+				unsigned char relative = chunk.relative[i];
+
+				corner.v += (relative & RELATIVE_V) ? chunk.basePosition : 0;
+				corner.t += (relative & RELATIVE_T) ? chunk.baseTexcoord : 0;
+				corner.n += (relative & RELATIVE_N) ? chunk.baseNormal : 0;
+
+				corner.v = corner.v < (int)positionCount ? std::max(corner.v, -1) : -1;
+				corner.t = corner.t < (int)texcoordCount ? std::max(corner.t, -1) : -1;
+				corner.n = corner.n < (int)normalCount ? std::max(corner.n, -1) : -1;
+			}
+
+			std::vector<unsigned char>().swap(chunk.relative);
+		}
+	});
+
+	//materials, index 0 is used by faces without (known) material
+	std::string directory;
+	std::string::size_type slash = filename.find_last_of("/\\");
+
+	if (slash != std::string::npos)
+	{
+		directory = filename.substr(0, slash + 1);
+	}
+
+	MaterialData defaultMaterial;
+	defaultMaterial.diffuseColor = glm::vec3(0.6f);
+
+	data.materials.assign(1, defaultMaterial);
+
+	std::map<std::string, unsigned int> materialIds;
+
+	for (unsigned int c = 0; c < m_chunks.size(); c++)
+	{
+		for (unsigned int l = 0; l < m_chunks[c].libraries.size(); l++)
+		{
+			if (!loadMaterials(directory + m_chunks[c].libraries[l], data, materialIds))
+			{
+				printf("Error loading material library '%s'\n", m_chunks[c].libraries[l].c_str());
+			}
+		}
+	}
+
+	//faces are split to submeshes by object / group and material, in order of first use
+	std::deque<Submesh> submeshes;
+	std::map<std::pair<unsigned int, unsigned int>, unsigned int> submeshIds;
+	std::map<std::string, unsigned int> groupIds;
+
+	unsigned int group = 0, material = 0;
+	int current = -1;
+
+	for (unsigned int c = 0; c < m_chunks.size(); c++)
+	{
+		const Chunk &chunk = m_chunks[c];
+		unsigned int s = 0;
+
+		for (unsigned int f = 0; f + 1 <= chunk.faces.size(); f++)
+		{
+			while (s < chunk.switches.size() && chunk.switches[s].face == f)
+			{
+				const Switch &change = chunk.switches[s++];
+
+				if (change.material)
+				{
+					std::map<std::string, unsigned int>::const_iterator it = materialIds.find(change.name);
+					material = it != materialIds.end() ? it->second : 0;
+				}
+				else
+				{
+					group = groupIds.insert(std::make_pair(change.name, (unsigned int)groupIds.size() + 1)).first->second;
+				}
+
+				current = -1;
+			}
+
+			//last entry of faces is end sentinel
+			if (f + 1 == chunk.faces.size())
+			{
+				break;
+			}
+
+			if (current < 0)
+			{
+				std::pair<std::map<std::pair<unsigned int, unsigned int>, unsigned int>::iterator, bool> inserted =
+					submeshIds.insert(std::make_pair(std::make_pair(group, material), (unsigned int)submeshes.size()));
+
+				if (inserted.second)
+				{
+					submeshes.push_back(Submesh());
+					submeshes.back().materialIndex = material;
+				}
+
+				current = (int)inserted.first->second;
+			}
+
+			submeshes[current].faces.push_back(((unsigned long long)c << 32) | f);
+		}
+	}
+
+	m_pool.parallelFor((unsigned int)submeshes.size(), 1, [&](unsigned int first, unsigned int last)
+	{
+		for (unsigned int i = first; i < last; i++)
+		{
+			buildSubmesh(submeshes[i]);
+		}
+	});
+
+	m_chunks.clear();
+	std::vector<float>().swap(m_positions);
+	std::vector<float>().swap(m_texcoords);
+	std::vector<float>().swap(m_normals);
+
+	//submeshes are stored one after another
+	unsigned int vertexCount = 0, indexCount = 0;
+
+	data.submeshes.resize(submeshes.size());
+
+	for (unsigned int i = 0; i < submeshes.size(); i++)
+	{
+		SubmeshData &submesh = data.submeshes[i];
+
+		submesh.materialIndex = submeshes[i].materialIndex;
+		submesh.baseVertex = vertexCount;
+		submesh.numVertices = (unsigned int)submeshes[i].positions.size() / 3;
+		submesh.baseIndex = indexCount;
+		submesh.numIndices = (unsigned int)submeshes[i].indices.size();
+
+		vertexCount += submesh.numVertices;
+		indexCount += submesh.numIndices;
+	}
+
+	data.positions.resize(vertexCount * 3);
+	data.texcoords.resize(vertexCount * 2);
+	data.normals.resize(vertexCount * 3);
+	data.tangents.resize(vertexCount * 3);
+	data.bitangents.resize(vertexCount * 3);
+	data.indices.resize(indexCount);
+
+	m_pool.parallelFor((unsigned int)submeshes.size(), 1, [&](unsigned int first, unsigned int last)
+	{
+		for (unsigned int i = first; i < last; i++)
+		{
+			const Submesh &source = submeshes[i];
+			const SubmeshData &target = data.submeshes[i];
+
+			std::copy(source.positions.begin(), source.positions.end(), data.positions.begin() + target.baseVertex * 3);
+			std::copy(source.texcoords.begin(), source.texcoords.end(), data.texcoords.begin() + target.baseVertex * 2);
+			std::copy(source.normals.begin(), source.normals.end(), data.normals.begin() + target.baseVertex * 3);
+			std::copy(source.tangents.begin(), source.tangents.end(), data.tangents.begin() + target.baseVertex * 3);
+			std::copy(source.bitangents.begin(), source.bitangents.end(), data.bitangents.begin() + target.baseVertex * 3);
+			std::copy(source.indices.begin(), source.indices.end(), data.indices.begin() + target.baseIndex);
+		}
+	});
+
+	return true;
+}
+
+/// <summary>
+/// Parses statements of single chunk. Indices are resolved to 0 based, relative
+/// ones only within chunk.
+/// </summary>
+/// <param name="chunk">chunk.</param>
+void ObjLoader::parseChunk(Chunk &chunk) const
+{
+	const char *p = chunk.begin;
+
+	while (p < chunk.end)
+	{
+		while (p < chunk.end && isSpace(*p))
+		{
+			p++;
+		}
+
+		const char *lineEnd = (const char*)memchr(p, '\n', chunk.end - p);
+
+		if (!lineEnd)
+		{
+			lineEnd = chunk.end;
+		}
+
+		if (lineEnd - p >= 2)
+		{
+			if (p[0] == 'v' && isSpace(p[1]))
+			{
+				p += 2;
+
+				for (unsigned int k = 0; k < 3; k++)
+				{
+					chunk.positions.push_back(parseFloat(p, lineEnd));
+				}
+			}
+			else if (p[0] == 'v' && p[1] == 't')
+			{
+				p += 2;
+
+				for (unsigned int k = 0; k < 2; k++)
+				{
+					chunk.texcoords.push_back(parseFloat(p, lineEnd));
+				}
+			}
+			else if (p[0] == 'v' && p[1] == 'n')
+			{
+				p += 2;
+
+				for (unsigned int k = 0; k < 3; k++)
+				{
+					chunk.normals.push_back(parseFloat(p, lineEnd));
+				}
+			}
+			else if (p[0] == 'f' && isSpace(p[1]))
+			{
+				unsigned int first = (unsigned int)chunk.corners.size();
+
+				for (p += 2;;)
+				{
+					while (p < lineEnd && isSpace(*p))
+					{
+						p++;
+					}
+
+					if (p >= lineEnd || !(isDigit(*p) || *p == '-' || *p == '+'))
+					{
+						break;
+					}
+
+					//v, v/t, v//n or v/t/n
+					Corner corner;
+					unsigned char relative = 0;
+
+					corner.v = resolveIndex(parseInt(p, lineEnd), (unsigned int)chunk.positions.size() / 3, relative, RELATIVE_V);
+					corner.t = -1;
+					corner.n = -1;
+
+					if (p < lineEnd && *p == '/')
+					{
+						p++;
+
+						if (p < lineEnd && *p != '/')
+						{
+							corner.t = resolveIndex(parseInt(p, lineEnd), (unsigned int)chunk.texcoords.size() / 2, relative, RELATIVE_T);
+						}
+
+						if (p < lineEnd && *p == '/')
+						{
+							p++;
+							corner.n = resolveIndex(parseInt(p, lineEnd), (unsigned int)chunk.normals.size() / 3, relative, RELATIVE_N);
+						}
+					}
+
+					while (p < lineEnd && !isSpace(*p))
+					{
+						p++;
+					}
+
+					chunk.corners.push_back(corner);
+					chunk.relative.push_back(relative);
+				}
+
+				//points and lines are ignored
+				if (chunk.corners.size() - first >= 3)
+				{
+					chunk.faces.push_back(first);
+				}
+				else
+				{
+					chunk.corners.resize(first);
+					chunk.relative.resize(first);
+				}
+			}
+			else if (isStatement(p, lineEnd, "usemtl"))
+			{
+				Switch change = { (unsigned int)chunk.faces.size(), true, readName(p + 6, lineEnd) };
+				chunk.switches.push_back(change);
+			}
+			else if ((p[0] == 'o' || p[0] == 'g') && isSpace(p[1]))
+			{
+				Switch change = { (unsigned int)chunk.faces.size(), false, readName(p + 1, lineEnd) };
+				chunk.switches.push_back(change);
+			}
+			else if (isStatement(p, lineEnd, "mtllib"))
+			{
+				chunk.libraries.push_back(readName(p + 6, lineEnd));
+			}
+		}
+
+		p = lineEnd + 1;
+	}
+
+	//end sentinel
+	chunk.faces.push_back((unsigned int)chunk.corners.size());
+}
+
+/// <summary>
+/// Loads MTL library. Diffuse color and diffuse, specular and bump (normal)
+/// maps are read, map options are skipped (path is last token).
+/// </summary>
+/// <param name="filename">MTL file.</param>
+/// <param name="data">mesh, materials are appended.</param>
+/// <param name="materialIds">material indices by name.</param>
+/// <returns>FALSE if file can not be read.</returns>
+bool ObjLoader::loadMaterials(const std::string &filename, MeshData &data, std::map<std::string, unsigned int> &materialIds) const
+{
+	FILE *f = fopen(filename.c_str(), "r");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	char buffer[1024];
+	MaterialData *material = NULL;
+
+	while (fgets(buffer, sizeof(buffer), f))
+	{
+		const char *p = buffer;
+		const char *end = buffer + strlen(buffer);
+
+		while (end > p && (isSpace(end[-1]) || end[-1] == '\n'))
+		{
+			end--;
+		}
+
+		while (p < end && isSpace(*p))
+		{
+			p++;
+		}
+
+		if (isStatement(p, end, "newmtl"))
+		{
+			std::string name = readName(p + 6, end);
+
+			MaterialData entry;
+			entry.diffuseColor = glm::vec3(0.6f);
+
+			materialIds[name] = (unsigned int)data.materials.size();
+			data.materials.push_back(entry);
+			material = &data.materials.back();
+			continue;
+		}
+
+		if (!material)
+		{
+			continue;
+		}
+
+		//path of map statements is its last token
+		const char *token = end;
+
+		while (token > p && isSpace(token[-1]))
+		{
+			token--;
+		}
+
+		const char *tokenEnd = token;
+
+		while (token > p && !isSpace(token[-1]))
+		{
+			token--;
+		}
+
+		if (isStatement(p, end, "Kd"))
+		{
+			p += 2;
+
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				material->diffuseColor[k] = parseFloat(p, end);
+			}
+		}
+		else if (isStatement(p, end, "map_Kd"))
+		{
+			material->diffuseMap = std::string(token, tokenEnd);
+		}
+		else if (isStatement(p, end, "map_Ks"))
+		{
+			material->specularMap = std::string(token, tokenEnd);
+		}
+		else if (isStatement(p, end, "map_bump") || isStatement(p, end, "map_Bump") || isStatement(p, end, "bump"))
+		{
+			material->normalMap = std::string(token, tokenEnd);
+		}
+	}
+
+	fclose(f);
+
+	return true;
+}
+
+/// <summary>
+/// Triangulates faces of submesh (fan), creates single vertex per unique
+/// combination of corner attributes and generates missing attributes.
+/// </summary>
+/// <param name="submesh">submesh with assigned faces.</param>
+void ObjLoader::buildSubmesh(Submesh &submesh) const
+{
+	std::unordered_map<VertexKey, unsigned int, VertexKeyHash> vertices;
+	vertices.reserve(submesh.faces.size() * 2);
+
+	std::vector<unsigned int> polygon;
+	bool hasNormals = true;
+
+	for (unsigned int i = 0; i < submesh.faces.size(); i++)
+	{
+		const Chunk &chunk = m_chunks[(unsigned int)(submesh.faces[i] >> 32)];
+		unsigned int face = (unsigned int)(submesh.faces[i] & 0xffffffff);
+
+		polygon.clear();
+
+		for (unsigned int k = chunk.faces[face]; k < chunk.faces[face + 1]; k++)
+		{
+			const Corner &corner = chunk.corners[k];
+			VertexKey key = { corner.v, corner.t, corner.n };
+
+			std::pair<std::unordered_map<VertexKey, unsigned int, VertexKeyHash>::iterator, bool> inserted =
+				vertices.insert(std::make_pair(key, (unsigned int)submesh.positionIds.size()));
+
+			if (inserted.second)
+			{
+				for (unsigned int c = 0; c < 3; c++)
+				{
+					submesh.positions.push_back(corner.v >= 0 ? m_positions[corner.v * 3 + c] : 0.0f);
+					submesh.normals.push_back(corner.n >= 0 ? m_normals[corner.n * 3 + c] : 0.0f);
+				}
+
+				for (unsigned int c = 0; c < 2; c++)
+				{
+					submesh.texcoords.push_back(corner.t >= 0 ? m_texcoords[corner.t * 2 + c] : 0.0f);
+				}
+
+				submesh.positionIds.push_back(corner.v);
+				hasNormals = hasNormals && corner.n >= 0;
+			}
+
+			polygon.push_back(inserted.first->second);
+		}
+
+		for (unsigned int k = 1; k + 1 < polygon.size(); k++)
+		{
+			submesh.indices.push_back(polygon[0]);
+			submesh.indices.push_back(polygon[k]);
+			submesh.indices.push_back(polygon[k + 1]);
+		}
+	}
+
+	std::vector<unsigned long long>().swap(submesh.faces);
+
+	if (!hasNormals)
+	{
+		generateNormals(submesh);
+	}
+
+	//tangent frame is computed before texture coordinates flip (as by Assimp)
+	generateTangents(submesh);
+
+	for (unsigned int i = 1; i < submesh.texcoords.size(); i += 2)
+	{
+		submesh.texcoords[i] = 1.0f - submesh.texcoords[i];
+	}
+
+	std::vector<int>().swap(submesh.positionIds);
+}
+
+/// <summary>
+/// Generates smooth normals, faces are weighted by area and vertices sharing
+/// source position share normal.
+/// </summary>
+/// <param name="submesh">submesh.</param>
+void ObjLoader::generateNormals(Submesh &submesh) const
+{
+	unsigned int vertexCount = (unsigned int)submesh.positionIds.size();
+
+	//vertices with the same position accumulate to the same slot
+	std::unordered_map<int, unsigned int> slotIds;
+	std::vector<unsigned int> slots(vertexCount);
+
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		int id = submesh.positionIds[i] >= 0 ? submesh.positionIds[i] : -(int)i - 2;
+		slots[i] = slotIds.insert(std::make_pair(id, (unsigned int)slotIds.size())).first->second;
+	}
+
+	std::vector<glm::vec3> accumulated(slotIds.size(), glm::vec3(0.0f));
+	const glm::vec3 *positions = (const glm::vec3*)&submesh.positions[0];
+
+	for (unsigned int i = 0; i + 2 < submesh.indices.size(); i += 3)
+	{
+		const unsigned int *triangle = &submesh.indices[i];
+		glm::vec3 normal = glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			accumulated[slots[triangle[k]]] += normal;
+		}
+	}
+
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 normal = accumulated[slots[i]];
+		float length = glm::length(normal);
+
+		if (length > 0.0f)
+		{
+			normal /= length;
+		}
+
+		submesh.normals[i * 3] = normal.x;
+		submesh.normals[i * 3 + 1] = normal.y;
+		submesh.normals[i * 3 + 2] = normal.z;
+	}
+}
+
+/// <summary>
+/// Generates tangents and bitangents from texture coordinates, accumulated per
+/// vertex and orthogonalized against normal.
+/// </summary>
+/// <param name="submesh">submesh.</param>
+void ObjLoader::generateTangents(Submesh &submesh) const
+{
+	unsigned int vertexCount = (unsigned int)submesh.positions.size() / 3;
+
+	submesh.tangents.assign(vertexCount * 3, 0.0f);
+	submesh.bitangents.assign(vertexCount * 3, 0.0f);
+
+	if (vertexCount == 0)
+	{
+		return;
+	}
+
+	const glm::vec3 *positions = (const glm::vec3*)&submesh.positions[0];
+	const glm::vec2 *texcoords = (const glm::vec2*)&submesh.texcoords[0];
+	const glm::vec3 *normals = (const glm::vec3*)&submesh.normals[0];
+	glm::vec3 *tangents = (glm::vec3*)&submesh.tangents[0];
+	glm::vec3 *bitangents = (glm::vec3*)&submesh.bitangents[0];
+
+	for (unsigned int i = 0; i + 2 < submesh.indices.size(); i += 3)
+	{
+		const unsigned int *triangle = &submesh.indices[i];
+
+		glm::vec3 v = positions[triangle[1]] - positions[triangle[0]];
+		glm::vec3 w = positions[triangle[2]] - positions[triangle[0]];
+
+		glm::vec2 s = texcoords[triangle[1]] - texcoords[triangle[0]];
+		glm::vec2 t = texcoords[triangle[2]] - texcoords[triangle[0]];
+
+		//the same texture coordinates, default direction is used
+		if (s.x * t.y == s.y * t.x)
+		{
+			s = glm::vec2(0.0f, 1.0f);
+			t = glm::vec2(1.0f, 0.0f);
+		}
+
+		float direction = (t.x * s.y - t.y * s.x) < 0.0f ? -1.0f : 1.0f;
+
+		glm::vec3 tangent = (w * s.y - v * t.y) * direction;
+		glm::vec3 bitangent = (w * s.x - v * t.x) * direction;
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			tangents[triangle[k]] += tangent;
+			bitangents[triangle[k]] += bitangent;
+		}
+	}
+
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 tangent = tangents[i] - normals[i] * glm::dot(normals[i], tangents[i]);
+		glm::vec3 bitangent = bitangents[i] - normals[i] * glm::dot(normals[i], bitangents[i]);
+
+		float tangentLength = glm::length(tangent), bitangentLength = glm::length(bitangent);
+
+		tangents[i] = tangentLength > 0.0f ? tangent / tangentLength : glm::vec3(0.0f);
+		bitangents[i] = bitangentLength > 0.0f ? bitangent / bitangentLength : glm::vec3(0.0f);
+	}
+}
@@ -0,0 +1,489 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements benchmark scenario generator. Light distributions
+approximate typical content (uniform fill, clustered hotspots, lights
+attached to surfaces, corridors), layouts repeat scene mesh to increase
+geometry load. Scenarios are stored as header, light and instance records.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <stdio.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "scene\scenario\ScenarioGenerator.h"
+
+//scenario file header
+#define SCENARIO_MAGIC		"ECLS"
+#define SCENARIO_VERSION	1
+
+//streams of lights and layout are independent
+#define LAYOUT_SEED_SALT	0x9e3779b9u
+
+//distribution parameters
+#define CLUSTER_LIGHTS		64		//average lights per hotspot
+#define CLUSTER_MAX			32
+#define CLUSTER_SIGMA		0.04f	//fraction of scene diagonal
+#define SURFACE_OFFSET		0.1f	//fraction of light radius above surface
+#define CORRIDOR_WIDTH		0.15f	//fraction of scene extent across corridor
+#define CORRIDOR_HEIGHT		0.4f	//fraction of scene height from floor
+#define CITY_STREET			0.3f	//street width as fraction of block size
+#define CITY_EMPTY			0.15f	//probability of empty block
+
+typedef struct
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int seed;
+	unsigned int distribution;
+	unsigned int lightCount;
+	float radiusMin;
+	float radiusMax;
+	unsigned int layout;
+	unsigned int layoutSize;
+	unsigned int instanceCount;
+} ScenarioHeader;
+
+//light record, color is stored as RGB8
+typedef struct
+{
+	float position[3];
+	float radius;
+	unsigned char color[4];
+} LightRecord;
+
+/// <summary>
+/// Portable random numbers on top of mt19937
+/// </summary>
+class ScenarioRandom
+{
+	public:
+		ScenarioRandom(unsigned int seed) : m_engine(seed) {}
+
+		/// <summary>
+		/// Returns uniform number from range <min, max).
+		/// </summary>
+		float uniform(float min, float max)
+		{
+			return min + (max - min) * ((m_engine() >> 8) * (1.0f / 16777216.0f));
+		}
+
+		/// <summary>
+		/// Returns uniform integer from range <0, count).
+		/// </summary>
+		unsigned int index(unsigned int count)
+		{
+			return (unsigned int)(((unsigned long long)m_engine() * count) >> 32);
+		}
+
+		/// <summary>
+		/// Returns normally distributed number (Box-Muller).
+		/// </summary>
+		float normal(float sigma)
+		{
+			float u = uniform(1e-7f, 1.0f), v = uniform(0.0f, 1.0f);
+			return sigma * sqrtf(-2.0f * logf(u)) * cosf(6.28318531f * v);
+		}
+
+		/// <summary>
+		/// Returns uniform point in box.
+		/// </summary>
+		glm::vec3 point(const AABB &box)
+		{
+			float x = uniform(box.min.x, box.max.x);
+			float y = uniform(box.min.y, box.max.y);
+			float z = uniform(box.min.z, box.max.z);
+
+			return glm::vec3(x, y, z);
+		}
+
+	protected:
+		std::mt19937 m_engine;
+};
+
+/// <summary>
+/// Initializes a new instance of the <see cref="ScenarioGenerator"/> class.
+/// </summary>
+/// <param name="meshBounds">object space bounds of scene mesh.</param>
+/// <param name="surface">object space surface samples of scene mesh, must outlive generator.</param>
+ScenarioGenerator::ScenarioGenerator(const AABB &meshBounds, const std::vector<SurfaceSample> &surface)
+	: m_meshBounds(meshBounds), m_surface(surface)
+{
+}
+
+/// <summary>
+/// Generates layout and lights of scenario.
+/// </summary>
+/// <param name="desc">scenario parameters.</param>
+/// <param name="scenario">output scenario.</param>
+void ScenarioGenerator::generate(const ScenarioDesc &desc, Scenario &scenario) const
+{
+	scenario.desc = desc;
+
+	generateLayout(desc, scenario.instances);
+	generateLights(desc, scenario.instances, scenario.lights);
+}
+
+/// <summary>
+/// Generates model matrices of scene mesh instances. The first instance always
+/// keeps identity transform (occluders are taken from mesh in object space).
+/// </summary>
+/// <param name="desc">scenario parameters.</param>
+/// <param name="instances">output model matrices.</param>
+void ScenarioGenerator::generateLayout(const ScenarioDesc &desc, std::vector<glm::mat4> &instances) const
+{
+	ScenarioRandom random(desc.seed ^ LAYOUT_SEED_SALT);
+	unsigned int size = desc.layout == SL_Single ? 1 : std::max(desc.layoutSize, 1u);
+
+	glm::vec3 extent = m_meshBounds.max - m_meshBounds.min;
+	glm::vec3 center = (m_meshBounds.min + m_meshBounds.max) * 0.5f;
+
+	instances.clear();
+
+	for (unsigned int z = 0; z < size; z++)
+	{
+		for (unsigned int x = 0; x < size; x++)
+		{
+			if (desc.layout != SL_CityGrid)
+			{
+				instances.push_back(glm::translate(glm::mat4(), glm::vec3(x * extent.x, 0.0f, z * extent.z)));
+				continue;
+			}
+
+			//square blocks, so rotated block fits too
+			float block = std::max(extent.x, extent.z) * (1.0f + CITY_STREET);
+			unsigned int rotation = random.index(4);
+			bool empty = random.uniform(0.0f, 1.0f) < CITY_EMPTY;
+
+			if (x == 0 && z == 0)
+			{
+				instances.push_back(glm::mat4());
+				continue;
+			}
+
+			if (empty)
+			{
+				continue;
+			}
+
+			glm::mat4 transform = glm::translate(glm::mat4(), glm::vec3(x * block, 0.0f, z * block) + center);
+			transform = glm::rotate(transform, 90.0f * rotation, glm::vec3(0.0f, 1.0f, 0.0f));
+			transform = glm::translate(transform, -center);
+
+			instances.push_back(transform);
+		}
+	}
+}
+
+/// <summary>
+/// Returns bounds enclosing all instances of scene mesh.
+/// </summary>
+/// <param name="instances">model matrices.</param>
+/// <returns>world space bounds</returns>
+AABB ScenarioGenerator::getSceneBounds(const std::vector<glm::mat4> &instances) const
+{
+	AABB bounds = emptyAABB();
+
+	for (unsigned int i = 0; i < instances.size(); i++)
+	{
+		expandAABB(bounds, transformAABB(m_meshBounds, instances[i]));
+	}
+
+	return isValidAABB(bounds) ? bounds : m_meshBounds;
+}
+
+/// <summary>
+/// Generates lights of given distribution over all instances.
+/// </summary>
+/// <param name="desc">scenario parameters.</param>
+/// <param name="instances">model matrices of scene mesh.</param>
+/// <param name="lights">output lights.</param>
+void ScenarioGenerator::generateLights(const ScenarioDesc &desc, const std::vector<glm::mat4> &instances, Lights &lights) const
+{
+	ScenarioRandom random(desc.seed);
+	AABB bounds = getSceneBounds(instances);
+	glm::vec3 extent = bounds.max - bounds.min;
+
+	LightDistribution distribution = desc.distribution;
+
+	if (distribution == LD_Surface && (m_surface.empty() || instances.empty()))
+	{
+		distribution = LD_Uniform;
+	}
+
+	//hotspots of clustered distribution
+	std::vector<glm::vec3> hotspots;
+
+	if (distribution == LD_Clustered)
+	{
+		hotspots.resize(std::min(std::max(desc.lightCount / CLUSTER_LIGHTS, 1u), (unsigned int)CLUSTER_MAX));
+
+		for (unsigned int h = 0; h < hotspots.size(); h++)
+		{
+			hotspots[h] = random.point(bounds);
+		}
+	}
+
+	//corridor spans the longest horizontal axis through the scene center
+	AABB corridor = bounds;
+
+	if (distribution == LD_Corridor)
+	{
+		unsigned int across = extent.x >= extent.z ? 2 : 0;
+		float middle = (bounds.min[across] + bounds.max[across]) * 0.5f;
+
+		corridor.min[across] = middle - extent[across] * CORRIDOR_WIDTH * 0.5f;
+		corridor.max[across] = middle + extent[across] * CORRIDOR_WIDTH * 0.5f;
+		corridor.max.y = bounds.min.y + extent.y * CORRIDOR_HEIGHT;
+	}
+
+	float sigma = glm::length(extent) * CLUSTER_SIGMA;
+
+	lights.resize(desc.lightCount);
+
+	for (unsigned int i = 0; i < lights.size(); i++)
+	{
+		Light &light = lights[i];
+
+		//colors are quantized as in scenario file, so saved scenario matches generated one
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			light.color[c] = (unsigned char)random.index(256) / 255.0f;
+		}
+
+		light.radius = random.uniform(desc.radiusMin, desc.radiusMax);
+
+		switch (distribution)
+		{
+			case LD_Clustered:
+			{
+				const glm::vec3 &hotspot = hotspots[random.index((unsigned int)hotspots.size())];
+				glm::vec3 offset;
+
+				//components drawn in fixed order (argument evaluation order is unspecified)
+				for (unsigned int c = 0; c < 3; c++)
+				{
+					offset[c] = random.normal(sigma);
+				}
+
+				light.position = glm::clamp(hotspot + offset, bounds.min, bounds.max);
+			}
+			break;
+
+			case LD_Surface:
+			{
+				const SurfaceSample &sample = m_surface[random.index((unsigned int)m_surface.size())];
+				const glm::mat4 &transform = instances[random.index((unsigned int)instances.size())];
+
+				glm::vec3 normal = glm::normalize(glm::mat3(transform) * sample.normal);
+				light.position = glm::vec3(transform * glm::vec4(sample.position, 1.0f)) + normal * light.radius * SURFACE_OFFSET;
+			}
+			break;
+
+			case LD_Corridor:
+				light.position = random.point(corridor);
+				break;
+
+			default:
+				light.position = random.point(bounds);
+				break;
+		}
+	}
+}
+
+/// <summary>
+/// Saves scenario to binary file.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <param name="scenario">scenario.</param>
+/// <returns>FALSE if file can not be written.</returns>
+bool ScenarioGenerator::save(const std::string &filename, const Scenario &scenario)
+{
+	FILE *f = fopen(filename.c_str(), "wb");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	ScenarioHeader header;
+	memcpy(header.magic, SCENARIO_MAGIC, 4);
+	header.version = SCENARIO_VERSION;
+	header.seed = scenario.desc.seed;
+	header.distribution = scenario.desc.distribution;
+	header.lightCount = (unsigned int)scenario.lights.size();
+	header.radiusMin = scenario.desc.radiusMin;
+	header.radiusMax = scenario.desc.radiusMax;
+	header.layout = scenario.desc.layout;
+	header.layoutSize = scenario.desc.layoutSize;
+	header.instanceCount = (unsigned int)scenario.instances.size();
+
+	bool rc = fwrite(&header, sizeof(header), 1, f) == 1;
+
+	for (unsigned int i = 0; i < scenario.lights.size() && rc; i++)
+	{
+		const Light &light = scenario.lights[i];
+		LightRecord record;
+
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			record.position[c] = light.position[c];
+			record.color[c] = (unsigned char)(glm::clamp(light.color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+
+		record.radius = light.radius;
+		record.color[3] = 0;
+
+		rc = fwrite(&record, sizeof(record), 1, f) == 1;
+	}
+
+	//affine part of matrices (4 columns x 3 rows)
+	for (unsigned int i = 0; i < scenario.instances.size() && rc; i++)
+	{
+		float columns[12];
+
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			for (unsigned int r = 0; r < 3; r++)
+			{
+				columns[c * 3 + r] = scenario.instances[i][c][r];
+			}
+		}
+
+		rc = fwrite(columns, sizeof(columns), 1, f) == 1;
+	}
+
+	fclose(f);
+
+	return rc;
+}
+
+/// <summary>
+/// Loads scenario from binary file.
+/// </summary>
+/// <param name="filename">scenario file.</param>
+/// <param name="scenario">output scenario.</param>
+/// <returns>FALSE if file can not be read or is not valid scenario.</returns>
+bool ScenarioGenerator::load(const std::string &filename, Scenario &scenario)
+{
+	FILE *f = fopen(filename.c_str(), "rb");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	ScenarioHeader header;
+
+	bool rc = fread(&header, sizeof(header), 1, f) == 1 && memcmp(header.magic, SCENARIO_MAGIC, 4) == 0 &&
+		header.version == SCENARIO_VERSION && header.distribution < LD_Max && header.layout < SL_Max;
+
+	//records must fit into rest of file, corrupted counts would allocate gigabytes otherwise
+	if (rc)
+	{
+		long position = ftell(f);
+		rc = position >= 0 && fseek(f, 0, SEEK_END) == 0;
+
+		long end = rc ? ftell(f) : -1;
+		rc = rc && end >= position && fseek(f, position, SEEK_SET) == 0;
+
+		unsigned long long required = (unsigned long long)header.lightCount * sizeof(LightRecord) +
+			(unsigned long long)header.instanceCount * 12 * sizeof(float);
+
+		rc = rc && required <= (unsigned long long)(end - position);
+	}
+
+	if (rc)
+	{
+		scenario.desc.seed = header.seed;
+		scenario.desc.distribution = (LightDistribution)header.distribution;
+		scenario.desc.lightCount = header.lightCount;
+		scenario.desc.radiusMin = header.radiusMin;
+		scenario.desc.radiusMax = header.radiusMax;
+		scenario.desc.layout = (SceneLayout)header.layout;
+		scenario.desc.layoutSize = header.layoutSize;
+
+		scenario.lights.resize(header.lightCount);
+		scenario.instances.resize(header.instanceCount);
+	}
+
+	for (unsigned int i = 0; rc && i < scenario.lights.size(); i++)
+	{
+		LightRecord record;
+		rc = fread(&record, sizeof(record), 1, f) == 1;
+
+		Light &light = scenario.lights[i];
+
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			light.position[c] = record.position[c];
+			light.color[c] = record.color[c] / 255.0f;
+		}
+
+		light.radius = record.radius;
+	}
+
+	for (unsigned int i = 0; rc && i < scenario.instances.size(); i++)
+	{
+		float columns[12];
+		rc = fread(columns, sizeof(columns), 1, f) == 1;
+
+		glm::mat4 &transform = scenario.instances[i];
+		transform = glm::mat4();
+
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			for (unsigned int r = 0; r < 3; r++)
+			{
+				transform[c][r] = columns[c * 3 + r];
+			}
+		}
+	}
+
+	fclose(f);
+
+	return rc;
+}
+
+/// <summary>
+/// Returns name of light distribution.
+/// </summary>
+/// <param name="distribution">distribution.</param>
+/// <returns>name</returns>
+const char *ScenarioGenerator::getDistributionName(LightDistribution distribution)
+{
+	static const char *names[LD_Max] = { "uniform", "clustered", "surface", "corridor" };
+
+	return distribution < LD_Max ? names[distribution] : "unknown";
+}
+
+/// <summary>
+/// Returns name of scene layout.
+/// </summary>
+/// <param name="layout">layout.</param>
+/// <returns>name</returns>
+const char *ScenarioGenerator::getLayoutName(SceneLayout layout)
+{
+	static const char *names[SL_Max] = { "single", "repeated", "city" };
+
+	return layout < SL_Max ? names[layout] : "unknown";
+}
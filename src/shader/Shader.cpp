@@ -193,6 +193,14 @@ shader shader::readFile(const std::string& file, GLenum type, std::ofstream &log
 
 	insertMacro("MAX_LIGHTS", S_MAX_LIGHTS, version);
 
+#if TEXTURE_ARRAYS
+	insertMacro("TEXTURE_ARRAYS", "1", version);
+#endif
+
+#if TEXTURE_COMPRESSION
+	insertMacro("TEXTURE_COMPRESSION", "1", version);
+#endif
+
 	buffer << version;
 	buffer << temp;
 
@@ -22,12 +22,15 @@ This file represents external texture loader (for mesh textures, ...).
 To load textures, stb_image.c library has been used.
 */
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <string>
 #include <GL\glew.h>
 #include "textures\stb_image.c"
 #include "textures\Texture.h"
+#include "textures\TextureLoader.h"
+#include "textures\TextureStreamer.h"
 
 
 /// <summary>
@@ -35,10 +38,33 @@ To load textures, stb_image.c library has been used.
 /// </summary>
 /// <param name="textureTarget">The texture target.</param>
 /// <param name="filename">The filename.</param>
-Texture::Texture(GLenum textureTarget, const std::string& filename)
+/// <param name="kind">texture usage, decides compressed format.</param>
+Texture::Texture(GLenum textureTarget, const std::string& filename, TextureKind kind)
 {
     m_textureTarget = textureTarget;
+    m_kind          = kind;
     m_filename      = filename;
+    m_textureObj    = 0;
+    m_loader        = NULL;
+    m_loadId        = 0;
+    m_memorySize    = 0;
+    m_streamer      = NULL;
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="Texture"/> class.
+/// </summary>
+Texture::~Texture()
+{
+	if (m_streamer)
+	{
+		m_streamer->remove(this);
+	}
+
+	if (m_textureObj != 0)
+	{
+		glDeleteTextures(1, &m_textureObj);
+	}
 }
 
 /// <summary>
@@ -51,6 +77,20 @@ bool Texture::Load(bool srgb)
 	int x, y, n;
 	int force_channels = 4;
 
+	//cooked (block compressed) image with precomputed mipmaps
+	if (stbi_info(m_filename.c_str(), &x, &y, &n))
+	{
+		CookedImage image;
+		GLenum format = chooseFormat(srgb, n);
+
+		if (TextureCooker::isCompressed(format) && TextureCooker::load(m_filename, format, image))
+		{
+			uploadCooked(image);
+			m_memorySize = TextureCooker::chainSize(format, x, y);
+			return true;
+		}
+	}
+
 	unsigned char* image_data = NULL;
 
 	try
@@ -77,6 +117,8 @@ bool Texture::Load(bool srgb)
 	//generate mipmap
 	glGenerateMipmap(GL_TEXTURE_2D);
 
+	m_memorySize = TextureCooker::chainSize(GL_RGBA8, x, y);
+
 	glTexParameterf(m_textureTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameterf(m_textureTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -93,6 +135,135 @@ bool Texture::Load(bool srgb)
 }
 
 
+/// <summary>
+/// Creates texture object and requests its data from asynchronous loader.
+/// Texture is not usable until isResident() returns TRUE.
+/// </summary>
+/// <param name="srgb">if set to <c>true</c> set color model to SRGB, else RGB.</param>
+/// <param name="loader">asynchronous texture loader.</param>
+/// <returns>TRUE if image file can be read.</returns>
+bool Texture::LoadAsync(bool srgb, TextureLoader &loader)
+{
+	int x, y, n;
+
+	//only header is read here, image is decoded by loader
+	if (!stbi_info(m_filename.c_str(), &x, &y, &n))
+	{
+		return false;
+	}
+
+	glGenTextures(1, &m_textureObj);
+	glBindTexture(m_textureTarget, m_textureObj);
+
+	glTexParameterf(m_textureTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameterf(m_textureTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(m_textureTarget, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(m_textureTarget, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glBindTexture(m_textureTarget, 0);
+
+	GLenum format = chooseFormat(srgb, n);
+
+	m_loader = &loader;
+	m_loadId = loader.request(m_filename, m_textureTarget, m_textureObj, format);
+	m_memorySize = TextureCooker::chainSize(format, x, y);
+
+	return true;
+}
+
+/// <summary>
+/// Chooses internal format, block compressed format by texture usage or
+/// uncompressed format if compression is disabled.
+/// </summary>
+/// <param name="srgb">SRGB color model of uncompressed format.</param>
+/// <param name="components">components count of image.</param>
+/// <returns>internal format</returns>
+GLenum Texture::chooseFormat(bool srgb, int components) const
+{
+	GLenum format = TextureCooker::chooseFormat(m_kind, components);
+
+	if (TextureCooker::isCompressed(format))
+	{
+		return format;
+	}
+
+	return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+}
+
+/// <summary>
+/// Creates texture object from cooked mipmap chain.
+/// </summary>
+/// <param name="image">cooked image.</param>
+void Texture::uploadCooked(const CookedImage &image)
+{
+	glGenTextures(1, &m_textureObj);
+	glBindTexture(m_textureTarget, m_textureObj);
+
+	for (unsigned int l = 0; l < image.levels.size(); l++)
+	{
+		glCompressedTexImage2D(m_textureTarget, l, image.format, std::max(1, image.width >> l), std::max(1, image.height >> l), 0,
+			(GLsizei)image.levels[l].size(), &image.levels[l][0]);
+	}
+
+	glTexParameteri(m_textureTarget, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+	glTexParameterf(m_textureTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameterf(m_textureTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(m_textureTarget, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(m_textureTarget, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glBindTexture(m_textureTarget, 0);
+}
+
+/// <summary>
+/// Creates texture object and hands it over to mipmap streamer. Only coarse
+/// levels are loaded at first, finer levels follow on demand.
+/// </summary>
+/// <param name="srgb">if set to <c>true</c> set color model to SRGB, else RGB.</param>
+/// <param name="streamer">mipmap streamer.</param>
+/// <returns>TRUE if image file can be read.</returns>
+bool Texture::LoadStreamed(bool srgb, TextureStreamer &streamer)
+{
+	int x, y, n;
+
+	if (!stbi_info(m_filename.c_str(), &x, &y, &n))
+	{
+		return false;
+	}
+
+	glGenTextures(1, &m_textureObj);
+	glBindTexture(m_textureTarget, m_textureObj);
+
+	glTexParameterf(m_textureTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameterf(m_textureTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(m_textureTarget, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(m_textureTarget, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glBindTexture(m_textureTarget, 0);
+
+	GLenum format = chooseFormat(srgb, n);
+
+	m_streamer = &streamer;
+	m_streamer->add(this, m_textureObj, m_filename, format, x, y);
+	m_memorySize = TextureCooker::chainSize(format, x, y);
+
+	return true;
+}
+
+/// <summary>
+/// Determines whether texture data has been uploaded (coarse levels of
+/// streamed texture).
+/// </summary>
+/// <returns>TRUE if texture can be sampled.</returns>
+bool Texture::isResident() const
+{
+	if (m_streamer)
+	{
+		return m_streamer->isResident(this);
+	}
+
+	return m_loader == NULL || m_loader->isResident(m_loadId);
+}
+
 /// <summary>
 /// Binds texture to specified texture unit.
 /// </summary>
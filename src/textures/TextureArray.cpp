@@ -0,0 +1,367 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements texture array packer. Layers are uploaded directly from
+decoded images, so only single decoded image is kept in memory during build.
+*/
+
+#include <algorithm>
+#include <stdio.h>
+
+#define STBI_HEADER_FILE_ONLY
+#include "textures\stb_image.c"
+#include "textures\TextureArray.h"
+#include "textures\TextureLoader.h"
+#include "textures\TextureCooker.h"
+#include "textures\TextureRegistry.h"
+
+/// <summary>
+/// Returns printable name of layer format.
+/// </summary>
+/// <param name="format">internal format.</param>
+/// <returns>format name</returns>
+static const char *formatName(GLenum format)
+{
+	switch (format)
+	{
+		case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT: return "BC1 SRGB";
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: return "BC3 SRGB";
+		case GL_COMPRESSED_RG_RGTC2: return "BC5";
+		case GL_SRGB8_ALPHA8: return "SRGB";
+		default: return "RGB";
+	}
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="TextureArrayPacker"/> class.
+/// </summary>
+TextureArrayPacker::TextureArrayPacker() : m_loader(NULL)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="TextureArrayPacker"/> class.
+/// </summary>
+TextureArrayPacker::~TextureArrayPacker()
+{
+	clear();
+}
+
+/// <summary>
+/// Deletes array objects and registered images.
+/// </summary>
+void TextureArrayPacker::clear()
+{
+	for (unsigned int i = 0; i < m_arrays.size(); i++)
+	{
+		if (m_arrays[i].object != 0)
+		{
+			glDeleteTextures(1, &m_arrays[i].object);
+		}
+	}
+
+	m_arrays.clear();
+	m_entries.clear();
+	m_loader = NULL;
+}
+
+/// <summary>
+/// Finds array for given size and format, creates new one if there is none.
+/// </summary>
+/// <param name="width">layer width.</param>
+/// <param name="height">layer height.</param>
+/// <param name="format">internal format.</param>
+/// <returns>array index</returns>
+int TextureArrayPacker::findGroup(int width, int height, GLenum format)
+{
+	for (unsigned int i = 0; i < m_arrays.size(); i++)
+	{
+		if (m_arrays[i].width == width && m_arrays[i].height == height && m_arrays[i].format == format)
+		{
+			return (int)i;
+		}
+	}
+
+	Group group = { width, height, format, 0, 0, 1, false };
+	m_arrays.push_back(group);
+
+	return (int)m_arrays.size() - 1;
+}
+
+/// <summary>
+/// Registers image file, only image header is read at this point. Image
+/// already registered with the same format is not added again.
+/// </summary>
+/// <param name="filename">image file.</param>
+/// <param name="kind">texture usage, decides layer format.</param>
+/// <returns>image id, -1 if image can not be read</returns>
+int TextureArrayPacker::addImage(const std::string &filename, TextureKind kind)
+{
+	Entry entry;
+	int components;
+
+	if (!stbi_info(filename.c_str(), &entry.width, &entry.height, &components))
+	{
+		return -1;
+	}
+
+	entry.filename = TextureRegistry::canonicalPath(filename);
+	entry.color = glm::vec4(1.0f);
+	entry.format = TextureCooker::chooseFormat(kind, components);
+
+	//image shared by several materials occupies single layer
+	for (unsigned int i = 0; i < m_entries.size(); i++)
+	{
+		if (m_entries[i].filename == entry.filename && m_entries[i].format == entry.format)
+		{
+			TextureRegistry::shared().recordDuplicate(TextureCooker::chainSize(entry.format, entry.width, entry.height));
+			return (int)i;
+		}
+	}
+	entry.slot.array = findGroup(entry.width, entry.height, entry.format);
+	entry.slot.layer = (int)m_arrays[entry.slot.array].layers++;
+	entry.loadId = -1;
+
+	m_entries.push_back(entry);
+	TextureRegistry::shared().recordLoad(TextureCooker::chainSize(entry.format, entry.width, entry.height));
+
+	return (int)m_entries.size() - 1;
+}
+
+/// <summary>
+/// Registers single pixel layer of solid color (default textures).
+/// </summary>
+/// <param name="color">linear RGBA color.</param>
+/// <returns>image id</returns>
+int TextureArrayPacker::addColor(const glm::vec4 &color)
+{
+	Entry entry;
+
+	entry.color = color;
+	entry.width = 1;
+	entry.height = 1;
+	entry.format = GL_RGBA8;
+	entry.slot.array = findGroup(1, 1, GL_RGBA8);
+	entry.slot.layer = (int)m_arrays[entry.slot.array].layers++;
+	entry.loadId = -1;
+
+	m_entries.push_back(entry);
+
+	return (int)m_entries.size() - 1;
+}
+
+/// <summary>
+/// Returns array and layer of registered image.
+/// </summary>
+/// <param name="id">image id.</param>
+/// <returns>slot, array = -1 for invalid id</returns>
+TextureSlot TextureArrayPacker::getSlot(int id) const
+{
+	if (id < 0 || id >= (int)m_entries.size())
+	{
+		TextureSlot none = { -1, 0 };
+		return none;
+	}
+
+	return m_entries[id].slot;
+}
+
+/// <summary>
+/// Determines whether layer of registered image has been uploaded.
+/// </summary>
+/// <param name="id">image id.</param>
+/// <returns>TRUE if layer can be sampled.</returns>
+bool TextureArrayPacker::isResident(int id) const
+{
+	if (id < 0 || id >= (int)m_entries.size())
+	{
+		return false;
+	}
+
+	return m_entries[id].loadId < 0 || m_loader->isResident(m_entries[id].loadId);
+}
+
+/// <summary>
+/// Allocates arrays with full mipmap chains and uploads all registered images.
+/// With asynchronous loader only requests are issued, arrays are sampled from
+/// base level until all their layers arrive (see update()).
+/// </summary>
+/// <param name="loader">asynchronous loader, NULL = synchronous upload.</param>
+/// <returns>TRUE if all images have been uploaded (or requested).</returns>
+bool TextureArrayPacker::build(TextureLoader *loader)
+{
+	bool rc = true;
+
+	m_loader = loader;
+
+	for (unsigned int i = 0; i < m_arrays.size(); i++)
+	{
+		Group &group = m_arrays[i];
+
+		glGenTextures(1, &group.object);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, group.object);
+
+		group.levels = 1;
+		while ((std::max(group.width, group.height) >> group.levels) > 0)
+		{
+			group.levels++;
+		}
+
+		for (int l = 0; l < group.levels; l++)
+		{
+			int width = std::max(1, group.width >> l), height = std::max(1, group.height >> l);
+
+			if (TextureCooker::isCompressed(group.format))
+			{
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, l, group.format, width, height, group.layers, 0,
+					TextureCooker::levelSize(group.format, width, height) * group.layers, NULL);
+			}
+			else
+			{
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, l, group.format, width, height, group.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			}
+		}
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		//mipmaps are not valid until all layers are uploaded
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+	}
+
+	//upload layers, decoded image is released right after upload
+	for (unsigned int i = 0; i < m_entries.size(); i++)
+	{
+		Entry &entry = m_entries[i];
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[entry.slot.array].object);
+
+		if (entry.filename.empty())
+		{
+			unsigned char pixel[4];
+
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				pixel[c] = (unsigned char)(glm::clamp(entry.color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, entry.slot.layer, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+			continue;
+		}
+
+		if (loader)
+		{
+			entry.loadId = (int)loader->request(entry.filename, GL_TEXTURE_2D_ARRAY, m_arrays[entry.slot.array].object, entry.format, entry.slot.layer);
+			continue;
+		}
+
+		if (TextureCooker::isCompressed(entry.format))
+		{
+			CookedImage image;
+
+			if (!TextureCooker::load(entry.filename, entry.format, image) || image.width != entry.width || image.height != entry.height)
+			{
+				printf("Error packing texture '%s'\n", entry.filename.c_str());
+				rc = false;
+				continue;
+			}
+
+			for (unsigned int l = 0; l < image.levels.size(); l++)
+			{
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, 0, 0, entry.slot.layer, std::max(1, image.width >> l), std::max(1, image.height >> l), 1,
+					image.format, (GLsizei)image.levels[l].size(), &image.levels[l][0]);
+			}
+
+			continue;
+		}
+
+		int x, y, n;
+		unsigned char *image_data = stbi_load(entry.filename.c_str(), &x, &y, &n, 4);
+
+		if (!image_data || x != entry.width || y != entry.height)
+		{
+			printf("Error packing texture '%s'\n", entry.filename.c_str());
+			stbi_image_free(image_data);
+			rc = false;
+			continue;
+		}
+
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, entry.slot.layer, x, y, 1, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
+
+		stbi_image_free(image_data);
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	for (unsigned int i = 0; i < m_arrays.size(); i++)
+	{
+		printf("Texture array %d: %dx%d %s, %d layers\n", i, m_arrays[i].width, m_arrays[i].height,
+			formatName(m_arrays[i].format), m_arrays[i].layers);
+	}
+
+	update();
+
+	return rc;
+}
+
+/// <summary>
+/// Generates mipmaps of arrays whose layers have all been uploaded and enables
+/// sampling of whole mipmap chain.
+/// Call once per frame while asynchronous loading is in progress.
+/// </summary>
+void TextureArrayPacker::update()
+{
+	std::vector<unsigned char> waiting(m_arrays.size(), 0);
+
+	for (unsigned int i = 0; i < m_entries.size(); i++)
+	{
+		const Entry &entry = m_entries[i];
+
+		if (entry.loadId >= 0 && m_loader->getState(entry.loadId) == TextureLoader::PENDING)
+		{
+			waiting[entry.slot.array] = 1;
+		}
+	}
+
+	for (unsigned int i = 0; i < m_arrays.size(); i++)
+	{
+		Group &group = m_arrays[i];
+
+		if (group.complete || waiting[i] || group.object == 0)
+		{
+			continue;
+		}
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, group.object);
+
+		//compressed layers are uploaded with cooked mipmaps
+		if (!TextureCooker::isCompressed(group.format))
+		{
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		}
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, group.levels - 1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		group.complete = true;
+	}
+}
@@ -0,0 +1,646 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements texture cooker. Mipmaps are built by 2x2 box filter
+(two output texels per SSE2 iteration), blocks are compressed by bounding box
+endpoint fit with inset (J.M.P. van Waveren, Real-Time DXT Compression) and
+nearest palette entry search. Cooked chains are cached in "<source>.eclt"
+files, cache is rebuilt whenever source image is newer.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <emmintrin.h>
+
+#define STBI_HEADER_FILE_ONLY
+#include "textures\stb_image.c"
+#include "textures\TextureCooker.h"
+#include "configuration\Config.h"
+
+//cache file header
+#define COOKED_MAGIC	"ECLT"
+#define COOKED_VERSION	1
+
+typedef struct
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int format;
+	unsigned int width;
+	unsigned int height;
+	unsigned int levels;
+} CookedHeader;
+
+//serializes cache file access of concurrent loads of the same image
+static std::mutex cacheMutex;
+
+/// <summary>
+/// Chooses GPU format for texture of given usage.
+/// </summary>
+/// <param name="kind">texture usage.</param>
+/// <param name="components">components count of source image.</param>
+/// <returns>internal format</returns>
+GLenum TextureCooker::chooseFormat(TextureKind kind, int components)
+{
+#if TEXTURE_COMPRESSION
+	if (kind == TEXTURE_KIND_NORMAL)
+	{
+		return GL_COMPRESSED_RG_RGTC2;
+	}
+
+	//images with alpha channel need BC3
+	return (components == 2 || components == 4) ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+#else
+	return kind == TEXTURE_KIND_NORMAL ? GL_RGBA8 : GL_SRGB8_ALPHA8;
+#endif
+}
+
+/// <summary>
+/// Determines whether format is block compressed format produced by cooker.
+/// </summary>
+/// <param name="format">internal format.</param>
+/// <returns>TRUE for BC1, BC3 and BC5 formats.</returns>
+bool TextureCooker::isCompressed(GLenum format)
+{
+	return format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+		   format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ||
+		   format == GL_COMPRESSED_RG_RGTC2;
+}
+
+/// <summary>
+/// Computes size of single mipmap level.
+/// </summary>
+/// <param name="format">internal format.</param>
+/// <param name="width">level width.</param>
+/// <param name="height">level height.</param>
+/// <returns>size in bytes</returns>
+unsigned int TextureCooker::levelSize(GLenum format, int width, int height)
+{
+	if (!isCompressed(format))
+	{
+		return width * height * 4;
+	}
+
+	unsigned int blockBytes = (format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ? 8 : 16;
+
+	return ((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+}
+
+/// <summary>
+/// Computes count of mipmap levels down to 1x1.
+/// </summary>
+/// <param name="width">base width.</param>
+/// <param name="height">base height.</param>
+/// <returns>levels count</returns>
+int TextureCooker::levelCount(int width, int height)
+{
+	int levels = 1;
+
+	while ((std::max(width, height) >> levels) > 0)
+	{
+		levels++;
+	}
+
+	return levels;
+}
+
+/// <summary>
+/// Computes size of whole mipmap chain.
+/// </summary>
+/// <param name="format">internal format.</param>
+/// <param name="width">base width.</param>
+/// <param name="height">base height.</param>
+/// <returns>size in bytes</returns>
+size_t TextureCooker::chainSize(GLenum format, int width, int height)
+{
+	size_t size = 0;
+
+	for (int l = 0; l < levelCount(width, height); l++)
+	{
+		size += levelSize(format, std::max(1, width >> l), std::max(1, height >> l));
+	}
+
+	return size;
+}
+
+/// <summary>
+/// Returns cooked mipmap chain of image, cooks it and stores to cache if
+/// cache file is missing or outdated. Uncompressed formats get RGBA8 chain
+/// which is not cached.
+/// </summary>
+/// <param name="filename">source image.</param>
+/// <param name="format">internal format.</param>
+/// <param name="image">output chain.</param>
+/// <param name="firstLevel">finest level needed, finer levels are not read.</param>
+/// <returns>FALSE if source image can not be decoded.</returns>
+bool TextureCooker::load(const std::string &filename, GLenum format, CookedImage &image, int firstLevel)
+{
+	bool compressed = isCompressed(format);
+
+	if (compressed && readCache(filename, format, image, firstLevel))
+	{
+		return true;
+	}
+
+	int width, height, n;
+	unsigned char *data = stbi_load(filename.c_str(), &width, &height, &n, 4);
+
+	if (!data)
+	{
+		return false;
+	}
+
+	std::vector<std::vector<unsigned char> > mipmaps;
+	generateMipmaps(data, width, height, format == GL_COMPRESSED_RG_RGTC2, mipmaps);
+
+	stbi_image_free(data);
+
+	image.format = format;
+	image.width = width;
+	image.height = height;
+	image.levels.resize(mipmaps.size());
+
+	for (unsigned int l = 0; l < mipmaps.size(); l++)
+	{
+		if (compressed)
+		{
+			compress(&mipmaps[l][0], std::max(1, width >> l), std::max(1, height >> l), format, image.levels[l]);
+		}
+		else
+		{
+			image.levels[l].swap(mipmaps[l]);
+		}
+	}
+
+	if (compressed && !writeCache(filename, image))
+	{
+		printf("Could not write texture cache for '%s'\n", filename.c_str());
+	}
+
+	for (int l = 0; l < firstLevel && l < (int)image.levels.size(); l++)
+	{
+		std::vector<unsigned char>().swap(image.levels[l]);
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Builds mipmap chain of RGBA8 image down to 1x1 by 2x2 box filter. Colors
+/// are averaged in stored (gamma) space, normals are renormalized.
+/// </summary>
+/// <param name="rgba">base level.</param>
+/// <param name="width">base width.</param>
+/// <param name="height">base height.</param>
+/// <param name="normalMap">if set to <c>true</c> texels are treated as unit vectors.</param>
+/// <param name="levels">output levels, including base level copy.</param>
+void TextureCooker::generateMipmaps(const unsigned char *rgba, int width, int height, bool normalMap, std::vector<std::vector<unsigned char> > &levels)
+{
+	levels.resize(levelCount(width, height));
+	levels[0].assign(rgba, rgba + width * height * 4);
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(2);
+
+	for (unsigned int l = 1; l < levels.size(); l++)
+	{
+		int sw = std::max(1, width >> (l - 1)), sh = std::max(1, height >> (l - 1));
+		int dw = std::max(1, width >> l), dh = std::max(1, height >> l);
+
+		const unsigned char *src = &levels[l - 1][0];
+		levels[l].resize(dw * dh * 4);
+		unsigned char *dst = &levels[l][0];
+
+		for (int y = 0; y < dh; y++)
+		{
+			const unsigned char *row0 = src + std::min(2 * y, sh - 1) * sw * 4;
+			const unsigned char *row1 = src + std::min(2 * y + 1, sh - 1) * sw * 4;
+			unsigned char *out = dst + y * dw * 4;
+
+			int x = 0;
+
+			//2 output texels from 4x2 source texels
+			for (; x + 1 < dw && 2 * x + 3 < sw; x += 2)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i*)(row0 + 2 * x * 4));
+				__m128i b = _mm_loadu_si128((const __m128i*)(row1 + 2 * x * 4));
+
+				__m128i sumLo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i sumHi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+				__m128i sum01 = _mm_add_epi16(sumLo, _mm_srli_si128(sumLo, 8));
+				__m128i sum23 = _mm_add_epi16(sumHi, _mm_srli_si128(sumHi, 8));
+
+				__m128i average = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum01, sum23), round), 2);
+
+				_mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(average, average));
+			}
+
+			for (; x < dw; x++)
+			{
+				int x0 = std::min(2 * x, sw - 1) * 4, x1 = std::min(2 * x + 1, sw - 1) * 4;
+
+				for (int c = 0; c < 4; c++)
+				{
+					out[x * 4 + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+				}
+			}
+		}
+
+		if (normalMap)
+		{
+			for (int i = 0; i < dw * dh; i++)
+			{
+				float n[3];
+				for (int c = 0; c < 3; c++)
+				{
+					n[c] = dst[i * 4 + c] / 127.5f - 1.0f;
+				}
+
+				float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+				if (length > 1e-4f)
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						dst[i * 4 + c] = (unsigned char)std::min(255.0f, std::max(0.0f, (n[c] / length + 1.0f) * 127.5f + 0.5f));
+					}
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Compresses RGBA8 image to blocks of given format. Blocks crossing image
+/// border repeat edge texels.
+/// </summary>
+/// <param name="rgba">image.</param>
+/// <param name="width">width.</param>
+/// <param name="height">height.</param>
+/// <param name="format">compressed format.</param>
+/// <param name="blocks">output blocks.</param>
+void TextureCooker::compress(const unsigned char *rgba, int width, int height, GLenum format, std::vector<unsigned char> &blocks)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	unsigned int blockBytes = levelSize(format, 4, 4);
+
+	blocks.resize(levelSize(format, width, height));
+
+	unsigned char block[64];
+
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			for (int y = 0; y < 4; y++)
+			{
+				for (int x = 0; x < 4; x++)
+				{
+					int sx = std::min(bx * 4 + x, width - 1), sy = std::min(by * 4 + y, height - 1);
+					memcpy(block + (y * 4 + x) * 4, rgba + (sy * width + sx) * 4, 4);
+				}
+			}
+
+			unsigned char *out = &blocks[(by * blocksX + bx) * blockBytes];
+
+			if (format == GL_COMPRESSED_RG_RGTC2)
+			{
+				compressBlockBC5(block, out);
+			}
+			else if (blockBytes == 16)
+			{
+				compressBlockBC3(block, out);
+			}
+			else
+			{
+				compressBlockBC1(block, out);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Compresses 4x4 RGBA block to BC1 (4 color mode).
+/// </summary>
+/// <param name="block">16 RGBA texels.</param>
+/// <param name="out">8 bytes of block.</param>
+void TextureCooker::compressBlockBC1(const unsigned char *block, unsigned char *out)
+{
+	int minC[3] = { 255, 255, 255 }, maxC[3] = { 0, 0, 0 };
+	int mean[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			minC[c] = std::min(minC[c], (int)block[i * 4 + c]);
+			maxC[c] = std::max(maxC[c], (int)block[i * 4 + c]);
+			mean[c] += block[i * 4 + c];
+		}
+	}
+
+	//pick diagonal of bounding box following correlation of red and blue with green
+	int covRG = 0, covBG = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		int g = block[i * 4 + 1] * 16 - mean[1];
+		covRG += (block[i * 4] * 16 - mean[0]) * g;
+		covBG += (block[i * 4 + 2] * 16 - mean[2]) * g;
+	}
+
+	if (covRG < 0)
+	{
+		std::swap(minC[0], maxC[0]);
+	}
+
+	if (covBG < 0)
+	{
+		std::swap(minC[2], maxC[2]);
+	}
+
+	//inset box by 1/16 of its size to reduce error of endpoints
+	unsigned short endpoints[2];
+	int colors[4][3];
+
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (maxC[c] - minC[c]) / 16;
+		maxC[c] -= inset;
+		minC[c] += inset;
+	}
+
+	endpoints[0] = (unsigned short)(((maxC[0] >> 3) << 11) | ((maxC[1] >> 2) << 5) | (maxC[2] >> 3));
+	endpoints[1] = (unsigned short)(((minC[0] >> 3) << 11) | ((minC[1] >> 2) << 5) | (minC[2] >> 3));
+
+	//4 color mode requires c0 > c1
+	if (endpoints[0] < endpoints[1])
+	{
+		std::swap(endpoints[0], endpoints[1]);
+	}
+
+	for (int e = 0; e < 2; e++)
+	{
+		int r = (endpoints[e] >> 11) & 31, g = (endpoints[e] >> 5) & 63, b = endpoints[e] & 31;
+
+		colors[e][0] = (r << 3) | (r >> 2);
+		colors[e][1] = (g << 2) | (g >> 4);
+		colors[e][2] = (b << 3) | (b >> 2);
+	}
+
+	for (int c = 0; c < 3; c++)
+	{
+		colors[2][c] = (2 * colors[0][c] + colors[1][c]) / 3;
+		colors[3][c] = (colors[0][c] + 2 * colors[1][c]) / 3;
+	}
+
+	unsigned int indices = 0;
+
+	if (endpoints[0] != endpoints[1])
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0, bestDistance = INT_MAX;
+
+			for (int p = 0; p < 4; p++)
+			{
+				int dr = block[i * 4] - colors[p][0], dg = block[i * 4 + 1] - colors[p][1], db = block[i * 4 + 2] - colors[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+
+			indices |= (unsigned int)best << (i * 2);
+		}
+	}
+
+	out[0] = (unsigned char)(endpoints[0] & 0xff);
+	out[1] = (unsigned char)(endpoints[0] >> 8);
+	out[2] = (unsigned char)(endpoints[1] & 0xff);
+	out[3] = (unsigned char)(endpoints[1] >> 8);
+
+	for (int b = 0; b < 4; b++)
+	{
+		out[4 + b] = (unsigned char)(indices >> (b * 8));
+	}
+}
+
+/// <summary>
+/// Compresses single channel of 4x4 block to BC4 (8 value mode).
+/// </summary>
+/// <param name="block">16 RGBA texels.</param>
+/// <param name="channel">compressed channel.</param>
+/// <param name="out">8 bytes of block.</param>
+void TextureCooker::compressBlockBC4(const unsigned char *block, unsigned int channel, unsigned char *out)
+{
+	int minV = 255, maxV = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		minV = std::min(minV, (int)block[i * 4 + channel]);
+		maxV = std::max(maxV, (int)block[i * 4 + channel]);
+	}
+
+	int palette[8];
+	palette[0] = maxV;
+	palette[1] = minV;
+
+	for (int k = 1; k < 7; k++)
+	{
+		palette[k + 1] = ((7 - k) * maxV + k * minV) / 7;
+	}
+
+	unsigned long long indices = 0;
+
+	if (maxV != minV)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int value = block[i * 4 + channel];
+			int best = 0, bestDistance = INT_MAX;
+
+			for (int p = 0; p < 8; p++)
+			{
+				int distance = abs(value - palette[p]);
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+
+			indices |= (unsigned long long)best << (i * 3);
+		}
+	}
+
+	out[0] = (unsigned char)maxV;
+	out[1] = (unsigned char)minV;
+
+	for (int b = 0; b < 6; b++)
+	{
+		out[2 + b] = (unsigned char)(indices >> (b * 8));
+	}
+}
+
+/// <summary>
+/// Compresses 4x4 RGBA block to BC3 (BC4 alpha + BC1 color).
+/// </summary>
+/// <param name="block">16 RGBA texels.</param>
+/// <param name="out">16 bytes of block.</param>
+void TextureCooker::compressBlockBC3(const unsigned char *block, unsigned char *out)
+{
+	compressBlockBC4(block, 3, out);
+	compressBlockBC1(block, out + 8);
+}
+
+/// <summary>
+/// Compresses red and green channel of 4x4 block to BC5 (two BC4 blocks).
+/// </summary>
+/// <param name="block">16 RGBA texels.</param>
+/// <param name="out">16 bytes of block.</param>
+void TextureCooker::compressBlockBC5(const unsigned char *block, unsigned char *out)
+{
+	compressBlockBC4(block, 0, out);
+	compressBlockBC4(block, 1, out + 8);
+}
+
+/// <summary>
+/// Returns path of cache file of image.
+/// </summary>
+/// <param name="filename">source image.</param>
+/// <returns>cache file path</returns>
+std::string TextureCooker::cachePath(const std::string &filename)
+{
+	return filename + ".eclt";
+}
+
+/// <summary>
+/// Reads cooked image from cache, cache is valid if it is newer than source
+/// image and stores requested format.
+/// </summary>
+/// <param name="filename">source image.</param>
+/// <param name="format">requested format.</param>
+/// <param name="image">output chain.</param>
+/// <param name="firstLevel">finest level needed, finer levels are skipped.</param>
+/// <returns>TRUE if valid cache entry exists.</returns>
+bool TextureCooker::readCache(const std::string &filename, GLenum format, CookedImage &image, int firstLevel)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	std::string path = cachePath(filename);
+	struct stat sourceInfo, cacheInfo;
+
+	if (stat(filename.c_str(), &sourceInfo) != 0 || stat(path.c_str(), &cacheInfo) != 0 || cacheInfo.st_mtime < sourceInfo.st_mtime)
+	{
+		return false;
+	}
+
+	FILE *f = fopen(path.c_str(), "rb");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	CookedHeader header;
+	bool valid = fread(&header, sizeof(header), 1, f) == 1 && memcmp(header.magic, COOKED_MAGIC, 4) == 0 &&
+				 header.version == COOKED_VERSION && header.format == format &&
+				 header.levels == (unsigned int)levelCount(header.width, header.height);
+
+	if (valid)
+	{
+		image.format = format;
+		image.width = header.width;
+		image.height = header.height;
+		image.levels.resize(header.levels);
+
+		for (unsigned int l = 0; l < header.levels && valid; l++)
+		{
+			unsigned int size;
+			valid = fread(&size, sizeof(size), 1, f) == 1 && size == levelSize(format, std::max(1, image.width >> l), std::max(1, image.height >> l));
+
+			if (valid && (int)l < firstLevel)
+			{
+				image.levels[l].clear();
+				valid = fseek(f, size, SEEK_CUR) == 0;
+			}
+			else if (valid)
+			{
+				image.levels[l].resize(size);
+				valid = fread(&image.levels[l][0], 1, size, f) == size;
+			}
+		}
+	}
+
+	fclose(f);
+
+	return valid;
+}
+
+/// <summary>
+/// Writes cooked image to cache file.
+/// </summary>
+/// <param name="filename">source image.</param>
+/// <param name="image">cooked chain.</param>
+/// <returns>TRUE on success.</returns>
+bool TextureCooker::writeCache(const std::string &filename, const CookedImage &image)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	FILE *f = fopen(cachePath(filename).c_str(), "wb");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	CookedHeader header;
+	memcpy(header.magic, COOKED_MAGIC, 4);
+	header.version = COOKED_VERSION;
+	header.format = image.format;
+	header.width = image.width;
+	header.height = image.height;
+	header.levels = (unsigned int)image.levels.size();
+
+	bool rc = fwrite(&header, sizeof(header), 1, f) == 1;
+
+	for (unsigned int l = 0; l < image.levels.size() && rc; l++)
+	{
+		unsigned int size = (unsigned int)image.levels[l].size();
+
+		rc = fwrite(&size, sizeof(size), 1, f) == 1 && fwrite(&image.levels[l][0], 1, size, f) == size;
+	}
+
+	fclose(f);
+
+	return rc;
+}
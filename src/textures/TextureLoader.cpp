@@ -0,0 +1,406 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements asynchronous texture loader. Decode threads block when
+queue of decoded images is full, so at most queueCapacity decoded images
+(plus one per thread) exist at once. Uploads go through two orphaned pixel
+buffer objects used in turns.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <stdio.h>
+
+#define STBI_HEADER_FILE_ONLY
+#include "textures\stb_image.c"
+#include "textures\TextureLoader.h"
+#include "utils\timers\PerformanceTimer.h"
+#include "utils\timers\ZoneProfiler.h"
+
+/// <summary>
+/// Initializes a new instance of the <see cref="TextureLoader"/> class. Requires current GL context.
+/// </summary>
+/// <param name="decodeThreads">decode threads count, 0 = half of hardware threads.</param>
+/// <param name="queueCapacity">maximal count of decoded images waiting for upload.</param>
+TextureLoader::TextureLoader(unsigned int decodeThreads, unsigned int queueCapacity) :
+	m_capacity(std::max(queueCapacity, 1u)), m_stop(false), m_pendingCount(0), m_nextPbo(0)
+{
+	if (decodeThreads == 0)
+	{
+		decodeThreads = std::max(std::thread::hardware_concurrency() / 2, 1u);
+	}
+
+	glGenBuffers(2, m_pbos);
+
+	for (unsigned int i = 0; i < decodeThreads; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::decodeLoop, this));
+	}
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="TextureLoader"/> class. Unfinished requests are dropped.
+/// </summary>
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> requestLock(m_requestMutex);
+		std::lock_guard<std::mutex> decodedLock(m_decodedMutex);
+		m_stop = true;
+	}
+
+	m_requestCondition.notify_all();
+	m_notFull.notify_all();
+
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+
+	for (unsigned int i = 0; i < m_decoded.size(); i++)
+	{
+		release(m_decoded[i]);
+	}
+
+	glDeleteBuffers(2, m_pbos);
+}
+
+/// <summary>
+/// Requests image to be loaded into texture (2D texture, or layer of already
+/// allocated texture array). Compressed images are loaded with all mipmaps,
+/// only level 0 is loaded otherwise. Streamed textures get only given range
+/// of levels (CPU built mipmaps for uncompressed formats).
+/// </summary>
+/// <param name="filename">image file.</param>
+/// <param name="target">GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.</param>
+/// <param name="texture">texture object.</param>
+/// <param name="format">internal format, layers of arrays have to match format of array.</param>
+/// <param name="layer">array layer.</param>
+/// <param name="firstLevel">first uploaded level of streamed 2D texture, -1 = whole image.</param>
+/// <param name="lastLevel">last uploaded level of streamed 2D texture.</param>
+/// <returns>request id</returns>
+unsigned int TextureLoader::request(const std::string &filename, GLenum target, GLuint texture, GLenum format, int layer, int firstLevel, int lastLevel)
+{
+	Job job;
+
+	job.id = (unsigned int)m_states.size();
+	job.filename = filename;
+	job.target = target;
+	job.texture = texture;
+	job.format = format;
+	job.layer = target == GL_TEXTURE_2D_ARRAY ? layer : -1;
+	job.firstLevel = target == GL_TEXTURE_2D ? firstLevel : -1;
+	job.lastLevel = lastLevel;
+	job.data = NULL;
+	job.cooked = NULL;
+	job.width = 0;
+	job.height = 0;
+
+	m_states.push_back(PENDING);
+	m_pendingCount++;
+
+	{
+		std::lock_guard<std::mutex> lock(m_requestMutex);
+		m_requests.push_back(job);
+	}
+
+	m_requestCondition.notify_one();
+
+	return job.id;
+}
+
+/// <summary>
+/// Decode thread loop.
+/// </summary>
+void TextureLoader::decodeLoop()
+{
+	ZoneProfiler::setThreadName("Texture decoder");
+
+	for (;;)
+	{
+		Job job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_requestMutex);
+
+			while (!m_stop && m_requests.empty())
+			{
+				m_requestCondition.wait(lock);
+			}
+
+			if (m_stop)
+			{
+				return;
+			}
+
+			job = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		{
+			PROFILE_ZONE("Decode texture");
+
+			if (TextureCooker::isCompressed(job.format) || job.firstLevel >= 0)
+			{
+				job.cooked = new CookedImage;
+
+				if (TextureCooker::load(job.filename, job.format, *job.cooked, std::max(job.firstLevel, 0)))
+				{
+					job.width = job.cooked->width;
+					job.height = job.cooked->height;
+				}
+				else
+				{
+					delete job.cooked;
+					job.cooked = NULL;
+				}
+			}
+			else
+			{
+				int n;
+				job.data = stbi_load(job.filename.c_str(), &job.width, &job.height, &n, 4);
+			}
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_decodedMutex);
+
+			while (!m_stop && m_decoded.size() >= m_capacity)
+			{
+				m_notFull.wait(lock);
+			}
+
+			if (m_stop)
+			{
+				release(job);
+				return;
+			}
+
+			m_decoded.push_back(job);
+		}
+	}
+}
+
+/// <summary>
+/// Uploads decoded images until time budget is exhausted. At least one image
+/// is uploaded if available, so loading always progresses.
+/// </summary>
+/// <param name="budgetMs">time budget in milliseconds.</param>
+/// <returns>uploaded images count</returns>
+unsigned int TextureLoader::update(double budgetMs)
+{
+	PROFILE_FUNCTION();
+
+	PerformanceTimer timer;
+	timer.start();
+
+	unsigned int uploads = 0;
+
+	while (m_pendingCount > 0)
+	{
+		Job job;
+
+		{
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+
+			if (m_decoded.empty())
+			{
+				break;
+			}
+
+			job = m_decoded.front();
+			m_decoded.pop_front();
+		}
+
+		m_notFull.notify_one();
+
+		upload(job);
+		uploads++;
+
+		if (timer.getElapsedTime() * 1000.0 >= budgetMs)
+		{
+			break;
+		}
+	}
+
+	return uploads;
+}
+
+/// <summary>
+/// Blocks until all requests are uploaded (or failed).
+/// </summary>
+void TextureLoader::finish()
+{
+	while (m_pendingCount > 0)
+	{
+		if (update(1e9) == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/// <summary>
+/// Releases decoded image of job.
+/// </summary>
+/// <param name="job">decoded job.</param>
+void TextureLoader::release(Job &job)
+{
+	stbi_image_free(job.data);
+	delete job.cooked;
+
+	job.data = NULL;
+	job.cooked = NULL;
+}
+
+/// <summary>
+/// Uploads decoded image through pixel buffer object and releases it. All
+/// levels of cooked image are placed one after another in the same buffer.
+/// </summary>
+/// <param name="job">decoded job.</param>
+void TextureLoader::upload(Job &job)
+{
+	m_pendingCount--;
+
+	if (!job.data && !job.cooked)
+	{
+		printf("Error loading texture '%s'\n", job.filename.c_str());
+		m_states[job.id] = FAILED;
+		return;
+	}
+
+	glBindTexture(job.target, job.texture);
+
+	//layer has to match size of array it was registered to
+	if (job.layer >= 0)
+	{
+		GLint width, height;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_HEIGHT, &height);
+
+		if (width != job.width || height != job.height)
+		{
+			printf("Error packing texture '%s'\n", job.filename.c_str());
+			glBindTexture(job.target, 0);
+			release(job);
+			m_states[job.id] = FAILED;
+			return;
+		}
+	}
+
+	//level images in client memory, starting with level first
+	std::vector<const unsigned char*> levels;
+	std::vector<GLsizei> sizes;
+	int first = std::max(job.firstLevel, 0);
+
+	if (job.cooked)
+	{
+		int last = (int)job.cooked->levels.size() - 1;
+
+		if (job.firstLevel >= 0 && job.lastLevel >= 0)
+		{
+			last = std::min(last, job.lastLevel);
+		}
+
+		for (int l = first; l <= last; l++)
+		{
+			levels.push_back(&job.cooked->levels[l][0]);
+			sizes.push_back((GLsizei)job.cooked->levels[l].size());
+		}
+	}
+	else
+	{
+		levels.push_back(job.data);
+		sizes.push_back(job.width * job.height * 4);
+	}
+
+	GLsizeiptr size = 0;
+	for (unsigned int l = 0; l < sizes.size(); l++)
+	{
+		size += sizes[l];
+	}
+
+	std::vector<const unsigned char*> pixels(levels.size());
+
+	//orphan buffer, driver does not wait for previous upload from it
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbos[m_nextPbo]);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	m_nextPbo = (m_nextPbo + 1) % 2;
+
+	void *mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+
+	if (mapped)
+	{
+		//pixels become offsets into buffer
+		GLsizeiptr offset = 0;
+
+		for (unsigned int l = 0; l < levels.size(); l++)
+		{
+			memcpy((unsigned char*)mapped + offset, levels[l], sizes[l]);
+			pixels[l] = (const unsigned char*)NULL + offset;
+			offset += sizes[l];
+		}
+
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+	{
+		//fall back to client memory upload
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		pixels = levels;
+	}
+
+	bool compressed = TextureCooker::isCompressed(job.format);
+
+	for (unsigned int i = 0; i < levels.size(); i++)
+	{
+		int l = first + (int)i;
+		int width = std::max(1, job.width >> l), height = std::max(1, job.height >> l);
+
+		if (compressed && job.layer >= 0)
+		{
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, 0, 0, job.layer, width, height, 1, job.format, sizes[i], pixels[i]);
+		}
+		else if (compressed)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, l, job.format, width, height, 0, sizes[i], pixels[i]);
+		}
+		else if (job.layer >= 0)
+		{
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, job.layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels[i]);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, l, job.format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels[i]);
+
+			//streamed textures carry CPU built mipmaps
+			if (job.firstLevel < 0)
+			{
+				glGenerateMipmap(GL_TEXTURE_2D);
+			}
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindTexture(job.target, 0);
+
+	release(job);
+	m_states[job.id] = RESIDENT;
+}
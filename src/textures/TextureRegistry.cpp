@@ -0,0 +1,170 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements texture registry. Canonical path is absolute path with
+unified separators (and case on Windows), so relative paths of different
+models referencing the same file resolve to the same key.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <stdio.h>
+#include <stdlib.h>
+#include "textures\TextureRegistry.h"
+#include "textures\Texture.h"
+
+/// <summary>
+/// Initializes a new instance of the <see cref="TextureRegistry"/> class.
+/// </summary>
+TextureRegistry::TextureRegistry()
+{
+	m_statistics.loads = 0;
+	m_statistics.duplicates = 0;
+	m_statistics.bytesLoaded = 0;
+	m_statistics.bytesSaved = 0;
+}
+
+/// <summary>
+/// Returns registry shared by whole application.
+/// </summary>
+/// <returns>shared registry</returns>
+TextureRegistry &TextureRegistry::shared()
+{
+	static TextureRegistry registry;
+	return registry;
+}
+
+/// <summary>
+/// Converts path to canonical form used as registry key.
+/// </summary>
+/// <param name="filename">image path.</param>
+/// <returns>canonical path, unchanged path if file does not exist</returns>
+std::string TextureRegistry::canonicalPath(const std::string &filename)
+{
+	std::string path = filename;
+
+#ifdef _WIN32
+	char buffer[_MAX_PATH];
+
+	if (_fullpath(buffer, filename.c_str(), _MAX_PATH))
+	{
+		path = buffer;
+	}
+
+	//file names are case insensitive
+	std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+#else
+	char *resolved = realpath(filename.c_str(), NULL);
+
+	if (resolved)
+	{
+		path = resolved;
+		free(resolved);
+	}
+#endif
+
+	std::replace(path.begin(), path.end(), '\\', '/');
+
+	return path;
+}
+
+/// <summary>
+/// Returns texture of image, image is loaded only if no live texture with the
+/// same canonical path and options exists.
+/// </summary>
+/// <param name="filename">image path.</param>
+/// <param name="kind">texture usage.</param>
+/// <param name="srgb">SRGB color model of uncompressed texture.</param>
+/// <param name="loader">asynchronous loader, NULL = load synchronously.</param>
+/// <param name="streamer">mipmap streamer, takes precedence over loader.</param>
+/// <returns>texture handle, empty handle if image can not be loaded</returns>
+TextureHandle TextureRegistry::acquire(const std::string &filename, TextureKind kind, bool srgb, TextureLoader *loader, TextureStreamer *streamer)
+{
+	char options[16];
+	sprintf(options, "|%d|%d|%d", (int)kind, srgb ? 1 : 0, streamer ? 1 : 0);
+
+	std::string key = canonicalPath(filename) + options;
+
+	std::map<std::string, std::weak_ptr<Texture> >::iterator it = m_textures.find(key);
+
+	if (it != m_textures.end())
+	{
+		TextureHandle texture = it->second.lock();
+
+		if (texture)
+		{
+			recordDuplicate(texture->getMemorySize());
+			return texture;
+		}
+	}
+
+	TextureHandle texture(new Texture(GL_TEXTURE_2D, filename, kind));
+
+	bool loaded;
+
+	if (streamer)
+	{
+		loaded = texture->LoadStreamed(srgb, *streamer);
+	}
+	else
+	{
+		loaded = loader ? texture->LoadAsync(srgb, *loader) : texture->Load(srgb);
+	}
+
+	if (!loaded)
+	{
+		return TextureHandle();
+	}
+
+	m_textures[key] = texture;
+	recordLoad(texture->getMemorySize());
+
+	return texture;
+}
+
+/// <summary>
+/// Records loaded image (also used by texture arrays which share layers on
+/// their own).
+/// </summary>
+/// <param name="bytes">GPU memory of image.</param>
+void TextureRegistry::recordLoad(size_t bytes)
+{
+	m_statistics.loads++;
+	m_statistics.bytesLoaded += bytes;
+}
+
+/// <summary>
+/// Records request served by already loaded image.
+/// </summary>
+/// <param name="bytes">GPU memory of image.</param>
+void TextureRegistry::recordDuplicate(size_t bytes)
+{
+	m_statistics.duplicates++;
+	m_statistics.bytesSaved += bytes;
+}
+
+/// <summary>
+/// Prints deduplication statistics.
+/// </summary>
+void TextureRegistry::printStatistics() const
+{
+	printf("Textures: %u loaded (%.2f MB), %u duplicate loads avoided (%.2f MB saved)\n", m_statistics.loads,
+		m_statistics.bytesLoaded / (1024.0 * 1024.0), m_statistics.duplicates, m_statistics.bytesSaved / (1024.0 * 1024.0));
+}
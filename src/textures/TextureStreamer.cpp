@@ -0,0 +1,361 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements mipmap streamer. Memory of levels is accounted when they
+are requested, so loads in flight count against budget too. Evicted levels
+are respecified as zero sized images which releases their storage.
+*/
+
+#include <algorithm>
+#include <vector>
+#include "textures\TextureStreamer.h"
+#include "textures\TextureLoader.h"
+#include "textures\TextureCooker.h"
+
+//levels of LOD faded out per frame after new level arrives
+#define STREAMING_FADE_STEP 0.125f
+
+/// <summary>
+/// Initializes a new instance of the <see cref="TextureStreamer"/> class.
+/// </summary>
+/// <param name="loader">asynchronous loader used for level uploads.</param>
+/// <param name="budget">GPU memory budget in bytes.</param>
+/// <param name="tailSize">largest dimension of always resident levels.</param>
+/// <param name="idleFrames">frames without request after which texture is idle.</param>
+TextureStreamer::TextureStreamer(TextureLoader &loader, size_t budget, int tailSize, unsigned int idleFrames) :
+	m_loader(loader), m_budget(budget), m_residentBytes(0), m_tailSize(std::max(tailSize, 1)), m_idleFrames(idleFrames), m_frame(1)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="TextureStreamer"/> class. Textures are not owned by streamer.
+/// </summary>
+TextureStreamer::~TextureStreamer()
+{
+}
+
+/// <summary>
+/// Starts streaming of texture, coarse levels up to tail size are requested
+/// right away. Texture object has to have no levels specified.
+/// </summary>
+/// <param name="texture">streamed texture.</param>
+/// <param name="object">texture object.</param>
+/// <param name="filename">image file.</param>
+/// <param name="format">internal format.</param>
+/// <param name="width">image width.</param>
+/// <param name="height">image height.</param>
+void TextureStreamer::add(Texture *texture, GLuint object, const std::string &filename, GLenum format, int width, int height)
+{
+	Record record;
+
+	record.object = object;
+	record.filename = filename;
+	record.format = format;
+	record.width = width;
+	record.height = height;
+	record.levels = TextureCooker::levelCount(width, height);
+
+	record.tailLevel = 0;
+	while (record.tailLevel < record.levels - 1 && (std::max(width, height) >> record.tailLevel) > m_tailSize)
+	{
+		record.tailLevel++;
+	}
+
+	record.residentLevel = record.levels;
+	record.pendingLevel = record.tailLevel;
+	record.minLod = 0.0f;
+	record.desiredLevel = record.tailLevel;
+	record.priority = 0.0f;
+	record.lastUsed = 0;
+
+	glBindTexture(GL_TEXTURE_2D, object);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, record.tailLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, record.levels - 1);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, 0.0f);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	record.loadId = m_loader.request(filename, GL_TEXTURE_2D, object, format, -1, record.tailLevel, record.levels - 1);
+	m_residentBytes += rangeSize(record, record.tailLevel, record.levels - 1);
+
+	m_records[texture] = record;
+}
+
+/// <summary>
+/// Stops streaming of texture (texture is being deleted).
+/// </summary>
+/// <param name="texture">streamed texture.</param>
+void TextureStreamer::remove(const Texture *texture)
+{
+	std::map<const Texture*, Record>::iterator it = m_records.find(texture);
+
+	if (it == m_records.end())
+	{
+		return;
+	}
+
+	const Record &record = it->second;
+	int first = record.pendingLevel >= 0 ? record.pendingLevel : record.residentLevel;
+
+	m_residentBytes -= rangeSize(record, first, record.levels - 1);
+	m_records.erase(it);
+}
+
+/// <summary>
+/// Requests detail of texture for current frame. Texture is assumed to span
+/// its surface once, so level with about one texel per pixel is chosen.
+/// </summary>
+/// <param name="texture">streamed texture.</param>
+/// <param name="pixels">size of textured surface on screen in pixels.</param>
+void TextureStreamer::request(const Texture *texture, float pixels)
+{
+	std::map<const Texture*, Record>::iterator it = m_records.find(texture);
+
+	if (it == m_records.end())
+	{
+		return;
+	}
+
+	Record &record = it->second;
+	int size = std::max(record.width, record.height);
+	int level = 0;
+
+	while (level < record.tailLevel && (float)(size >> (level + 1)) >= pixels)
+	{
+		level++;
+	}
+
+	//the most demanding use within frame wins
+	if (record.lastUsed != m_frame)
+	{
+		record.desiredLevel = level;
+		record.priority = pixels;
+		record.lastUsed = m_frame;
+	}
+	else
+	{
+		record.desiredLevel = std::min(record.desiredLevel, level);
+		record.priority = std::max(record.priority, pixels);
+	}
+}
+
+/// <summary>
+/// Determines whether coarse levels of texture are resident.
+/// </summary>
+/// <param name="texture">streamed texture.</param>
+/// <returns>TRUE if texture can be sampled.</returns>
+bool TextureStreamer::isResident(const Texture *texture) const
+{
+	std::map<const Texture*, Record>::const_iterator it = m_records.find(texture);
+
+	return it != m_records.end() && it->second.residentLevel <= it->second.tailLevel;
+}
+
+/// <summary>
+/// Finishes completed loads, evicts levels over budget and requests finer
+/// levels of textures used in last frame, the largest on screen first. Call
+/// once per frame after all requests of frame have been made.
+/// </summary>
+/// <param name="maxRequests">maximal count of new loads.</param>
+void TextureStreamer::update(unsigned int maxRequests)
+{
+	std::vector<std::pair<float, Record*> > candidates;
+
+	for (std::map<const Texture*, Record>::iterator it = m_records.begin(); it != m_records.end(); ++it)
+	{
+		Record &record = it->second;
+
+		if (record.pendingLevel >= 0)
+		{
+			TextureLoader::State state = m_loader.getState(record.loadId);
+
+			if (state == TextureLoader::RESIDENT)
+			{
+				//fade from previous level, tail appears at once
+				record.minLod = record.residentLevel < record.levels ? (float)(record.residentLevel - record.pendingLevel) : 0.0f;
+				setBaseLevel(record, record.pendingLevel);
+				record.pendingLevel = -1;
+			}
+			else if (state == TextureLoader::FAILED)
+			{
+				m_residentBytes -= rangeSize(record, record.pendingLevel, record.residentLevel - 1);
+				record.pendingLevel = -1;
+			}
+		}
+
+		if (record.minLod > 0.0f)
+		{
+			record.minLod = std::max(record.minLod - STREAMING_FADE_STEP, 0.0f);
+
+			glBindTexture(GL_TEXTURE_2D, record.object);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, record.minLod);
+		}
+
+		if (record.pendingLevel < 0 && record.residentLevel <= record.tailLevel && record.lastUsed == m_frame &&
+			record.desiredLevel < record.residentLevel)
+		{
+			candidates.push_back(std::make_pair(record.priority, &record));
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	//idle textures lose detail first, then textures holding more detail than needed
+	bool evicted = true;
+
+	while (m_residentBytes > m_budget && evicted)
+	{
+		evicted = evictOne(true) || evictOne(false);
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+
+	unsigned int issued = 0;
+
+	for (int i = (int)candidates.size() - 1; i >= 0 && issued < maxRequests; i--)
+	{
+		Record &record = *candidates[i].second;
+		int level = record.desiredLevel;
+
+		//finest level fitting to budget
+		while (level < record.residentLevel && m_residentBytes + rangeSize(record, level, record.residentLevel - 1) > m_budget)
+		{
+			level++;
+		}
+
+		if (level >= record.residentLevel)
+		{
+			continue;
+		}
+
+		record.pendingLevel = level;
+		record.loadId = m_loader.request(record.filename, GL_TEXTURE_2D, record.object, record.format, -1, level, record.residentLevel - 1);
+		m_residentBytes += rangeSize(record, level, record.residentLevel - 1);
+
+		issued++;
+	}
+
+	m_frame++;
+}
+
+/// <summary>
+/// Computes memory of range of levels.
+/// </summary>
+/// <param name="record">streamed texture.</param>
+/// <param name="first">first level.</param>
+/// <param name="last">last level (inclusive).</param>
+/// <returns>size in bytes</returns>
+size_t TextureStreamer::rangeSize(const Record &record, int first, int last) const
+{
+	size_t size = 0;
+
+	for (int l = first; l <= last; l++)
+	{
+		size += TextureCooker::levelSize(record.format, std::max(1, record.width >> l), std::max(1, record.height >> l));
+	}
+
+	return size;
+}
+
+/// <summary>
+/// Sets finest resident level and exposes it to sampling.
+/// </summary>
+/// <param name="record">streamed texture.</param>
+/// <param name="level">finest resident level.</param>
+void TextureStreamer::setBaseLevel(Record &record, int level)
+{
+	record.residentLevel = level;
+
+	glBindTexture(GL_TEXTURE_2D, record.object);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, record.minLod);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/// <summary>
+/// Releases finest resident level of texture.
+/// </summary>
+/// <param name="record">streamed texture.</param>
+void TextureStreamer::evictLevel(Record &record)
+{
+	int level = record.residentLevel;
+
+	m_residentBytes -= rangeSize(record, level, level);
+	record.minLod = std::max(record.minLod - 1.0f, 0.0f);
+	setBaseLevel(record, level + 1);
+
+	//zero sized image releases storage of level
+	glBindTexture(GL_TEXTURE_2D, record.object);
+
+	if (TextureCooker::isCompressed(record.format))
+	{
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, record.format, 0, 0, 0, 0, NULL);
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, record.format, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/// <summary>
+/// Evicts single level of the least important texture.
+/// </summary>
+/// <param name="idleOnly">if set to <c>true</c> only idle textures are considered, otherwise
+/// textures with finer levels than desired.</param>
+/// <returns>FALSE if there is no texture to evict from.</returns>
+bool TextureStreamer::evictOne(bool idleOnly)
+{
+	Record *victim = NULL;
+
+	for (std::map<const Texture*, Record>::iterator it = m_records.begin(); it != m_records.end(); ++it)
+	{
+		Record &record = it->second;
+
+		//tail is never evicted, loads in flight finish first
+		if (record.pendingLevel >= 0 || record.residentLevel >= record.tailLevel)
+		{
+			continue;
+		}
+
+		bool idle = record.lastUsed + m_idleFrames < m_frame;
+
+		if (idleOnly ? !idle : record.residentLevel >= record.desiredLevel)
+		{
+			continue;
+		}
+
+		//least recently used, then the smallest on screen
+		if (!victim || record.lastUsed < victim->lastUsed ||
+			(record.lastUsed == victim->lastUsed && record.priority < victim->priority))
+		{
+			victim = &record;
+		}
+	}
+
+	if (!victim)
+	{
+		return false;
+	}
+
+	evictLevel(*victim);
+
+	return true;
+}
@@ -0,0 +1,163 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements memory mapped file using Win32 file mapping (mmap on
+other platforms).
+*/
+
+#include "utils\MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/// <summary>
+/// Initializes a new instance of the <see cref="MappedFile"/> class.
+/// </summary>
+MappedFile::MappedFile() : m_data(NULL), m_size(0)
+{
+#ifdef _WIN32
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+#else
+	m_file = -1;
+#endif
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="MappedFile"/> class.
+/// </summary>
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+/// <summary>
+/// Maps whole file to memory.
+/// </summary>
+/// <param name="filename">file path.</param>
+/// <returns>TRUE on success, empty file can not be mapped.</returns>
+bool MappedFile::open(const std::string &filename)
+{
+	close();
+
+#ifdef _WIN32
+	m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (!m_mapping)
+	{
+		close();
+		return false;
+	}
+
+	m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	m_size = (size_t)size.QuadPart;
+#else
+	m_file = ::open(filename.c_str(), O_RDONLY);
+
+	if (m_file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+
+	if (fstat(m_file, &info) != 0 || info.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+
+	m_data = data == MAP_FAILED ? NULL : (const char*)data;
+	m_size = (size_t)info.st_size;
+#endif
+
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Unmaps file.
+/// </summary>
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+	}
+
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+#else
+	if (m_data)
+	{
+		munmap((void*)m_data, m_size);
+	}
+
+	if (m_file >= 0)
+	{
+		::close(m_file);
+	}
+
+	m_file = -1;
+#endif
+
+	m_data = NULL;
+	m_size = 0;
+}
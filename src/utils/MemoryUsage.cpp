@@ -0,0 +1,121 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements process memory usage queries. Windows reports working
+set by psapi, other platforms read /proc/self/status. Peak can be reset only
+on Linux, callers on Windows have to compare peak with value before measured
+section.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "utils\MemoryUsage.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+/// <summary>
+/// Reads value of /proc/self/status field in bytes.
+/// </summary>
+/// <param name="field">field name including colon.</param>
+/// <returns>value, 0 if field is missing</returns>
+static size_t readStatusField(const char *field)
+{
+	FILE *f = fopen("/proc/self/status", "r");
+	size_t value = 0;
+
+	if (!f)
+	{
+		return 0;
+	}
+
+	char line[256];
+	size_t length = strlen(field);
+
+	while (fgets(line, sizeof(line), f))
+	{
+		if (strncmp(line, field, length) == 0)
+		{
+			unsigned long kb = 0;
+			sscanf(line + length, "%lu", &kb);
+			value = (size_t)kb * 1024;
+			break;
+		}
+	}
+
+	fclose(f);
+
+	return value;
+}
+#endif
+
+/// <summary>
+/// Returns current resident memory of process.
+/// </summary>
+/// <returns>size in bytes</returns>
+size_t MemoryUsage::getCurrent()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+#else
+	return readStatusField("VmRSS:");
+#endif
+}
+
+/// <summary>
+/// Returns peak resident memory of process.
+/// </summary>
+/// <returns>size in bytes</returns>
+size_t MemoryUsage::getPeak()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+	return readStatusField("VmHWM:");
+#endif
+}
+
+/// <summary>
+/// Resets peak to current resident memory.
+/// </summary>
+/// <returns>FALSE if platform does not support it.</returns>
+bool MemoryUsage::resetPeak()
+{
+#ifdef _WIN32
+	return false;
+#else
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	bool rc = fputs("5", f) >= 0;
+	fclose(f);
+
+	return rc;
+#endif
+}
@@ -0,0 +1,572 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements offscreen OpenGL context. API is selected at runtime,
+libEGL and libOSMesa are loaded dynamically, so they are needed only when
+they are used. EGL context is created on Mesa surfaceless platform (no
+display connection is needed) and made current without surface, OSMesa
+context renders to buffer in memory. Both require compatibility profile
+of OpenGL 3.3 (e.g. llvmpipe).
+*/
+
+#include "utils\OffscreenContext.h"
+
+#include <GLFW/glfw3.h>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define OFFSCREEN_APIENTRY __stdcall
+#else
+#include <dlfcn.h>
+#define OFFSCREEN_APIENTRY
+#endif
+
+//EGL 1.4 and EXT_platform_base subset, libEGL is loaded at runtime so headers and import library are not needed
+typedef void *EGLDisplay;
+typedef void *EGLConfig;
+typedef void *EGLContext;
+typedef void *EGLSurface;
+typedef int EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+
+#define EGL_NONE						0x3038
+#define EGL_SURFACE_TYPE				0x3033
+#define EGL_RENDERABLE_TYPE				0x3040
+#define EGL_OPENGL_BIT					0x0008
+#define EGL_OPENGL_API					0x30A2
+#define EGL_PLATFORM_SURFACELESS_MESA	0x31DD
+
+typedef void *(OFFSCREEN_APIENTRY *EglGetProcAddress)(const char *name);
+typedef EGLDisplay (OFFSCREEN_APIENTRY *EglGetDisplay)(void *nativeDisplay);
+typedef EGLDisplay (OFFSCREEN_APIENTRY *EglGetPlatformDisplay)(EGLenum platform, void *nativeDisplay, const EGLint *attributes);
+typedef EGLBoolean (OFFSCREEN_APIENTRY *EglInitialize)(EGLDisplay display, EGLint *major, EGLint *minor);
+typedef EGLBoolean (OFFSCREEN_APIENTRY *EglBindAPI)(EGLenum api);
+typedef EGLBoolean (OFFSCREEN_APIENTRY *EglChooseConfig)(EGLDisplay display, const EGLint *attributes, EGLConfig *configs, EGLint size, EGLint *count);
+typedef EGLContext (OFFSCREEN_APIENTRY *EglCreateContext)(EGLDisplay display, EGLConfig config, EGLContext share, const EGLint *attributes);
+typedef EGLBoolean (OFFSCREEN_APIENTRY *EglMakeCurrent)(EGLDisplay display, EGLSurface draw, EGLSurface read, EGLContext context);
+typedef EGLBoolean (OFFSCREEN_APIENTRY *EglDestroyContext)(EGLDisplay display, EGLContext context);
+typedef EGLBoolean (OFFSCREEN_APIENTRY *EglTerminate)(EGLDisplay display);
+
+//OSMesa subset, libOSMesa is loaded at runtime
+#define OSMESA_RGBA						GL_RGBA
+#define OSMESA_FORMAT					0x22
+#define OSMESA_DEPTH_BITS				0x30
+#define OSMESA_STENCIL_BITS				0x31
+#define OSMESA_PROFILE					0x33
+#define OSMESA_COMPAT_PROFILE			0x35
+#define OSMESA_CONTEXT_MAJOR_VERSION	0x36
+#define OSMESA_CONTEXT_MINOR_VERSION	0x37
+
+typedef void *(OFFSCREEN_APIENTRY *OsMesaGetProcAddress)(const char *name);
+typedef void *(OFFSCREEN_APIENTRY *OsMesaCreateContextAttribs)(const int *attributes, void *share);
+typedef void *(OFFSCREEN_APIENTRY *OsMesaCreateContextExt)(GLenum format, GLint depthBits, GLint stencilBits, GLint accumBits, void *share);
+typedef GLboolean (OFFSCREEN_APIENTRY *OsMesaMakeCurrent)(void *context, void *buffer, GLenum type, GLsizei width, GLsizei height);
+typedef void (OFFSCREEN_APIENTRY *OsMesaDestroyContext)(void *context);
+
+//GLEW pointers referenced by application (including ShaderProgram setters), functions of OpenGL 1.1
+//are exported by OpenGL library, new OpenGL 1.2+ calls have to be added here for EGL/OSMesa contexts
+#define OFFSCREEN_GL_FUNCTIONS(F) \
+	F(ActiveTexture) F(AttachShader) F(BindBuffer) F(BindBufferBase) F(BindBufferRange) F(BindFramebuffer) \
+	F(BindRenderbuffer) F(BindVertexArray) F(BlitFramebuffer) F(BufferData) F(CheckFramebufferStatus) \
+	F(CompileShader) F(CompressedTexImage2D) F(CompressedTexImage3D) F(CompressedTexSubImage3D) \
+	F(CreateProgram) F(CreateShader) F(DeleteBuffers) F(DeleteFramebuffers) F(DeleteProgram) F(DeleteQueries) \
+	F(DeleteRenderbuffers) F(DeleteShader) F(DeleteVertexArrays) F(DetachShader) F(DisableVertexAttribArray) \
+	F(DrawBuffers) F(DrawElementsInstancedBaseVertex) F(EnableVertexAttribArray) F(FramebufferRenderbuffer) \
+	F(FramebufferTexture2D) F(GenBuffers) F(GenFramebuffers) F(GenQueries) F(GenRenderbuffers) \
+	F(GenVertexArrays) F(GenerateMipmap) F(GetAttribLocation) F(GetProgramInfoLog) F(GetProgramiv) \
+	F(GetQueryObjectiv) F(GetQueryObjectui64v) F(GetShaderInfoLog) F(GetShaderiv) F(GetUniformBlockIndex) \
+	F(GetUniformLocation) F(LinkProgram) F(MapBuffer) F(QueryCounter) F(RenderbufferStorage) F(ShaderSource) \
+	F(TexBuffer) F(TexImage3D) F(TexSubImage3D) F(Uniform1d) F(Uniform1dv) F(Uniform1f) F(Uniform1fv) \
+	F(Uniform1i) F(Uniform1iv) F(Uniform1ui) F(Uniform1uiv) F(Uniform2d) F(Uniform2dv) F(Uniform2f) \
+	F(Uniform2fv) F(Uniform2i) F(Uniform2iv) F(Uniform2ui) F(Uniform2uiv) F(Uniform3d) F(Uniform3dv) \
+	F(Uniform3f) F(Uniform3fv) F(Uniform3i) F(Uniform3iv) F(Uniform3ui) F(Uniform3uiv) F(Uniform4d) \
+	F(Uniform4dv) F(Uniform4f) F(Uniform4fv) F(Uniform4i) F(Uniform4iv) F(Uniform4ui) F(Uniform4uiv) \
+	F(UniformBlockBinding) F(UniformMatrix2fv) F(UniformMatrix3fv) F(UniformMatrix4fv) F(UnmapBuffer) \
+	F(UseProgram) F(VertexAttrib1d) F(VertexAttrib1dv) F(VertexAttrib1f) F(VertexAttrib1fv) F(VertexAttrib2d) \
+	F(VertexAttrib2dv) F(VertexAttrib2f) F(VertexAttrib2fv) F(VertexAttrib3d) F(VertexAttrib3dv) \
+	F(VertexAttrib3f) F(VertexAttrib3fv) F(VertexAttrib4d) F(VertexAttrib4dv) F(VertexAttrib4f) \
+	F(VertexAttrib4fv) F(VertexAttribDivisor) F(VertexAttribI1i) F(VertexAttribI1iv) F(VertexAttribI1ui) \
+	F(VertexAttribI1uiv) F(VertexAttribI2i) F(VertexAttribI2iv) F(VertexAttribI2ui) F(VertexAttribI2uiv) \
+	F(VertexAttribI3i) F(VertexAttribI3iv) F(VertexAttribI3ui) F(VertexAttribI3uiv) F(VertexAttribI4i) \
+	F(VertexAttribI4iv) F(VertexAttribI4ui) F(VertexAttribI4uiv) F(VertexAttribPointer)
+
+#define OFFSCREEN_GL_FUNCTION(name) { (void**)&__glew##name, "gl" #name },
+
+/// <summary>
+/// GLEW function pointer and name of OpenGL function
+/// </summary>
+typedef struct
+{
+	void **pointer;
+	const char *name;
+} GLFunction;
+
+static const GLFunction glFunctions[] = { OFFSCREEN_GL_FUNCTIONS(OFFSCREEN_GL_FUNCTION) };
+
+
+/// <summary>
+/// Loads shared library.
+/// </summary>
+/// <param name="names">file names tried in order, NULL terminated.</param>
+/// <returns>library handle, NULL if none of names could be loaded</returns>
+static void *openLibrary(const char *const *names)
+{
+	for (; *names != NULL; names++)
+	{
+		#ifdef _WIN32
+		  void *library = (void*)LoadLibraryA(*names);
+		#else
+		  void *library = dlopen(*names, RTLD_NOW | RTLD_GLOBAL);
+		#endif
+
+		if (library != NULL)
+		{
+			return library;
+		}
+	}
+
+	return NULL;
+}
+
+
+/// <summary>
+/// Gets exported symbol of shared library.
+/// </summary>
+/// <param name="library">library handle.</param>
+/// <param name="name">symbol name.</param>
+/// <returns>symbol address, NULL if it is not exported</returns>
+static void *getSymbol(void *library, const char *name)
+{
+	#ifdef _WIN32
+	  return (void*)GetProcAddress((HMODULE)library, name);
+	#else
+	  return dlsym(library, name);
+	#endif
+}
+
+
+/// <summary>
+/// Unloads shared library.
+/// </summary>
+/// <param name="library">library handle.</param>
+static void closeLibrary(void *library)
+{
+	#ifdef _WIN32
+	  FreeLibrary((HMODULE)library);
+	#else
+	  dlclose(library);
+	#endif
+}
+
+
+/// <summary>
+/// Initializes a new instance of the <see cref="OffscreenContext"/> class.
+/// </summary>
+OffscreenContext::OffscreenContext() : m_api(OFFSCREEN_CONTEXT_API), m_size(0), m_framebuffer(0), m_library(NULL), m_display(NULL), m_context(NULL), m_window(NULL)
+{
+	m_renderbuffers[0] = m_renderbuffers[1] = 0;
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="OffscreenContext"/> class.
+/// </summary>
+OffscreenContext::~OffscreenContext()
+{
+	release();
+}
+
+/// <summary>
+/// Creates context and makes it current on calling thread.
+/// </summary>
+/// <param name="size">size of output framebuffer in pixels.</param>
+/// <param name="api">OFFSCREEN_API_GLFW, OFFSCREEN_API_EGL or OFFSCREEN_API_OSMESA.</param>
+/// <returns>false if context could not be created</returns>
+bool OffscreenContext::create(const glm::uvec2 &size, int api)
+{
+	m_size = size;
+	m_api = api;
+
+	switch (api)
+	{
+		case OFFSCREEN_API_EGL:
+			return createEgl();
+
+		case OFFSCREEN_API_OSMESA:
+			return createOsMesa();
+
+		default:
+			m_api = OFFSCREEN_API_GLFW;
+			return createGlfw();
+	}
+}
+
+/// <summary>
+/// Creates hidden GLFW window, it needs display (X11, Windows desktop).
+/// </summary>
+/// <returns>false if window could not be created</returns>
+bool OffscreenContext::createGlfw()
+{
+	if (!glfwInit())
+	{
+		std::cerr << "Offscreen: glfwInit failed" << std::endl;
+		return false;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	m_window = glfwCreateWindow((int)m_size.x, (int)m_size.y, "ECL", NULL, NULL);
+
+	if (m_window == NULL)
+	{
+		std::cerr << "Offscreen: hidden window could not be created" << std::endl;
+		return false;
+	}
+
+	glfwMakeContextCurrent(m_window);
+	glfwSwapInterval(0);
+
+	return true;
+}
+
+/// <summary>
+/// Creates EGL context on Mesa surfaceless platform, no display connection
+/// is needed. Context is made current without surface.
+/// </summary>
+/// <returns>false if context could not be created</returns>
+bool OffscreenContext::createEgl()
+{
+	const char *names[] = { "libEGL.so.1", "libEGL.so", "libEGL.dll", NULL };
+
+	if ((m_library = openLibrary(names)) == NULL)
+	{
+		std::cerr << "Offscreen: libEGL could not be loaded" << std::endl;
+		return false;
+	}
+
+	EglGetProcAddress getProcAddress = (EglGetProcAddress)getSymbol(m_library, "eglGetProcAddress");
+	EglGetDisplay getDisplay = (EglGetDisplay)getSymbol(m_library, "eglGetDisplay");
+	EglInitialize initialize = (EglInitialize)getSymbol(m_library, "eglInitialize");
+	EglBindAPI bindApi = (EglBindAPI)getSymbol(m_library, "eglBindAPI");
+	EglChooseConfig chooseConfig = (EglChooseConfig)getSymbol(m_library, "eglChooseConfig");
+	EglCreateContext createContext = (EglCreateContext)getSymbol(m_library, "eglCreateContext");
+	EglMakeCurrent makeCurrent = (EglMakeCurrent)getSymbol(m_library, "eglMakeCurrent");
+
+	if (!getProcAddress || !getDisplay || !initialize || !bindApi || !chooseConfig || !createContext || !makeCurrent)
+	{
+		std::cerr << "Offscreen: libEGL does not export EGL 1.4" << std::endl;
+		return false;
+	}
+
+	//surfaceless platform does not connect to X11/Wayland or GPU device
+	EglGetPlatformDisplay getPlatformDisplay = (EglGetPlatformDisplay)getProcAddress("eglGetPlatformDisplayEXT");
+	EGLint major, minor;
+
+	m_display = getPlatformDisplay ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, NULL, NULL) : getDisplay(NULL);
+
+	if (m_display == NULL || !initialize(m_display, &major, &minor))
+	{
+		std::cerr << "Offscreen: EGL display could not be initialized" << std::endl;
+		m_display = NULL;
+		return false;
+	}
+
+	if (!bindApi(EGL_OPENGL_API))
+	{
+		std::cerr << "Offscreen: EGL does not support OpenGL" << std::endl;
+		return false;
+	}
+
+	//no surface is created, any surface type is fine
+	const EGLint configAttributes[] = { EGL_SURFACE_TYPE, 0, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config;
+	EGLint configCount = 0;
+
+	if (!chooseConfig(m_display, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		std::cerr << "Offscreen: no EGL config with OpenGL" << std::endl;
+		return false;
+	}
+
+	if ((m_context = createContext(m_display, config, NULL, NULL)) == NULL)
+	{
+		std::cerr << "Offscreen: EGL context could not be created" << std::endl;
+		return false;
+	}
+
+	//EGL_KHR_surfaceless_context
+	if (!makeCurrent(m_display, NULL, NULL, m_context))
+	{
+		std::cerr << "Offscreen: EGL context could not be made current without surface" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Creates OSMesa context rendering to buffer in memory. OpenGL 1.1 functions
+/// are taken from linked OpenGL library, so application has to be linked
+/// against libOSMesa instead of libGL.
+/// </summary>
+/// <returns>false if context could not be created</returns>
+bool OffscreenContext::createOsMesa()
+{
+	const char *names[] = { "libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so", "osmesa.dll", NULL };
+
+	if ((m_library = openLibrary(names)) == NULL)
+	{
+		std::cerr << "Offscreen: libOSMesa could not be loaded" << std::endl;
+		return false;
+	}
+
+	OsMesaCreateContextAttribs createContextAttribs = (OsMesaCreateContextAttribs)getSymbol(m_library, "OSMesaCreateContextAttribs");
+	OsMesaCreateContextExt createContextExt = (OsMesaCreateContextExt)getSymbol(m_library, "OSMesaCreateContextExt");
+	OsMesaMakeCurrent makeCurrent = (OsMesaMakeCurrent)getSymbol(m_library, "OSMesaMakeCurrent");
+
+	if (!makeCurrent || (!createContextAttribs && !createContextExt))
+	{
+		std::cerr << "Offscreen: libOSMesa does not export OSMesa functions" << std::endl;
+		return false;
+	}
+
+	//OpenGL 3.3 compatibility profile needs OSMesa 11.2+, older ones create legacy context
+	if (createContextAttribs)
+	{
+		const int attributes[] = { OSMESA_FORMAT, OSMESA_RGBA, OSMESA_DEPTH_BITS, 24, OSMESA_STENCIL_BITS, 8,
+			OSMESA_PROFILE, OSMESA_COMPAT_PROFILE, OSMESA_CONTEXT_MAJOR_VERSION, 3, OSMESA_CONTEXT_MINOR_VERSION, 3, 0 };
+
+		m_context = createContextAttribs(attributes, NULL);
+	}
+	else
+	{
+		m_context = createContextExt(OSMESA_RGBA, 24, 8, 0, NULL);
+	}
+
+	if (m_context == NULL)
+	{
+		std::cerr << "Offscreen: OSMesa context could not be created" << std::endl;
+		return false;
+	}
+
+	m_colorBuffer.resize(m_size.x * m_size.y * 4);
+
+	if (!makeCurrent(m_context, &m_colorBuffer[0], GL_UNSIGNED_BYTE, m_size.x, m_size.y))
+	{
+		std::cerr << "Offscreen: OSMesa context could not be made current" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Gets address of OpenGL function from API of the context.
+/// </summary>
+/// <param name="name">function name.</param>
+/// <returns>function address, NULL if it is not available</returns>
+void *OffscreenContext::getProcAddress(const char *name) const
+{
+	const char *loader = m_api == OFFSCREEN_API_EGL ? "eglGetProcAddress" : "OSMesaGetProcAddress";
+
+	EglGetProcAddress getProcAddress = (EglGetProcAddress)getSymbol(m_library, loader);
+
+	return getProcAddress ? getProcAddress(name) : NULL;
+}
+
+/// <summary>
+/// Loads OpenGL functions of current context. GLEW loads functions of hidden
+/// window by WGL/GLX, functions of EGL and OSMesa contexts are loaded by
+/// eglGetProcAddress/OSMesaGetProcAddress.
+/// </summary>
+/// <returns>false if some of used functions is not available</returns>
+bool OffscreenContext::loadFunctions()
+{
+	if (m_api == OFFSCREEN_API_GLFW)
+	{
+		glewExperimental = GL_TRUE;
+
+		return glewInit() == GLEW_OK;
+	}
+
+	bool loaded = true;
+
+	for (unsigned int i = 0; i < sizeof(glFunctions) / sizeof(glFunctions[0]); i++)
+	{
+		*glFunctions[i].pointer = getProcAddress(glFunctions[i].name);
+
+		if (*glFunctions[i].pointer == NULL)
+		{
+			std::cerr << "Offscreen: " << glFunctions[i].name << " is not available" << std::endl;
+			loaded = false;
+		}
+	}
+
+	return loaded;
+}
+
+/// <summary>
+/// Creates output framebuffer, OpenGL functions have to be loaded. Framebuffer
+/// is left bound together with viewport of its size.
+/// </summary>
+/// <returns>framebuffer object, 0 if it is incomplete</returns>
+GLuint OffscreenContext::createFramebuffer()
+{
+	glGenRenderbuffers(2, m_renderbuffers);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_size.x, m_size.y);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_size.x, m_size.y);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_renderbuffers[1]);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Offscreen: output framebuffer is incomplete" << std::endl;
+		return 0;
+	}
+
+	glViewport(0, 0, m_size.x, m_size.y);
+
+	return m_framebuffer;
+}
+
+/// <summary>
+/// Reads output framebuffer, rows are stored from the bottom one.
+/// </summary>
+/// <param name="rgb">output RGB values in [0, 1].</param>
+void OffscreenContext::readPixels(std::vector<float> &rgb) const
+{
+	rgb.resize(m_size.x * m_size.y * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_size.x, m_size.y, GL_RGB, GL_FLOAT, &rgb[0]);
+}
+
+/// <summary>
+/// Deletes output framebuffer, context and unloads library of its API.
+/// </summary>
+void OffscreenContext::release()
+{
+	if (m_framebuffer)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(2, m_renderbuffers);
+
+		m_framebuffer = 0;
+		m_renderbuffers[0] = m_renderbuffers[1] = 0;
+	}
+
+	if (m_api == OFFSCREEN_API_EGL && m_library)
+	{
+		EglMakeCurrent makeCurrent = (EglMakeCurrent)getSymbol(m_library, "eglMakeCurrent");
+		EglDestroyContext destroyContext = (EglDestroyContext)getSymbol(m_library, "eglDestroyContext");
+		EglTerminate terminate = (EglTerminate)getSymbol(m_library, "eglTerminate");
+
+		if (m_display)
+		{
+			makeCurrent(m_display, NULL, NULL, NULL);
+
+			if (m_context)
+			{
+				destroyContext(m_display, m_context);
+			}
+
+			terminate(m_display);
+		}
+	}
+	else if (m_api == OFFSCREEN_API_OSMESA && m_library)
+	{
+		OsMesaDestroyContext destroyContext = (OsMesaDestroyContext)getSymbol(m_library, "OSMesaDestroyContext");
+
+		if (m_context && destroyContext)
+		{
+			destroyContext(m_context);
+		}
+	}
+	else if (m_window)
+	{
+		glfwDestroyWindow(m_window);
+		glfwTerminate();
+	}
+
+	if (m_library)
+	{
+		closeLibrary(m_library);
+	}
+
+	m_library = NULL;
+	m_display = NULL;
+	m_context = NULL;
+	m_window = NULL;
+}
+
+/// <summary>
+/// Gets name of context API.
+/// </summary>
+/// <returns>API name</returns>
+const char *OffscreenContext::getApiName() const
+{
+	switch (m_api)
+	{
+		case OFFSCREEN_API_EGL:
+			return "EGL surfaceless";
+
+		case OFFSCREEN_API_OSMESA:
+			return "OSMesa";
+
+		default:
+			return "hidden GLFW window";
+	}
+}
+
+/// <summary>
+/// Parses context API of --offscreen-api option.
+/// </summary>
+/// <param name="name">glfw, egl or osmesa.</param>
+/// <returns>OFFSCREEN_API_* value, -1 for unknown name</returns>
+int OffscreenContext::parseApi(const char *name)
+{
+	if (strcmp(name, "glfw") == 0)
+	{
+		return OFFSCREEN_API_GLFW;
+	}
+	else if (strcmp(name, "egl") == 0)
+	{
+		return OFFSCREEN_API_EGL;
+	}
+	else if (strcmp(name, "osmesa") == 0)
+	{
+		return OFFSCREEN_API_OSMESA;
+	}
+
+	return -1;
+}
@@ -0,0 +1,376 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements benchmark recorder. Percentiles are interpolated between
+closest ranks of sorted values. Histogram of tile light counts is written as
+mean number of tiles per frame.
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include "utils\benchmark\BenchmarkRecorder.h"
+
+//recorded columns: frame time, fps, grid build, GPU frame, GPU passes and light grid statistics
+#define COLUMN_FRAME_MS		0
+#define COLUMN_FPS			1
+#define COLUMN_GRID_MS		2
+#define COLUMN_GPU_FRAME_MS	3
+#define COLUMN_GPU			4
+#define COLUMN_TILE_MEAN	(COLUMN_GPU + GP_Max)
+#define COLUMN_TILE_P95		(COLUMN_TILE_MEAN + 1)
+#define COLUMN_TILE_MAX		(COLUMN_TILE_MEAN + 2)
+#define COLUMN_LIST_LENGTH	(COLUMN_TILE_MEAN + 3)
+#define COLUMN_TILES_OVER	(COLUMN_TILE_MEAN + 4)
+#define COLUMN_COUNT		(COLUMN_TILE_MEAN + 5)
+
+static const char *columnNames[COLUMN_COUNT] =
+{
+	"frame_ms",
+	"fps",
+	"grid_build_ms",
+	"gpu_frame_ms",
+	"gpu_gbuffer_ms",
+	"gpu_depth_prepass_ms",
+	"gpu_minmax_depth_ms",
+	"gpu_lighting_ms",
+	"gpu_blit_ms",
+	"tile_lights_mean",
+	"tile_lights_p95",
+	"tile_lights_max",
+	"light_list_length",
+	"tiles_over_threshold_pct",
+};
+
+/// <summary>
+/// Initializes a new instance of the <see cref="BenchmarkRecorder"/> class.
+/// </summary>
+/// <param name="config">configuration of run.</param>
+/// <param name="name">run name.</param>
+/// <param name="techniqueName">name of rendering technique.</param>
+BenchmarkRecorder::BenchmarkRecorder(const BenchmarkConfig &config, const std::string &name, const std::string &techniqueName)
+	: m_config(config), m_name(name), m_techniqueName(techniqueName)
+{
+}
+
+/// <summary>
+/// Gets values of column for all frames.
+/// </summary>
+/// <param name="column">column index.</param>
+/// <param name="values">output values.</param>
+void BenchmarkRecorder::getValues(unsigned int column, std::vector<double> &values) const
+{
+	values.resize(m_frames.size());
+
+	for (unsigned int i = 0; i < m_frames.size(); i++)
+	{
+		const BenchmarkFrame &frame = m_frames[i];
+
+		switch (column)
+		{
+			case COLUMN_FRAME_MS:
+				values[i] = frame.frameMs;
+				break;
+			case COLUMN_FPS:
+				values[i] = frame.frameMs > 0.0 ? 1000.0 / frame.frameMs : 0.0;
+				break;
+			case COLUMN_GRID_MS:
+				values[i] = frame.gridBuildMs;
+				break;
+			case COLUMN_GPU_FRAME_MS:
+				values[i] = frame.gpuFrameMs;
+				break;
+			case COLUMN_TILE_MEAN:
+				values[i] = frame.tileLightsMean;
+				break;
+			case COLUMN_TILE_P95:
+				values[i] = frame.tileLightsP95;
+				break;
+			case COLUMN_TILE_MAX:
+				values[i] = frame.tileLightsMax;
+				break;
+			case COLUMN_LIST_LENGTH:
+				values[i] = frame.lightListLength;
+				break;
+			case COLUMN_TILES_OVER:
+				values[i] = frame.tilesOverThreshold;
+				break;
+			default:
+				values[i] = frame.gpuMs[column - COLUMN_GPU];
+				break;
+		}
+	}
+}
+
+/// <summary>
+/// Computes mean, extremes and percentiles of values.
+/// </summary>
+/// <param name="values">values, copy is sorted.</param>
+/// <returns>summary</returns>
+BenchmarkSummary BenchmarkRecorder::summarize(std::vector<double> values)
+{
+	BenchmarkSummary summary = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+	if (values.empty())
+	{
+		return summary;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	double sum = 0.0;
+
+	for (unsigned int i = 0; i < values.size(); i++)
+	{
+		sum += values[i];
+	}
+
+	double *percentiles[4] = { &summary.p50, &summary.p90, &summary.p95, &summary.p99 };
+	const double ranks[4] = { 0.5, 0.9, 0.95, 0.99 };
+
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		double position = ranks[i] * (values.size() - 1);
+		size_t lower = (size_t)position;
+		size_t upper = std::min(lower + 1, values.size() - 1);
+
+		*percentiles[i] = values[lower] + (values[upper] - values[lower]) * (position - lower);
+	}
+
+	summary.mean = sum / values.size();
+	summary.min = values.front();
+	summary.max = values.back();
+
+	return summary;
+}
+
+/// <summary>
+/// Writes per-frame values to CSV file.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <returns>false if file could not be written</returns>
+bool BenchmarkRecorder::writeCsv(const std::string &filename) const
+{
+	std::ofstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::vector<double> columns[COLUMN_COUNT];
+
+	file << "frame";
+
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+	{
+		getValues(c, columns[c]);
+		file << "," << columnNames[c];
+	}
+
+	file << "\n" << std::fixed << std::setprecision(4);
+
+	for (unsigned int i = 0; i < m_frames.size(); i++)
+	{
+		file << i;
+
+		for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+		{
+			file << "," << columns[c][i];
+		}
+
+		file << "\n";
+	}
+
+	return file.good();
+}
+
+/// <summary>
+/// Writes configuration, summary and per-frame values to JSON file.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <param name="renderer">OpenGL renderer string.</param>
+/// <returns>false if file could not be written</returns>
+bool BenchmarkRecorder::writeJson(const std::string &filename, const std::string &renderer) const
+{
+	std::ofstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::vector<double> columns[COLUMN_COUNT];
+
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+	{
+		getValues(c, columns[c]);
+	}
+
+	//renderer string is not escaped, quotes and backslashes are replaced
+	std::string rendererName = renderer;
+	std::replace(rendererName.begin(), rendererName.end(), '"', '\'');
+	std::replace(rendererName.begin(), rendererName.end(), '\\', '/');
+
+	file << std::fixed << std::setprecision(4);
+	file << "{\n";
+	file << "\t\"name\": \"" << m_name << "\",\n";
+	file << "\t\"renderer\": \"" << rendererName << "\",\n";
+	file << "\t\"config\": {\n";
+	file << "\t\t\"technique\": \"" << m_techniqueName << "\",\n";
+	file << "\t\t\"resolution\": [" << m_config.resolution.x << ", " << m_config.resolution.y << "],\n";
+	file << "\t\t\"tile_size\": " << m_config.tileSize << ",\n";
+	file << "\t\t\"lights\": " << m_config.lightCount << ",\n";
+	file << "\t\t\"minmax\": " << (m_config.minMax ? "true" : "false") << ",\n";
+	file << "\t\t\"frames\": " << m_frames.size() << "\n";
+	file << "\t},\n";
+
+	file << "\t\"summary\": {\n";
+
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+	{
+		BenchmarkSummary summary = summarize(columns[c]);
+
+		file << "\t\t\"" << columnNames[c] << "\": { \"mean\": " << summary.mean << ", \"min\": " << summary.min
+			<< ", \"p50\": " << summary.p50 << ", \"p90\": " << summary.p90 << ", \"p95\": " << summary.p95
+			<< ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << " }" << (c + 1 < COLUMN_COUNT ? ",\n" : "\n");
+	}
+
+	file << "\t},\n";
+
+	file << "\t\"frames\": {\n";
+
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+	{
+		file << "\t\t\"" << columnNames[c] << "\": [";
+
+		for (unsigned int i = 0; i < columns[c].size(); i++)
+		{
+			file << (i > 0 ? ", " : "") << columns[c][i];
+		}
+
+		file << "]" << (c + 1 < COLUMN_COUNT ? ",\n" : "\n");
+	}
+
+	file << "\t},\n";
+
+	//tiles by light count summed over frames, trailing empty bins are left out
+	size_t bins = m_tileHistogram.size();
+
+	while (bins > 0 && m_tileHistogram[bins - 1] == 0)
+	{
+		bins--;
+	}
+
+	file << "\t\"tile_histogram\": [";
+
+	for (size_t b = 0; b < bins; b++)
+	{
+		file << (b > 0 ? ", " : "") << m_tileHistogram[b];
+	}
+
+	file << "]\n";
+	file << "}\n";
+
+	return file.good();
+}
+
+/// <summary>
+/// Writes histogram of tile light counts to CSV file. Rows above the highest
+/// recorded count are left out, the last bin counts also longer lists.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <returns>false if file could not be written</returns>
+bool BenchmarkRecorder::writeTileHistogram(const std::string &filename) const
+{
+	std::ofstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	unsigned long long tiles = 0;
+	size_t bins = m_tileHistogram.size();
+
+	for (size_t b = 0; b < m_tileHistogram.size(); b++)
+	{
+		tiles += m_tileHistogram[b];
+	}
+
+	while (bins > 0 && m_tileHistogram[bins - 1] == 0)
+	{
+		bins--;
+	}
+
+	double frames = m_frames.empty() ? 1.0 : double(m_frames.size());
+
+	file << "lights,tiles_per_frame,fraction\n" << std::fixed << std::setprecision(4);
+
+	for (size_t b = 0; b < bins; b++)
+	{
+		file << b << "," << m_tileHistogram[b] / frames << "," << (tiles > 0 ? double(m_tileHistogram[b]) / tiles : 0.0) << "\n";
+	}
+
+	return file.good();
+}
+
+/// <summary>
+/// Writes header of sweep summary table (one row per run).
+/// </summary>
+/// <param name="stream">output stream.</param>
+void BenchmarkRecorder::writeSummaryHeader(std::ostream &stream)
+{
+	stream << "name,technique,width,height,tile_size,lights,minmax,frames";
+
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+	{
+		stream << "," << columnNames[c] << "_mean," << columnNames[c] << "_p50," << columnNames[c] << "_p95," << columnNames[c] << "_p99";
+	}
+
+	stream << "\n";
+}
+
+/// <summary>
+/// Writes row of sweep summary table.
+/// </summary>
+/// <param name="stream">output stream.</param>
+void BenchmarkRecorder::writeSummaryRow(std::ostream &stream) const
+{
+	stream << m_name << "," << m_techniqueName << "," << m_config.resolution.x << "," << m_config.resolution.y << ","
+		<< m_config.tileSize << "," << m_config.lightCount << "," << (m_config.minMax ? 1 : 0) << "," << m_frames.size();
+
+	std::streamsize precision = stream.precision(4);
+	stream << std::fixed;
+
+	for (unsigned int c = 0; c < COLUMN_COUNT; c++)
+	{
+		std::vector<double> values;
+		getValues(c, values);
+
+		BenchmarkSummary summary = summarize(values);
+
+		stream << "," << summary.mean << "," << summary.p50 << "," << summary.p95 << "," << summary.p99;
+	}
+
+	stream << "\n";
+	stream.unsetf(std::ios_base::floatfield);
+	stream.precision(precision);
+}
@@ -0,0 +1,353 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements benchmark sweep specification.
+*/
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include "utils\benchmark\BenchmarkSpec.h"
+#include "configuration\Config.h"
+
+//accepted ranges of sweep values, larger values are rather typos than intended runs
+#define SPEC_MAX_RESOLUTION		16384
+#define SPEC_MAX_TILE			1024
+#define SPEC_MAX_LIGHTS			(1 << 24)
+#define SPEC_MAX_FRAMES			1000000
+
+/// <summary>
+/// Parses decimal number. Number is parsed as signed, so negative values are
+/// rejected instead of wrapping around to large unsigned values.
+/// </summary>
+/// <param name="text">parsed text.</param>
+/// <param name="min">minimal accepted value.</param>
+/// <param name="max">maximal accepted value.</param>
+/// <param name="number">output number.</param>
+/// <param name="end">character expected behind number.</param>
+/// <returns>pointer behind number, NULL if text is not number in range</returns>
+static const char *parseNumber(const char *text, long min, long max, unsigned int &number, char end = '\0')
+{
+	char *next;
+
+	errno = 0;
+	long value = strtol(text, &next, 10);
+
+	if (next == text || *next != end || errno == ERANGE || value < min || value > max)
+	{
+		return NULL;
+	}
+
+	number = (unsigned int)value;
+	return next;
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="BenchmarkSpec"/> class. Default
+/// sweep uses resolution, tile size and light count of current build, all
+/// techniques and both min/max depth settings.
+/// </summary>
+/// <param name="techniqueNames">names of available techniques.</param>
+BenchmarkSpec::BenchmarkSpec(const std::vector<std::string> &techniqueNames) : m_techniqueNames(techniqueNames)
+{
+	resolutions.push_back(glm::uvec2(RES_X, RES_Y));
+	tileSizes.push_back(TILE_SIZE_XY);
+	lightCounts.push_back(MAX_LIGHTS);
+
+	for (unsigned int i = 0; i < techniqueNames.size(); i++)
+	{
+		techniques.push_back(i);
+	}
+
+	minMax.push_back(true);
+	minMax.push_back(false);
+
+	warmupFrames = BENCHMARK_WARMUP_FRAMES;
+	measuredFrames = BENCHMARK_MEASURED_FRAMES;
+	outputDir = "experiments/Benchmark";
+	writeCsv = true;
+	writeJson = true;
+}
+
+/// <summary>
+/// Loads sweep from file, keys not present in file keep default values.
+/// </summary>
+/// <param name="filename">sweep specification file.</param>
+/// <returns>false if file could not be read or contains invalid values</returns>
+bool BenchmarkSpec::load(const std::string &filename)
+{
+	std::ifstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		std::cerr << "Benchmark: could not open " << filename << std::endl;
+		return false;
+	}
+
+	std::string line;
+	unsigned int lineNumber = 0;
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		size_t comment = line.find('#');
+
+		if (comment != std::string::npos)
+		{
+			line.erase(comment);
+		}
+
+		size_t separator = line.find('=');
+
+		if (separator == std::string::npos)
+		{
+			//empty or comment line
+			if (line.find_first_not_of(" \t\r") == std::string::npos)
+			{
+				continue;
+			}
+
+			std::cerr << "Benchmark: " << filename << ":" << lineNumber << ": expected 'key = values'" << std::endl;
+			return false;
+		}
+
+		std::istringstream keyStream(line.substr(0, separator));
+		std::istringstream values(line.substr(separator + 1));
+		std::string key;
+		keyStream >> key;
+
+		if (!parseLine(key, values))
+		{
+			std::cerr << "Benchmark: " << filename << ":" << lineNumber << ": invalid value of '" << key << "': " << line << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Parses values of single key.
+/// </summary>
+/// <param name="key">key name.</param>
+/// <param name="values">whitespace separated values.</param>
+/// <returns>false if key is unknown or value is invalid</returns>
+bool BenchmarkSpec::parseLine(const std::string &key, std::istringstream &values)
+{
+	std::vector<std::string> tokens;
+	std::string token;
+
+	while (values >> token)
+	{
+		tokens.push_back(token);
+	}
+
+	if (tokens.empty())
+	{
+		return false;
+	}
+
+	if (key == "resolution")
+	{
+		resolutions.clear();
+
+		for (unsigned int i = 0; i < tokens.size(); i++)
+		{
+			unsigned int x, y;
+			const char *next = parseNumber(tokens[i].c_str(), 1, SPEC_MAX_RESOLUTION, x, 'x');
+
+			if (next == NULL || parseNumber(next + 1, 1, SPEC_MAX_RESOLUTION, y) == NULL)
+			{
+				return false;
+			}
+
+			resolutions.push_back(glm::uvec2(x, y));
+		}
+	}
+	else if (key == "tile" || key == "lights" || key == "warmup" || key == "frames")
+	{
+		std::vector<unsigned int> numbers;
+
+		//warmup may be skipped, everything else needs at least one
+		long min = key == "warmup" ? 0 : 1;
+		long max = key == "tile" ? SPEC_MAX_TILE : key == "lights" ? SPEC_MAX_LIGHTS : SPEC_MAX_FRAMES;
+
+		for (unsigned int i = 0; i < tokens.size(); i++)
+		{
+			unsigned int number;
+
+			if (parseNumber(tokens[i].c_str(), min, max, number) == NULL)
+			{
+				return false;
+			}
+
+			numbers.push_back(number);
+		}
+
+		if (key == "tile")
+		{
+			tileSizes = numbers;
+		}
+		else if (key == "lights")
+		{
+			lightCounts = numbers;
+		}
+		else if (key == "warmup")
+		{
+			warmupFrames = numbers[0];
+		}
+		else
+		{
+			measuredFrames = numbers[0];
+		}
+	}
+	else if (key == "technique")
+	{
+		techniques.clear();
+
+		for (unsigned int i = 0; i < tokens.size(); i++)
+		{
+			unsigned int t = 0;
+
+			while (t < m_techniqueNames.size() && m_techniqueNames[t] != tokens[i])
+			{
+				t++;
+			}
+
+			if (t == m_techniqueNames.size())
+			{
+				return false;
+			}
+
+			techniques.push_back(t);
+		}
+	}
+	else if (key == "minmax")
+	{
+		minMax.clear();
+
+		for (unsigned int i = 0; i < tokens.size(); i++)
+		{
+			if (tokens[i] == "on")
+			{
+				minMax.push_back(true);
+			}
+			else if (tokens[i] == "off")
+			{
+				minMax.push_back(false);
+			}
+			else
+			{
+				return false;
+			}
+		}
+	}
+	else if (key == "output")
+	{
+		outputDir = tokens[0];
+	}
+	else if (key == "format")
+	{
+		writeCsv = writeJson = false;
+
+		for (unsigned int i = 0; i < tokens.size(); i++)
+		{
+			if (tokens[i] == "csv")
+			{
+				writeCsv = true;
+			}
+			else if (tokens[i] == "json")
+			{
+				writeJson = true;
+			}
+			else
+			{
+				return false;
+			}
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	return measuredFrames > 0;
+}
+
+/// <summary>
+/// Expands sweep to list of configurations. Configurations sharing resolution
+/// and tile size are adjacent.
+/// </summary>
+/// <param name="configs">output configurations.</param>
+void BenchmarkSpec::getConfigurations(std::vector<BenchmarkConfig> &configs) const
+{
+	configs.clear();
+
+	for (unsigned int r = 0; r < resolutions.size(); r++)
+	{
+		for (unsigned int s = 0; s < tileSizes.size(); s++)
+		{
+			for (unsigned int t = 0; t < techniques.size(); t++)
+			{
+				for (unsigned int l = 0; l < lightCounts.size(); l++)
+				{
+					for (unsigned int m = 0; m < minMax.size(); m++)
+					{
+						BenchmarkConfig config;
+						config.resolution = resolutions[r];
+						config.tileSize = tileSizes[s];
+						config.technique = techniques[t];
+						config.lightCount = lightCounts[l];
+						config.minMax = minMax[m];
+
+						configs.push_back(config);
+					}
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Returns run name in format of experiments folders, e.g. "TD1280x720L1024minmax"
+/// (technique abbreviated to its capital letters) with tile size appended.
+/// </summary>
+/// <param name="config">benchmark configuration.</param>
+/// <returns>run name</returns>
+std::string BenchmarkSpec::getRunName(const BenchmarkConfig &config) const
+{
+	const std::string &technique = m_techniqueNames[config.technique];
+	std::ostringstream name;
+
+	for (unsigned int i = 0; i < technique.size(); i++)
+	{
+		if (technique[i] >= 'A' && technique[i] <= 'Z')
+		{
+			name << technique[i];
+		}
+	}
+
+	name << config.resolution.x << "x" << config.resolution.y << "L" << config.lightCount
+		<< (config.minMax ? "minmax" : "nominmax") << "T" << config.tileSize;
+
+	return name.str();
+}
@@ -0,0 +1,358 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements thread pool used to spread CPU work (culling, loading)
+over all available cores. Deques are guarded by their own mutexes, so workers
+contend only while stealing.
+*/
+
+#include <algorithm>
+#include "configuration\Config.h"
+#include "utils\threading\ThreadPool.h"
+#include "utils\threading\ThreadLocal.h"
+#include "utils\timers\ZoneProfiler.h"
+
+#ifdef _WIN32
+  #include "utils\timers\Win32ApiWrapper.h"
+#elif defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+//jobs are shown in zone trace by default
+#if ZONE_PROFILER_ENABLED
+JobHook ThreadPool::s_jobHook = &ZoneProfiler::record;
+#else
+JobHook ThreadPool::s_jobHook = NULL;
+#endif
+
+//worker of calling thread, NULL pool for threads which are not workers
+static THREAD_LOCAL ThreadPool *currentPool = NULL;
+static THREAD_LOCAL unsigned int currentWorker = 0;
+
+
+/// <summary>
+/// Pins calling thread to single logical core.
+/// </summary>
+/// <param name="core">core index.</param>
+static void pinCurrentThread(unsigned int core)
+{
+	#if defined(_WIN32)
+	  SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+	#elif defined(__linux__)
+	  cpu_set_t set;
+	  CPU_ZERO(&set);
+	  CPU_SET(core, &set);
+	  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+	#endif
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="ThreadPool"/> class.
+/// </summary>
+/// <param name="threads">worker count, 0 = hardware threads - 1 (calling thread works too).</param>
+/// <param name="pinThreads">pin worker i to logical core i + 1, core 0 is left to main thread.</param>
+ThreadPool::ThreadPool(unsigned int threads, bool pinThreads) : m_pending(0), m_stop(false)
+{
+	if (threads == 0)
+	{
+		unsigned int hw = std::thread::hardware_concurrency();
+		threads = hw > 1 ? hw - 1 : 1;
+	}
+
+	//one deque per worker and shared one for other threads
+	for (unsigned int i = 0; i < threads + 1; i++)
+	{
+		m_queues.push_back(new JobQueue());
+	}
+
+	for (unsigned int i = 0; i < threads; i++)
+	{
+		m_workers.push_back(std::thread(&ThreadPool::workerLoop, this, i, pinThreads));
+	}
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="ThreadPool"/> class. Waits for workers,
+/// queued jobs are finished.
+/// </summary>
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+
+	m_condition.notify_all();
+
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+
+	for (unsigned int i = 0; i < m_queues.size(); i++)
+	{
+		delete m_queues[i];
+	}
+}
+
+/// <summary>
+/// Returns pool shared by whole application.
+/// </summary>
+/// <returns>shared pool</returns>
+ThreadPool &ThreadPool::shared()
+{
+	static ThreadPool pool(0, THREAD_POOL_PINNING != 0);
+	return pool;
+}
+
+/// <summary>
+/// Returns deque of calling thread.
+/// </summary>
+/// <returns>worker index, shared deque index for other threads</returns>
+int ThreadPool::getWorkerIndex() const
+{
+	return currentPool == this ? (int)currentWorker : (int)m_workers.size();
+}
+
+/// <summary>
+/// Queues job for asynchronous execution.
+/// </summary>
+/// <param name="task">The task.</param>
+/// <param name="counter">counter incremented until job is finished, may be NULL.</param>
+/// <param name="name">job name for profiling hook, string literal.</param>
+void ThreadPool::submit(const std::function<void()> &task, JobCounter *counter, const char *name)
+{
+	Job job;
+	job.task = task;
+	job.counter = counter;
+	job.name = name;
+
+	if (counter != NULL)
+	{
+		counter->m_count++;
+	}
+
+	JobQueue &queue = *m_queues[getWorkerIndex()];
+
+	//counted before push, so that pop never sees more jobs than pending
+	m_pending++;
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	//sleeper checks pending jobs under this mutex, so notification is not lost
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+
+	m_condition.notify_one();
+}
+
+/// <summary>
+/// Takes job for thread of given deque: the newest one of own deque, then
+/// the oldest one of shared deque or of other workers.
+/// </summary>
+/// <param name="index">deque of calling thread.</param>
+/// <param name="job">output job.</param>
+/// <returns>FALSE if all deques were empty.</returns>
+bool ThreadPool::popJob(int index, Job &job)
+{
+	if (m_pending.load() == 0)
+	{
+		return false;
+	}
+
+	unsigned int count = (unsigned int)m_queues.size();
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		JobQueue &queue = *m_queues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.jobs.empty())
+		{
+			continue;
+		}
+
+		if (i == 0 && index < (int)m_workers.size())
+		{
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+		}
+		else
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+		}
+
+		m_pending--;
+
+		return true;
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Executes job and signals its counter.
+/// </summary>
+/// <param name="job">The job.</param>
+void ThreadPool::runJob(Job &job)
+{
+	JobHook hook = s_jobHook;
+	unsigned long long beginTicks = hook ? PerformanceTimer::getTickCount() : 0;
+
+	job.task();
+
+	if (hook)
+	{
+		hook(job.name, beginTicks, PerformanceTimer::getTickCount());
+	}
+
+	//counter is decremented before lock, waiting thread checks it under lock
+	//and the pool outlives the counter
+	if (job.counter != NULL && --job.counter->m_count == 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_condition.notify_all();
+	}
+}
+
+/// <summary>
+/// Worker thread main loop.
+/// </summary>
+/// <param name="index">worker index.</param>
+/// <param name="pin">pin to logical core.</param>
+void ThreadPool::workerLoop(unsigned int index, bool pin)
+{
+	ZoneProfiler::setThreadName("Worker");
+
+	currentPool = this;
+	currentWorker = index;
+
+	if (pin)
+	{
+		pinCurrentThread((index + 1) % std::max(std::thread::hardware_concurrency(), 1u));
+	}
+
+	for (;;)
+	{
+		Job job;
+
+		if (popJob(index, job))
+		{
+			runJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+		while (!m_stop && m_pending.load() == 0)
+		{
+			m_condition.wait(lock);
+		}
+
+		if (m_stop && m_pending.load() == 0)
+		{
+			return;
+		}
+	}
+}
+
+/// <summary>
+/// Waits until all jobs of counter are finished. Calling thread executes
+/// queued jobs meanwhile (jobs of counter or any others).
+/// </summary>
+/// <param name="counter">The counter.</param>
+void ThreadPool::wait(JobCounter &counter)
+{
+	PROFILE_ZONE("Wait for jobs");
+
+	int index = getWorkerIndex();
+
+	while (!counter.isDone())
+	{
+		Job job;
+
+		if (popJob(index, job))
+		{
+			runJob(job);
+			continue;
+		}
+
+		//remaining jobs are running on other threads
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+		while (!counter.isDone() && m_pending.load() == 0)
+		{
+			m_condition.wait(lock);
+		}
+	}
+}
+
+/// <summary>
+/// Splits range [0, count) into chunks of at least grain items and executes body
+/// for every chunk. Returns after all chunks are done.
+/// </summary>
+/// <param name="count">items count.</param>
+/// <param name="grain">minimal chunk size.</param>
+/// <param name="body">function called with [begin, end) range.</param>
+/// <param name="name">job name of chunks, string literal.</param>
+void ThreadPool::parallelFor(unsigned int count, unsigned int grain, const std::function<void(unsigned int, unsigned int)> &body, const char *name)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	grain = std::max(grain, 1u);
+
+	//aim for a few chunks per thread to balance uneven work
+	unsigned int threads = getThreadCount() + 1;
+	unsigned int chunk = std::max(grain, (count + threads * 4 - 1) / (threads * 4));
+	unsigned int chunks = (count + chunk - 1) / chunk;
+
+	if (chunks == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	JobCounter counter;
+
+	for (unsigned int c = 1; c < chunks; c++)
+	{
+		unsigned int begin = c * chunk;
+		unsigned int end = std::min(count, begin + chunk);
+
+		submit([&body, begin, end]()
+		{
+			body(begin, end);
+		}, &counter, name);
+	}
+
+	//calling thread processes first chunk and helps with queued ones
+	body(0, std::min(count, chunk));
+
+	wait(counter);
+}
@@ -0,0 +1,278 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements GPU profiler.
+*/
+
+#include "utils\timers\GpuProfiler.h"
+
+//results older than this are dropped if nobody reads them
+#define GPU_PROFILER_MAX_RESULTS 256
+
+/// <summary>
+/// Initializes a new instance of the <see cref="GpuProfiler"/> class.
+/// </summary>
+GpuProfiler::GpuProfiler() : m_current(0), m_initialized(false), m_frameActive(false), m_enabled(true)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="GpuProfiler"/> class.
+/// </summary>
+GpuProfiler::~GpuProfiler()
+{
+	release();
+}
+
+/// <summary>
+/// Creates queries, requires current OpenGL context.
+/// </summary>
+void GpuProfiler::init()
+{
+	release();
+
+	for (unsigned int i = 0; i < GPU_TIMER_FRAMES; i++)
+	{
+		m_ring[i].frame = 0;
+		m_ring[i].pending = false;
+		m_ring[i].lastQuery = 0;
+
+		glGenQueries(GP_Max * 2, m_ring[i].queries);
+	}
+
+	m_current = 0;
+	m_initialized = true;
+}
+
+/// <summary>
+/// Deletes queries and drops unread results.
+/// </summary>
+void GpuProfiler::release()
+{
+	if (!m_initialized)
+	{
+		return;
+	}
+
+	for (unsigned int i = 0; i < GPU_TIMER_FRAMES; i++)
+	{
+		glDeleteQueries(GP_Max * 2, m_ring[i].queries);
+		m_ring[i].pending = false;
+	}
+
+	m_results.clear();
+	m_initialized = false;
+	m_frameActive = false;
+}
+
+/// <summary>
+/// Starts new frame. Finished frames are read, ring slot of the oldest frame is
+/// reused (its results are read first, which waits for GPU only if it is more
+/// than GPU_TIMER_FRAMES frames behind).
+/// </summary>
+/// <param name="frame">frame number reported with results.</param>
+void GpuProfiler::beginFrame(unsigned int frame)
+{
+	if (!m_enabled || !m_initialized)
+	{
+		return;
+	}
+
+	if (m_frameActive)
+	{
+		m_current = (m_current + 1) % GPU_TIMER_FRAMES;
+	}
+
+	//read frames finished meanwhile, oldest first
+	for (unsigned int i = 0; i < GPU_TIMER_FRAMES; i++)
+	{
+		FrameQueries &slot = m_ring[(m_current + i) % GPU_TIMER_FRAMES];
+
+		if (!slot.pending)
+		{
+			continue;
+		}
+
+		//frames finish in order
+		if (i > 0 && !isAvailable(slot))
+		{
+			break;
+		}
+
+		resolve(slot);
+	}
+
+	FrameQueries &slot = m_ring[m_current];
+
+	slot.frame = frame;
+	slot.pending = true;
+	slot.lastQuery = 0;
+
+	for (unsigned int p = 0; p < GP_Max; p++)
+	{
+		slot.used[p] = false;
+	}
+
+	m_frameActive = true;
+}
+
+/// <summary>
+/// Writes begin timestamp of pass.
+/// </summary>
+/// <param name="pass">profiled pass.</param>
+void GpuProfiler::begin(GpuPass pass)
+{
+	if (!m_enabled || !m_frameActive)
+	{
+		return;
+	}
+
+	FrameQueries &slot = m_ring[m_current];
+
+	glQueryCounter(slot.queries[pass * 2], GL_TIMESTAMP);
+	slot.used[pass] = true;
+}
+
+/// <summary>
+/// Writes end timestamp of pass.
+/// </summary>
+/// <param name="pass">profiled pass.</param>
+void GpuProfiler::end(GpuPass pass)
+{
+	if (!m_enabled || !m_frameActive || !m_ring[m_current].used[pass])
+	{
+		return;
+	}
+
+	FrameQueries &slot = m_ring[m_current];
+
+	glQueryCounter(slot.queries[pass * 2 + 1], GL_TIMESTAMP);
+	slot.lastQuery = slot.queries[pass * 2 + 1];
+}
+
+/// <summary>
+/// Returns the oldest finished frame.
+/// </summary>
+/// <param name="times">GPU times of frame.</param>
+/// <returns>false if no results are ready</returns>
+bool GpuProfiler::popResult(GpuFrameTimes &times)
+{
+	if (m_results.empty())
+	{
+		return false;
+	}
+
+	times = m_results.front();
+	m_results.pop_front();
+
+	return true;
+}
+
+/// <summary>
+/// Reads results of all frames in flight (waits for GPU).
+/// </summary>
+void GpuProfiler::flush()
+{
+	if (!m_initialized)
+	{
+		return;
+	}
+
+	//oldest frame first
+	for (unsigned int i = 1; i <= GPU_TIMER_FRAMES; i++)
+	{
+		FrameQueries &slot = m_ring[(m_current + i) % GPU_TIMER_FRAMES];
+
+		if (slot.pending)
+		{
+			resolve(slot);
+		}
+	}
+
+	m_frameActive = false;
+}
+
+/// <summary>
+/// Checks if all timestamps of frame are available.
+/// </summary>
+/// <param name="slot">ring slot of frame.</param>
+/// <returns>true if results can be read without waiting</returns>
+bool GpuProfiler::isAvailable(const FrameQueries &slot) const
+{
+	if (slot.lastQuery == 0)
+	{
+		return true;
+	}
+
+	GLint available = 0;
+	glGetQueryObjectiv(slot.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+
+	return available != 0;
+}
+
+/// <summary>
+/// Reads timestamps of frame into results queue.
+/// </summary>
+/// <param name="slot">ring slot of frame.</param>
+void GpuProfiler::resolve(FrameQueries &slot)
+{
+	GpuFrameTimes times;
+	times.frame = slot.frame;
+	times.frameMs = 0.0;
+
+	GLuint64 first = 0, last = 0;
+
+	for (unsigned int p = 0; p < GP_Max; p++)
+	{
+		times.passMs[p] = 0.0;
+
+		if (!slot.used[p])
+		{
+			continue;
+		}
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(slot.queries[p * 2], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(slot.queries[p * 2 + 1], GL_QUERY_RESULT, &end);
+
+		times.passMs[p] = end > begin ? (end - begin) / 1000000.0 : 0.0;
+
+		if (first == 0 || begin < first)
+		{
+			first = begin;
+		}
+
+		last = end > last ? end : last;
+	}
+
+	if (last > first)
+	{
+		times.frameMs = (last - first) / 1000000.0;
+	}
+
+	slot.pending = false;
+
+	m_results.push_back(times);
+
+	if (m_results.size() > GPU_PROFILER_MAX_RESULTS)
+	{
+		m_results.pop_front();
+	}
+}
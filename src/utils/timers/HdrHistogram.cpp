@@ -0,0 +1,214 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements high dynamic range histogram. Bucket of value is given
+by its highest set bit (exponent) and following SAMPLE_HISTOGRAM_SUB_BITS - 1
+bits (mantissa).
+*/
+
+#include <algorithm>
+#include <cmath>
+#include "utils\timers\HdrHistogram.h"
+
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif
+
+/// <summary>
+/// Returns index of the highest set bit, value must not be zero.
+/// </summary>
+/// <param name="value">value.</param>
+/// <returns>bit index</returns>
+static inline unsigned int highestBit(unsigned long long value)
+{
+	#ifdef _MSC_VER
+	  unsigned long index;
+	  _BitScanReverse64(&index, value);
+	  return index;
+	#else
+	  return 63 - __builtin_clzll(value);
+	#endif
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="HdrHistogram"/> class.
+/// </summary>
+HdrHistogram::HdrHistogram() : m_counts(HDR_BUCKET_COUNT, 0)
+{
+	reset();
+}
+
+/// <summary>
+/// Removes all values.
+/// </summary>
+void HdrHistogram::reset()
+{
+	std::fill(m_counts.begin(), m_counts.end(), 0);
+
+	m_count = 0;
+	m_min = ~0ull;
+	m_max = 0;
+	m_sum = 0.0;
+}
+
+/// <summary>
+/// Records value.
+/// </summary>
+/// <param name="value">value.</param>
+/// <param name="count">number of occurrences.</param>
+void HdrHistogram::record(unsigned long long value, unsigned long long count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	m_counts[getBucket(value)] += count;
+	m_count += count;
+	m_sum += (double)value * count;
+
+	m_min = value < m_min ? value : m_min;
+	m_max = value > m_max ? value : m_max;
+}
+
+/// <summary>
+/// Adds occurrences to bucket, exact range has to be set by setRange().
+/// </summary>
+/// <param name="bucket">bucket index.</param>
+/// <param name="count">number of occurrences.</param>
+void HdrHistogram::addBucket(unsigned int bucket, unsigned long long count)
+{
+	m_counts[bucket] += count;
+	m_count += count;
+}
+
+/// <summary>
+/// Merges exact minimum, maximum and sum of values added by addBucket().
+/// </summary>
+/// <param name="min">minimal value.</param>
+/// <param name="max">maximal value.</param>
+/// <param name="sum">sum of values.</param>
+void HdrHistogram::setRange(unsigned long long min, unsigned long long max, double sum)
+{
+	m_min = min < m_min ? min : m_min;
+	m_max = max > m_max ? max : m_max;
+	m_sum += sum;
+}
+
+/// <summary>
+/// Adds all values of another histogram.
+/// </summary>
+/// <param name="histogram">merged histogram.</param>
+void HdrHistogram::merge(const HdrHistogram &histogram)
+{
+	if (histogram.m_count == 0)
+	{
+		return;
+	}
+
+	for (unsigned int i = 0; i < HDR_BUCKET_COUNT; i++)
+	{
+		m_counts[i] += histogram.m_counts[i];
+	}
+
+	m_count += histogram.m_count;
+	setRange(histogram.m_min, histogram.m_max, histogram.m_sum);
+}
+
+/// <summary>
+/// Returns value at percentile, middle of bucket clamped to exact range.
+/// </summary>
+/// <param name="percentile">percentile from range <0, 100>.</param>
+/// <returns>value</returns>
+unsigned long long HdrHistogram::getValueAtPercentile(double percentile) const
+{
+	if (m_count == 0)
+	{
+		return 0;
+	}
+
+	unsigned long long rank = (unsigned long long)ceil(percentile / 100.0 * m_count);
+	rank = rank < 1 ? 1 : (rank > m_count ? m_count : rank);
+
+	unsigned long long cumulative = 0;
+
+	for (unsigned int i = 0; i < HDR_BUCKET_COUNT; i++)
+	{
+		cumulative += m_counts[i];
+
+		if (cumulative >= rank)
+		{
+			unsigned long long value = getBucketLowest(i) + getBucketWidth(i) / 2;
+
+			return value < m_min ? m_min : (value > m_max ? m_max : value);
+		}
+	}
+
+	return m_max;
+}
+
+/// <summary>
+/// Returns bucket of value.
+/// </summary>
+/// <param name="value">value.</param>
+/// <returns>bucket index</returns>
+unsigned int HdrHistogram::getBucket(unsigned long long value)
+{
+	if (value < HDR_SUB_BUCKETS)
+	{
+		return (unsigned int)value;
+	}
+
+	unsigned int shift = highestBit(value) - (SAMPLE_HISTOGRAM_SUB_BITS - 1);
+
+	return shift * HDR_HALF_BUCKETS + (unsigned int)(value >> shift);
+}
+
+/// <summary>
+/// Returns the lowest value of bucket.
+/// </summary>
+/// <param name="bucket">bucket index.</param>
+/// <returns>value</returns>
+unsigned long long HdrHistogram::getBucketLowest(unsigned int bucket)
+{
+	if (bucket < HDR_SUB_BUCKETS)
+	{
+		return bucket;
+	}
+
+	unsigned int shift = bucket / HDR_HALF_BUCKETS - 1;
+
+	return (unsigned long long)(bucket - shift * HDR_HALF_BUCKETS) << shift;
+}
+
+/// <summary>
+/// Returns number of values in bucket.
+/// </summary>
+/// <param name="bucket">bucket index.</param>
+/// <returns>bucket width</returns>
+unsigned long long HdrHistogram::getBucketWidth(unsigned int bucket)
+{
+	if (bucket < HDR_SUB_BUCKETS)
+	{
+		return 1;
+	}
+
+	return 1ull << (bucket / HDR_HALF_BUCKETS - 1);
+}
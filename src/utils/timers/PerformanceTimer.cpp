@@ -19,6 +19,9 @@ using C/C++ with some external helper libraries to handle basic operations.
 File information
 -----------------
 Performance timer class used to measure CPU time of some parts of code. 
+Ticks come from QueryPerformanceCounter (Windows), clock_gettime (Linux) or
+from TSC read by rdtscp with frequency calibrated against them
+(PERFORMANCE_TIMER_TSC, requires invariant TSC).
 */
 
 /****************************************************************************/
@@ -44,6 +47,7 @@ Performance timer class used to measure CPU time of some parts of code.
  */
 /****************************************************************************/
 #include "utils\timers\PerformanceTimer.h"
+#include "configuration\Config.h"
 
 #ifdef _WIN32
   #include "utils\timers\Win32ApiWrapper.h"
@@ -54,8 +58,26 @@ Performance timer class used to measure CPU time of some parts of code.
   #error No implementation for the current platform available
 #endif // _WIN32
 
+#if PERFORMANCE_TIMER_TSC
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #else
+    #include <x86intrin.h>
+  #endif
 
-unsigned int PerformanceTimer::getTickCount()
+  //reference interval of TSC calibration
+  #define TSC_CALIBRATION_MS 20
+#endif
+
+//computed during static initialization, function local statics are not thread safe in VS2013
+static unsigned long long ticksPerSecond = 0;
+
+
+/// <summary>
+/// Returns ticks of operating system monotonic clock.
+/// </summary>
+/// <returns></returns>
+static unsigned long long getSystemTicks()
 {
 	#if defined(_WIN32)
 	  LARGE_INTEGER i;
@@ -64,18 +86,76 @@ unsigned int PerformanceTimer::getTickCount()
 	#elif defined(__linux__)
 	  timespec ts;
 	  clock_gettime( CLOCK_MONOTONIC, &ts );
-	  return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+	  return (unsigned long long)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
 	#endif
 }
 
 
-unsigned int PerformanceTimer::initTicksPerSecond()
+/// <summary>
+/// Returns frequency of operating system monotonic clock.
+/// </summary>
+/// <returns></returns>
+static unsigned long long getSystemTicksPerSecond()
 {
 	#if defined(_WIN32)
 	  LARGE_INTEGER hpFrequency;
 	  QueryPerformanceFrequency(&hpFrequency);
-	  return  hpFrequency.QuadPart;
+	  return hpFrequency.QuadPart;
 	#elif defined(__linux__)
-	  return 1000000000llu;
+	  return NSEC_PER_SEC;
 	#endif
 }
+
+
+unsigned long long PerformanceTimer::getTickCount()
+{
+	#if PERFORMANCE_TIMER_TSC
+	  unsigned int aux;
+	  return __rdtscp(&aux);
+	#else
+	  return getSystemTicks();
+	#endif
+}
+
+
+unsigned long long PerformanceTimer::getTicksPerSecond()
+{
+	if (ticksPerSecond == 0)
+	{
+		ticksPerSecond = initTicksPerSecond();
+	}
+
+	return ticksPerSecond;
+}
+
+
+unsigned long long PerformanceTimer::initTicksPerSecond()
+{
+	#if PERFORMANCE_TIMER_TSC
+	  //count TSC ticks during reference interval of system clock
+	  unsigned long long systemFrequency = getSystemTicksPerSecond();
+	  unsigned long long interval = systemFrequency * TSC_CALIBRATION_MS / 1000;
+
+	  unsigned long long systemStart = getSystemTicks();
+	  unsigned long long tscStart = getTickCount();
+	  unsigned long long systemEnd;
+
+	  do
+	  {
+		  systemEnd = getSystemTicks();
+	  } while (systemEnd - systemStart < interval);
+
+	  unsigned long long tscEnd = getTickCount();
+
+	  return (unsigned long long)((double)(tscEnd - tscStart) * systemFrequency / (systemEnd - systemStart));
+	#else
+	  return getSystemTicksPerSecond();
+	#endif
+}
+
+
+//calibrate before threads start to use timers
+static struct TicksPerSecondInit
+{
+	TicksPerSecondInit(){ PerformanceTimer::getTicksPerSecond(); }
+} ticksPerSecondInit;
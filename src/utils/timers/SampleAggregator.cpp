@@ -0,0 +1,203 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements lock-free sample aggregator. Slots are allocated on
+first record of thread, counters are updated by relaxed atomic operations,
+so recording never blocks render or worker threads.
+*/
+
+#include <cstddef>
+#include "utils\timers\SampleAggregator.h"
+
+//index + 1 of slot used by thread, zero when not assigned yet
+static THREAD_LOCAL unsigned int threadSlotIndex = 0;
+
+//next slot index handed to new thread
+static std::atomic<unsigned int> nextThreadSlot(0);
+
+
+/// <summary>
+/// Initializes a new instance of the <see cref="SampleAggregator"/> class.
+/// </summary>
+SampleAggregator::SampleAggregator()
+{
+	for (unsigned int i = 0; i < SAMPLE_AGGREGATOR_THREADS; i++)
+	{
+		m_slots[i].store(NULL);
+	}
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="SampleAggregator"/> class.
+/// </summary>
+SampleAggregator::~SampleAggregator()
+{
+	for (unsigned int i = 0; i < SAMPLE_AGGREGATOR_THREADS; i++)
+	{
+		delete m_slots[i].load();
+	}
+}
+
+/// <summary>
+/// Returns slot index of calling thread.
+/// </summary>
+/// <returns>slot index</returns>
+unsigned int SampleAggregator::getThreadIndex()
+{
+	if (threadSlotIndex == 0)
+	{
+		threadSlotIndex = nextThreadSlot.fetch_add(1, std::memory_order_relaxed) % SAMPLE_AGGREGATOR_THREADS + 1;
+	}
+
+	return threadSlotIndex - 1;
+}
+
+/// <summary>
+/// Zeroes slot, atomics are not initialized by default constructor.
+/// </summary>
+/// <param name="slot">slot.</param>
+void SampleAggregator::clearSlot(ThreadSlot *slot)
+{
+	for (unsigned int i = 0; i < HDR_BUCKET_COUNT; i++)
+	{
+		slot->counts[i].store(0, std::memory_order_relaxed);
+	}
+
+	slot->count.store(0, std::memory_order_relaxed);
+	slot->sum.store(0, std::memory_order_relaxed);
+	slot->min.store(~0ull, std::memory_order_relaxed);
+	slot->max.store(0, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Returns slot of calling thread, allocates it on first use.
+/// </summary>
+/// <returns>slot</returns>
+SampleAggregator::ThreadSlot *SampleAggregator::getSlot()
+{
+	std::atomic<ThreadSlot*> &entry = m_slots[getThreadIndex()];
+	ThreadSlot *slot = entry.load(std::memory_order_acquire);
+
+	if (slot == NULL)
+	{
+		ThreadSlot *created = new ThreadSlot;
+		clearSlot(created);
+
+		//thread sharing the slot index may have been faster
+		if (entry.compare_exchange_strong(slot, created, std::memory_order_acq_rel))
+		{
+			slot = created;
+		}
+		else
+		{
+			delete created;
+		}
+	}
+
+	return slot;
+}
+
+/// <summary>
+/// Records sample.
+/// </summary>
+/// <param name="nanoseconds">sample in nanoseconds.</param>
+void SampleAggregator::record(unsigned long long nanoseconds)
+{
+	ThreadSlot *slot = getSlot();
+
+	slot->counts[HdrHistogram::getBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+	slot->count.fetch_add(1, std::memory_order_relaxed);
+	slot->sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+	unsigned long long current = slot->min.load(std::memory_order_relaxed);
+	while (nanoseconds < current && !slot->min.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed));
+
+	current = slot->max.load(std::memory_order_relaxed);
+	while (nanoseconds > current && !slot->max.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed));
+}
+
+/// <summary>
+/// Removes all samples. Samples recorded concurrently may be partially kept.
+/// </summary>
+void SampleAggregator::reset()
+{
+	for (unsigned int i = 0; i < SAMPLE_AGGREGATOR_THREADS; i++)
+	{
+		ThreadSlot *slot = m_slots[i].load(std::memory_order_acquire);
+
+		if (slot != NULL)
+		{
+			clearSlot(slot);
+		}
+	}
+}
+
+/// <summary>
+/// Merges slots of all threads into histogram.
+/// </summary>
+/// <param name="histogram">output histogram, previous content is removed.</param>
+void SampleAggregator::getHistogram(HdrHistogram &histogram) const
+{
+	histogram.reset();
+
+	for (unsigned int i = 0; i < SAMPLE_AGGREGATOR_THREADS; i++)
+	{
+		ThreadSlot *slot = m_slots[i].load(std::memory_order_acquire);
+
+		if (slot == NULL || slot->count.load(std::memory_order_relaxed) == 0)
+		{
+			continue;
+		}
+
+		for (unsigned int j = 0; j < HDR_BUCKET_COUNT; j++)
+		{
+			unsigned long long count = slot->counts[j].load(std::memory_order_relaxed);
+
+			if (count > 0)
+			{
+				histogram.addBucket(j, count);
+			}
+		}
+
+		histogram.setRange(slot->min.load(std::memory_order_relaxed), slot->max.load(std::memory_order_relaxed),
+			(double)slot->sum.load(std::memory_order_relaxed));
+	}
+}
+
+/// <summary>
+/// Returns summary of all recorded samples.
+/// </summary>
+/// <returns>summary in milliseconds</returns>
+SampleSummary SampleAggregator::summarize() const
+{
+	HdrHistogram histogram;
+	getHistogram(histogram);
+
+	SampleSummary summary;
+	summary.count = histogram.getCount();
+	summary.minMs = histogram.getMin() / 1e6;
+	summary.meanMs = histogram.getMean() / 1e6;
+	summary.p50Ms = histogram.getValueAtPercentile(50.0) / 1e6;
+	summary.p95Ms = histogram.getValueAtPercentile(95.0) / 1e6;
+	summary.p99Ms = histogram.getValueAtPercentile(99.0) / 1e6;
+	summary.maxMs = histogram.getMax() / 1e6;
+
+	return summary;
+}
@@ -0,0 +1,236 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+This file implements CPU zone profiler. Ring buffer of thread is allocated
+by setThreadName() or by the first zone of thread, recording only writes
+zone into ring and publishes it by atomic counter.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#include "utils\timers\ZoneProfiler.h"
+#include "utils\threading\ThreadLocal.h"
+
+/// <summary>
+/// Zone of code recorded by thread
+/// </summary>
+typedef struct
+{
+	const char *name;
+	unsigned long long beginTicks;
+	unsigned long long endTicks;
+} ZoneEvent;
+
+/// <summary>
+/// Ring of zones owned by single thread
+/// </summary>
+typedef struct
+{
+	ZoneEvent events[ZONE_PROFILER_EVENTS];
+	std::atomic<unsigned long long> written;	//zones recorded since start, ring index = written % ZONE_PROFILER_EVENTS
+	const char *name;
+} ZoneThread;
+
+//rings of threads, threads over ZONE_PROFILER_THREADS are not recorded
+static std::atomic<ZoneThread*> zoneThreads[ZONE_PROFILER_THREADS];
+static std::atomic<unsigned int> zoneThreadCount(0);
+
+//ring of calling thread, NULL until first use
+static THREAD_LOCAL ZoneThread *currentThread = NULL;
+static THREAD_LOCAL bool currentThreadDropped = false;
+
+//trace timestamps are relative to start of application
+static unsigned long long epochTicks = PerformanceTimer::getTickCount();
+
+
+/// <summary>
+/// Returns ring of calling thread, allocates it on first use.
+/// </summary>
+/// <returns>ring or NULL if there are too many threads</returns>
+static ZoneThread *getThread()
+{
+	if (currentThread == NULL && !currentThreadDropped)
+	{
+		unsigned int index = zoneThreadCount.fetch_add(1);
+
+		if (index >= ZONE_PROFILER_THREADS)
+		{
+			currentThreadDropped = true;
+			return NULL;
+		}
+
+		ZoneThread *thread = new ZoneThread;
+		thread->written.store(0, std::memory_order_relaxed);
+		thread->name = NULL;
+
+		zoneThreads[index].store(thread, std::memory_order_release);
+		currentThread = thread;
+	}
+
+	return currentThread;
+}
+
+
+/// <summary>
+/// Names calling thread in trace and preallocates its ring, so that the first
+/// zone does not allocate.
+/// </summary>
+/// <param name="name">thread name, string literal.</param>
+void ZoneProfiler::setThreadName(const char *name)
+{
+	ZoneThread *thread = getThread();
+
+	if (thread != NULL)
+	{
+		thread->name = name;
+	}
+}
+
+
+/// <summary>
+/// Records zone of calling thread.
+/// </summary>
+/// <param name="name">zone name, string literal.</param>
+/// <param name="beginTicks">PerformanceTimer ticks at start of zone.</param>
+/// <param name="endTicks">PerformanceTimer ticks at end of zone.</param>
+void ZoneProfiler::record(const char *name, unsigned long long beginTicks, unsigned long long endTicks)
+{
+	ZoneThread *thread = getThread();
+
+	if (thread == NULL)
+	{
+		return;
+	}
+
+	unsigned long long index = thread->written.load(std::memory_order_relaxed);
+
+	ZoneEvent &e = thread->events[index % ZONE_PROFILER_EVENTS];
+	e.name = name;
+	e.beginTicks = beginTicks;
+	e.endTicks = endTicks;
+
+	thread->written.store(index + 1, std::memory_order_release);
+}
+
+
+/// <summary>
+/// Removes recorded zones, should be called when no zone is being recorded.
+/// </summary>
+void ZoneProfiler::clear()
+{
+	unsigned int count = std::min(zoneThreadCount.load(), (unsigned int)ZONE_PROFILER_THREADS);
+
+	for (unsigned int t = 0; t < count; t++)
+	{
+		ZoneThread *thread = zoneThreads[t].load(std::memory_order_acquire);
+
+		if (thread != NULL)
+		{
+			thread->written.store(0, std::memory_order_release);
+		}
+	}
+}
+
+
+/// <summary>
+/// Converts ticks to microseconds since start of application.
+/// </summary>
+/// <param name="ticks">PerformanceTimer ticks.</param>
+/// <returns>microseconds</returns>
+static double ticksToTraceTime(unsigned long long ticks)
+{
+	return ticks > epochTicks ? PerformanceTimer::ticksToNanoseconds(ticks - epochTicks) / 1000.0 : 0.0;
+}
+
+
+/// <summary>
+/// Writes zones of all threads as Chrome trace_event JSON (complete events).
+/// Threads may keep recording, zones overwritten during export are skipped.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <returns>false if file could not be written</returns>
+bool ZoneProfiler::writeTrace(const std::string &filename)
+{
+	std::ofstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"ECL\"}}";
+
+	unsigned int count = std::min(zoneThreadCount.load(), (unsigned int)ZONE_PROFILER_THREADS);
+	std::vector<ZoneEvent> events;
+
+	for (unsigned int t = 0; t < count; t++)
+	{
+		ZoneThread *thread = zoneThreads[t].load(std::memory_order_acquire);
+
+		if (thread == NULL)
+		{
+			continue;
+		}
+
+		if (thread->name != NULL)
+		{
+			file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t
+				<< ", \"args\": {\"name\": \"" << thread->name << "\"}}";
+			file << ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t
+				<< ", \"args\": {\"sort_index\": " << t << "}}";
+		}
+
+		//copy ring, then drop zones overwritten meanwhile (the slot of zone being written included)
+		unsigned long long written = thread->written.load(std::memory_order_acquire);
+		unsigned long long first = written > ZONE_PROFILER_EVENTS ? written - ZONE_PROFILER_EVENTS : 0;
+
+		events.clear();
+
+		for (unsigned long long i = first; i < written; i++)
+		{
+			events.push_back(thread->events[i % ZONE_PROFILER_EVENTS]);
+		}
+
+		unsigned long long writtenAfter = thread->written.load(std::memory_order_acquire);
+		unsigned long long valid = writtenAfter >= ZONE_PROFILER_EVENTS ? writtenAfter - ZONE_PROFILER_EVENTS + 1 : 0;
+		unsigned int skip = valid > first ? (unsigned int)std::min(valid - first, (unsigned long long)events.size()) : 0;
+
+		for (unsigned int i = skip; i < events.size(); i++)
+		{
+			const ZoneEvent &e = events[i];
+			double begin = ticksToTraceTime(e.beginTicks);
+			double end = ticksToTraceTime(e.endTicks);
+
+			file << ",\n{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << t
+				<< ", \"ts\": " << begin << ", \"dur\": " << (end > begin ? end - begin : 0.0) << "}";
+		}
+	}
+
+	file << "\n]}\n";
+
+	return file.good();
+}
@@ -0,0 +1,670 @@
+﻿/*
+Project:		Efficient computation of Lighting
+Type:			Bachelor's thesis
+Author:			Tomáš Kubovčík, xkubov02@stud.fit.vutbr.cz
+Supervisor:		Ing. Tomáš Milet
+School info:	Brno Univeristy of Technology (VUT)
+Faculty of Information Technology (FIT)
+Department of Computer Graphics and Multimedia (UPGM)
+
+Project information
+---------------------
+The goal of this project is to efficiently compute lighting in scenes
+with hundrends to thousands light sources. To handle this there have been
+implemented lighting techniques as deferred shading, tiled deferred shading
+and tiled forward shading. Application requires GPU supporting OpenGL 3.3+
+but may be compatible with older versions. Application logic was implemented
+using C/C++ with some external helper libraries to handle basic operations.
+
+File information
+-----------------
+Light grid microbenchmark. Builds light grid on CPU without OpenGL from
+synthetic inputs swept by benchmark spec (resolution, tile, lights, minmax,
+warmup, frames) or from input saved by F11 key in ECL, and reports time
+per light and per tile together with statistics of light lists.
+
+Snapshot stream captured by F10 key (or --grid-snapshots) is replayed by
+--replay, grids are rebuilt and compared with checksums of captured frames.
+
+Grids are built on single thread unless --threads sets size of thread pool
+splitting tile rows between jobs (calling thread included).
+
+--shade also shades synthetic G-buffer of every configuration by CPU reference
+of tiled deferred light pass (scalar and AVX2 paths, tiles split by the same
+pool), reports shading time and difference of both paths and optionally saves
+images as "<prefix><configuration>.pfm".
+
+--animate moves lights by light animator before every build (frames advance
+by 1 / CAMERA_PLAYBACK_FPS) and reports time of animation update.
+
+Usage: GridBench [spec] [--input grid_input.txt] [--csv gridbench.csv] [--threads n] [--shade [--image prefix]] [--animate]
+       GridBench --replay grid_snapshot.bin [--threads n]
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdio.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "configuration\Config.h"
+#include "lighting\lights\LightAnimator.h"
+#include "lighting\tiled\Grid.h"
+#include "lighting\tiled\GridInput.h"
+#include "lighting\tiled\GridSnapshot.h"
+#include "lighting\tiled\GridStatistics.h"
+#include "lighting\tiled\ReferenceShading.h"
+#include "utils\benchmark\BenchmarkSpec.h"
+#include "utils\threading\ThreadPool.h"
+#include "utils\timers\HdrHistogram.h"
+#include "utils\timers\PerformanceTimer.h"
+
+//camera of synthetic inputs, same as ECL camera
+#define SYNTHETIC_FOV		67.0f
+#define SYNTHETIC_NEAR		1.0f
+#define SYNTHETIC_FAR		5000.0f
+
+//lights and visible surfaces are placed in this distance range, lights
+//closer to camera would cover whole screen
+#define SYNTHETIC_MIN_DEPTH	100.0f
+#define SYNTHETIC_DEPTH		3000.0f
+
+//default sweep, 1M lights need few seconds per configuration
+#define DEFAULT_WARMUP		3
+#define DEFAULT_FRAMES		20
+
+//same lights for all tile sizes and min/max settings of light count
+#define SYNTHETIC_SEED		1
+
+//measured shadings of every path (--shade), single shading of 4K takes seconds
+#define SHADE_FRAMES		3
+
+//pool of parallel grid build (--threads), NULL = single thread
+static ThreadPool *buildPool = NULL;
+
+//CPU reference shading of synthetic G-buffers (--shade), images are saved if prefix is set
+static bool shadeEnabled = false;
+static std::string imagePrefix;
+
+//lights are animated before every build (--animate)
+static bool animateEnabled = false;
+
+/// <summary>
+/// Light grid exposing bounding quads pass to be timed separately
+/// </summary>
+class BenchmarkGrid : public LightGrid
+{
+	public:
+		BenchmarkGrid(const glm::uvec2 &resolution, unsigned int tileSize) : LightGrid(resolution, tileSize){ }
+
+		void computeQuads(const Lights &lights, const glm::mat4 &view, const glm::mat4 &projection, float n)
+		{
+			computeBoundingQuads(lights, view, projection, n);
+		}
+};
+
+/// <summary>
+/// Result of single configuration
+/// </summary>
+typedef struct
+{
+	std::string name;
+	BenchmarkConfig config;
+	unsigned int visibleLights;		//lights with bounding quad on screen
+	GridStatistics lists;			//lights per tile of the last build
+	double buildNs;					//p50 of whole grid build
+	double buildP99Ns;
+	double quadsNs;					//p50 of bounding quads pass
+	double animateNs;				//p50 of light animation, 0 without --animate
+	unsigned int animatedLights;	//lights moved by animation
+	double shadeScalarNs;			//p50 of reference shading, 0 without --shade
+	double shadeSimdNs;				//p50 of AVX2 shading, 0 if CPU lacks AVX2
+	unsigned long long shadedPairs;	//pixel-light pairs of tile light lists
+	float shadeMaxError;			//maximal difference of scalar and AVX2 image
+} GridBenchResult;
+
+
+/// <summary>
+/// Generates lights inside view frustum (and around it) and optionally
+/// min/max depths of tiles. Radii are scaled so that total light volume
+/// matches MAX_LIGHTS lights of LIGHT_RADIUS_MIN - LIGHT_RADIUS_MAX.
+/// </summary>
+/// <param name="config">configuration.</param>
+/// <param name="seed">random seed.</param>
+/// <param name="input">output grid input.</param>
+static void generateInput(const BenchmarkConfig &config, unsigned int seed, GridInput &input)
+{
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	float aspect = float(config.resolution.x) / float(config.resolution.y);
+	float tanHalfY = tan(glm::radians(SYNTHETIC_FOV) * 0.5f);
+	float radiusScale = pow(float(MAX_LIGHTS) / float(config.lightCount), 1.0f / 3.0f);
+
+	input.resolution = config.resolution;
+	input.tileSize = config.tileSize;
+	input.nearPlane = SYNTHETIC_NEAR;
+	input.view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	input.projection = glm::perspective(SYNTHETIC_FOV, aspect, SYNTHETIC_NEAR, SYNTHETIC_FAR);
+
+	input.lights.resize(config.lightCount);
+
+	for (unsigned int i = 0; i < config.lightCount; i++)
+	{
+		Light &l = input.lights[i];
+		float depth = SYNTHETIC_MIN_DEPTH + unit(generator) * (SYNTHETIC_DEPTH - SYNTHETIC_MIN_DEPTH);
+
+		//20% margin, lights just outside frustum still touch border tiles
+		l.position.x = (unit(generator) * 2.0f - 1.0f) * 1.2f * depth * tanHalfY * aspect;
+		l.position.y = (unit(generator) * 2.0f - 1.0f) * 1.2f * depth * tanHalfY;
+		l.position.z = -depth;
+		l.color = glm::vec3(unit(generator), unit(generator), unit(generator));
+		l.radius = float(LIGHT_RADIUS_MIN + unit(generator) * (LIGHT_RADIUS_MAX - LIGHT_RADIUS_MIN)) * radiusScale;
+	}
+
+	input.tileDepthRanges.clear();
+
+	if (config.minMax)
+	{
+		glm::uvec2 gridDim = (config.resolution + config.tileSize - 1u) / config.tileSize;
+		input.tileDepthRanges.resize(gridDim.x * gridDim.y);
+
+		//view space depths, min is the nearest surface
+		for (unsigned int i = 0; i < input.tileDepthRanges.size(); i++)
+		{
+			float nearest = SYNTHETIC_MIN_DEPTH + unit(generator) * (SYNTHETIC_DEPTH - SYNTHETIC_MIN_DEPTH);
+			float thickness = nearest * (0.05f + unit(generator) * 0.45f);
+
+			input.tileDepthRanges[i].min = -nearest;
+			input.tileDepthRanges[i].max = -(nearest + thickness);
+		}
+	}
+}
+
+
+/// <summary>
+/// Generates G-buffer of surfaces facing camera. Surfaces are inside depth
+/// ranges of tiles if input has them, otherwise depth grows from the bottom
+/// row to the top one.
+/// </summary>
+/// <param name="input">grid input.</param>
+/// <param name="seed">random seed.</param>
+/// <param name="gBuffer">output G-buffer.</param>
+static void generateGBuffer(const GridInput &input, unsigned int seed, ShadingGBuffer &gBuffer)
+{
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	glm::uvec2 gridDim = (input.resolution + input.tileSize - 1u) / input.tileSize;
+	glm::vec2 tanHalf(1.0f / input.projection[0][0], 1.0f / input.projection[1][1]);
+
+	resizeGBuffer(gBuffer, input.resolution);
+
+	for (unsigned int y = 0; y < input.resolution.y; y++)
+	{
+		for (unsigned int x = 0; x < input.resolution.x; x++)
+		{
+			unsigned int i = y * input.resolution.x + x;
+			float depth;
+
+			if (!input.tileDepthRanges.empty())
+			{
+				const MinMax &range = input.tileDepthRanges[(y / input.tileSize) * gridDim.x + x / input.tileSize];
+				depth = -range.min + unit(generator) * (range.min - range.max);
+			}
+			else
+			{
+				depth = SYNTHETIC_MIN_DEPTH + (SYNTHETIC_DEPTH - SYNTHETIC_MIN_DEPTH) * (y + 0.5f) / input.resolution.y;
+			}
+
+			//view ray through pixel center
+			glm::vec3 ray(((x + 0.5f) / input.resolution.x * 2.0f - 1.0f) * tanHalf.x, ((y + 0.5f) / input.resolution.y * 2.0f - 1.0f) * tanHalf.y, -1.0f);
+			glm::vec3 position = ray * depth;
+			glm::vec3 jitter(unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f);
+			glm::vec3 normal = glm::normalize(glm::normalize(-ray) + jitter * 0.6f);
+			float specular = 0.02f + unit(generator) * 0.3f;
+
+			for (unsigned int c = 0; c < 3; c++)
+			{
+				gBuffer.position[c][i] = position[c];
+				gBuffer.normal[c][i] = normal[c];
+				gBuffer.diffuse[c][i] = unit(generator);
+				gBuffer.specular[c][i] = specular;
+			}
+
+			gBuffer.shininess[i] = 8.0f + unit(generator) * 120.0f;
+		}
+	}
+}
+
+
+/// <summary>
+/// Shades G-buffer repeatedly by one path and measures it.
+/// </summary>
+/// <param name="gBuffer">G-buffer.</param>
+/// <param name="grid">built grid.</param>
+/// <param name="simd">AVX2 path.</param>
+/// <param name="image">output image.</param>
+/// <returns>p50 of shading in nanoseconds</returns>
+static double measureShading(const ShadingGBuffer &gBuffer, const LightGrid &grid, bool simd, ShadingImage &image)
+{
+	HdrHistogram shadeTimes;
+	PerformanceTimer timer;
+
+	for (unsigned int f = 0; f < SHADE_FRAMES; f++)
+	{
+		timer.reset();
+		timer.start();
+		shadeTiledDeferred(gBuffer, grid, image, buildPool, simd);
+		timer.stop();
+
+		shadeTimes.record(timer.getElapsedNanoseconds());
+	}
+
+	return (double)shadeTimes.getValueAtPercentile(50.0);
+}
+
+
+/// <summary>
+/// Shades synthetic G-buffer by built grid with scalar and AVX2 path.
+/// </summary>
+/// <param name="input">grid input.</param>
+/// <param name="grid">grid built from input.</param>
+/// <param name="result">output result, shading fields are set.</param>
+static void runShading(const GridInput &input, const LightGrid &grid, GridBenchResult &result)
+{
+	ShadingGBuffer gBuffer;
+	ShadingImage scalarImage;
+	ShadingImage simdImage;
+
+	generateGBuffer(input, SYNTHETIC_SEED, gBuffer);
+
+	//pixel-light pairs, border tiles are cropped by viewport
+	result.shadedPairs = 0;
+
+	for (unsigned int t = 0; t < grid.getTileCount(); t++)
+	{
+		glm::uvec2 tile(t % grid.getGridDim().x, t / grid.getGridDim().x);
+		glm::uvec2 size = glm::min((tile + 1u) * grid.getTileSize(), input.resolution) - tile * grid.getTileSize();
+
+		result.shadedPairs += (unsigned long long)grid.getCounts()[t] * size.x * size.y;
+	}
+
+	result.shadeScalarNs = measureShading(gBuffer, grid, false, scalarImage);
+
+	if (isSimdShadingAvailable())
+	{
+		ImageDifference difference;
+
+		result.shadeSimdNs = measureShading(gBuffer, grid, true, simdImage);
+		compareImages(scalarImage, simdImage, difference);
+		result.shadeMaxError = difference.maxError;
+	}
+
+	if (!imagePrefix.empty() && !saveImagePfm(imagePrefix + result.name + ".pfm", scalarImage))
+	{
+		std::cerr << "GridBench: could not write " << imagePrefix << result.name << ".pfm" << std::endl;
+	}
+}
+
+
+/// <summary>
+/// Builds grid repeatedly and measures it.
+/// </summary>
+/// <param name="input">grid input.</param>
+/// <param name="warmup">builds not measured.</param>
+/// <param name="frames">measured builds.</param>
+/// <param name="result">output result, name and config are kept.</param>
+static void runConfiguration(GridInput &input, unsigned int warmup, unsigned int frames, GridBenchResult &result)
+{
+	BenchmarkGrid grid(input.resolution, input.tileSize);
+	grid.setThreadPool(buildPool);
+
+	HdrHistogram buildTimes;
+	HdrHistogram quadsTimes;
+	HdrHistogram animateTimes;
+	PerformanceTimer timer;
+
+	//animated copy of input lights
+	Lights lights = input.lights;
+	LightAnimator animator;
+
+	if (animateEnabled)
+	{
+		AABB bounds = emptyAABB();
+
+		for (unsigned int i = 0; i < lights.size(); i++)
+		{
+			expandAABB(bounds, lights[i].position);
+		}
+
+		animator.setLights(lights, bounds, SYNTHETIC_SEED);
+	}
+
+	for (unsigned int f = 0; f < warmup + frames; f++)
+	{
+		unsigned long long animateNs = 0;
+
+		if (animateEnabled)
+		{
+			timer.reset();
+			timer.start();
+			animator.update(float(f / CAMERA_PLAYBACK_FPS), lights, buildPool);
+			timer.stop();
+
+			animateNs = timer.getElapsedNanoseconds();
+		}
+
+		timer.reset();
+		timer.start();
+		grid.computeQuads(lights, input.view, input.projection, input.nearPlane);
+		timer.stop();
+
+		unsigned long long quadsNs = timer.getElapsedNanoseconds();
+
+		timer.reset();
+		timer.start();
+		grid.buildLightGrid(input.tileDepthRanges, lights, input.nearPlane, input.view, input.projection);
+		timer.stop();
+
+		if (f >= warmup)
+		{
+			animateTimes.record(animateNs);
+			quadsTimes.record(quadsNs);
+			buildTimes.record(timer.getElapsedNanoseconds());
+		}
+	}
+
+	result.visibleLights = (unsigned int)grid.getViewSpaceLights().size();
+	computeGridStatistics(grid.getCounts(), grid.getTileCount(), result.lists);
+
+	result.buildNs = (double)buildTimes.getValueAtPercentile(50.0);
+	result.buildP99Ns = (double)buildTimes.getValueAtPercentile(99.0);
+	result.quadsNs = (double)quadsTimes.getValueAtPercentile(50.0);
+	result.animateNs = (double)animateTimes.getValueAtPercentile(50.0);
+	result.animatedLights = animator.getAnimatedCount();
+
+	result.shadeScalarNs = 0.0;
+	result.shadeSimdNs = 0.0;
+	result.shadedPairs = 0;
+	result.shadeMaxError = 0.0f;
+
+	if (shadeEnabled)
+	{
+		runShading(input, grid, result);
+	}
+}
+
+
+/// <summary>
+/// Prints result line.
+/// </summary>
+/// <param name="r">result.</param>
+static void printResult(const GridBenchResult &r)
+{
+	unsigned int lights = (unsigned int)std::max<size_t>(r.config.lightCount, 1);
+
+	printf("%-34s %9u %10.3f %10.3f %9.2f %9.1f %11u %8.2f %7u %7u %7.2f\n", r.name.c_str(), r.visibleLights,
+		r.buildNs / 1e6, r.buildP99Ns / 1e6, r.buildNs / lights, r.buildNs / r.lists.tiles,
+		r.lists.listLength, r.lists.meanLights, r.lists.p95Lights, r.lists.maxLights, r.lists.overThreshold * 100.0f);
+
+	if (animateEnabled)
+	{
+		printf("%-34s animation %.3f ms (%.2f ns/light, %u lights animated)\n", "", r.animateNs / 1e6,
+			r.animateNs / std::max(r.animatedLights, 1u), r.animatedLights);
+	}
+
+	if (shadeEnabled)
+	{
+		double pairs = double(std::max(r.shadedPairs, 1ull));
+
+		printf("%-34s shading %.3f ms scalar (%.2f ns/pixel-light)", "", r.shadeScalarNs / 1e6, r.shadeScalarNs / pairs);
+
+		if (r.shadeSimdNs > 0.0)
+		{
+			printf(", %.3f ms AVX2 (%.2f ns/pixel-light), max difference %g", r.shadeSimdNs / 1e6, r.shadeSimdNs / pairs, r.shadeMaxError);
+		}
+
+		printf("\n");
+	}
+}
+
+
+/// <summary>
+/// Writes results to CSV file.
+/// </summary>
+/// <param name="filename">output file.</param>
+/// <param name="results">results.</param>
+/// <returns>false if file could not be written</returns>
+static bool writeCsv(const std::string &filename, const std::vector<GridBenchResult> &results)
+{
+	std::ofstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file << "name,resolution_x,resolution_y,tile,lights,minmax,tiles,visible_lights,build_ms_p50,build_ms_p99,quads_ms_p50,"
+		"ns_per_light,ns_per_tile,list_length,mean_list,p95_list,max_list,tiles_over_threshold_pct,"
+		"shade_scalar_ms,shade_simd_ms,shaded_pixel_lights,shade_max_difference,animate_ms\n";
+
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		const GridBenchResult &r = results[i];
+		unsigned int lights = std::max(r.config.lightCount, 1u);
+
+		file << r.name << "," << r.config.resolution.x << "," << r.config.resolution.y << "," << r.config.tileSize << ","
+			<< r.config.lightCount << "," << (r.config.minMax ? 1 : 0) << "," << r.lists.tiles << "," << r.visibleLights << ","
+			<< r.buildNs / 1e6 << "," << r.buildP99Ns / 1e6 << "," << r.quadsNs / 1e6 << ","
+			<< r.buildNs / lights << "," << r.buildNs / r.lists.tiles << "," << r.lists.listLength << "," << r.lists.meanLights << ","
+			<< r.lists.p95Lights << "," << r.lists.maxLights << "," << r.lists.overThreshold * 100.0f << ","
+			<< r.shadeScalarNs / 1e6 << "," << r.shadeSimdNs / 1e6 << "," << r.shadedPairs << "," << r.shadeMaxError << "," << r.animateNs / 1e6 << "\n";
+	}
+
+	return file.good();
+}
+
+
+/// <summary>
+/// Rebuilds grids of snapshot stream and compares them with captured grids.
+/// </summary>
+/// <param name="filename">snapshot stream.</param>
+/// <returns>process exit code, 1 if any grid differs</returns>
+static int replaySnapshots(const std::string &filename)
+{
+	GridSnapshotReader reader;
+
+	if (!reader.open(filename))
+	{
+		std::cerr << "GridBench: " << filename << " is not grid snapshot stream" << std::endl;
+		return 1;
+	}
+
+	LightGrid grid;
+	grid.setThreadPool(buildPool);
+
+	GridInput input;
+	HdrHistogram buildTimes;
+	PerformanceTimer timer;
+	unsigned int checksum;
+	unsigned int frames = 0;
+	unsigned int mismatches = 0;
+	double nsPerLight = 0.0;
+
+	while (reader.read(input, checksum))
+	{
+		if (grid.getResolution() != input.resolution || grid.getTileSize() != input.tileSize)
+		{
+			grid.resize(input.resolution, input.tileSize);
+		}
+
+		timer.reset();
+		timer.start();
+		grid.buildLightGrid(input.tileDepthRanges, input.lights, input.nearPlane, input.view, input.projection);
+		timer.stop();
+
+		unsigned long long ns = timer.getElapsedNanoseconds();
+		buildTimes.record(ns);
+		nsPerLight += double(ns) / std::max<size_t>(input.lights.size(), 1);
+		frames++;
+
+		if (grid.computeChecksum() != checksum && ++mismatches <= 10)
+		{
+			printf("Frame %u: light lists differ from captured grid\n", reader.getFrame());
+		}
+	}
+
+	printf("%u frames replayed, %u differ, build %.3f ms p50, %.3f ms p99, %.2f ns/light\n", frames, mismatches,
+		buildTimes.getValueAtPercentile(50.0) / 1e6, buildTimes.getValueAtPercentile(99.0) / 1e6, frames ? nsPerLight / frames : 0.0);
+
+	return mismatches > 0 ? 1 : 0;
+}
+
+
+int main(int argc, char **argv)
+{
+	std::vector<std::string> techniqueNames(1, "LightGrid");
+	BenchmarkSpec spec(techniqueNames);
+	std::string inputFile;
+	std::string csvFile = "gridbench.csv";
+	std::string replayFile;
+	unsigned int threads = 1;
+
+	//default sweep of synthetic inputs
+	spec.resolutions.clear();
+	spec.resolutions.push_back(glm::uvec2(1280, 720));
+	spec.resolutions.push_back(glm::uvec2(1920, 1080));
+	spec.resolutions.push_back(glm::uvec2(3840, 2160));
+	spec.tileSizes.clear();
+	spec.tileSizes.push_back(16);
+	spec.tileSizes.push_back(32);
+	spec.tileSizes.push_back(64);
+	spec.lightCounts.clear();
+	spec.lightCounts.push_back(1000);
+	spec.lightCounts.push_back(10000);
+	spec.lightCounts.push_back(100000);
+	spec.lightCounts.push_back(1000000);
+	spec.warmupFrames = DEFAULT_WARMUP;
+	spec.measuredFrames = DEFAULT_FRAMES;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+		{
+			inputFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+		{
+			csvFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			replayFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			threads = std::max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "--shade") == 0)
+		{
+			shadeEnabled = true;
+		}
+		else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc)
+		{
+			imagePrefix = argv[++i];
+		}
+		else if (strcmp(argv[i], "--animate") == 0)
+		{
+			animateEnabled = true;
+		}
+		else if (argv[i][0] != '-')
+		{
+			if (!spec.load(argv[i]))
+			{
+				return 1;
+			}
+		}
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [spec] [--input grid_input.txt] [--csv gridbench.csv] [--threads n] [--shade [--image prefix]] [--animate]" << std::endl;
+			std::cerr << "       " << argv[0] << " --replay grid_snapshot.bin [--threads n]" << std::endl;
+			return 1;
+		}
+	}
+
+	//calling thread takes part in parallel build, pool is unused by single thread
+	ThreadPool pool(threads > 1 ? threads - 1 : 1, THREAD_POOL_PINNING != 0);
+
+	if (threads > 1)
+	{
+		buildPool = &pool;
+	}
+
+	if (!replayFile.empty())
+	{
+		return replaySnapshots(replayFile);
+	}
+
+	std::vector<BenchmarkConfig> configs;
+	GridInput recorded;
+
+	if (!inputFile.empty())
+	{
+		if (!loadGridInput(inputFile, recorded))
+		{
+			std::cerr << "GridBench: could not load " << inputFile << std::endl;
+			return 1;
+		}
+
+		BenchmarkConfig config;
+		config.resolution = recorded.resolution;
+		config.tileSize = recorded.tileSize;
+		config.technique = 0;
+		config.lightCount = (unsigned int)recorded.lights.size();
+		config.minMax = !recorded.tileDepthRanges.empty();
+
+		configs.push_back(config);
+	}
+	else
+	{
+		spec.getConfigurations(configs);
+	}
+
+	printf("%-34s %9s %10s %10s %9s %9s %11s %8s %7s %7s %7s\n", "configuration", "visible", "build ms", "p99 ms",
+		"ns/light", "ns/tile", "list length", "mean", "p95", "max", "over %");
+
+	std::vector<GridBenchResult> results(configs.size());
+
+	for (unsigned int c = 0; c < configs.size(); c++)
+	{
+		GridBenchResult &result = results[c];
+		result.config = configs[c];
+		result.name = spec.getRunName(configs[c]);
+
+		if (inputFile.empty())
+		{
+			GridInput input;
+			generateInput(configs[c], SYNTHETIC_SEED, input);
+			runConfiguration(input, spec.warmupFrames, spec.measuredFrames, result);
+		}
+		else
+		{
+			runConfiguration(recorded, spec.warmupFrames, spec.measuredFrames, result);
+		}
+
+		printResult(result);
+	}
+
+	if (spec.writeCsv && !writeCsv(csvFile, results))
+	{
+		std::cerr << "GridBench: could not write " << csvFile << std::endl;
+		return 1;
+	}
+
+	return 0;
+}